@@ -0,0 +1,230 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+
+#include "wcomponent.h"
+#include "wentity.h"
+#include "entity_registry.h"
+#include "math3d.h"
+#include "clock.hpp"
+#include "moving_average.h"
+
+using namespace wcore;
+using namespace wcore::math;
+
+// Benchmark comparing the blueprint entity model (one heap allocated WEntity per entity,
+// components in a type_index hash map, entities in an id map) with archetype storage on
+// the access patterns of EntitySystem and Scene:
+//   - creation
+//   - update of all entities having two given components
+//   - front to back sort of displayable entities (Scene::sort_models())
+
+class WCBenchPosition: public WComponent
+{
+public:
+    vec3 position;
+};
+REGISTER_COMPONENT(WCBenchPosition);
+
+class WCBenchVelocity: public WComponent
+{
+public:
+    vec3 velocity;
+};
+REGISTER_COMPONENT(WCBenchVelocity);
+
+static constexpr uint32_t N_ENTITIES = 100000;
+static constexpr uint32_t N_RUNS     = 20;
+
+struct Sample
+{
+    vec3 position;
+    vec3 velocity;
+    bool moving;
+};
+
+static std::vector<Sample> make_samples(uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> pos_dis(-500.f, 500.f);
+    std::uniform_real_distribution<float> vel_dis(-1.f, 1.f);
+
+    std::vector<Sample> samples(N_ENTITIES);
+    for(auto&& sample: samples)
+    {
+        sample.position = vec3(pos_dis(gen), pos_dis(gen), pos_dis(gen));
+        sample.velocity = vec3(vel_dis(gen), vel_dis(gen), vel_dis(gen));
+        sample.moving   = (gen()%2 == 0); // Two archetypes
+    }
+    return samples;
+}
+
+static void print_stats(const char* label, const MovingAverage& avg, float scale, const char* unit)
+{
+    FinalStatistics stats = avg.get_stats();
+    std::cout << std::setw(28) << std::left << label
+              << " mean: "   << std::setw(10) << stats.mean*scale
+              << " median: " << std::setw(10) << stats.median*scale
+              << " min: "    << std::setw(10) << stats.min_val*scale
+              << unit << std::endl;
+}
+
+static inline float to_seconds(std::chrono::nanoseconds period)
+{
+    return std::chrono::duration_cast<std::chrono::duration<float>>(period).count();
+}
+
+// * Current model: what EntitySystem did before archetype storage
+struct MapWorld
+{
+    std::map<uint64_t, std::shared_ptr<WEntity>> entities;
+    std::vector<uint64_t> moving;      // Ids of entities with a velocity
+    std::vector<uint64_t> displayable; // Ids of all entities
+
+    void build(const std::vector<Sample>& samples)
+    {
+        uint64_t id = 0;
+        for(auto&& sample: samples)
+        {
+            std::shared_ptr<WEntity> entity(new WEntity());
+            entity->add_component<WCBenchPosition>()->position = sample.position;
+            if(sample.moving)
+            {
+                entity->add_component<WCBenchVelocity>()->velocity = sample.velocity;
+                moving.push_back(id);
+            }
+            displayable.push_back(id);
+            entities.insert(std::pair(id++, entity));
+        }
+    }
+
+    void update(float dt)
+    {
+        for(uint64_t id: moving)
+        {
+            WEntity& entity = *entities.at(id);
+            entity.get_component<WCBenchPosition>()->position += dt*entity.get_component<WCBenchVelocity>()->velocity;
+        }
+    }
+
+    void sort(const vec3& eye)
+    {
+        std::sort(displayable.begin(), displayable.end(),
+        [&](uint64_t a, uint64_t b)
+        {
+            float dist_a = norm2(entities.at(a)->get_component<WCBenchPosition>()->position-eye);
+            float dist_b = norm2(entities.at(b)->get_component<WCBenchPosition>()->position-eye);
+            return (dist_a < dist_b);
+        });
+    }
+};
+
+// * Archetype storage
+struct ArchetypeWorld
+{
+    EntityRegistry registry;
+    std::vector<std::pair<float, EntityHandle>> keyed;
+    std::vector<EntityHandle> displayable;
+
+    void build(const std::vector<Sample>& samples)
+    {
+        for(auto&& sample: samples)
+        {
+            EntityHandle handle = registry.create();
+            registry.add<WCBenchPosition>(handle)->position = sample.position;
+            if(sample.moving)
+                registry.add<WCBenchVelocity>(handle)->velocity = sample.velocity;
+        }
+    }
+
+    void update(float dt)
+    {
+        registry.query<WCBenchPosition, WCBenchVelocity>(
+        [dt](EntityHandle, WCBenchPosition& pos, WCBenchVelocity& vel)
+        {
+            pos.position += dt*vel.velocity;
+        });
+    }
+
+    void sort(const vec3& eye)
+    {
+        keyed.clear();
+        registry.query<WCBenchPosition>([&](EntityHandle handle, WCBenchPosition& pos)
+        {
+            keyed.push_back({norm2(pos.position-eye), handle});
+        });
+        std::sort(keyed.begin(), keyed.end(),
+        [](const std::pair<float, EntityHandle>& a, const std::pair<float, EntityHandle>& b)
+        {
+            return (a.first < b.first);
+        });
+        displayable.resize(keyed.size());
+        for(uint32_t ii=0; ii<keyed.size(); ++ii)
+            displayable[ii] = keyed[ii].second;
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    std::cout << "ECS storage benchmark: " << N_ENTITIES << " entities." << std::endl;
+
+    std::vector<Sample> samples(make_samples(42));
+    MovingAverage map_build(N_RUNS),  arch_build(N_RUNS);
+    MovingAverage map_update(N_RUNS), arch_update(N_RUNS);
+    MovingAverage map_sort(N_RUNS),   arch_sort(N_RUNS);
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> eye_dis(-500.f, 500.f);
+    const float dt = 1.f/60.f;
+
+    nanoClock clock;
+    for(uint32_t ii=0; ii<N_RUNS; ++ii)
+    {
+        MapWorld map_world;
+        ArchetypeWorld arch_world;
+
+        clock.restart();
+        map_world.build(samples);
+        map_build.push(to_seconds(clock.get_elapsed_time()));
+        clock.restart();
+        arch_world.build(samples);
+        arch_build.push(to_seconds(clock.get_elapsed_time()));
+
+        clock.restart();
+        map_world.update(dt);
+        map_update.push(to_seconds(clock.get_elapsed_time()));
+        clock.restart();
+        arch_world.update(dt);
+        arch_update.push(to_seconds(clock.get_elapsed_time()));
+
+        vec3 eye(eye_dis(gen), eye_dis(gen), eye_dis(gen));
+        clock.restart();
+        map_world.sort(eye);
+        map_sort.push(to_seconds(clock.get_elapsed_time()));
+        clock.restart();
+        arch_world.sort(eye);
+        arch_sort.push(to_seconds(clock.get_elapsed_time()));
+
+        // Both sorts must agree on the nearest entity
+        const vec3& map_nearest  = map_world.entities.at(map_world.displayable[0])->get_component<WCBenchPosition>()->position;
+        const vec3& arch_nearest = arch_world.registry.get<WCBenchPosition>(arch_world.displayable[0])->position;
+        if(norm2(map_nearest-eye) != norm2(arch_nearest-eye))
+        {
+            std::cout << "Sort mismatch at run " << ii << std::endl;
+            return 1;
+        }
+    }
+
+    print_stats("Build (map)",        map_build,   1e3, "ms");
+    print_stats("Build (archetype)",  arch_build,  1e3, "ms");
+    print_stats("Update (map)",       map_update,  1e6, "µs");
+    print_stats("Update (archetype)", arch_update, 1e6, "µs");
+    print_stats("Sort (map)",         map_sort,    1e3, "ms");
+    print_stats("Sort (archetype)",   arch_sort,   1e3, "ms");
+
+    return 0;
+}
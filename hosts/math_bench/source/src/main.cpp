@@ -0,0 +1,229 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include "math3d.h"
+#include "clock.hpp"
+#include "moving_average.h"
+
+using namespace wcore;
+using namespace wcore::math;
+
+// Microbenchmark of the SIMD math paths against plain scalar code, on batches sized
+// like a frame worth of scene work:
+//   - 4x4 matrix products (model-view-projection updates)
+//   - general 4x4 inverse (RayCaster unprojection, camera)
+//   - point transforms (OBB vertices)
+//   - TRS composition (Transformation::get_model_matrix())
+//   - quaternion products
+
+static constexpr uint32_t N_ELEMENTS = 10000;
+static constexpr uint32_t N_RUNS     = 50;
+
+// * Scalar references, same arithmetic as the generic templates
+static void scalar_product(const mat4& lhs, const mat4& rhs, mat4& out)
+{
+    for(unsigned col=0; col<4; ++col)
+        for(unsigned row=0; row<4; ++row)
+        {
+            float sum = 0.f;
+            for(unsigned kk=0; kk<4; ++kk)
+                sum += lhs[4*kk+row]*rhs[4*col+kk];
+            out[4*col+row] = sum;
+        }
+}
+
+static vec3 scalar_transform(const mat4& m, const vec3& v)
+{
+    return vec3(m[0]*v[0] + m[4]*v[1] + m[8]*v[2]  + m[12],
+                m[1]*v[0] + m[5]*v[1] + m[9]*v[2]  + m[13],
+                m[2]*v[0] + m[6]*v[1] + m[10]*v[2] + m[14]);
+}
+
+static quat scalar_quat_product(const quat& lhs, const quat& rhs)
+{
+    float w = lhs[3]*rhs[3] - lhs[0]*rhs[0] - lhs[1]*rhs[1] - lhs[2]*rhs[2];
+    float x = lhs[3]*rhs[0] + lhs[0]*rhs[3] + lhs[1]*rhs[2] - lhs[2]*rhs[1];
+    float y = lhs[3]*rhs[1] - lhs[0]*rhs[2] + lhs[1]*rhs[3] + lhs[2]*rhs[0];
+    float z = lhs[3]*rhs[2] + lhs[0]*rhs[1] - lhs[1]*rhs[0] + lhs[2]*rhs[3];
+    return quat(x, y, z, w);
+}
+
+static mat4 scalar_trs(const vec3& position, const quat& orientation, float scale)
+{
+    mat4 T, S, TR, TRS;
+    T.init_translation(position);
+    S.init_scale(scale);
+    scalar_product(T, orientation.get_rotation_matrix(), TR);
+    scalar_product(TR, S, TRS);
+    return TRS;
+}
+
+static void print_stats(const char* label, const MovingAverage& avg, float scale, const char* unit)
+{
+    FinalStatistics stats = avg.get_stats();
+    std::cout << std::setw(28) << std::left << label
+              << " mean: "   << std::setw(10) << stats.mean*scale
+              << " median: " << std::setw(10) << stats.median*scale
+              << " min: "    << std::setw(10) << stats.min_val*scale
+              << unit << std::endl;
+}
+
+static inline float to_seconds(std::chrono::nanoseconds period)
+{
+    return std::chrono::duration_cast<std::chrono::duration<float>>(period).count();
+}
+
+// Prevents the compiler from discarding the results
+static float checksum(const float* data, size_t count)
+{
+    float sum = 0.f;
+    for(size_t ii=0; ii<count; ++ii)
+        sum += data[ii];
+    return sum;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::cout << "Math benchmark: " << N_ELEMENTS << " elements per batch";
+#ifdef __AVX__
+    std::cout << " (AVX)";
+#elif defined(__SSE__)
+    std::cout << " (SSE)";
+#endif
+#ifdef __OPTIM_ALIGNED_MATH__
+    std::cout << " (aligned storage)";
+#endif
+    std::cout << "." << std::endl;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(-1.f, 1.f);
+    std::uniform_real_distribution<float> scale_dis(0.5f, 2.f);
+
+    std::vector<mat4> matrices(N_ELEMENTS), products(N_ELEMENTS);
+    std::vector<vec3> points(N_ELEMENTS), transformed(N_ELEMENTS);
+    std::vector<quat> orientations(N_ELEMENTS), quat_products(N_ELEMENTS);
+    std::vector<float> scales(N_ELEMENTS);
+    for(uint32_t ii=0; ii<N_ELEMENTS; ++ii)
+    {
+        for(unsigned jj=0; jj<16; ++jj)
+            matrices[ii][jj] = dis(gen);
+        points[ii] = vec3(100.f*dis(gen), 100.f*dis(gen), 100.f*dis(gen));
+        orientations[ii] = quat(dis(gen), dis(gen), dis(gen), dis(gen)).normalized();
+        scales[ii] = scale_dis(gen);
+    }
+    mat4 VP(matrices[0]);
+
+    MovingAverage scalar_mul(N_RUNS),  simd_mul(N_RUNS),   batch_mul(N_RUNS);
+    MovingAverage scalar_inv(N_RUNS),  simd_inv(N_RUNS);
+    MovingAverage scalar_xf(N_RUNS),   batch_xf(N_RUNS);
+    MovingAverage product_trs(N_RUNS), batch_trs(N_RUNS);
+    MovingAverage scalar_quat(N_RUNS), simd_quat(N_RUNS);
+
+    float sink = 0.f;
+    nanoClock clock;
+    for(uint32_t run=0; run<N_RUNS; ++run)
+    {
+        // * Matrix products
+        clock.restart();
+        for(uint32_t ii=0; ii<N_ELEMENTS; ++ii)
+            scalar_product(VP, matrices[ii], products[ii]);
+        scalar_mul.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(products.back().get_pointer(), 16);
+
+        clock.restart();
+        for(uint32_t ii=0; ii<N_ELEMENTS; ++ii)
+            products[ii] = VP*matrices[ii];
+        simd_mul.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(products.back().get_pointer(), 16);
+
+        clock.restart();
+        multiply(VP, matrices.data(), products.data(), N_ELEMENTS);
+        batch_mul.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(products.back().get_pointer(), 16);
+
+        // * General inverse
+        // transposed_inverse() still uses the scalar cofactor expansion, same cost as
+        // inverse() without SSE. Random matrices are not affine.
+        clock.restart();
+        for(uint32_t ii=0; ii<N_ELEMENTS; ++ii)
+            transposed_inverse(matrices[ii], products[ii]);
+        scalar_inv.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(products.back().get_pointer(), 16);
+
+        clock.restart();
+        for(uint32_t ii=0; ii<N_ELEMENTS; ++ii)
+            inverse(matrices[ii], products[ii]);
+        simd_inv.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(products.back().get_pointer(), 16);
+
+        // * Point transforms
+        clock.restart();
+        for(uint32_t ii=0; ii<N_ELEMENTS; ++ii)
+            transformed[ii] = scalar_transform(VP, points[ii]);
+        scalar_xf.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(transformed.back().get_pointer(), 3);
+
+        clock.restart();
+        transform_points(VP, points.data(), transformed.data(), N_ELEMENTS);
+        batch_xf.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(transformed.back().get_pointer(), 3);
+
+        // * TRS composition
+        clock.restart();
+        for(uint32_t ii=0; ii<N_ELEMENTS; ++ii)
+            products[ii] = scalar_trs(points[ii], orientations[ii], scales[ii]);
+        product_trs.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(products.back().get_pointer(), 16);
+
+        clock.restart();
+        compose_trs(points.data(), orientations.data(), scales.data(), products.data(), N_ELEMENTS);
+        batch_trs.push(to_seconds(clock.get_elapsed_time()));
+        sink += checksum(products.back().get_pointer(), 16);
+
+        // * Quaternion products
+        clock.restart();
+        for(uint32_t ii=1; ii<N_ELEMENTS; ++ii)
+            quat_products[ii] = scalar_quat_product(orientations[ii-1], orientations[ii]);
+        scalar_quat.push(to_seconds(clock.get_elapsed_time()));
+        sink += quat_products.back()[3];
+
+        clock.restart();
+        for(uint32_t ii=1; ii<N_ELEMENTS; ++ii)
+            quat_products[ii] = orientations[ii-1]*orientations[ii];
+        simd_quat.push(to_seconds(clock.get_elapsed_time()));
+        sink += quat_products.back()[3];
+    }
+
+    print_stats("mat4 product (scalar)",   scalar_mul,  1e6, "µs");
+    print_stats("mat4 product (operator)", simd_mul,    1e6, "µs");
+    print_stats("mat4 product (batch)",    batch_mul,   1e6, "µs");
+    print_stats("mat4 inverse (scalar)",   scalar_inv,  1e6, "µs");
+    print_stats("mat4 inverse",            simd_inv,    1e6, "µs");
+    print_stats("Points (scalar)",         scalar_xf,   1e6, "µs");
+    print_stats("Points (batch)",          batch_xf,    1e6, "µs");
+    print_stats("TRS (products)",          product_trs,  1e6, "µs");
+    print_stats("TRS (batch)",             batch_trs,   1e6, "µs");
+    print_stats("quat product (scalar)",   scalar_quat, 1e6, "µs");
+    print_stats("quat product",            simd_quat,   1e6, "µs");
+
+    // * Check batch results against single operations
+    bool ok = true;
+    multiply(VP, matrices.data(), products.data(), N_ELEMENTS);
+    for(uint32_t ii=0; ii<N_ELEMENTS && ok; ++ii)
+    {
+        mat4 expect;
+        scalar_product(VP, matrices[ii], expect);
+        for(unsigned jj=0; jj<16; ++jj)
+            ok &= (std::abs(expect[jj]-products[ii][jj]) < 1e-5f);
+    }
+    if(!ok)
+    {
+        std::cout << "Batch product mismatch" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Checksum: " << sink << std::endl;
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include "octree.hpp"
+#include "linear_octree.hpp"
+#include "bounding_boxes.h"
+#include "camera.h"
+#include "clock.hpp"
+#include "moving_average.h"
+
+using namespace wcore;
+using namespace wcore::math;
+
+// Mimics Scene::StaticOctree usage: one group per chunk, objects are world space AABBs
+struct UData
+{
+    int key;
+
+    bool operator==(const UData& other) const
+    {
+        return key == other.key;
+    }
+};
+
+typedef Octree<BoundingRegion, UData>       PointerOctree;
+typedef LinearOctree<BoundingRegion, UData> FlatOctree;
+
+static constexpr uint32_t CHUNK_SIZE_M   = 32;
+static constexpr uint32_t CHUNKS_PER_DIM = 16;
+static constexpr uint32_t OBJ_PER_CHUNK  = 256;
+static constexpr uint32_t N_BUILDS       = 20;
+static constexpr uint32_t N_QUERIES      = 500;
+
+struct Sample
+{
+    BoundingRegion bounds;
+    UData data;
+    uint32_t chunk;
+};
+
+static std::vector<Sample> make_level(uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> pos_dis(0.f, float(CHUNK_SIZE_M));
+    std::uniform_real_distribution<float> height_dis(0.f, 8.f);
+    std::uniform_real_distribution<float> size_dis(0.25f, 3.f);
+
+    std::vector<Sample> samples;
+    samples.reserve(CHUNKS_PER_DIM*CHUNKS_PER_DIM*OBJ_PER_CHUNK);
+    int key = 0;
+    for(uint32_t cx=0; cx<CHUNKS_PER_DIM; ++cx)
+    {
+        for(uint32_t cz=0; cz<CHUNKS_PER_DIM; ++cz)
+        {
+            uint32_t chunk = cx*CHUNKS_PER_DIM+cz;
+            for(uint32_t ii=0; ii<OBJ_PER_CHUNK; ++ii)
+            {
+                vec3 center(cx*CHUNK_SIZE_M+pos_dis(gen), height_dis(gen), cz*CHUNK_SIZE_M+pos_dis(gen));
+                vec3 half(size_dis(gen), size_dis(gen), size_dis(gen));
+                samples.push_back(Sample({BoundingRegion(center, half), UData({key++}), chunk}));
+            }
+        }
+    }
+    return samples;
+}
+
+static void print_stats(const char* label, const MovingAverage& avg, float scale, const char* unit)
+{
+    FinalStatistics stats = avg.get_stats();
+    std::cout << std::setw(28) << std::left << label
+              << " mean: "   << std::setw(10) << stats.mean*scale
+              << " median: " << std::setw(10) << stats.median*scale
+              << " min: "    << std::setw(10) << stats.min_val*scale
+              << unit << std::endl;
+}
+
+static inline float to_seconds(std::chrono::nanoseconds period)
+{
+    return std::chrono::duration_cast<std::chrono::duration<float>>(period).count();
+}
+
+// Insert chunk by chunk and propagate after each chunk, like Scene::populate_static_octree()
+template <typename OctreeT>
+static void build(OctreeT& octree, const std::vector<Sample>& samples)
+{
+    octree.set_root_bounding_region(BoundingRegion({0.f, float(CHUNK_SIZE_M)-1,
+                                                    0.f, float(CHUNK_SIZE_M)-1,
+                                                    0.f, float(CHUNK_SIZE_M)-1}));
+    uint32_t current_chunk = samples[0].chunk;
+    for(auto&& sample: samples)
+    {
+        if(sample.chunk != current_chunk)
+        {
+            octree.propagate();
+            current_chunk = sample.chunk;
+        }
+        octree.insert(typename OctreeT::DataT(sample.bounds, sample.data, sample.chunk));
+    }
+    octree.propagate();
+}
+
+template <typename OctreeT>
+static uint64_t query(OctreeT& octree, const std::vector<Camera>& cameras, MovingAverage& avg)
+{
+    uint64_t total = 0;
+    nanoClock clock;
+    for(auto&& camera: cameras)
+    {
+        uint32_t count = 0;
+        clock.restart();
+        octree.traverse_range(camera.get_frustum_box(), [&](auto&& obj)
+        {
+            ++count;
+        });
+        avg.push(to_seconds(clock.get_elapsed_time()));
+        total += count;
+    }
+    return total;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::cout << "Octree benchmark: " << CHUNKS_PER_DIM*CHUNKS_PER_DIM << " chunks, "
+              << CHUNKS_PER_DIM*CHUNKS_PER_DIM*OBJ_PER_CHUNK << " objects." << std::endl;
+
+    std::vector<Sample> samples(make_level(42));
+
+    // * Build time
+    MovingAverage ptr_build(N_BUILDS);
+    MovingAverage flat_build(N_BUILDS);
+    nanoClock clock;
+    for(uint32_t ii=0; ii<N_BUILDS; ++ii)
+    {
+        {
+            clock.restart();
+            PointerOctree octree;
+            build(octree, samples);
+            ptr_build.push(to_seconds(clock.get_elapsed_time()));
+        }
+        {
+            clock.restart();
+            FlatOctree octree;
+            build(octree, samples);
+            flat_build.push(to_seconds(clock.get_elapsed_time()));
+        }
+    }
+
+    // * Frustum query time, cameras wandering across the level
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> pos_dis(0.f, float(CHUNKS_PER_DIM*CHUNK_SIZE_M));
+    std::uniform_real_distribution<float> yaw_dis(0.f, 360.f);
+    std::uniform_real_distribution<float> pitch_dis(-30.f, 10.f);
+    std::vector<Camera> cameras;
+    cameras.reserve(N_QUERIES);
+    for(uint32_t ii=0; ii<N_QUERIES; ++ii)
+    {
+        cameras.emplace_back(1024, 768);
+        Camera& camera = cameras.back();
+        camera.set_perspective(1024, 768, 0.1f, 100.f);
+        camera.set_position(vec3(pos_dis(gen), 10.f, pos_dis(gen)));
+        camera.set_orientation(yaw_dis(gen), pitch_dis(gen));
+        camera.update(1.f/60.f);
+    }
+
+    PointerOctree ptr_octree;
+    FlatOctree flat_octree;
+    build(ptr_octree, samples);
+    build(flat_octree, samples);
+
+    MovingAverage ptr_query(N_QUERIES);
+    MovingAverage flat_query(N_QUERIES);
+    uint64_t ptr_visible  = query(ptr_octree, cameras, ptr_query);
+    uint64_t flat_visible = query(flat_octree, cameras, flat_query);
+
+    print_stats("Build (pointer octree)",  ptr_build,  1e3, "ms");
+    print_stats("Build (linear octree)",   flat_build, 1e3, "ms");
+    print_stats("Frustum (pointer octree)", ptr_query,  1e6, "µs");
+    print_stats("Frustum (linear octree)",  flat_query, 1e6, "µs");
+
+    std::cout << "Linear octree nodes: " << flat_octree.get_node_count() << std::endl;
+    if(ptr_visible != flat_visible)
+    {
+        std::cout << "Visible object count mismatch: " << ptr_visible
+                  << " vs " << flat_visible << std::endl;
+        return 1;
+    }
+    std::cout << "Visible objects over all queries: " << flat_visible << std::endl;
+
+    return 0;
+}
@@ -1,16 +1,14 @@
 #version 400 core
 
+#include "frame_data.glsl"
+
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec3 in_normal;
 layout(location = 2) in vec3 in_tangent;
 layout(location = 3) in vec2 in_texCoord;
-
-struct Transform
-{
-    mat4 m4_ModelView;
-    mat4 m4_ModelViewProjection;
-    mat3 m3_Normal; // Normal matrix to transform normals
-};
+#ifdef VARIANT_INSTANCED
+layout(location = 4) in mat4 in_model; // Per-instance model matrix, locations 4 to 7
+#endif
 
 struct render_data
 {
@@ -29,8 +27,10 @@ out vec2 landscape_coord;
 #endif
 
 // UNIFORMS
-uniform Transform tr;
 uniform render_data rd;
+#ifndef VARIANT_INSTANCED
+#include "object_data.glsl"
+#endif
 
 #ifdef VARIANT_SPLAT
 uniform float f_inv_chunk_size;
@@ -38,12 +38,21 @@ uniform float f_inv_chunk_size;
 
 void main()
 {
-    vec4 viewPos   = tr.m4_ModelView * vec4(in_position, 1.0);
+#ifdef VARIANT_INSTANCED
+    mat4 M = in_model;
+#else
+    mat4 M = m4_Model;
+#endif
+    mat4 MV  = m4_View * M;
+    mat4 MVP = m4_ViewProjection * M;
+    mat3 NM  = mat3(MV); // Transposed inverse of MV if non uniform scales
+
+    vec4 viewPos   = MV * vec4(in_position, 1.0);
     vertex_pos  = viewPos.xyz/viewPos.w;
     vertex_texCoord = in_texCoord;
 
-    vec3 N = normalize(tr.m3_Normal * in_normal);
-    vec3 T = normalize(tr.m3_Normal * in_tangent);
+    vec3 N = normalize(NM * in_normal);
+    vec3 T = normalize(NM * in_tangent);
     // re-orthogonalize T with respect to N (Gram-Schmidt process)
     T = normalize(T - dot(T, N)*N);
     vec3 B = -cross(N, T); // Apparently minus is needed for normal/parallax mapping to work correctly
@@ -57,5 +66,5 @@ void main()
     landscape_coord = in_position.xz * f_inv_chunk_size;
     #endif
 
-    gl_Position = tr.m4_ModelViewProjection * vec4(in_position,1.0);
+    gl_Position = MVP * vec4(in_position,1.0);
 }
@@ -0,0 +1,25 @@
+#version 400 core
+
+// Max depth reduction of the G-Buffer depth to the occlusion buffer resolution.
+// Each output texel covers the full footprint of input texels its screen rectangle
+// overlaps, so that the result is conservative.
+
+layout(location = 0) out float out_depth;
+
+uniform sampler2D depthTex;
+uniform vec2 v2_scale; // Input size / output size
+
+void main()
+{
+    ivec2 size = textureSize(depthTex, 0);
+    vec2 texel = floor(gl_FragCoord.xy);
+    ivec2 lo = ivec2(floor(texel*v2_scale));
+    ivec2 hi = min(ivec2(ceil((texel+1.0)*v2_scale)), size);
+
+    float max_depth = 0.0;
+    for(int yy=lo.y; yy<hi.y; ++yy)
+        for(int xx=lo.x; xx<hi.x; ++xx)
+            max_depth = max(max_depth, texelFetch(depthTex, ivec2(xx,yy), 0).r);
+
+    out_depth = max_depth;
+}
@@ -0,0 +1,10 @@
+// Per-frame data shared by all programs, bound to UniformBlock::FRAME
+// Filled by RenderPipeline::update_frame_data(), keep both layouts in sync
+layout(std140) uniform frame_data
+{
+    mat4 m4_View;
+    mat4 m4_Projection;
+    mat4 m4_ViewProjection;
+    vec4 v4_proj_params;   // Position reconstruction (1/P00, 1/P11, P22-1, P23)
+    vec2 v2_screenSize;
+};
@@ -0,0 +1,7 @@
+// Per-object data, bound to UniformBlock::OBJECT
+// Written by GeometryRenderer for all objects of a pass at once, each draw binds
+// its own range. Keep in sync with ObjectData (geometry_renderer.cpp)
+layout(std140) uniform object_data
+{
+    mat4 m4_Model;
+};
@@ -15,8 +15,10 @@ struct render_data
     vec2 v2_screenSize;
     // Shadow
     float f_shadowBias;
-    vec2 v2_shadowTexelSize;
+    vec2 v2_shadowTexelSize;   // Texel size of shadow map atlas
     bool b_shadow_enabled;
+    vec4 v4_cascadeFar;        // View space far distance of each shadow cascade
+    int i_cascadeCount;
     // Ambient occlusion
     bool b_enableSSAO;
     // Reflections
@@ -54,7 +56,18 @@ uniform sampler2D SSRTex;
 
 uniform render_data rd;
 uniform light       lt;
-uniform mat4 m4_LightSpace;
+// Shadow cascades are laid out horizontally in shadow map atlas, see ShadowMapRenderer
+#define MAX_SHADOW_CASCADES 4
+uniform mat4 m4_LightSpace[MAX_SHADOW_CASCADES];
+
+#ifdef VARIANT_TILED
+    // Point light lists, see LightGrid
+    uniform samplerBuffer lightDataTex;   // 2 texels per light: (view position, radius) (color, ambient strength)
+    uniform usamplerBuffer tileTex;       // 1 texel per tile: (offset in index list, light count)
+    uniform usamplerBuffer lightIndexTex; // Light lists of all tiles
+    uniform int i_tileSize;
+    uniform int i_tilesX;
+#endif
 
 // CONSTANTS
 // Relative luminance coefficients for sRGB primaries, values from Wikipedia
@@ -116,23 +129,40 @@ void main()
         float visibility = 1.0f;
         if(rd.b_shadow_enabled)
         {
-            vec4 fragLightSpace = m4_LightSpace * vec4(fragPos, 1.0f);
-            vec3 shadowMapCoords = fragLightSpace.xyz / fragLightSpace.w;
-
-            // Calculate slope factor for slope-scaled depth bias
-            float slopebias = clamp(dot(fragNormal,lt.v3_lightPosition),0.0f,1.0f);
-            slopebias = sqrt(1.0f-slopebias*slopebias)/slopebias; // = tan(acos(slopebias));
+            // Select cascade from view depth
+            int cascade = rd.i_cascadeCount-1;
+            for(int ii=0; ii<rd.i_cascadeCount-1; ++ii)
+            {
+                if(-fragPos.z < rd.v4_cascadeFar[ii])
+                {
+                    cascade = ii;
+                    break;
+                }
+            }
 
-            #ifdef __EXPERIMENTAL_VARIANCE_SHADOW_MAPPING__
-                visibility = shadow_variance(shadowTex, shadowMapCoords);
-            #else
-                //visibility = shadow_amount(shadowTex, shadowMapCoords, rd.f_shadowBias, rd.v2_shadowTexelSize);
-                visibility = shadow_amount_Poisson(shadowTex, shadowMapCoords, fragPos, rd.f_shadowBias*slopebias, rd.v2_shadowTexelSize);
-            #endif
+            vec4 fragLightSpace = m4_LightSpace[cascade] * vec4(fragPos, 1.0f);
+            vec3 shadowMapCoords = fragLightSpace.xyz / fragLightSpace.w;
 
-            // Falloff around map edges
-            float falloff = square_falloff(shadowMapCoords.xy, 0.3f);
-            visibility = mix(1.0f, visibility, smoothstep(0.2f, 0.8f, falloff));
+            if(InRange(shadowMapCoords.x) && InRange(shadowMapCoords.y))
+            {
+                // Cascade coordinates to atlas coordinates
+                vec3 atlasCoords = vec3((shadowMapCoords.x + float(cascade)) / float(rd.i_cascadeCount), shadowMapCoords.yz);
+
+                // Calculate slope factor for slope-scaled depth bias
+                float slopebias = clamp(dot(fragNormal,lt.v3_lightPosition),0.0f,1.0f);
+                slopebias = sqrt(1.0f-slopebias*slopebias)/slopebias; // = tan(acos(slopebias));
+
+                #ifdef __EXPERIMENTAL_VARIANCE_SHADOW_MAPPING__
+                    visibility = shadow_variance(shadowTex, atlasCoords);
+                #else
+                    //visibility = shadow_amount(shadowTex, atlasCoords, rd.f_shadowBias, rd.v2_shadowTexelSize);
+                    visibility = shadow_amount_Poisson(shadowTex, atlasCoords, fragPos, rd.f_shadowBias*slopebias, rd.v2_shadowTexelSize);
+                #endif
+
+                // Falloff around cascade edges
+                float falloff = square_falloff(shadowMapCoords.xy, 0.3f);
+                visibility = mix(1.0f, visibility, smoothstep(0.2f, 0.8f, falloff));
+            }
         }
         if(rd.b_lighting_enabled)
         {
@@ -182,6 +212,32 @@ void main()
         total_light = point_contrib * attenuate(distance, lt.f_light_radius, 3.0f);
     #endif
 
+    // All point lights overlapping this tile
+    #ifdef VARIANT_TILED
+        ivec2 tile = ivec2(gl_FragCoord.xy) / i_tileSize;
+        uvec2 tile_data = texelFetch(tileTex, tile.y*i_tilesX + tile.x).xy;
+        for(uint ii=0u; ii<tile_data.y; ++ii)
+        {
+            int light_index = int(texelFetch(lightIndexTex, int(tile_data.x + ii)).r);
+            vec4 pos_radius = texelFetch(lightDataTex, 2*light_index);
+            vec3 diff = pos_radius.xyz - fragPos;
+            float distance = length(diff);
+            if(distance >= pos_radius.w)
+                continue;
+
+            vec4 color_ambient = texelFetch(lightDataTex, 2*light_index+1);
+            vec3 radiance = CookTorrance(color_ambient.rgb,
+                                         diff / distance,
+                                         fragNormal,
+                                         viewDir,
+                                         fragAlbedo,
+                                         fragMetallic,
+                                         fragRoughness);
+            vec3 ambient = (fragAO * color_ambient.a) * fragAlbedo;
+            total_light += (radiance + ambient) * attenuate(distance, pos_radius.w, 3.0f);
+        }
+    #endif
+
     out_color.rgb = total_light;
 
     // "Bright pass"
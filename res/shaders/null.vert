@@ -1,9 +1,18 @@
 #version 400 core
 layout(location = 0) in vec3 in_position;
+#ifdef VARIANT_INSTANCED
+layout(location = 4) in mat4 in_model; // Per-instance model matrix, locations 4 to 7
 
+uniform mat4 m4_ViewProjection;
+#else
 uniform mat4 m4_ModelViewProjection;
+#endif
 
 void main()
 {
+#ifdef VARIANT_INSTANCED
+    gl_Position = m4_ViewProjection*in_model*vec4(in_position, 1.0);
+#else
     gl_Position = m4_ModelViewProjection*vec4(in_position, 1.0);
+#endif
 }
@@ -30,6 +30,7 @@ class WCSoundEmitter: public WComponent
 {
 public:
     hash_t sound_name;
+    int channel = 0; // Sound system channel, 0 until the sound is played
 };
 
 } // namespace wcore::component
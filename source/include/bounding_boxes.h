@@ -133,6 +133,16 @@ public:
     inline float dist_to_plane(uint32_t index, math::vec3 vPoint) const;
 
     void update(const Camera& camera);
+    // Set frustum from its 8 world space corners, in the RBN, RBF, LBF, LBN, RTN, RTF, LTF, LTN order
+    void update(const std::array<math::vec3, 8>& corners);
+
+    // Compute n_splits+1 split positions along the view axis, as fractions of the [near, far] depth range.
+    // lambda blends the logarithmic (1) and uniform (0) split schemes.
+    void set_splits(uint32_t n_splits, float lambda, float near, float far);
+    inline uint32_t get_split_count() const           { return splits_.size()-1; }
+    inline float get_split(uint32_t index) const      { return splits_[index]; }
+    // Corners of the frustum slice between split positions index and index+1
+    void split_corners(uint32_t splitIndex, std::array<math::vec3, 8>& destination) const;
     math::vec3 split_center(uint32_t splitIndex) const;
 };
 
@@ -40,6 +40,100 @@ public:
     static IndexBuffer* create(uint32_t* index_data, std::size_t size, bool dynamic=false);
 };
 
+// Element format of a texture buffer
+enum class TextureBufferFormat: uint8_t
+{
+    R32UI,
+    RG32UI,
+    RGBA32F
+};
+
+class StreamBuffer;
+// Linear buffer sampled in shaders through a buffer texture (samplerBuffer / usamplerBuffer)
+class TextureBuffer
+{
+public:
+    TextureBuffer() {}
+    virtual ~TextureBuffer() {}
+
+    // Bind buffer texture to a texture unit
+    virtual void bind(uint32_t unit) const = 0;
+    virtual void unbind() const = 0;
+
+    // Replace buffer content, storage grows if needed
+    virtual void stream(const void* data, std::size_t size) = 0;
+    // Sample a range of a stream buffer instead of own storage, until next call to stream().
+    // offset must be a multiple of 256. Returns false if buffer texture ranges are not supported.
+    virtual bool set_source(const StreamBuffer& buffer, std::size_t offset, std::size_t size) = 0;
+
+    static TextureBuffer* create(TextureBufferFormat format, std::size_t size=0);
+};
+
+// Buffer backing a uniform block, shared by all programs declaring this block
+class UniformBuffer
+{
+public:
+    UniformBuffer() {}
+    virtual ~UniformBuffer() {}
+
+    // Bind whole buffer to a uniform block binding point
+    virtual void bind(uint32_t binding) const = 0;
+
+    virtual void stream(const void* data, std::size_t size, std::size_t offset=0) const = 0;
+
+    static UniformBuffer* create(std::size_t size, bool dynamic=true);
+};
+
+// Asynchronous copy of framebuffer pixels to client memory. The transfer is
+// started by read() and can be mapped once is_ready() returns true, typically
+// one or two frames later, so the CPU never waits for the GPU.
+class ReadbackBuffer
+{
+public:
+    ReadbackBuffer() {}
+    virtual ~ReadbackBuffer() {}
+
+    // Start transfer of a rectangle of the first color attachment of the bound framebuffer,
+    // single float channel per pixel, rows bottom to top
+    virtual void read(uint32_t width, uint32_t height) = 0;
+    // Check if last transfer has completed
+    virtual bool is_ready() const = 0;
+    // Map transferred data for reading, nullptr on failure
+    virtual const float* map() = 0;
+    virtual void unmap() = 0;
+
+    static ReadbackBuffer* create(std::size_t size);
+};
+
+// Ring buffer shared by all producers of per-frame dynamic data (instance attributes,
+// per-frame uniforms...). Each frame writes to its own region, a region is reused
+// n_frames later once the GPU is done reading it, so writes never wait for draw calls
+// still in flight. Data written during a frame is valid until the end of this frame.
+class StreamBuffer
+{
+public:
+    static constexpr std::size_t INVALID_OFFSET = std::size_t(-1);
+
+    StreamBuffer() {}
+    virtual ~StreamBuffer() {}
+
+    // Copy data to current frame region, returns its offset in the buffer,
+    // or INVALID_OFFSET if the region is full
+    virtual std::size_t write(const void* data, std::size_t size, std::size_t alignment=16) = 0;
+    // Called once per frame when all draw calls reading this frame data were submitted
+    virtual void next_frame() = 0;
+
+    // Bind as the source of vertex attributes (offsets are passed to the attribute layout)
+    virtual void bind_vertex() const = 0;
+    virtual void unbind_vertex() const = 0;
+    // Bind a range to a uniform block binding point, offset must be a multiple of 256
+    virtual void bind_uniform(uint32_t binding, std::size_t offset, std::size_t size) const = 0;
+
+    virtual std::size_t get_frame_capacity() const = 0;
+
+    static StreamBuffer* create(std::size_t frame_size, uint32_t n_frames=3);
+};
+
 class BufferLayout;
 class VertexArray
 {
@@ -51,6 +145,9 @@ public:
     virtual void unbind() const = 0;
 
     virtual void set_layout(const BufferLayout& layout) const = 0;
+    // Declare per-instance attributes sourced from the currently bound vertex buffer,
+    // starting at attribute location first_location and byte offset offset in this buffer
+    virtual void set_instance_layout(const BufferLayout& layout, uint32_t first_location, std::size_t offset=0) const = 0;
 
     static VertexArray* create();
 };
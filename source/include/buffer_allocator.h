@@ -0,0 +1,64 @@
+#ifndef BUFFER_ALLOCATOR_H
+#define BUFFER_ALLOCATOR_H
+
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace wcore
+{
+
+struct AllocatorStats
+{
+    std::size_t capacity      = 0;
+    std::size_t used          = 0;
+    std::size_t largest_free  = 0; // Largest allocation that can still succeed
+    uint32_t n_allocations    = 0;
+    uint32_t n_free_blocks    = 0;
+
+    inline float occupancy() const { return capacity ? float(used)/capacity : 0.f; }
+    // 0 when all free space is contiguous, close to 1 when it is scattered in small blocks
+    inline float fragmentation() const
+    {
+        std::size_t free = capacity-used;
+        return free ? 1.f-float(largest_free)/free : 0.f;
+    }
+
+    AllocatorStats& operator+=(const AllocatorStats& other);
+};
+
+/*
+    Sub-allocator of a fixed size range, used to place many small buffers in a large
+    GPU buffer. Sizes and offsets are expressed in arbitrary units (bytes, vertices,
+    indices...). Free blocks are kept sorted by offset, allocation is first fit and
+    released blocks are merged with their free neighbors, which keeps fragmentation low
+    when allocations have similar lifetimes.
+*/
+class BufferAllocator
+{
+public:
+    static constexpr std::size_t INVALID_OFFSET = std::size_t(-1);
+
+    explicit BufferAllocator(std::size_t capacity);
+
+    // Returns the offset of a block of requested size, INVALID_OFFSET if no free block is large enough
+    std::size_t allocate(std::size_t size);
+    // Release a block returned by allocate()
+    void release(std::size_t offset);
+
+    inline std::size_t get_capacity() const  { return capacity_; }
+    inline std::size_t get_used() const      { return used_; }
+    inline bool is_empty() const             { return allocations_.empty(); }
+    AllocatorStats get_stats() const;
+
+private:
+    std::size_t capacity_;
+    std::size_t used_;
+    std::map<std::size_t, std::size_t> free_blocks_;           // offset -> size
+    std::unordered_map<std::size_t, std::size_t> allocations_; // offset -> size
+};
+
+} // namespace wcore
+
+#endif // BUFFER_ALLOCATOR_H
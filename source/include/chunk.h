@@ -9,6 +9,7 @@
 #include "render_batch.hpp"
 #include "math3d.h"
 #include "vertex_format.h"
+#include "frustum_culling.h"
 
 namespace wcore
 {
@@ -18,6 +19,8 @@ class Model;
 class LineModel;
 class Camera;
 class Light;
+class HiZBuffer;
+namespace lod { struct LodSelector; }
 struct Vertex3P3N3T2U;
 struct Vertex3P;
 
@@ -69,6 +72,7 @@ private:
     RenderBatch<Vertex3P3N3T2U> blend_render_batch_;
     RenderBatch<Vertex3P>       line_render_batch_;
     pTerrain terrain_;
+    bool uploaded_;
 
     std::vector<pModel> models_;
     std::vector<pModel> models_blend_;
@@ -81,6 +85,10 @@ private:
     std::vector<PositionUpdater*> position_updaters_;
     std::vector<ConstantRotator*> constant_rotators_;
 
+    // Visibility slots: model instances, then opaque models, then blend models
+    CullingBoxes culling_boxes_;
+    VisibilityBitset visibility_;
+
 public:
     Chunk(math::i32vec2 coords);
     ~Chunk();
@@ -102,12 +110,27 @@ public:
 
     void sort_models(pCamera camera);
 
+    // visible_only: skip models that were culled during the last visibility pass
     void traverse_models(ModelVisitor func,
                          ModelEvaluator ifFunc=DEFAULT_MODEL_EVALUATOR,
                          ORDER order=ORDER::IRRELEVANT,
-                         MODEL_CATEGORY model_cat=MODEL_CATEGORY::OPAQUE) const;
+                         MODEL_CATEGORY model_cat=MODEL_CATEGORY::OPAQUE,
+                         bool visible_only=false) const;
+
+    bool visit_model_first(ModelVisitor func, ModelEvaluator ifFunc, bool visible_only=false) const;
+
+    // Visit model instances only, front to back
+    void traverse_model_instances(cModelVisitor func, bool visible_only=false) const;
 
-    bool visit_model_first(ModelVisitor func, ModelEvaluator ifFunc) const;
+    // Size visibility data for current models, return the number of visibility slots
+    uint32_t prepare_culling();
+    // Gather bounding boxes of slots [begin, end) and frustum cull them, then test
+    // the remaining boxes against an occlusion buffer and select their LOD, if any.
+    // Distinct ranges (begin multiple of 64) can be culled concurrently.
+    void cull(const FrustumPlanes& planes, uint32_t begin, uint32_t end,
+              const HiZBuffer* hiz=nullptr, const lod::LodSelector* lods=nullptr);
+    // Models added after the last visibility pass are considered visible
+    inline bool is_visible(uint32_t slot) const { return slot >= visibility_.size() || visibility_.test(slot); }
 
     void traverse_line_models(std::function<void(pLineModel)> func);
 
@@ -116,7 +139,14 @@ public:
     void traverse_lights(cLightVisitor func,
                          cLightEvaluator ifFunc=DEFAULT_CLIGHT_EVALUATOR) const;
 
+    // Submit then upload geometry
     void load_geometry();
+    // Fill render batches (CPU side only)
+    void submit_geometry();
+    // Send render batches to the driver
+    void upload_geometry();
+    // Geometry was uploaded, chunk can be drawn
+    inline bool is_uploaded() const { return uploaded_; }
 
     void draw(const BufferToken& buffer_token) const;
     void update(float dt);
@@ -0,0 +1,191 @@
+#ifndef CHUNK_CACHE_H
+#define CHUNK_CACHE_H
+
+/*
+    ChunkCache bakes the generated content of a chunk to a binary file,
+    one file per chunk. When the chunk is visited again, the file is mapped
+    in memory and its content is used as is, instead of generating it anew.
+
+    As of version 1.1 data is layed out like this:
+    [HEADER]                  -> 128 bytes, padded
+    [array of float]          -> terrain height map, width*length values
+    [array of Vertex3P3N3T2U] -> terrain vertex buffer content (edges not stitched)
+    [array of uint32_t]       -> terrain index buffer content
+    [array of BakedTransform] -> final model transforms, models then batch instances
+    [array of uint32_t]       -> random draws consumed by each batch transform
+    [array of BakedLight]     -> final light parameters
+
+    Header holds a stamp of the level file the chunk was generated from,
+    baked chunks of a modified level are ignored and baked again.
+*/
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "math3d.h"
+#include "io_utils.h"
+#include "vertex_format.h"
+
+namespace fs = std::filesystem;
+
+namespace wcore
+{
+
+class HeightMap;
+template <typename VertexT> class Mesh;
+using SurfaceMesh = Mesh<Vertex3P3N3T2U>;
+
+struct WchkHeader
+{
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    uint64_t source_stamp;
+    int32_t  chunk_x;
+    int32_t  chunk_z;
+    uint32_t hm_width;
+    uint32_t hm_length;
+    float    hm_scale;
+    uint32_t vertex_size;
+    uint32_t n_vertices;
+    uint32_t n_indices;
+    uint32_t n_transforms;
+    uint32_t n_batches;
+    uint32_t n_lights;
+};
+
+// Final transformation of a model, grounded and translated to world space
+struct BakedTransform
+{
+    float position[3];
+    float orientation[4];
+    float scale;
+};
+
+enum BakedLightFlags: uint32_t
+{
+    BAKED_LIGHT_POINT    = 1 << 0, // Directional light otherwise
+    BAKED_LIGHT_DYNAMIC  = 1 << 1  // Has Motion or href, node must be parsed
+};
+
+// Final parameters of a light, grounded and translated to world space
+struct BakedLight
+{
+    uint32_t flags;
+    uint32_t node_index; // Rank of the light node among its siblings
+    float position[3];
+    float color[3];
+    float brightness;
+    float ambient_strength;
+    float radius;
+};
+
+#define WCHK_HEADER_SIZE 128
+typedef union
+{
+    struct WchkHeader h;
+    uint8_t padding[WCHK_HEADER_SIZE];
+} WchkHeaderWrapper;
+
+// Read-only view on a mapped baked chunk file
+class BakedChunk
+{
+public:
+    inline const WchkHeader& get_header() const            { return *header_; }
+    inline const float* get_heights() const                { return heights_; }
+    inline const Vertex3P3N3T2U* get_vertices() const      { return vertices_; }
+    inline const uint32_t* get_indices() const             { return indices_; }
+    inline const BakedTransform* get_transforms() const    { return transforms_; }
+    inline const uint32_t* get_batch_draws() const         { return batch_draws_; }
+    inline const BakedLight* get_lights() const            { return lights_; }
+
+    // Copy baked data to new objects
+    HeightMap* make_heightmap() const;
+    std::shared_ptr<SurfaceMesh> make_terrain_mesh() const;
+
+private:
+    friend class ChunkCache;
+
+    io::MappedFile file_;
+    const WchkHeader* header_ = nullptr;
+    const float* heights_ = nullptr;
+    const Vertex3P3N3T2U* vertices_ = nullptr;
+    const uint32_t* indices_ = nullptr;
+    const BakedTransform* transforms_ = nullptr;
+    const uint32_t* batch_draws_ = nullptr;
+    const BakedLight* lights_ = nullptr;
+};
+
+// Copy of the generated content of a chunk, so that it can be baked
+// by a worker thread while the live terrain is stitched and rendered.
+// Placements are filled by the scene loader as models and lights are created.
+struct ChunkBakeData
+{
+    ChunkBakeData(const math::i32vec2& chunk_coords,
+                  const HeightMap& heightmap,
+                  const SurfaceMesh& terrain_mesh);
+
+    math::i32vec2 chunk_coords;
+    uint32_t hm_width;
+    uint32_t hm_length;
+    float hm_scale;
+    std::vector<float> heights;
+    std::vector<Vertex3P3N3T2U> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<BakedTransform> transforms;
+    std::vector<uint32_t> batch_draws;
+    std::vector<BakedLight> lights;
+};
+
+class ChunkCache
+{
+public:
+    ChunkCache();
+
+    // Set folder to bake chunks to, and identify the level baked chunks must match
+    void init(const fs::path& folder, const std::string& level_name, uint64_t source_stamp);
+    inline bool is_enabled() const { return !folder_.empty(); }
+    inline void disable()          { folder_.clear(); }
+
+    // Map baked chunk, nullptr if chunk was not baked or is stale
+    std::unique_ptr<BakedChunk> fetch(const math::i32vec2& chunk_coords) const;
+    // Check that a valid baked chunk exists, only reads the header
+    bool is_baked(const math::i32vec2& chunk_coords) const;
+    // Bake chunk terrain only, return false on error
+    bool store(const math::i32vec2& chunk_coords,
+               const HeightMap& heightmap,
+               const SurfaceMesh& terrain_mesh) const;
+    // Bake a copy of chunk content, safe to call from a worker thread
+    // as long as init() / disable() are not called concurrently
+    bool store(const ChunkBakeData& data) const;
+    // Delete all baked chunks of current level
+    void clear() const;
+
+    // Stamp of a level file content
+    static uint64_t make_stamp(const std::string& level_content);
+
+private:
+    fs::path get_path(const math::i32vec2& chunk_coords) const;
+    bool header_sanity_check(const WchkHeader& header,
+                             const math::i32vec2& chunk_coords,
+                             size_t file_size) const;
+    bool write_chunk(const math::i32vec2& chunk_coords,
+                     const WchkHeaderWrapper& header,
+                     const float* heights,
+                     const Vertex3P3N3T2U* vertices,
+                     const uint32_t* indices,
+                     const BakedTransform* transforms,
+                     const uint32_t* batch_draws,
+                     const BakedLight* lights) const;
+
+private:
+    fs::path folder_;
+    std::string level_name_;
+    uint64_t source_stamp_;
+};
+
+} // namespace wcore
+
+#endif // CHUNK_CACHE_H
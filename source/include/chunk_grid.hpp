@@ -0,0 +1,180 @@
+#ifndef CHUNK_GRID_HPP
+#define CHUNK_GRID_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+#include "math3d.h"
+
+namespace wcore
+{
+
+// Chunk coordinates are biased and packed in 16 bits each, so that the index is exact
+// (no collision) for coordinates in [-32767, 32767], and never 0 (0 means "no chunk").
+inline uint32_t coords_to_chunk_index(const math::i32vec2& coords)
+{
+    return (uint32_t(uint16_t(coords.x()+32768)) << 16) | uint32_t(uint16_t(coords.y()+32768));
+}
+
+inline math::i32vec2 chunk_index_to_coords(uint32_t index)
+{
+    return math::i32vec2(int32_t(index >> 16) - 32768, int32_t(index & 0xffff) - 32768);
+}
+
+/*
+    Container for loaded chunks, keyed by chunk index.
+    Values are stored contiguously (in no particular order) for fast traversal, and located
+    through an open addressing table (linear probing, power of two size) indexed by a mix of
+    the exact chunk index. Removal swaps the last value in the hole and uses backward shift
+    deletion in the table, so there are no tombstones and lookups stay short.
+    Neighbor lookups are plain find() calls on the neighbor index.
+*/
+template <typename ValueT>
+class ChunkGrid
+{
+public:
+    struct Entry
+    {
+        uint32_t index;
+        ValueT value;
+    };
+
+    typedef typename std::vector<Entry>::iterator iterator;
+    typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+    ChunkGrid():
+    slots_(16, EMPTY)
+    {}
+
+    inline uint32_t size() const { return uint32_t(entries_.size()); }
+    inline bool empty() const    { return entries_.empty(); }
+
+    inline iterator begin()             { return entries_.begin(); }
+    inline iterator end()               { return entries_.end(); }
+    inline const_iterator begin() const { return entries_.begin(); }
+    inline const_iterator end() const   { return entries_.end(); }
+
+    // Returns a pointer to the value, nullptr if no such chunk
+    inline ValueT* find(uint32_t index)
+    {
+        uint32_t slot = find_slot(index);
+        return (slots_[slot]==EMPTY) ? nullptr : &entries_[slots_[slot]].value;
+    }
+    inline const ValueT* find(uint32_t index) const
+    {
+        uint32_t slot = find_slot(index);
+        return (slots_[slot]==EMPTY) ? nullptr : &entries_[slots_[slot]].value;
+    }
+    inline bool contains(uint32_t index) const { return find(index) != nullptr; }
+    // Chunk must exist
+    inline ValueT& at(uint32_t index)
+    {
+        ValueT* value = find(index);
+        assert(value && "[ChunkGrid] No such chunk.");
+        return *value;
+    }
+    inline const ValueT& at(uint32_t index) const
+    {
+        const ValueT* value = find(index);
+        assert(value && "[ChunkGrid] No such chunk.");
+        return *value;
+    }
+
+    // Returns false if the index is already present
+    bool insert(uint32_t index, const ValueT& value);
+    // Returns false if the index is not present
+    bool erase(uint32_t index);
+    inline void clear()
+    {
+        entries_.clear();
+        std::fill(slots_.begin(), slots_.end(), EMPTY);
+    }
+
+private:
+    static constexpr uint32_t EMPTY = uint32_t(-1);
+
+    inline uint32_t mask() const { return uint32_t(slots_.size()-1); }
+    // Neighbor chunks have close indices, mix bits to spread them
+    inline uint32_t home_slot(uint32_t index) const { return (index*0x9E3779B1u >> 7) & mask(); }
+    // Slot holding index, or the empty slot ending its probe sequence
+    inline uint32_t find_slot(uint32_t index) const
+    {
+        uint32_t slot = home_slot(index);
+        while(slots_[slot]!=EMPTY && entries_[slots_[slot]].index!=index)
+            slot = (slot+1) & mask();
+        return slot;
+    }
+    void rehash(uint32_t n_slots);
+
+private:
+    std::vector<Entry> entries_;  // Contiguous values
+    std::vector<uint32_t> slots_; // Position in entries_, or EMPTY
+};
+
+template <typename ValueT>
+bool ChunkGrid<ValueT>::insert(uint32_t index, const ValueT& value)
+{
+    // Keep load factor under 1/2
+    if(2*(entries_.size()+1) > slots_.size())
+        rehash(2*uint32_t(slots_.size()));
+
+    uint32_t slot = find_slot(index);
+    if(slots_[slot] != EMPTY)
+        return false;
+
+    slots_[slot] = uint32_t(entries_.size());
+    entries_.push_back({index, value});
+    return true;
+}
+
+template <typename ValueT>
+bool ChunkGrid<ValueT>::erase(uint32_t index)
+{
+    uint32_t slot = find_slot(index);
+    if(slots_[slot] == EMPTY)
+        return false;
+
+    // * Move last entry to the hole
+    uint32_t position = slots_[slot];
+    uint32_t last = uint32_t(entries_.size()-1);
+    if(position != last)
+    {
+        slots_[find_slot(entries_[last].index)] = position;
+        entries_[position] = entries_[last];
+    }
+    entries_.pop_back();
+
+    // * Backward shift deletion: pull following entries of the cluster that
+    // can legally move to the hole
+    uint32_t hole = slot;
+    uint32_t next = (hole+1) & mask();
+    while(slots_[next] != EMPTY)
+    {
+        uint32_t home = home_slot(entries_[slots_[next]].index);
+        // Entry can move if its home slot is not in (hole, next] (cyclically)
+        bool in_range = (hole <= next) ? (hole < home && home <= next)
+                                       : (hole < home || home <= next);
+        if(!in_range)
+        {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+        next = (next+1) & mask();
+    }
+    slots_[hole] = EMPTY;
+    return true;
+}
+
+template <typename ValueT>
+void ChunkGrid<ValueT>::rehash(uint32_t n_slots)
+{
+    slots_.assign(n_slots, EMPTY);
+    for(uint32_t ii=0; ii<entries_.size(); ++ii)
+        slots_[find_slot(entries_[ii].index)] = ii;
+}
+
+} // namespace wcore
+
+#endif // CHUNK_GRID_HPP
@@ -1,6 +1,9 @@
 #ifndef CHUNK_MANAGER_H
 #define CHUNK_MANAGER_H
 
+#include <deque>
+#include <memory>
+
 #include "game_system.h"
 #include "math3d.h"
 
@@ -11,6 +14,7 @@ namespace wcore
 #define __OPT_CHUNK_LOAD_FULL_DISK__
 
 class InputHandler;
+class JobCounter;
 class ChunkManager: public GameSystem
 {
 private:
@@ -24,8 +28,30 @@ private:
     uint32_t last_chunk_;
 #endif
 
+    // * Streaming
+    // Chunk load requests, nearest to predicted camera position first
+    std::deque<math::i32vec2> load_queue_;
+    // Chunks whose render batches are being filled by a worker thread
+    struct StreamingChunk
+    {
+        uint32_t chunk_index;
+        std::unique_ptr<JobCounter> submit_job;
+    };
+    std::deque<StreamingChunk> upload_queue_;
+    float stream_budget_ms_;    // Max time spent loading / uploading chunks per frame
+    float prefetch_horizon_s_;  // How far ahead camera position is extrapolated for prefetching
+    math::vec3 last_cam_pos_;
+    math::vec3 cam_velocity_;
+    math::i32vec2 predicted_coords_;
+    uint32_t last_prefetch_chunk_;
+    // Chunks to prefetch, nearest to predicted camera position first
+    std::deque<math::i32vec2> prefetch_queue_;
+    uint32_t max_prefetch_jobs_; // Max prefetch jobs in flight
 
 public:
+    // Terrain chunks are geomipmapped, far chunks are cheap enough to load up to the far plane
+    static constexpr uint8_t MAX_VIEW_RADIUS = 16;
+
     ChunkManager();
     ~ChunkManager();
 
@@ -38,7 +64,20 @@ public:
 
     inline void toggle() { active_ = !active_; }
 
+    // Wait for streaming jobs and remove chunks not uploaded yet
+    void cancel_streaming();
+
 private:
+    // Load chunk on this thread, fill its render batches on a worker thread
+    void stream_chunk(const math::i32vec2& chunk_coords);
+    // Wait for chunk submission job if any and remove it from the upload queue
+    void finish_streaming(uint32_t chunk_index);
+    // Extrapolate camera position and generate terrain of upcoming chunks in the background
+    void prefetch(const math::vec3& cam_pos, float dt);
+    // Load queued chunks and upload finished ones within frame budget
+    // return true if some chunk became drawable
+    bool process_queues();
+
     // calculate binary coding for chunk quadrant partition
     // given normalized centered local coordinates
     inline uint8_t quadrant(const math::vec2& lcp)
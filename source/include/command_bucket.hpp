@@ -0,0 +1,195 @@
+#ifndef COMMAND_BUCKET_HPP
+#define COMMAND_BUCKET_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace wcore
+{
+
+class Model;
+class Chunk;
+
+// Draw command for opaque geometry, chunk is null for entity models
+struct DrawCommand
+{
+    const Model* model;
+    const Chunk* chunk;
+};
+
+/*
+    64 bits draw command sort key, most significant bits first:
+    [pass:4][shader:8][material:20][depth:16][VAO:16]
+    Sorting commands by key groups draws by render state, the most expensive state
+    changes (shader, then material / textures) being the least frequent. Within a state
+    group, commands are ordered by quantized depth, then by vertex array.
+*/
+namespace sort_key
+{
+    static constexpr uint32_t PASS_BITS     = 4;
+    static constexpr uint32_t SHADER_BITS   = 8;
+    static constexpr uint32_t MATERIAL_BITS = 20;
+    static constexpr uint32_t DEPTH_BITS    = 16;
+    static constexpr uint32_t VAO_BITS      = 16;
+
+    static constexpr uint32_t VAO_SHIFT      = 0;
+    static constexpr uint32_t DEPTH_SHIFT    = VAO_SHIFT + VAO_BITS;
+    static constexpr uint32_t MATERIAL_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+    static constexpr uint32_t SHADER_SHIFT   = MATERIAL_SHIFT + MATERIAL_BITS;
+    static constexpr uint32_t PASS_SHIFT     = SHADER_SHIFT + SHADER_BITS;
+
+    static_assert(PASS_SHIFT + PASS_BITS == 64, "Sort key fields must fill 64 bits.");
+
+    // Pass ids, in execution order
+    enum Pass: uint32_t
+    {
+        PASS_GBUFFER = 0,
+        PASS_SHADOW  = 1,
+        PASS_FORWARD = 2
+    };
+
+    inline constexpr uint64_t field(uint64_t value, uint32_t bits, uint32_t shift)
+    {
+        return (value & ((uint64_t(1) << bits) - 1)) << shift;
+    }
+
+    // Values are truncated to their field width
+    inline constexpr uint64_t make(uint32_t pass, uint32_t shader, uint32_t material, uint32_t depth, uint32_t vao)
+    {
+        return field(pass,     PASS_BITS,     PASS_SHIFT)
+             | field(shader,   SHADER_BITS,   SHADER_SHIFT)
+             | field(material, MATERIAL_BITS, MATERIAL_SHIFT)
+             | field(depth,    DEPTH_BITS,    DEPTH_SHIFT)
+             | field(vao,      VAO_BITS,      VAO_SHIFT);
+    }
+
+    inline constexpr uint32_t get_pass(uint64_t key)
+    {
+        return uint32_t((key >> PASS_SHIFT) & ((uint64_t(1) << PASS_BITS) - 1));
+    }
+
+    inline constexpr uint32_t get_shader(uint64_t key)
+    {
+        return uint32_t((key >> SHADER_SHIFT) & ((uint64_t(1) << SHADER_BITS) - 1));
+    }
+
+    inline constexpr uint32_t get_material(uint64_t key)
+    {
+        return uint32_t((key >> MATERIAL_SHIFT) & ((uint64_t(1) << MATERIAL_BITS) - 1));
+    }
+
+    // Quantize a normalized depth in [0,1], invert for back to front ordering
+    inline uint32_t quantize_depth(float depth, bool back_to_front=false)
+    {
+        depth = std::min(std::max(depth, 0.f), 1.f);
+        if(back_to_front)
+            depth = 1.f - depth;
+        return uint32_t(depth * float((1u << DEPTH_BITS) - 1));
+    }
+
+    // Fold a hash value to a material id
+    inline constexpr uint32_t fold_material(std::size_t hash)
+    {
+        uint64_t h = uint64_t(hash);
+        h ^= (h >> 40) ^ (h >> 20);
+        return uint32_t(h & ((uint64_t(1) << MATERIAL_BITS) - 1));
+    }
+} // namespace sort_key
+
+/*
+    A CommandBucket collects draw commands along with their sort keys, sorts them with
+    a LSD radix sort, and executes them in key order. Commands with equal keys are
+    executed in submission order (the sort is stable).
+    Submitting commands does not touch the graphics API, so a bucket can be filled
+    from any thread as long as a single thread submits to it at a time.
+*/
+template <typename CommandT>
+class CommandBucket
+{
+public:
+    CommandBucket() = default;
+
+    inline void reserve(std::size_t capacity)
+    {
+        commands_.reserve(capacity);
+        entries_.reserve(capacity);
+        scratch_.reserve(capacity);
+    }
+
+    // Remove all commands, storage is kept for next frame
+    inline void clear()
+    {
+        commands_.clear();
+        entries_.clear();
+    }
+
+    inline void submit(uint64_t key, const CommandT& command)
+    {
+        entries_.push_back({key, uint32_t(commands_.size())});
+        commands_.push_back(command);
+    }
+
+    inline std::size_t size() const { return entries_.size(); }
+    inline bool empty() const       { return entries_.empty(); }
+
+    // Sort commands by key
+    void sort()
+    {
+        const std::size_t count = entries_.size();
+        if(count < 2)
+            return;
+
+        // * Histograms of all 8 key bytes in a single pass
+        uint32_t histograms[8][256] = {};
+        for(auto&& entry: entries_)
+            for(uint32_t bb=0; bb<8; ++bb)
+                ++histograms[bb][(entry.key >> (8*bb)) & 0xff];
+
+        // * One counting sort pass per byte, least significant first.
+        // Bytes that are the same in all keys are skipped.
+        scratch_.resize(count);
+        for(uint32_t bb=0; bb<8; ++bb)
+        {
+            uint32_t* histogram = histograms[bb];
+            if(histogram[(entries_[0].key >> (8*bb)) & 0xff] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for(uint32_t ii=0; ii<256; ++ii)
+            {
+                uint32_t n = histogram[ii];
+                histogram[ii] = offset;
+                offset += n;
+            }
+            for(auto&& entry: entries_)
+                scratch_[histogram[(entry.key >> (8*bb)) & 0xff]++] = entry;
+            std::swap(entries_, scratch_);
+        }
+    }
+
+    // Visit commands in key order: func(key, command)
+    template <typename FuncT>
+    void execute(FuncT func) const
+    {
+        for(auto&& entry: entries_)
+            func(entry.key, commands_[entry.index]);
+    }
+
+    inline uint64_t get_key(std::size_t ii) const { return entries_[ii].key; }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t index; // Index in commands_
+    };
+
+    std::vector<CommandT> commands_; // Submission order
+    std::vector<Entry> entries_;     // Key order after sort()
+    std::vector<Entry> scratch_;     // Radix sort double buffer
+};
+
+} // namespace wcore
+
+#endif // COMMAND_BUCKET_HPP
@@ -5,6 +5,7 @@
 #include <typeindex>
 
 #include "error.h"
+#include "entity_registry.h"
 
 namespace wcore
 {
@@ -20,6 +21,9 @@ namespace detail
 {
     typedef WComponent* (*CreateComponentFunc)();
     typedef std::unordered_map<std::type_index, CreateComponentFunc> ComponentRegistry;
+    // Copy a blueprint component into archetype storage
+    typedef void (*CopyComponentFunc)(EntityRegistry&, EntityHandle, const WComponent*);
+    typedef std::unordered_map<std::type_index, CopyComponentFunc> ComponentCopyRegistry;
 
     inline ComponentRegistry& getComponentRegistry()
     {
@@ -27,6 +31,12 @@ namespace detail
         return reg;
     }
 
+    inline ComponentCopyRegistry& getComponentCopyRegistry()
+    {
+        static ComponentCopyRegistry reg;
+        return reg;
+    }
+
     //TODO: TEMPLATE THIS WITH ALLOCATOR TYPE, WE WANT TO ENSURE BLOCK ALLOCATION!!!
     template<class T>
     WComponent* createComponent()
@@ -34,6 +44,14 @@ namespace detail
         return new T;
     }
 
+    template<class T>
+    void copyComponent(EntityRegistry& registry, EntityHandle handle, const WComponent* src)
+    {
+        // Stored components have no parent WEntity
+        T* component = registry.add<T>(handle, *static_cast<const T*>(src));
+        component->parent_ = nullptr;
+    }
+
     template<class T>
     struct RegistryEntry
     {
@@ -64,6 +82,7 @@ namespace detail
                 // this name.
                 fatal("Commponent already defined: type_index= " + std::string(type.name()));
             }
+            getComponentCopyRegistry().insert(ComponentCopyRegistry::value_type(type, copyComponent<T>));
         }
 
         RegistryEntry(const RegistryEntry<T>&)            = delete;
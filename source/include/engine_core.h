@@ -42,6 +42,8 @@ public:
 
     inline void register_initializer_system(hash_t name, InitializerSystem* system) { game_systems_.register_initializer_system(name, system); }
     inline void register_game_system(hash_t name, GameSystem* system)               { game_systems_.register_game_system(name, system, handler_); }
+    inline void add_system_dependency(hash_t name, hash_t dependency)               { game_systems_.add_dependency(name, dependency); }
+    inline void set_system_worker_update(hash_t name, bool value=true)              { game_systems_.set_worker_update(name, value); }
     inline void init_game_systems()           { game_systems_.init_game_systems(); }
     inline void init_system_parameters()      { game_systems_.init(); }
     inline void serialize_system_parameters() { game_systems_.serialize(); }
@@ -0,0 +1,259 @@
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <cstdint>
+#include <cassert>
+
+namespace wcore
+{
+
+// Dense entity id, the generation tells a recycled slot from the entity that used it before
+struct EntityHandle
+{
+    static constexpr uint32_t INVALID_INDEX = uint32_t(-1);
+
+    uint32_t index      = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    inline bool is_valid() const { return index != INVALID_INDEX; }
+    inline bool operator==(const EntityHandle& other) const { return index==other.index && generation==other.generation; }
+    inline bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+namespace detail
+{
+    static constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+
+    inline uint32_t next_component_type_id()
+    {
+        static uint32_t id = 0;
+        assert(id < MAX_COMPONENT_TYPES && "[EntityRegistry] Too many component types.");
+        return id++;
+    }
+
+    // Type erased component array of an archetype
+    struct ColumnBase
+    {
+        virtual ~ColumnBase() = default;
+        // Empty column of the same component type
+        virtual std::unique_ptr<ColumnBase> make_empty() const = 0;
+        // Move component at given row to the end of another column of the same type
+        virtual void move_append(uint32_t row, ColumnBase& other) = 0;
+        // Replace component at given row by the last one
+        virtual void swap_remove(uint32_t row) = 0;
+    };
+
+    template <typename T>
+    struct Column: public ColumnBase
+    {
+        std::vector<T> data;
+
+        virtual std::unique_ptr<ColumnBase> make_empty() const override
+        {
+            return std::make_unique<Column<T>>();
+        }
+        virtual void move_append(uint32_t row, ColumnBase& other) override
+        {
+            static_cast<Column<T>&>(other).data.push_back(std::move(data[row]));
+        }
+        virtual void swap_remove(uint32_t row) override
+        {
+            if(row+1 != data.size())
+                data[row] = std::move(data.back());
+            data.pop_back();
+        }
+    };
+} // namespace detail
+
+// Small sequential id per component type, used as a bit in archetype signatures
+template <typename T>
+inline uint32_t component_type_id()
+{
+    static const uint32_t id = detail::next_component_type_id();
+    return id;
+}
+
+/*
+    Archetype based component storage.
+    Entities sharing the same set of component types (an archetype) are stored together,
+    each component type in its own contiguous array, so that a query visits components
+    linearly instead of doing a lookup per entity and per component. Adding or removing a
+    component moves the entity to another archetype (its components are moved, pointers
+    to them are invalidated).
+    Entity handles are dense indices into a record table, with a generation counter so
+    that a handle to a destroyed entity is detected after its slot is reused.
+    The structure version is bumped whenever entities are created, destroyed or change
+    archetype, so that systems can cache query results until it changes.
+    Structural changes are forbidden during a query.
+*/
+class EntityRegistry
+{
+public:
+    EntityRegistry();
+    ~EntityRegistry();
+
+    EntityHandle create();
+    // Returns false if the handle is stale
+    bool destroy(EntityHandle handle);
+    void clear();
+
+    inline bool is_alive(EntityHandle handle) const
+    {
+        return handle.index < records_.size() && records_[handle.index].generation == handle.generation
+            && records_[handle.index].archetype != INVALID_ARCHETYPE;
+    }
+    // Number of live entities
+    inline uint32_t size() const              { return uint32_t(records_.size() - free_indices_.size()); }
+    inline uint32_t get_archetype_count() const { return uint32_t(archetypes_.size()); }
+    inline uint64_t get_structure_version() const { return structure_version_; }
+
+    // Construct a component in place, if the entity already has one it is returned untouched
+    template <typename T, typename... ArgsT>
+    T* add(EntityHandle handle, ArgsT&&... args);
+    // Returns false if the entity has no such component
+    template <typename T>
+    bool remove(EntityHandle handle);
+    // Returns nullptr if the entity has no such component
+    template <typename T>
+    T* get(EntityHandle handle);
+    template <typename T>
+    inline bool has(EntityHandle handle) const
+    {
+        assert(is_alive(handle) && "[EntityRegistry] Stale entity handle.");
+        return archetypes_[records_[handle.index].archetype]->signature & signature_of<T>();
+    }
+
+    // Visit all entities having (at least) the given components: func(EntityHandle, ComponentsT&...)
+    template <typename... ComponentsT, typename FuncT>
+    void query(FuncT func);
+    // Number of entities having (at least) the given components
+    template <typename... ComponentsT>
+    uint32_t count() const;
+
+private:
+    static constexpr uint32_t INVALID_ARCHETYPE = uint32_t(-1);
+
+    struct Archetype
+    {
+        uint64_t signature = 0;
+        std::vector<EntityHandle> entities; // Row to entity
+        std::unique_ptr<detail::ColumnBase> columns[detail::MAX_COMPONENT_TYPES]; // By component type id
+
+        template <typename T>
+        inline std::vector<T>& column()
+        {
+            return static_cast<detail::Column<T>*>(columns[component_type_id<T>()].get())->data;
+        }
+    };
+
+    struct Record
+    {
+        uint32_t generation = 0;
+        uint32_t archetype  = INVALID_ARCHETYPE;
+        uint32_t row        = 0;
+    };
+
+    template <typename... ComponentsT>
+    static inline uint64_t signature_of() { return (0ull | ... | (1ull << component_type_id<ComponentsT>())); }
+
+    // Existing archetype with this signature or a new one whose columns are cloned from a
+    // source archetype. Component types that are not in the source must be added by the caller.
+    uint32_t get_archetype(uint64_t signature, uint32_t source, bool& created);
+    // Move an entity row to another archetype, components absent from the target are destroyed
+    void move_entity(EntityHandle handle, uint32_t target);
+    // Remove a row by swapping the last one in, and fix the moved entity record
+    void remove_row(Archetype& archetype, uint32_t row);
+
+private:
+    std::vector<std::unique_ptr<Archetype>> archetypes_;
+    std::unordered_map<uint64_t, uint32_t> archetype_index_; // Signature to archetype
+    std::vector<Record> records_;                             // By entity index
+    std::vector<uint32_t> free_indices_;                      // Recycled entity indices
+    uint64_t structure_version_;
+};
+
+template <typename T, typename... ArgsT>
+T* EntityRegistry::add(EntityHandle handle, ArgsT&&... args)
+{
+    assert(is_alive(handle) && "[EntityRegistry] Stale entity handle.");
+    uint32_t id = component_type_id<T>();
+    uint32_t source = records_[handle.index].archetype;
+    uint64_t signature = archetypes_[source]->signature;
+    if(signature & (1ull << id))
+        return &archetypes_[source]->column<T>()[records_[handle.index].row];
+
+    bool created = false;
+    uint32_t target = get_archetype(signature | (1ull << id), source, created);
+    Archetype& arch = *archetypes_[target];
+    if(created)
+        arch.columns[id] = std::make_unique<detail::Column<T>>();
+
+    // Component of the new type is constructed first, so that rows stay aligned
+    std::vector<T>& column = arch.column<T>();
+    column.emplace_back(std::forward<ArgsT>(args)...);
+    move_entity(handle, target);
+    return &column.back();
+}
+
+template <typename T>
+bool EntityRegistry::remove(EntityHandle handle)
+{
+    assert(is_alive(handle) && "[EntityRegistry] Stale entity handle.");
+    uint32_t id = component_type_id<T>();
+    uint32_t source = records_[handle.index].archetype;
+    uint64_t signature = archetypes_[source]->signature;
+    if(!(signature & (1ull << id)))
+        return false;
+
+    bool created = false;
+    uint32_t target = get_archetype(signature & ~(1ull << id), source, created);
+    move_entity(handle, target);
+    return true;
+}
+
+template <typename T>
+T* EntityRegistry::get(EntityHandle handle)
+{
+    assert(is_alive(handle) && "[EntityRegistry] Stale entity handle.");
+    const Record& record = records_[handle.index];
+    Archetype& arch = *archetypes_[record.archetype];
+    if(!(arch.signature & signature_of<T>()))
+        return nullptr;
+    return &arch.column<T>()[record.row];
+}
+
+template <typename... ComponentsT, typename FuncT>
+void EntityRegistry::query(FuncT func)
+{
+    const uint64_t mask = signature_of<ComponentsT...>();
+    for(auto&& arch: archetypes_)
+    {
+        if((arch->signature & mask) != mask || arch->entities.empty())
+            continue;
+
+        // Column base pointers are fetched once per archetype
+        auto columns = std::make_tuple(arch->template column<ComponentsT>().data()...);
+        const uint32_t n_rows = uint32_t(arch->entities.size());
+        for(uint32_t row=0; row<n_rows; ++row)
+            func(arch->entities[row], std::get<ComponentsT*>(columns)[row]...);
+    }
+}
+
+template <typename... ComponentsT>
+uint32_t EntityRegistry::count() const
+{
+    const uint64_t mask = signature_of<ComponentsT...>();
+    uint32_t total = 0;
+    for(auto&& arch: archetypes_)
+        if((arch->signature & mask) == mask)
+            total += uint32_t(arch->entities.size());
+    return total;
+}
+
+} // namespace wcore
+
+#endif // ENTITY_REGISTRY_H
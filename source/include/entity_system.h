@@ -1,8 +1,12 @@
 #ifndef ENTITY_SYSTEM_H
 #define ENTITY_SYSTEM_H
 
+#include <vector>
+#include <mutex>
+
 #include "game_system.h"
 #include "wentity.h"
+#include "entity_registry.h"
 
 namespace wcore
 {
@@ -15,16 +19,25 @@ public:
     virtual void init_self() override;
     virtual void update(const GameClock& clock) override;
 
-    uint64_t add_entity(std::shared_ptr<WEntity> entity);
+    // Queue an entity for creation from a blueprint. Its components are copied to
+    // archetype storage at the start of the next update, so that callers on other
+    // threads never reallocate component columns while they are being queried.
+    void add_entity(std::shared_ptr<WEntity> blueprint);
+    // Queue an entity for destruction at the start of the next update
+    void remove_entity(EntityHandle handle);
 
-    inline WEntity& get_entity(uint64_t id) { return *entities_.at(id); }
+    inline EntityRegistry& get_registry() { return registry_; }
 
 private:
-    inline uint64_t get_unique_id() { return unique_id_++; }
+    // Apply queued creations and destructions to the registry
+    void flush_pending();
 
 private:
-    std::map<uint64_t, std::shared_ptr<WEntity>> entities_;
-    uint64_t unique_id_; // Current unique entity id
+    EntityRegistry registry_;
+
+    std::mutex pending_mutex_;
+    std::vector<std::shared_ptr<WEntity>> pending_creations_;
+    std::vector<EntityHandle> pending_destructions_;
 
 };
 
@@ -0,0 +1,161 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <new>
+#include <cstddef>
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+#include "message.h"
+#include "mpsc_ring_buffer.hpp"
+
+namespace wcore
+{
+
+/*
+    Deferred event: a channel and a copy of the event data, stored in place.
+    Records live in the cells of the event queue, so queuing an event does not allocate
+    (unless the event data itself does). The concrete event type is remembered by
+    a small operation table, used to move, destroy and read back the data as WData.
+*/
+class EventRecord
+{
+public:
+    static constexpr size_t CAPACITY = 128;
+
+    EventRecord() = default;
+
+    template <typename T,
+              typename = typename std::enable_if<std::is_base_of<WData,typename std::decay<T>::type>::value >::type>
+    EventRecord(hash_t channel, T&& data):
+    channel_(channel),
+    ops_(&Ops<typename std::decay<T>::type>::table)
+    {
+        typedef typename std::decay<T>::type DataT;
+        static_assert(sizeof(DataT) <= CAPACITY, "EventRecord: event data too large to be deferred.");
+        static_assert(alignof(DataT) <= alignof(std::max_align_t), "EventRecord: event data over-aligned.");
+        new(&storage_) DataT(std::forward<T>(data));
+    }
+
+    EventRecord(EventRecord&& other):
+    channel_(other.channel_),
+    ops_(other.ops_)
+    {
+        if(ops_)
+            ops_->move(&storage_, &other.storage_);
+        other.ops_ = nullptr;
+    }
+
+    EventRecord& operator=(EventRecord&& other)
+    {
+        if(this != &other)
+        {
+            reset();
+            channel_ = other.channel_;
+            ops_ = other.ops_;
+            if(ops_)
+                ops_->move(&storage_, &other.storage_);
+            other.ops_ = nullptr;
+        }
+        return *this;
+    }
+
+    EventRecord(const EventRecord&) = delete;
+    EventRecord& operator=(const EventRecord&) = delete;
+
+    ~EventRecord() { reset(); }
+
+    inline bool is_valid() const     { return ops_ != nullptr; }
+    inline hash_t get_channel() const { return channel_; }
+    inline WData& get_data()          { return *ops_->as_data(&storage_); }
+
+    inline void reset()
+    {
+        if(ops_)
+            ops_->destroy(&storage_);
+        ops_ = nullptr;
+    }
+
+private:
+    struct OpTable
+    {
+        void (*move)(void* dst, void* src); // Move construct into dst and destroy src
+        void (*destroy)(void* ptr);
+        WData* (*as_data)(void* ptr);
+    };
+
+    template <typename DataT>
+    struct Ops
+    {
+        static void move(void* dst, void* src)
+        {
+            new(dst) DataT(std::move(*static_cast<DataT*>(src)));
+            static_cast<DataT*>(src)->~DataT();
+        }
+        static void destroy(void* ptr)     { static_cast<DataT*>(ptr)->~DataT(); }
+        static WData* as_data(void* ptr)   { return static_cast<DataT*>(ptr); }
+
+        static constexpr OpTable table = {&move, &destroy, &as_data};
+    };
+
+    hash_t channel_ = 0;
+    const OpTable* ops_ = nullptr; // nullptr when the record holds no event
+    typename std::aligned_storage<CAPACITY, alignof(std::max_align_t)>::type storage_;
+};
+
+/*
+    Per-frame queue of deferred events. Any thread can push, a single thread (the one that
+    owns the informer, usually the main thread) dispatches them in bulk at sync points.
+    Events pushed during a dispatch are kept for the next one.
+*/
+class EventQueue
+{
+public:
+    // Capacity must be a power of 2
+    explicit EventQueue(size_t capacity):
+    ring_(capacity),
+    n_popped_(0),
+    n_dropped_(0)
+    {}
+
+    // Any thread. Returns false and drops the event if the queue is full.
+    inline bool push(EventRecord&& record)
+    {
+        if(ring_.try_push(std::move(record)))
+            return true;
+        n_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Consumer thread only. Visit the events pushed before the call, in order.
+    template <typename FuncT>
+    uint32_t consume(FuncT func)
+    {
+        size_t n_pushed = ring_.get_push_count();
+        uint32_t count = 0;
+        EventRecord record;
+        // A producer may still be writing a reserved cell, its event is delivered next time
+        while(n_popped_ < n_pushed && ring_.try_pop(record))
+        {
+            ++n_popped_;
+            ++count;
+            func(record);
+            record.reset();
+        }
+        return count;
+    }
+
+    inline size_t get_dropped_count() const { return n_dropped_.load(std::memory_order_relaxed); }
+    inline size_t get_capacity() const      { return ring_.get_capacity(); }
+
+private:
+    MPSCRingBuffer<EventRecord> ring_;
+    size_t n_popped_;
+    std::atomic<size_t> n_dropped_;
+};
+
+} // namespace wcore
+
+#endif // EVENT_QUEUE_H
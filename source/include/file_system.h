@@ -6,6 +6,7 @@
 
 #include "wtypes.h"
 #include "singleton.hpp"
+#include "io_utils.h"
 
 namespace fs = std::filesystem;
 
@@ -39,6 +40,15 @@ public:
     std::string get_file_as_string(const char* filename,
                                    hash_t folder_node,
                                    hash_t archive);
+    // Map file specifying a physical file path
+    io::FileView map_file(const fs::path& file_path);
+    // Map file from archive, only works for stored (uncompressed) entries
+    io::FileView map_file(const char* virtual_path, hash_t archive);
+    // Map file, try from folder first then archive. An invalid view is returned
+    // if the file is compressed inside the archive, use a stream in that case.
+    io::FileView map_file(const char* filename,
+                          hash_t folder_node,
+                          hash_t archive);
     // Just check if file exists in folder or in archive
     bool file_exists(const char* filename,
                      hash_t folder_node,
@@ -3,6 +3,7 @@
 
 #include "renderer.h"
 #include "shader.h"
+#include "command_bucket.hpp"
 
 namespace wcore
 {
@@ -13,6 +14,7 @@ class ForwardRenderer : public Renderer
 private:
     Shader forward_stage_shader_;
     Shader skybox_shader_;
+    CommandBucket<DrawCommand> transparent_bucket_;
 
 public:
     ForwardRenderer();
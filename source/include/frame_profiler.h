@@ -0,0 +1,148 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+#include "singleton.hpp"
+#include "moving_average.h"
+
+namespace fs = std::filesystem;
+
+namespace wcore
+{
+
+/*
+    FrameProfiler records timed scopes (markers) into a ring buffer of frames.
+    CPU markers can be used from any thread and nested, GPU markers (see GPUProfileScope
+    in gpu_query_timer.h) time the GL commands issued within their scope.
+    Recorded frames can be exported as a Chrome trace (chrome://tracing, Perfetto...).
+
+    Use the W_PROFILE_SCOPE / W_PROFILE_GPU_SCOPE macros, they compile to nothing
+    when __PROFILE__ is not defined.
+*/
+
+struct ProfileEvent
+{
+    const char* name;  // String literal or interned with FrameProfiler::intern_name()
+    uint64_t start;    // ns since profiler creation
+    uint64_t duration; // ns
+    uint32_t thread;   // Profiler thread index, FrameProfiler::GPU_THREAD for GPU markers
+    uint32_t depth;    // Nesting level within thread
+};
+
+struct FrameProfile
+{
+    uint64_t index = 0;
+    uint64_t start = 0;    // ns since profiler creation
+    uint64_t duration = 0; // ns
+    std::vector<ProfileEvent> events;
+};
+
+class FrameProfiler: public Singleton<FrameProfiler>
+{
+public:
+    friend FrameProfiler& Singleton<FrameProfiler>::Instance();
+    friend void Singleton<FrameProfiler>::Kill();
+
+    static constexpr uint32_t GPU_THREAD = 0xffffffff;
+    static constexpr size_t MAX_FRAMES = 128;
+    static constexpr uint32_t MAX_THREADS = 32; // Threads above share the last event buffer
+
+    inline void set_enabled(bool value)  { enabled_.store(value, std::memory_order_release); }
+    inline bool is_enabled() const       { return enabled_.load(std::memory_order_acquire); }
+
+    // Frame boundaries, main thread only
+    void begin_frame();
+    void end_frame();
+
+    // Time in ns since profiler creation
+    inline uint64_t now() const
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::high_resolution_clock::now() - start_time_).count());
+    }
+    // Record a finished marker in current frame, any thread
+    void push_event(const ProfileEvent& event);
+    // Small index identifying calling thread in recorded events
+    static uint32_t thread_index();
+    // Get a string that lives as long as the profiler, for dynamic marker names
+    const char* intern_name(const std::string& name);
+
+    // Recorded frames, age 0 is the last complete frame. Main thread only.
+    inline size_t get_frame_count() const { return std::min(n_frames_, MAX_FRAMES); }
+    inline const FrameProfile& get_frame(size_t age) const { return frames_[(n_frames_-1-age) % MAX_FRAMES]; }
+    // Statistics over recorded frames of the total time spent in markers named name, in s
+    FinalStatistics get_stats(const char* name) const;
+    // Total time spent in markers named name during last complete frame, in s
+    float get_last_duration(const char* name) const;
+
+    // Write recorded frames as Chrome trace event JSON
+    bool export_chrome_trace(const fs::path& path) const;
+
+#ifndef __DISABLE_EDITOR__
+    void generate_widget();
+#endif
+
+private:
+    FrameProfiler();
+    ~FrameProfiler() = default;
+
+    std::atomic<bool> enabled_;
+    std::chrono::high_resolution_clock::time_point start_time_;
+
+    std::array<FrameProfile, MAX_FRAMES> frames_; // Ring buffer of complete frames
+    size_t n_frames_;                             // Number of frames recorded so far
+    FrameProfile current_;                        // Frame being recorded
+
+    // Events of the frame being recorded, one buffer per thread so that threads
+    // do not contend with each other. Buffers are merged by end_frame().
+    struct alignas(64) ThreadEvents
+    {
+        std::mutex mutex;
+        std::vector<ProfileEvent> events;
+    };
+    std::array<ThreadEvents, MAX_THREADS> thread_events_;
+
+    std::deque<std::string> names_; // Interned names, deque never moves its elements
+    std::mutex names_mutex_;
+};
+
+#define PROFILER FrameProfiler::Instance()
+
+// Times enclosing scope on the CPU
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+    uint32_t depth_;
+    bool active_;
+};
+
+} // namespace wcore
+
+#define W_PROFILE_CONCAT_(A, B) A##B
+#define W_PROFILE_CONCAT(A, B) W_PROFILE_CONCAT_(A, B)
+
+#ifdef __PROFILE__
+    #define W_PROFILE_SCOPE(NAME) wcore::ProfileScope W_PROFILE_CONCAT(profile_scope_, __LINE__)(NAME)
+#else
+    #define W_PROFILE_SCOPE(NAME)
+#endif
+
+#endif // FRAME_PROFILER_H
@@ -0,0 +1,105 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "math3d.h"
+
+namespace wcore
+{
+
+class FrustumBox;
+
+// Dynamic bitset, one bit per culled object.
+// Distinct 64 bits words can safely be written by distinct threads.
+class VisibilityBitset
+{
+public:
+    VisibilityBitset(): size_(0) {}
+
+    // Resize and set all bits to value
+    void resize(uint32_t size, bool value=false);
+
+    inline uint32_t size() const    { return size_; }
+    inline uint32_t n_words() const { return uint32_t(words_.size()); }
+
+    inline bool test(uint32_t index) const { return (words_[index>>6] >> (index&63)) & 1u; }
+    inline void set(uint32_t index)        { words_[index>>6] |= (uint64_t(1) << (index&63)); }
+    inline void reset(uint32_t index)      { words_[index>>6] &= ~(uint64_t(1) << (index&63)); }
+    inline uint64_t get_word(uint32_t word_index) const          { return words_[word_index]; }
+    inline void set_word(uint32_t word_index, uint64_t value)    { words_[word_index] = value; }
+
+    // Number of bits set
+    uint32_t count() const;
+
+private:
+    std::vector<uint64_t> words_;
+    uint32_t size_;
+};
+
+// Frustum planes in SoA layout, normals point to the interior of the frustum
+struct FrustumPlanes
+{
+    alignas(16) float nx[6];
+    alignas(16) float ny[6];
+    alignas(16) float nz[6];
+    alignas(16) float d[6];
+
+    void update(const FrustumBox& frustum_box);
+};
+
+// Oriented boxes in SoA layout (center + 3 half axes), ready for batched plane tests.
+// A box can be flagged as non cullable, it will always be reported visible.
+class CullingBoxes
+{
+public:
+    CullingBoxes(): size_(0), stride_(0) {}
+
+    // Resize storage for size boxes, previous content is lost
+    void resize(uint32_t size);
+    inline uint32_t size() const { return size_; }
+
+    // Set box from its 8 world space vertices, using the OBB / AABB vertex convention
+    void set(uint32_t index, const std::array<math::vec3, 8>& vertices);
+    // Flag box as non cullable
+    inline void set_no_cull(uint32_t index) { no_cull_.set(index); }
+
+    // Test boxes [begin, end) against frustum planes and write results to visibility.
+    // begin must be a multiple of 64 so that concurrent calls on different ranges
+    // don't write the same bitset words.
+    // use_simd=false forces the scalar path, which is the only one on targets without SSE.
+    void cull(const FrustumPlanes& planes, uint32_t begin, uint32_t end, VisibilityBitset& visibility,
+              bool use_simd=true) const;
+
+    // Number of boxes per job when a culling pass is split between threads
+    static constexpr uint32_t BATCH_SIZE = 1024;
+
+private:
+    enum Stream: uint32_t
+    {
+        CX, CY, CZ,    // Center
+        UX, UY, UZ,    // Half axes
+        VX, VY, VZ,
+        WX, WY, WZ,
+        N_STREAMS
+    };
+
+    inline float* stream(uint32_t ss)             { return &data_[ss*stride_]; }
+    inline const float* stream(uint32_t ss) const { return &data_[ss*stride_]; }
+
+    // Returns a mask with bit ii set if box begin+ii is visible, for ii in [0,count), count<=64
+    uint64_t cull_word(const FrustumPlanes& planes, uint32_t begin, uint32_t count) const;
+    // Same without SIMD
+    uint64_t cull_word_scalar(const FrustumPlanes& planes, uint32_t begin, uint32_t count) const;
+
+    std::vector<float> data_;
+    VisibilityBitset no_cull_;
+    uint32_t size_;
+    uint32_t stride_; // Stream size, padded to a multiple of 4 floats
+};
+
+} // namespace wcore
+
+#endif // FRUSTUM_CULLING_H
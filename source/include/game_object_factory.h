@@ -34,6 +34,11 @@ public:
     {
         return model_factory_->make_terrain_patch(desc);
     }
+    // Generate a terrain height map from descriptor (thread safe)
+    inline HeightMap* make_heightmap(const TerrainPatchDescriptor& desc)
+    {
+        return model_factory_->make_heightmap(desc);
+    }
     // Create a model from XML nodes and an optional random engine
     // If underlying mesh is cached, mesh_is_instance will be set to true
     inline std::shared_ptr<Model> make_model(rapidxml::xml_node<>* mesh_node,
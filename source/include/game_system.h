@@ -3,6 +3,10 @@
 
 #include <map>
 #include <list>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
 #include "wtypes.h"
 #include "listener.h"
 
@@ -18,6 +22,14 @@ class GameSystemContainer
 public:
     void register_initializer_system(hash_t name, InitializerSystem* system);
     void register_game_system(hash_t name, GameSystem* system, InputHandler& handler);
+    // Declare that a system must be updated after another one
+    void add_dependency(hash_t name, hash_t dependency);
+    // Allow a system to be updated on a worker thread. It must not use the graphics
+    // context and must declare dependencies on the systems whose state it accesses.
+    // Other systems are updated on the calling thread, in registration order.
+    void set_worker_update(hash_t name, bool value=true);
+    // Update all game systems, independent systems in parallel
+    void update(const GameClock& clock);
     void init();
     void serialize();
     void init_game_systems();
@@ -38,10 +50,39 @@ public:
     inline std::list<GameSystem*>::iterator end()   { return game_systems_.end(); }
 
 private:
+    // Update dependency graph node, in registration order
+    struct UpdateNode
+    {
+        GameSystem* system;
+        bool worker_update = false;
+        std::vector<uint32_t> dependencies; // Declared dependencies
+        std::vector<uint32_t> dependents;   // Computed by build_update_graph()
+        uint32_t n_dependencies = 0;
+        const char* profile_name = ""; // Profiling marker name
+    };
+    // Compute dependents lists, main thread systems are chained in registration order
+    void build_update_graph();
+    void update_serial(const GameClock& clock);
+    // Update a single system, within a profiling marker
+    void update_system(uint32_t index, const GameClock& clock);
+    // Called when a system update is done, release dependents that are ready
+    void release_dependents(uint32_t index, const GameClock& clock);
+    void schedule_update(uint32_t index, const GameClock& clock);
+
     std::map<hash_t, GameSystem*>        game_systems_map_;
     std::map<hash_t, InitializerSystem*> initializer_systems_map_;
     std::list<GameSystem*>        game_systems_;
     std::list<InitializerSystem*> initializer_systems_;
+
+    std::map<hash_t, uint32_t> node_index_;
+    std::vector<UpdateNode> update_nodes_;
+    bool graph_dirty_ = true;
+    bool graph_valid_ = false;
+    // Per-frame state
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining_deps_;
+    std::atomic<uint32_t> n_updated_;
+    std::mutex main_ready_mutex_;
+    std::vector<uint32_t> main_ready_; // Systems ready to be updated on the calling thread
 };
 
 class InitializerSystem
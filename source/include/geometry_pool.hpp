@@ -0,0 +1,224 @@
+#ifndef GEOMETRY_POOL_HPP
+#define GEOMETRY_POOL_HPP
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "buffer.h"
+#include "buffer_allocator.h"
+#include "config.h"
+#include "logger.h"
+
+namespace wcore
+{
+
+// Location of a render batch in a geometry pool
+struct GeometrySlice
+{
+    static constexpr uint32_t INVALID_ARENA = uint32_t(-1);
+
+    uint32_t arena       = INVALID_ARENA;
+    uint32_t base_vertex = 0; // First vertex in arena vertex buffer
+    uint32_t base_index  = 0; // First index in arena index buffer
+
+    inline bool is_valid() const { return arena != INVALID_ARENA; }
+};
+
+struct GeometryPoolStats
+{
+    uint32_t n_arenas = 0;
+    AllocatorStats vertices; // In vertices
+    AllocatorStats indices;  // In indices
+};
+
+/*
+    Shared GPU storage for static render batches of a given vertex format.
+    Geometry lives in a few large arenas, each made of a vertex buffer, an index buffer
+    and a vertex array. Batches get a slice of an arena when they are uploaded and give it
+    back when they are destroyed, so streaming chunks in and out does not create and
+    destroy GL buffers all the time. Indices stored in a slice must be offset by the
+    slice base vertex.
+    An arena is released when its last slice is, so all GPU memory is freed along with
+    the last batch, while the graphics context is still alive.
+    Arena capacity is set by root.render.geometry_pool.{vertex_arena_kb, index_arena_kb},
+    a batch larger than that gets an arena of its own.
+    Not thread safe, batches are uploaded and destroyed by the main thread.
+*/
+template <typename VertexT>
+class GeometryPool
+{
+public:
+    static GeometryPool& instance()
+    {
+        static GeometryPool pool;
+        return pool;
+    }
+
+    // Find room for a batch, create a new arena if needed. Returns false on failure.
+    bool allocate(uint32_t n_vertices, uint32_t n_indices, GeometrySlice& slice);
+    void release(GeometrySlice& slice);
+    // Copy batch data to its slice, indices must already be offset by slice.base_vertex
+    void upload(const GeometrySlice& slice,
+                const std::vector<VertexT>& vertices, uint32_t n_vertices,
+                const std::vector<uint32_t>& indices, uint32_t n_indices);
+
+    inline VertexArray*  get_vertex_array(const GeometrySlice& slice) const { return arenas_[slice.arena]->VAO; }
+    inline IndexBuffer*  get_index_buffer(const GeometrySlice& slice) const { return arenas_[slice.arena]->IBO; }
+
+    GeometryPoolStats get_stats() const;
+
+private:
+    GeometryPool();
+    ~GeometryPool() = default;
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    struct Arena
+    {
+        Arena(uint32_t vertex_capacity, uint32_t index_capacity):
+        vertex_allocator(vertex_capacity),
+        index_allocator(index_capacity)
+        {}
+        ~Arena()
+        {
+            delete VAO;
+            delete IBO;
+            delete VBO;
+        }
+
+        VertexBuffer* VBO = nullptr;
+        IndexBuffer*  IBO = nullptr;
+        VertexArray*  VAO = nullptr;
+        BufferAllocator vertex_allocator;
+        BufferAllocator index_allocator;
+    };
+
+    bool allocate_in(uint32_t arena, uint32_t n_vertices, uint32_t n_indices, GeometrySlice& slice);
+
+private:
+    std::vector<std::unique_ptr<Arena>> arenas_; // Released arenas leave a null slot, slice arena indices stay valid
+    uint32_t vertex_capacity_; // Default arena capacity in vertices
+    uint32_t index_capacity_;  // Default arena capacity in indices
+};
+
+template <typename VertexT>
+GeometryPool<VertexT>::GeometryPool()
+{
+    uint32_t vertex_arena_kb = 8192;
+    uint32_t index_arena_kb  = 4096;
+    CONFIG.get("root.render.geometry_pool.vertex_arena_kb"_h, vertex_arena_kb);
+    CONFIG.get("root.render.geometry_pool.index_arena_kb"_h, index_arena_kb);
+    vertex_capacity_ = uint32_t((vertex_arena_kb*1024ull)/sizeof(VertexT));
+    index_capacity_  = uint32_t((index_arena_kb*1024ull)/sizeof(uint32_t));
+}
+
+template <typename VertexT>
+bool GeometryPool<VertexT>::allocate_in(uint32_t arena, uint32_t n_vertices, uint32_t n_indices, GeometrySlice& slice)
+{
+    Arena& ar = *arenas_[arena];
+    std::size_t base_vertex = ar.vertex_allocator.allocate(n_vertices);
+    if(base_vertex == BufferAllocator::INVALID_OFFSET)
+        return false;
+    std::size_t base_index = ar.index_allocator.allocate(n_indices);
+    if(base_index == BufferAllocator::INVALID_OFFSET)
+    {
+        ar.vertex_allocator.release(base_vertex);
+        return false;
+    }
+
+    slice.arena       = arena;
+    slice.base_vertex = uint32_t(base_vertex);
+    slice.base_index  = uint32_t(base_index);
+    return true;
+}
+
+template <typename VertexT>
+bool GeometryPool<VertexT>::allocate(uint32_t n_vertices, uint32_t n_indices, GeometrySlice& slice)
+{
+    if(n_vertices==0 || n_indices==0)
+        return false;
+
+    // * Try existing arenas, first fit
+    for(uint32_t ii=0; ii<arenas_.size(); ++ii)
+        if(arenas_[ii] && allocate_in(ii, n_vertices, n_indices, slice))
+            return true;
+
+    // * New arena, in the first free slot
+    std::unique_ptr<Arena> arena(new Arena(std::max(vertex_capacity_, n_vertices),
+                                           std::max(index_capacity_, n_indices)));
+    arena->VAO = VertexArray::create();
+    arena->VBO = VertexBuffer::create(nullptr, arena->vertex_allocator.get_capacity()*sizeof(VertexT));
+    arena->IBO = IndexBuffer::create(nullptr, arena->index_allocator.get_capacity()*sizeof(uint32_t));
+    if(!arena->VAO || !arena->VBO || !arena->IBO)
+        return false;
+
+    arena->VAO->bind();
+    arena->VBO->bind();
+    arena->VAO->set_layout(VertexT::Layout);
+    arena->VAO->unbind();
+
+    auto slot = std::find(arenas_.begin(), arenas_.end(), nullptr);
+    uint32_t index = uint32_t(slot - arenas_.begin());
+    if(slot == arenas_.end())
+        arenas_.push_back(std::move(arena));
+    else
+        *slot = std::move(arena);
+
+    DLOGN("[GeometryPool] New arena <v>" + std::to_string(index) + "</v>: "
+          + std::to_string(arenas_[index]->vertex_allocator.get_capacity()) + " vertices, "
+          + std::to_string(arenas_[index]->index_allocator.get_capacity()) + " indices", "batch");
+
+    return allocate_in(index, n_vertices, n_indices, slice);
+}
+
+template <typename VertexT>
+void GeometryPool<VertexT>::release(GeometrySlice& slice)
+{
+    if(!slice.is_valid())
+        return;
+
+    Arena& ar = *arenas_[slice.arena];
+    ar.vertex_allocator.release(slice.base_vertex);
+    ar.index_allocator.release(slice.base_index);
+    if(ar.vertex_allocator.is_empty())
+    {
+        DLOGN("[GeometryPool] Releasing empty arena <v>" + std::to_string(slice.arena) + "</v>", "batch");
+        arenas_[slice.arena].reset();
+    }
+    slice = GeometrySlice();
+}
+
+template <typename VertexT>
+void GeometryPool<VertexT>::upload(const GeometrySlice& slice,
+                                   const std::vector<VertexT>& vertices, uint32_t n_vertices,
+                                   const std::vector<uint32_t>& indices, uint32_t n_indices)
+{
+    Arena& ar = *arenas_[slice.arena];
+    ar.VBO->stream(reinterpret_cast<float*>(const_cast<VertexT*>(vertices.data())),
+                   n_vertices*sizeof(VertexT),
+                   slice.base_vertex*sizeof(VertexT));
+    ar.IBO->stream(const_cast<uint32_t*>(indices.data()),
+                   n_indices*sizeof(uint32_t),
+                   slice.base_index*sizeof(uint32_t));
+    ar.VBO->unbind();
+    ar.IBO->unbind();
+}
+
+template <typename VertexT>
+GeometryPoolStats GeometryPool<VertexT>::get_stats() const
+{
+    GeometryPoolStats stats;
+    for(auto&& arena: arenas_)
+    {
+        if(!arena) continue;
+        ++stats.n_arenas;
+        stats.vertices += arena->vertex_allocator.get_stats();
+        stats.indices  += arena->index_allocator.get_stats();
+    }
+    return stats;
+}
+
+} // namespace wcore
+
+#endif // GEOMETRY_POOL_HPP
@@ -1,21 +1,36 @@
 #ifndef GEOMETRY_RENDERER_H
 #define GEOMETRY_RENDERER_H
 
+#include <vector>
+
 #include "renderer.h"
 #include "shader.h"
+#include "command_bucket.hpp"
 
 namespace wcore
 {
 
 struct Vertex3P3N3T2U;
 class Scene;
+class Model;
 class Camera;
+class UniformBuffer;
+struct ObjectData;
 class GeometryRenderer : public Renderer
 {
 private:
     Shader geometry_pass_shader_;
     Shader terrain_shader_;
     Shader null_shader_;
+    Shader instanced_shader_;
+    Shader null_instanced_shader_;
+
+    // Opaque draw commands, sorted by render state
+    CommandBucket<DrawCommand> opaque_bucket_;
+    // Per-object data of the opaque commands, in execution order
+    std::vector<ObjectData> object_data_;
+    // Backs the object_data uniform block when the stream buffer is full
+    UniformBuffer* object_ubo_;
 
     // Rendering data
     float wireframe_mix_;
@@ -24,10 +39,11 @@ private:
     // Configuration overrides
     bool allow_normal_mapping_;
     bool allow_parallax_mapping_;
+    bool allow_hardware_instancing_;
 
 public:
     GeometryRenderer();
-    virtual ~GeometryRenderer() = default;
+    virtual ~GeometryRenderer();
 
     virtual void render(Scene* pscene) override;
 
@@ -38,6 +54,13 @@ public:
     inline float& get_min_parallax_distance_nc()   { return min_parallax_distance_; }
 
     inline void toggle_wireframe();
+
+private:
+    // Send material uniforms and overrides, bind material textures if bind_textures is set
+    void prepare_material(Shader& shader, const Model& model, const math::vec3& campos, bool bind_textures=true);
+    // Bind the object_data range of object index, written at base_offset in the stream buffer.
+    // If base_offset is invalid, model_matrix is uploaded to the fallback uniform buffer instead.
+    void bind_object_data(std::size_t base_offset, uint32_t index, const math::mat4& model_matrix);
 };
 
 inline void GeometryRenderer::toggle_wireframe()
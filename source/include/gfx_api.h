@@ -10,7 +10,8 @@ namespace wcore
 enum class GfxAPI
 {
     None = 0,
-    OpenGL = 1
+    OpenGL = 1,
+    Null = 2    // No graphics device, commands are only recorded (headless runs, tests)
 };
 
 enum class DrawPrimitive
@@ -65,12 +66,16 @@ public:
     virtual void set_default_framebuffer(uint32_t index) = 0;
     // Bind the default framebuffer
     virtual void bind_default_frame_buffer() = 0;
+    // Bind a framebuffer as render target
+    virtual void bind_framebuffer(uint32_t handle) = 0;
     // Read framebuffer content to an array
     virtual void read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels) = 0;
 
     // * Draw commands
     // Draw a given number of primitives using currently bound index buffer, starting at a given offset
     virtual void draw_indexed(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset) = 0;
+    // Same as draw_indexed, repeated n_instances times using per-instance attributes
+    virtual void draw_indexed_instanced(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset, uint32_t n_instances) = 0;
     // Set the color used to clear any framebuffer
     virtual void set_clear_color(float r, float g, float b, float a) = 0;
     // Clear currently bound framebuffer
@@ -111,6 +116,10 @@ public:
     // * Raster state
     // Set the position and size of area to draw to
     virtual void viewport(float xx, float yy, float width, float height) = 0;
+    // Restrict drawing and clearing to a rectangle when scissor test is enabled
+    virtual void set_scissor(int32_t xx, int32_t yy, int32_t width, int32_t height) = 0;
+    // Enable/Disable scissor test
+    virtual void set_scissor_test_enabled(bool value) = 0;
     // Set which faces to cull out (front/back/none)
     virtual void set_cull_mode(CullMode value) = 0;
     // Set the line width for next line primitive draw calls
@@ -134,6 +143,7 @@ public:
 
 };
 
+class StreamBuffer;
 class Gfx
 {
 public:
@@ -141,6 +151,8 @@ public:
     static void set_api(GfxAPI api);
 
     static std::unique_ptr<RenderDevice> device;
+    // Ring buffer for per-frame dynamic data, created along with the render pipeline
+    static std::unique_ptr<StreamBuffer> stream_buffer;
 
 private:
     static GfxAPI api_;
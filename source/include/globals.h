@@ -27,6 +27,10 @@ public:
     int WIN_H    = 768;
     bool     SCR_FULL = false;
 
+    // Headless run: null graphics API, no window, stops after HEADLESS_FRAMES frames if non-zero
+    bool     HEADLESS        = false;
+    uint32_t HEADLESS_FRAMES = 0;
+
     std::string START_LEVEL = "crystal";
 };
 
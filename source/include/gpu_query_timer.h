@@ -1,6 +1,10 @@
 #ifndef GPU_QUERY_TIMER_H
 #define GPU_QUERY_TIMER_H
 
+#include <cstdint>
+
+#include "frame_profiler.h"
+
 namespace wcore
 {
 
@@ -27,6 +31,31 @@ private:
     uint32_t timer_;
 };
 
+// Times GPU commands issued within enclosing scope, result is recorded by the
+// FrameProfiler. Each marker name has its own GPUQueryTimer, so the time recorded
+// is the one of previous frame. GL timer queries cannot be nested: a GPU marker
+// opened while another one is active is ignored.
+class GPUProfileScope
+{
+public:
+    explicit GPUProfileScope(const char* name);
+    ~GPUProfileScope();
+
+    GPUProfileScope(const GPUProfileScope&) = delete;
+    GPUProfileScope& operator=(const GPUProfileScope&) = delete;
+
+private:
+    const char* name_;
+    GPUQueryTimer* timer_;
+    uint64_t start_;
+};
+
 } // namespace wcore
 
+#ifdef __PROFILE__
+    #define W_PROFILE_GPU_SCOPE(NAME) wcore::GPUProfileScope W_PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(NAME)
+#else
+    #define W_PROFILE_GPU_SCOPE(NAME)
+#endif
+
 #endif
@@ -0,0 +1,51 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <cstdint>
+
+#include "wcontext.h"
+
+namespace wcore
+{
+
+/*
+    Context without window nor input devices, used along with the null graphics API
+    to run the game loop on machines without a display. Every key is released and the
+    cursor stays where it was put. Each swap_buffers() call closes a frame of the null
+    render device. The loop stops after a given number of frames, or when stop() is called.
+*/
+class HeadlessContext: public AbstractContext
+{
+public:
+    // Run for max_frames frames, 0 to run until stop() is called
+    explicit HeadlessContext(uint32_t max_frames=0);
+    virtual ~HeadlessContext();
+
+    virtual uint16_t get_key_state(uint16_t key) override;
+    virtual uint8_t get_mouse_buttons_state() override;
+    virtual void get_window_size(int& width, int& height) override;
+    virtual void get_cursor_position(double& x, double& y) override;
+    virtual void set_cursor_position(double x, double y) override;
+    virtual void toggle_hard_cursor() override;
+    virtual void hide_hard_cursor() override;
+    virtual void show_hard_cursor() override;
+    virtual bool window_required() override;
+    virtual void swap_buffers() override;
+    virtual void poll_events() override;
+
+    // Make window_required() return false, game loop stops at the end of current frame
+    inline void stop()                           { running_ = false; }
+    // Number of frames swapped since creation
+    inline uint32_t get_frame_count() const      { return frame_count_; }
+
+private:
+    uint32_t max_frames_;
+    uint32_t frame_count_;
+    bool running_;
+    double cursor_x_;
+    double cursor_y_;
+};
+
+} // namespace wcore
+
+#endif // HEADLESS_CONTEXT_H
@@ -13,6 +13,8 @@ class HeightMap
 {
 public:
     HeightMap(uint32_t width, uint32_t length, float height=0.0f, float scale=1.0f);
+    // Copy heights from a raw array of width*length values
+    HeightMap(uint32_t width, uint32_t length, const float* heights, float scale=1.0f);
     HeightMap(const HeightMap& hm);
     ~HeightMap();
 
@@ -30,6 +32,8 @@ public:
     inline float get_scale() const { return scale_; }
 
     float get_height(const math::vec2& pos) const;
+    // Raw height data, width*length values
+    inline const float* data() const { return heights_; }
 
     // File IO
     void export_data(const std::string& file);
@@ -43,6 +43,7 @@ public:
     float epsilon = 1e-3;   // For horizontal ground detection
     uint32_t seed = 42;     // For RNG
     uint32_t iterations = 100;
+    uint32_t tile_size = 0; // Erode tiles of this size in parallel (0: sequential)
 
     void parse_xml(rapidxml::xml_node<char>* node);
 };
@@ -63,14 +64,19 @@ class HeightmapGenerator
 {
 public:
 
+    typedef NoiseGenerator2D<SimplexNoise<>> SimplexGenerator;
+
     static void init_simplex_generator(std::mt19937& rng);
     static void heightmap_from_simplex_noise(HeightMap& hm, const SimplexNoiseProps& info);
+    // Use a caller owned generator, so that height maps can be generated concurrently
+    static void heightmap_from_simplex_noise(HeightMap& hm, const SimplexNoiseProps& info,
+                                             SimplexGenerator& generator);
 
     static void erode(HeightMap& hm, const PlateauErosionProps& props);
     static void erode_droplets(HeightMap& hmap, const DropletErosionProps& params);
 
 private:
-    static NoiseGenerator2D<SimplexNoise<>> RNG_simplex_;
+    static SimplexGenerator RNG_simplex_;
 };
 
 }
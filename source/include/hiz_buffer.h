@@ -0,0 +1,112 @@
+#ifndef HIZ_BUFFER_H
+#define HIZ_BUFFER_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "math3d.h"
+
+namespace wcore
+{
+
+/*
+    Hierarchical depth buffer (Hi-Z) used for occlusion culling on the CPU.
+    Level 0 holds window space depth values in [0,1] (1 is the far plane), each texel
+    of level l+1 holds the maximum depth of the (up to) 2x2 texels of level l it covers.
+    A bounding box is occluded if its closest depth is farther than the farthest depth
+    of the pyramid texels its screen rectangle overlaps. The rectangle is tested at the
+    level where it spans at most 2x2 texels.
+
+    Level 0 can be filled either by a depth readback from the GPU (set_depth()), or by the
+    software rasterizer (clear() + rasterize_triangle()) when no GPU depth is available.
+    In both cases, build() must be called to compute the pyramid before any test.
+
+    The test is only exact from the viewpoint the depth was produced from: when the
+    eye moves, objects hidden behind an occluder can become visible before the buffer
+    is updated. get_eye_distance() lets the caller bound this error by skipping stale
+    buffers (see Scene::visibility_pass()).
+*/
+class HiZBuffer
+{
+public:
+    HiZBuffer();
+
+    // Set level 0 size, previous content is lost
+    void resize(uint32_t width, uint32_t height);
+    // Copy level 0 depth (row major, bottom row first) and view-projection matrix
+    // the depth was rendered with
+    void set_depth(const float* depth, const math::mat4& view_projection);
+    // Build depth pyramid from level 0
+    void build();
+    // Invalidate content, every box is visible until next build()
+    inline void invalidate() { valid_ = false; }
+
+    // * Software rasterizer
+    // Clear level 0 to far plane and set view-projection matrix used by next rasterizations
+    void clear(const math::mat4& view_projection);
+    // Rasterize a world space triangle to level 0 with a depth test. Triangles crossing
+    // the near plane are skipped, which can only make the buffer less occluding.
+    void rasterize_triangle(const math::vec3& p0, const math::vec3& p1, const math::vec3& p2);
+    // Rasterize an indexed triangle mesh, model matrix M
+    template <typename VertexT>
+    void rasterize_mesh(const std::vector<VertexT>& vertices, const std::vector<uint32_t>& indices,
+                        const math::mat4& M);
+
+    // Test a bounding box given by its 8 world space vertices. Boxes crossing the near
+    // plane, off screen or tested against an invalid buffer are never occluded.
+    bool is_occluded(const std::array<math::vec3, 8>& vertices) const;
+
+    inline bool is_valid() const             { return valid_; }
+    inline uint32_t get_width() const        { return width_; }
+    inline uint32_t get_height() const       { return height_; }
+    inline uint32_t get_level_count() const  { return uint32_t(levels_.size()); }
+    inline uint32_t get_level_width(uint32_t level) const  { return level_sizes_[level].first; }
+    inline uint32_t get_level_height(uint32_t level) const { return level_sizes_[level].second; }
+    inline float get_depth(uint32_t level, uint32_t xx, uint32_t yy) const
+    {
+        return levels_[level][yy*level_sizes_[level].first+xx];
+    }
+    inline const math::mat4& get_view_projection() const { return view_projection_; }
+    // Distance between a point and the eye the depth was produced from,
+    // infinite if the projection has no eye (orthographic)
+    float get_eye_distance(const math::vec3& point) const;
+
+private:
+    // Rasterize a clip space triangle to level 0
+    void rasterize_clip(const math::vec4& c0, const math::vec4& c1, const math::vec4& c2);
+    // Extract eye position from view-projection matrix
+    void update_eye();
+
+private:
+    uint32_t width_;
+    uint32_t height_;
+    bool valid_;
+    math::mat4 view_projection_; // Matrix the depth values were produced with
+    math::vec3 eye_;             // Eye position of this matrix
+    bool has_eye_;
+
+    std::vector<std::vector<float>> levels_;
+    std::vector<std::pair<uint32_t, uint32_t>> level_sizes_;
+    std::vector<math::vec4> clip_positions_; // Rasterizer scratch buffer
+};
+
+template <typename VertexT>
+void HiZBuffer::rasterize_mesh(const std::vector<VertexT>& vertices, const std::vector<uint32_t>& indices,
+                               const math::mat4& M)
+{
+    // Transform each vertex once
+    math::mat4 MVP = view_projection_*M;
+    clip_positions_.resize(vertices.size());
+    for(uint32_t ii=0; ii<vertices.size(); ++ii)
+        clip_positions_[ii] = MVP*math::vec4(vertices[ii].position_, 1.f);
+
+    for(uint32_t ii=0; ii+2<indices.size(); ii+=3)
+        rasterize_clip(clip_positions_[indices[ii]],
+                       clip_positions_[indices[ii+1]],
+                       clip_positions_[indices[ii+2]]);
+}
+
+} // namespace wcore
+
+#endif // HIZ_BUFFER_H
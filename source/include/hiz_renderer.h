@@ -0,0 +1,59 @@
+#ifndef HIZ_RENDERER_H
+#define HIZ_RENDERER_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "renderer.h"
+#include "shader.h"
+#include "buffer_module.h"
+
+namespace wcore
+{
+
+class ReadbackBuffer;
+
+/*
+    Fills the scene occlusion buffer (Hi-Z) used by the next visibility passes.
+    G-Buffer depth is max-reduced to a low resolution texture on the GPU, then copied
+    back asynchronously: the depth of frame n is available to the CPU at frame n+2,
+    along with the view-projection matrix it was rendered with. Boxes are tested with
+    this matrix, so the test stays consistent while the camera moves, and only objects
+    disoccluded during the readback latency can pop in late. The scene ignores the buffer
+    when the eye moved too far since (root.render.occlusion.max_motion).
+    When GPU readback is disabled (root.render.occlusion.software), terrain chunks are
+    rasterized on the CPU instead.
+*/
+class HiZRenderer : public Renderer
+{
+public:
+    HiZRenderer();
+    virtual ~HiZRenderer();
+
+    virtual void render(Scene* pscene) override;
+
+    inline uint32_t get_width() const  { return width_; }
+    inline uint32_t get_height() const { return height_; }
+
+private:
+    void render_gpu(Scene* pscene);
+    void render_software(Scene* pscene);
+
+private:
+    static constexpr uint32_t N_READBACK = 2;
+
+    Shader hiz_shader_;
+    std::unique_ptr<BufferModule> depth_buffer_;               // Reduced depth
+    std::array<ReadbackBuffer*, N_READBACK> readback_;
+    std::array<math::mat4, N_READBACK> readback_vp_;            // View-projection of each transfer
+    std::array<bool, N_READBACK> pending_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t frame_index_;
+    bool software_;
+};
+
+} // namespace wcore
+
+#endif // HIZ_RENDERER_H
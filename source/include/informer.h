@@ -1,13 +1,15 @@
 #ifndef INFORMER_H
 #define INFORMER_H
 
-#include <map>
-#include <list>
+#include <vector>
+#include <memory>
+#include <utility>
 #include <type_traits>
 #include <cassert>
 #include <iostream>
 
 #include "message.h"
+#include "event_queue.h"
 
 namespace wcore
 {
@@ -17,9 +19,16 @@ class Informer
     friend class Listener;
 
     protected:
-        typedef std::list<WpFunc> DelegateList;
-        typedef std::map<hash_t,DelegateList> SubscriberMap;
-        typedef std::map<WDelegateID,DelegateList::iterator> DelegateIDMap;
+        struct Delegate
+        {
+            WDelegateID id;
+            WpFunc func;
+            bool removed; // Removed during a dispatch, erased after it
+        };
+        typedef std::vector<Delegate> DelegateList;
+        // Flat table, channels are few and looked up linearly. Channels are never removed
+        // so that their position stays valid during a dispatch.
+        typedef std::vector<std::pair<hash_t,DelegateList>> SubscriberMap;
 
     public:
         Informer();
@@ -28,21 +37,44 @@ class Informer
         inline const SubscriberMap& get_delegates() const;
         inline WID get_WID() const;
 
+        // Deliver deferred events to delegates, in the order they were posted. Must be called
+        // by the thread that owns the informer, at a sync point. Returns the number of events.
+        uint32_t dispatch_deferred();
+        // Number of deferred events lost because the queue was full
+        inline size_t get_dropped_count() const { return event_queue_ ? event_queue_->get_dropped_count() : 0; }
+
     protected:
         // Multicast delegation. Perfect forward event data, checks that data inherits from struct WData
         template <typename T,
                   typename = typename std::enable_if<std::is_base_of<WData,T>::value >::type>
         void post(hash_t, T&&);
 
+        // Queue event data for the next dispatch_deferred(), callable from any thread.
+        // Use post() for events whose consumption must be known by the poster.
+        // Returns false if the queue is full.
+        template <typename T,
+                  typename = typename std::enable_if<std::is_base_of<WData,typename std::decay<T>::type>::value >::type>
+        bool post_deferred(hash_t, T&&);
+        // Allocate deferred event queue, before any call to post_deferred()
+        void enable_deferred(size_t capacity=1024);
+
     private:
         WDelegateID add_delegate(hash_t, WpFunc delegate);
         void remove_delegate(hash_t chan, WDelegateID);
+        void insert_delegate(hash_t chan, Delegate&& delegate);
+        void dispatch(uint32_t channel_index, WData& data);
+        // Position of a channel in the subscriber table, -1 if none
+        inline int find_channel(hash_t chan) const;
         static size_t N_INST;
         static const size_t MAX_DELEGATES;
 
     protected:
         SubscriberMap  subscriber_map_;
-        DelegateIDMap  delegate_ids_;
+        std::vector<std::pair<hash_t,Delegate>> pending_delegates_; // Added during a dispatch
+        std::unique_ptr<EventQueue> event_queue_;
+        size_t n_delegates_;      // Delegates added so far, for unique IDs
+        uint32_t dispatch_depth_; // Number of nested dispatches in progress
+        bool needs_compaction_;   // Delegates were added or removed during a dispatch
         WID id_;
 };
 
@@ -56,17 +88,29 @@ inline WID Informer::get_WID() const
     return id_;
 }
 
+inline int Informer::find_channel(hash_t chan) const
+{
+    for(uint32_t ii=0; ii<subscriber_map_.size(); ++ii)
+        if(subscriber_map_[ii].first == chan)
+            return int(ii);
+    return -1;
+}
+
 template <typename T, typename>
 void Informer::post(hash_t message_type, T&& data)
 {
     data.sender_ = id_;
-    const DelegateList& dlist = subscriber_map_.at(message_type);
-    for(auto&& delegate: dlist)
-    {
-        // Execute delegate and break if event was consumed
-        if(!delegate(std::forward<T>(data)))
-            break;
-    }
+    int channel = find_channel(message_type);
+    if(channel >= 0)
+        dispatch(uint32_t(channel), data);
+}
+
+template <typename T, typename>
+bool Informer::post_deferred(hash_t message_type, T&& data)
+{
+    assert(event_queue_ && "[Informer] Deferred events are not enabled for this informer.");
+    data.sender_ = id_;
+    return event_queue_->push(EventRecord(message_type, std::forward<T>(data)));
 }
 
 }
@@ -6,6 +6,7 @@
 #include <vector>
 #include <istream>
 #include <ostream>
+#include <memory>
 
 #include "wtypes.h"
 
@@ -44,6 +45,46 @@ extern std::vector<char> get_file_as_vector(const fs::path& file_path);
 // Get the contents of a binary file into a char vector
 extern std::vector<char> get_binary_file_as_vector(const fs::path& file_path);
 
+// Read-only memory mapping of a whole file.
+// On platforms without mmap, file content is read to a buffer instead.
+class MappedFile
+{
+public:
+    MappedFile();
+    explicit MappedFile(const fs::path& file_path);
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    // Map file, previous mapping is released. Return false on failure.
+    bool open(const fs::path& file_path);
+    void close();
+
+    inline bool is_open() const          { return data_ != nullptr; }
+    inline const uint8_t* data() const   { return data_; }
+    inline size_t size() const           { return size_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+#if !defined(__unix__) && !defined(__APPLE__)
+    std::vector<char> buffer_;
+#endif
+};
+
+// Read-only window on a mapped file, keeps the mapping alive.
+// Data is not guaranteed to be aligned, use memcpy for typed access.
+struct FileView
+{
+    std::shared_ptr<const MappedFile> mapping;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    inline explicit operator bool() const { return data != nullptr; }
+};
+
 } // namespace io
 } // namespace wcore
 #endif // IO_UTILS_H
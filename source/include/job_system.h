@@ -0,0 +1,140 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+#include "singleton.hpp"
+
+namespace wcore
+{
+
+class JobCounter;
+typedef std::function<void(void)> JobFunction;
+
+struct Job
+{
+    JobFunction func;
+    JobCounter* counter = nullptr; // Decremented when the job is done
+};
+
+// Counts unfinished jobs. Jobs can be scheduled to run after a counter reaches zero,
+// this is how dependencies between jobs are expressed.
+// A counter must not be destroyed / reused before it was waited on.
+class JobCounter
+{
+public:
+    friend class JobSystem;
+
+    JobCounter(): value_(0) {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    inline bool is_done() const    { return value_.load(std::memory_order_acquire) == 0; }
+    inline uint32_t get() const    { return value_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> value_;
+    std::mutex mutex_;
+    std::vector<Job> continuations_; // Jobs waiting for this counter to reach zero
+};
+
+// Work-stealing job scheduler.
+// Each worker thread owns a job deque: it pushes and pops jobs at the back (LIFO, cache
+// friendly), idle workers steal jobs at the front of the other deques. Threads that
+// are not workers (main thread...) share deque 0 and execute jobs while they wait.
+// Without worker threads, jobs are run by the waiting thread.
+class JobSystem: public Singleton<JobSystem>
+{
+public:
+    friend JobSystem& Singleton<JobSystem>::Instance();
+    friend void Singleton<JobSystem>::Kill();
+
+    // Spawn worker threads, n_workers=0 to use one thread per core minus the main thread
+    void init(uint32_t n_workers=0);
+    // Join all worker threads, jobs left are executed beforehand
+    void shutdown();
+
+    inline uint32_t get_worker_count() const { return uint32_t(workers_.size()); }
+
+    // Schedule a job, counter (if any) is incremented now and decremented when the job is done
+    void schedule(JobFunction&& func, JobCounter* counter=nullptr);
+    // Schedule a job that will only start after dependency counter reaches zero
+    void schedule_after(JobCounter& dependency, JobFunction&& func, JobCounter* counter=nullptr);
+    // Execute pending jobs until counter reaches zero
+    void wait(JobCounter& counter);
+    // Execute one pending job if any, return false if there was none
+    bool run_pending_job();
+
+    // Call func(ii) for ii in [begin, end), by batches of grain indices (grain=0: automatic)
+    template <typename FuncT>
+    void parallel_for(uint32_t begin, uint32_t end, FuncT&& func, uint32_t grain=0);
+
+private:
+    JobSystem();
+    ~JobSystem();
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void push(Job&& job);
+    bool pop(Job& job);
+    void execute(Job& job);
+    void worker_loop(uint32_t queue_index);
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkQueue>> queues_; // Index 0 is shared by non-worker threads
+
+    std::atomic<uint32_t> pending_; // Number of jobs in all queues
+    std::atomic<bool> quit_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+};
+
+template <typename FuncT>
+void JobSystem::parallel_for(uint32_t begin, uint32_t end, FuncT&& func, uint32_t grain)
+{
+    if(end <= begin)
+        return;
+
+    // Default: a few batches per thread so that stealing can even out the load
+    uint32_t count = end-begin;
+    if(grain == 0)
+        grain = std::max(1u, count/(4*(get_worker_count()+1)));
+
+    // Single batch, don't bother scheduling
+    if(grain >= count)
+    {
+        for(uint32_t ii=begin; ii<end; ++ii)
+            func(ii);
+        return;
+    }
+
+    JobCounter counter;
+    for(uint32_t start=begin; start<end; start+=grain)
+    {
+        uint32_t stop = std::min(start+grain, end);
+        schedule([&func, start, stop]()
+        {
+            for(uint32_t ii=start; ii<stop; ++ii)
+                func(ii);
+        }, &counter);
+    }
+    wait(counter);
+}
+
+#define JOBS JobSystem::Instance()
+
+} // namespace wcore
+
+#endif // JOB_SYSTEM_H
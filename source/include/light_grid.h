@@ -0,0 +1,78 @@
+#ifndef LIGHT_GRID_H
+#define LIGHT_GRID_H
+
+#include <vector>
+#include <cstdint>
+
+#include "math3d.h"
+
+namespace wcore
+{
+
+// Screen-space rectangle in tile coordinates, bounds inclusive
+struct TileRect
+{
+    uint32_t x0, y0, x1, y1;
+};
+
+/*
+    LightGrid bins point lights into screen-space tiles on the CPU, so that a single
+    full-screen lighting pass can loop over the lights that may touch each fragment.
+    Light bounding spheres are projected to a conservative screen rectangle, the
+    per-tile light lists are then built with a counting sort.
+
+    GPU layout (see lpass_exp.frag, VARIANT_TILED):
+    - light data:    2 vec4 per light (view position, radius) (color, ambient strength)
+    - tile data:     1 uvec2 per tile (offset in index list, light count), row major,
+                     tile (0,0) is at the bottom left corner of the screen
+    - light indices: uint indices into light data
+*/
+class LightGrid
+{
+public:
+    explicit LightGrid(uint32_t tile_size=32);
+
+    // Set screen size in pixels, recompute tile count
+    void resize(uint32_t screen_width, uint32_t screen_height);
+    // Remove all lights
+    void clear();
+    // Bin a point light. View-space position, projection matrix P. Return false if light
+    // is not visible.
+    bool push_light(const math::vec3& view_pos, float radius, const math::vec3& color,
+                    float ambient_strength, const math::mat4& P);
+    // Build per-tile light lists, call after all lights were pushed
+    void build();
+
+    // Conservative screen-space bounds of a view-space sphere, in tile coordinates.
+    // Return false if the sphere lies entirely behind the near plane or off screen.
+    bool compute_tile_rect(const math::vec3& view_pos, float radius, const math::mat4& P, TileRect& rect) const;
+
+    inline uint32_t get_tile_size() const     { return tile_size_; }
+    inline uint32_t get_tiles_x() const       { return tiles_x_; }
+    inline uint32_t get_tiles_y() const       { return tiles_y_; }
+    inline uint32_t get_light_count() const   { return uint32_t(rects_.size()); }
+
+    inline const std::vector<math::vec4>& get_light_data() const  { return light_data_; }
+    inline const std::vector<uint32_t>& get_tile_data() const     { return tile_data_; }
+    inline const std::vector<uint32_t>& get_light_indices() const { return light_indices_; }
+
+    // Light count and first light index of a tile
+    inline uint32_t get_tile_light_count(uint32_t tx, uint32_t ty) const  { return tile_data_[2*(ty*tiles_x_+tx)+1]; }
+    inline const uint32_t* get_tile_lights(uint32_t tx, uint32_t ty) const { return &light_indices_[tile_data_[2*(ty*tiles_x_+tx)]]; }
+
+private:
+    uint32_t tile_size_;
+    uint32_t screen_width_;
+    uint32_t screen_height_;
+    uint32_t tiles_x_;
+    uint32_t tiles_y_;
+
+    std::vector<TileRect> rects_;          // Tile rectangle of each pushed light
+    std::vector<math::vec4> light_data_;   // 2 vec4 per light
+    std::vector<uint32_t> tile_data_;      // (offset, count) per tile
+    std::vector<uint32_t> light_indices_;  // Light lists of all tiles, contiguous
+};
+
+} // namespace wcore
+
+#endif // LIGHT_GRID_H
@@ -1,21 +1,35 @@
 #ifndef LIGHTING_RENDERER_H
 #define LIGHTING_RENDERER_H
 
+#include <memory>
+
 #include "renderer.h"
 #include "shader.h"
+#include "light_grid.h"
 
 namespace wcore
 {
 
 struct Vertex3P;
+class TextureBuffer;
+class ShadowMapRenderer;
 class LightingRenderer : public Renderer
 {
 private:
     //Shader lighting_pass_shader_;
     Shader lpass_dir_shader_;
     Shader lpass_point_shader_;
+    Shader lpass_tiled_shader_;
     Shader null_shader_;
 
+    const ShadowMapRenderer& shadow_map_renderer_; // For shadow cascades
+
+    // Tiled light culling
+    LightGrid light_grid_;
+    std::unique_ptr<TextureBuffer> light_data_buffer_;
+    std::unique_ptr<TextureBuffer> tile_buffer_;
+    std::unique_ptr<TextureBuffer> light_index_buffer_;
+
     // Geometry data
     size_t buffer_offsets_[3];
     size_t num_elements_[3];
@@ -25,6 +39,7 @@ private:
     bool shadow_enabled_;
     bool lighting_enabled_;
     bool dirlight_enabled_;
+    bool tiled_lighting_enabled_;
 
     float bright_threshold_;
     float bright_knee_;
@@ -32,8 +47,8 @@ private:
     float shadow_bias_;
 
 public:
-    LightingRenderer();
-    virtual ~LightingRenderer() = default;
+    explicit LightingRenderer(const ShadowMapRenderer& shadow_map_renderer);
+    virtual ~LightingRenderer();
 
     void load_geometry();
     virtual void render(Scene* pscene) override;
@@ -43,16 +58,18 @@ public:
     inline void set_lighting_enabled(bool value)          { lighting_enabled_ = value; }
     inline void set_shadow_mapping_enabled(bool value)    { shadow_enabled_ = value; }
     inline void set_directional_light_enabled(bool value) { dirlight_enabled_ = value; }
+    inline void set_tiled_lighting_enabled(bool value)    { tiled_lighting_enabled_ = value; }
 
     inline void toggle_SSAO()           { SSAO_enabled_ = !SSAO_enabled_; }
     inline void toggle_SSR()            { SSR_enabled_ = !SSR_enabled_; }
     inline void toggle_lighting()       { lighting_enabled_ = !lighting_enabled_; }
     inline void toggle_shadow_mapping() { shadow_enabled_ = !shadow_enabled_; }
 
-    inline bool& get_SSAO_enabled_nc()     { return SSAO_enabled_; }
-    inline bool& get_SSR_enabled_nc()      { return SSR_enabled_; }
-    inline bool& get_shadow_enabled_nc()   { return shadow_enabled_; }
-    inline bool& get_lighting_enabled_nc() { return lighting_enabled_; }
+    inline bool& get_SSAO_enabled_nc()           { return SSAO_enabled_; }
+    inline bool& get_SSR_enabled_nc()            { return SSR_enabled_; }
+    inline bool& get_shadow_enabled_nc()         { return shadow_enabled_; }
+    inline bool& get_lighting_enabled_nc()       { return lighting_enabled_; }
+    inline bool& get_tiled_lighting_enabled_nc() { return tiled_lighting_enabled_; }
 
     inline void set_bright_threshold(float value)  { bright_threshold_ = value; }
     inline void set_bright_knee(float value)       { bright_knee_ = value; }
@@ -68,6 +85,12 @@ public:
     inline float& get_bright_knee_nc()       { return bright_knee_; }
     inline float& get_shadow_slope_bias_nc() { return shadow_slope_bias_; }
     inline float& get_shadow_bias_nc()       { return shadow_bias_; }
+
+private:
+    // Point lights, one stencil pass + one light volume pass per light
+    void render_point_lights_stencil(Scene* pscene);
+    // Point lights, binned in screen-space tiles, single full-screen pass
+    void render_point_lights_tiled(Scene* pscene);
 /*
 private:
     inline size_t QUAD_OFFSET()   { return buffer_offsets_[0]; }
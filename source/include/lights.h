@@ -54,6 +54,7 @@ public:
     inline float& get_ambient_strength_nc()             { return ambient_strength_; }
 
     virtual void set_radius(float value) {}
+    virtual float get_radius() const { return 0.f; }
 
     // Reference
     inline void set_reference(hash_t hname) { reference_ = hname; has_reference_ = true; }
@@ -97,7 +98,7 @@ public:
 
     ~PointLight();
 
-    inline float get_radius() const { return radius_; }
+    virtual float get_radius() const override     { return radius_; }
     virtual void set_radius(float value) override { radius_ = value; }
 
     virtual void update_uniforms(const Shader& shader) const override;
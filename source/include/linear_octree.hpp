@@ -0,0 +1,526 @@
+#ifndef LINEAR_OCTREE_HPP
+#define LINEAR_OCTREE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+#include "math3d.h"
+#include "bounding_boxes.h"
+
+namespace wcore
+{
+
+/*
+    Linear (Morton-coded) octree, drop-in replacement for Octree<PrimitiveT, UserDataT>.
+    Same template parameters, same traits requirements, same public interface.
+
+    Layout:
+        -> Objects are stored in structure of arrays (primitives, user data, group ids, keys)
+           sorted by locational code, so the content of any node is a contiguous range.
+        -> Nodes are stored depth-first in a single contiguous array. Each node knows the index
+           of the first node past its subtree, so traversals are iterative and a culled subtree
+           is skipped in O(1). Empty octants are not stored.
+        -> A locational key packs the Morton code (3 bits per level, x/z/y interleaved the same
+           way Octree::best_fit_octant() does) of the deepest cell that fully contains an
+           object, together with the depth of that cell.
+
+    Insertion is lazy: objects are appended to a pending range and only sorted in
+    when propagate() is called, then merged in place with the already sorted range. Growing the
+    root region toward an outlier remaps existing keys in place. Removal compacts the arrays in place (order is preserved)
+    and rebuilds the node array in linear time, no sorting required.
+    Visitors receive a DataRefT whose members are named like Octree::DataT's.
+*/
+template <class PrimitiveT, class UserDataT, uint32_t MAX_CELL_COUNT=16, uint32_t MAX_DEPTH=5>
+class LinearOctree
+{
+    static_assert(MAX_DEPTH>1 && MAX_DEPTH<19, "[LinearOctree] MAX_DEPTH must fit in a 64 bits locational key.");
+
+public:
+    struct DataT;
+    struct DataRefT;
+    typedef std::vector<DataT> ContentT;
+    typedef std::function<void(const DataRefT&)> DataVisitorT;
+    typedef std::function<void(const BoundingRegion&)> BoundsVisitorT;
+
+    LinearOctree();
+    LinearOctree(const BoundingRegion& bounding_region, const ContentT& content);
+    ~LinearOctree() = default;
+
+    void insert(const DataT& data);
+    void insert(const ContentT& data_list);
+
+    // Removal of an object inserted with a given user data
+    bool remove(const UserDataT& udata);
+    // Removal of all objects inserted with a given group id
+    void remove_group(uint32_t group_id);
+    // Sort pending objects in and rebuild node array (will make effective any previous insertion)
+    void propagate();
+
+    // Depth first traversal of objects held by leaf nodes
+    template <typename VisitorT>
+    void traverse_leaves(VisitorT visit) const;
+    // Depth first traversal of objects within specified range
+    // The two following traits must exist:
+    // - traits::collision<RangeT,BoundingRegion>
+    // - traits::collision<RangeT,PrimitiveT>
+    template <typename RangeT, typename VisitorT>
+    void traverse_range(const RangeT& query_range, VisitorT visit) const;
+    template <typename RangeT, typename VisitorT>
+    void traverse_bounds_range(const RangeT& query_range, VisitorT visit) const;
+
+    inline void set_root_bounding_region(const BoundingRegion& bounds);
+    inline bool is_initialized() const    { return initialized_; }
+    inline uint32_t get_size() const      { return primitives_.size(); }
+    inline uint32_t get_node_count() const { return nodes_.size(); }
+    inline void reserve(uint32_t size);
+
+private:
+    struct Node
+    {
+        BoundingRegion bounds;  // volume spanned by this node
+        uint32_t content_begin; // range of objects held at this level
+        uint32_t content_end;
+        uint32_t skip;          // index of the first node past this subtree
+        bool is_leaf;
+    };
+
+    // Key layout: [ Morton code (3 bits per level) | depth (5 bits) ]
+    static constexpr uint32_t DEPTH_BITS_ = 5;
+    static constexpr uint64_t DEPTH_MASK_ = (uint64_t(1)<<DEPTH_BITS_)-1;
+    static constexpr uint32_t MAX_LEVEL_  = MAX_DEPTH-1;
+
+    static inline uint32_t key_depth(uint64_t key) { return uint32_t(key & DEPTH_MASK_); }
+    // Octant of the child at depth+1 this key descends into
+    static inline uint8_t key_octant(uint64_t key, uint32_t depth)
+    {
+        return uint8_t((key >> (DEPTH_BITS_ + 3*(MAX_LEVEL_-1-depth))) & 7);
+    }
+
+    static inline uint8_t best_fit_octant(const BoundingRegion& bounds, const PrimitiveT& primitive);
+    static inline BoundingRegion child_bounds(const BoundingRegion& parent, uint8_t octant);
+
+    // Compute locational key of the deepest cell that fully contains a primitive
+    uint64_t compute_key(const PrimitiveT& primitive) const;
+    // Recursively emit nodes for a sorted object range, return node index
+    uint32_t build_node(const BoundingRegion& bounds, uint32_t depth, uint32_t begin, uint32_t end);
+    // Rebuild node array from sorted placed objects
+    void rebuild_nodes();
+    // Enlarge root region toward an outlier
+    void grow(uint8_t old_root_index);
+    // Remove objects matching predicate, keep relative order, return removed count
+    template <typename PredicateT>
+    uint32_t erase_if(PredicateT pred);
+
+private:
+    std::vector<Node>       nodes_;      // depth-first node array, root at index 0
+    std::vector<PrimitiveT> primitives_; // SoA object storage
+    std::vector<UserDataT>  data_;
+    std::vector<uint32_t>   group_ids_;
+    std::vector<uint64_t>   keys_;
+    std::vector<std::pair<uint64_t,uint32_t>> pending_; // propagation scratch buffers
+    std::vector<PrimitiveT> scratch_primitives_;
+    std::vector<UserDataT>  scratch_data_;
+    std::vector<uint32_t>   scratch_group_ids_;
+    BoundingRegion root_bounds_;
+    uint32_t n_placed_;  // objects in [0,n_placed_) are sorted and referenced by nodes
+    bool keys_valid_;    // false when root region was reset and keys need recomputing
+    bool initialized_;
+};
+
+// For convenience
+#define LOCTREE         LinearOctree<PrimitiveT, UserDataT, MAX_CELL_COUNT, MAX_DEPTH>
+#define LOCTREE_ARGLIST class PrimitiveT, class UserDataT, uint32_t MAX_CELL_COUNT, uint32_t MAX_DEPTH
+
+template <LOCTREE_ARGLIST>
+struct LOCTREE::DataT
+{
+    DataT(const PrimitiveT& p, const UserDataT& d, uint32_t g=0):
+    primitive(p),
+    data(d),
+    group_id(g){}
+
+    PrimitiveT primitive;
+    UserDataT data;
+    uint32_t group_id;
+};
+
+template <LOCTREE_ARGLIST>
+struct LOCTREE::DataRefT
+{
+    const PrimitiveT& primitive;
+    const UserDataT& data;
+    uint32_t group_id;
+};
+
+template <LOCTREE_ARGLIST>
+LOCTREE::LinearOctree():
+n_placed_(0),
+keys_valid_(false),
+initialized_(false)
+{
+
+}
+
+template <LOCTREE_ARGLIST>
+LOCTREE::LinearOctree(const BoundingRegion& bounding_region, const ContentT& content):
+root_bounds_(bounding_region),
+n_placed_(0),
+keys_valid_(false),
+initialized_(true)
+{
+    rebuild_nodes();
+    insert(content);
+}
+
+template <LOCTREE_ARGLIST>
+inline void LOCTREE::set_root_bounding_region(const BoundingRegion& bounds)
+{
+    root_bounds_ = bounds;
+    keys_valid_  = false;
+    initialized_ = true;
+    // Placed objects must be sorted again with respect to the new root
+    n_placed_ = 0;
+    rebuild_nodes();
+}
+
+template <LOCTREE_ARGLIST>
+inline void LOCTREE::reserve(uint32_t size)
+{
+    primitives_.reserve(size);
+    data_.reserve(size);
+    group_ids_.reserve(size);
+    keys_.reserve(size);
+}
+
+template <LOCTREE_ARGLIST>
+inline uint8_t LOCTREE::best_fit_octant(const BoundingRegion& bounds, const PrimitiveT& primitive)
+{
+    // Same octant arrangement as Octree
+    math::vec3 diff(traits::center<PrimitiveT>::get(primitive) - bounds.mid_point);
+    return (diff.x()<0 ? 0 : 1) + (diff.z()<0 ? 0 : 2) + (diff.y()<0 ? 0 : 4);
+}
+
+template <LOCTREE_ARGLIST>
+inline BoundingRegion LOCTREE::child_bounds(const BoundingRegion& parent, uint8_t octant)
+{
+    math::vec3 new_half   = 0.5f*parent.half;
+    math::vec3 new_center = parent.mid_point
+                          + math::vec3(((octant&1)?1.f:-1.f)*new_half.x(),
+                                       ((octant&4)?1.f:-1.f)*new_half.y(),
+                                       ((octant&2)?1.f:-1.f)*new_half.z());
+    return BoundingRegion(new_center, new_half);
+}
+
+template <LOCTREE_ARGLIST>
+uint64_t LOCTREE::compute_key(const PrimitiveT& primitive) const
+{
+    uint64_t code = 0;
+    uint32_t depth = 0;
+    BoundingRegion cell(root_bounds_);
+    // Walk down while a child octant fully contains the primitive
+    while(depth<MAX_LEVEL_)
+    {
+        uint8_t octant = best_fit_octant(cell, primitive);
+        BoundingRegion child(child_bounds(cell, octant));
+        if(!traits::collision<BoundingRegion,PrimitiveT>::contains(child, primitive))
+            break;
+
+        code |= uint64_t(octant) << 3*(MAX_LEVEL_-1-depth);
+        cell = child;
+        ++depth;
+    }
+    return (code << DEPTH_BITS_) | depth;
+}
+
+template <LOCTREE_ARGLIST>
+uint32_t LOCTREE::build_node(const BoundingRegion& bounds, uint32_t depth, uint32_t begin, uint32_t end)
+{
+    uint32_t index = nodes_.size();
+    nodes_.push_back(Node({bounds, begin, end, 0, true}));
+
+    // Only subdivide when node exceeds object capacity and is above max depth
+    if(end-begin>MAX_CELL_COUNT && depth<MAX_LEVEL_)
+    {
+        // Objects that cannot go any deeper sort first and stay at this level
+        uint32_t first = begin;
+        while(first<end && key_depth(keys_[first])<=depth)
+            ++first;
+        nodes_[index].content_end = first;
+
+        // Remaining objects are grouped by octant, dispatch each contiguous run to a child
+        uint32_t cursor = first;
+        while(cursor<end)
+        {
+            uint8_t octant = key_octant(keys_[cursor], depth);
+            uint32_t last = cursor+1;
+            while(last<end && key_octant(keys_[last], depth)==octant)
+                ++last;
+            build_node(child_bounds(bounds, octant), depth+1, cursor, last);
+            cursor = last;
+        }
+        nodes_[index].is_leaf = (nodes_.size() == index+1);
+    }
+
+    nodes_[index].skip = nodes_.size();
+    return index;
+}
+
+template <LOCTREE_ARGLIST>
+void LOCTREE::rebuild_nodes()
+{
+    nodes_.clear();
+    build_node(root_bounds_, 0, 0, n_placed_);
+}
+
+template <LOCTREE_ARGLIST>
+void LOCTREE::propagate()
+{
+    uint32_t size = primitives_.size();
+    if(n_placed_ == size && keys_valid_)
+        return;
+
+    // * Compute keys of pending objects (all of them if root region changed)
+    uint32_t first_dirty = keys_valid_ ? n_placed_ : 0;
+    pending_.clear();
+    pending_.reserve(size-first_dirty);
+    for(uint32_t ii=first_dirty; ii<size; ++ii)
+    {
+        keys_[ii] = compute_key(primitives_[ii]);
+        pending_.push_back(std::make_pair(keys_[ii], ii));
+    }
+
+    // * Sort pending objects only, already placed objects are sorted
+    std::sort(pending_.begin(), pending_.end());
+    uint32_t n_pending = pending_.size();
+    scratch_primitives_.clear(); scratch_primitives_.reserve(n_pending);
+    scratch_data_.clear();       scratch_data_.reserve(n_pending);
+    scratch_group_ids_.clear();  scratch_group_ids_.reserve(n_pending);
+    for(auto&& [key, index]: pending_)
+    {
+        scratch_primitives_.push_back(primitives_[index]);
+        scratch_data_.push_back(data_[index]);
+        scratch_group_ids_.push_back(group_ids_[index]);
+    }
+
+    // * Merge both sorted runs in place, back to front
+    // Placed objects with a key lower than every pending key are not moved
+    int64_t placed  = int64_t(first_dirty)-1;
+    int64_t pending = int64_t(n_pending)-1;
+    int64_t cursor  = int64_t(size)-1;
+    while(pending>=0)
+    {
+        if(placed>=0 && keys_[placed]>pending_[pending].first)
+        {
+            primitives_[cursor] = primitives_[placed];
+            data_[cursor]       = data_[placed];
+            group_ids_[cursor]  = group_ids_[placed];
+            keys_[cursor]       = keys_[placed];
+            --placed;
+        }
+        else
+        {
+            primitives_[cursor] = scratch_primitives_[pending];
+            data_[cursor]       = scratch_data_[pending];
+            group_ids_[cursor]  = scratch_group_ids_[pending];
+            keys_[cursor]       = pending_[pending].first;
+            --pending;
+        }
+        --cursor;
+    }
+
+    n_placed_   = size;
+    keys_valid_ = true;
+    rebuild_nodes();
+}
+
+template <LOCTREE_ARGLIST>
+template <typename PredicateT>
+uint32_t LOCTREE::erase_if(PredicateT pred)
+{
+    uint32_t size = primitives_.size();
+    uint32_t kept = 0;
+    uint32_t kept_placed = 0;
+    for(uint32_t ii=0; ii<size; ++ii)
+    {
+        if(pred(ii))
+            continue;
+        if(kept != ii)
+        {
+            primitives_[kept] = primitives_[ii];
+            data_[kept]       = data_[ii];
+            group_ids_[kept]  = group_ids_[ii];
+            keys_[kept]       = keys_[ii];
+        }
+        if(ii<n_placed_)
+            ++kept_placed;
+        ++kept;
+    }
+
+    if(kept == size)
+        return 0;
+
+    primitives_.erase(primitives_.begin()+kept, primitives_.end());
+    data_.erase(data_.begin()+kept, data_.end());
+    group_ids_.erase(group_ids_.begin()+kept, group_ids_.end());
+    keys_.erase(keys_.begin()+kept, keys_.end());
+    n_placed_ = kept_placed;
+
+    // Relative order is preserved, so no sorting is needed
+    rebuild_nodes();
+    return size-kept;
+}
+
+template <LOCTREE_ARGLIST>
+bool LOCTREE::remove(const UserDataT& udata)
+{
+    bool found = false;
+    return erase_if([&](uint32_t index)
+    {
+        if(!found && data_[index] == udata)
+            return (found = true);
+        return false;
+    }) != 0;
+}
+
+template <LOCTREE_ARGLIST>
+void LOCTREE::remove_group(uint32_t group_id)
+{
+    erase_if([&](uint32_t index)
+    {
+        return group_ids_[index] == group_id;
+    });
+}
+
+template <LOCTREE_ARGLIST>
+template <typename VisitorT>
+void LOCTREE::traverse_leaves(VisitorT visit) const
+{
+    for(auto&& node: nodes_)
+    {
+        if(!node.is_leaf) continue;
+        for(uint32_t ii=node.content_begin; ii<node.content_end; ++ii)
+            visit(DataRefT{primitives_[ii], data_[ii], group_ids_[ii]});
+    }
+
+    // Pending objects are held by root node
+    if(nodes_.size()<2)
+        for(uint32_t ii=n_placed_; ii<primitives_.size(); ++ii)
+            visit(DataRefT{primitives_[ii], data_[ii], group_ids_[ii]});
+}
+
+template <LOCTREE_ARGLIST>
+template <typename RangeT, typename VisitorT>
+void LOCTREE::traverse_range(const RangeT& query_range, VisitorT visit) const
+{
+    uint32_t index = 0;
+    while(index<nodes_.size())
+    {
+        const Node& node = nodes_[index];
+        // Skip whole subtree if out of range
+        if(!traits::collision<RangeT,BoundingRegion>::intersects(query_range, node.bounds))
+        {
+            index = node.skip;
+            continue;
+        }
+
+        for(uint32_t ii=node.content_begin; ii<node.content_end; ++ii)
+            if(traits::collision<RangeT,PrimitiveT>::intersects(query_range, primitives_[ii]))
+                visit(DataRefT{primitives_[ii], data_[ii], group_ids_[ii]});
+
+        // Next node in depth-first order is either first child or next sibling
+        ++index;
+    }
+
+    // Pending objects
+    for(uint32_t ii=n_placed_; ii<primitives_.size(); ++ii)
+        if(traits::collision<RangeT,PrimitiveT>::intersects(query_range, primitives_[ii]))
+            visit(DataRefT{primitives_[ii], data_[ii], group_ids_[ii]});
+}
+
+template <LOCTREE_ARGLIST>
+template <typename RangeT, typename VisitorT>
+void LOCTREE::traverse_bounds_range(const RangeT& query_range, VisitorT visit) const
+{
+    uint32_t index = 0;
+    while(index<nodes_.size())
+    {
+        const Node& node = nodes_[index];
+        if(!traits::collision<RangeT,BoundingRegion>::intersects(query_range, node.bounds))
+        {
+            index = node.skip;
+            continue;
+        }
+
+        visit(node.bounds);
+        ++index;
+    }
+}
+
+template <LOCTREE_ARGLIST>
+void LOCTREE::grow(uint8_t old_root_index)
+{
+    // New root spatial extent can be computed by using binary masking on old_root_index
+    math::vec3 new_half(2.0f*root_bounds_.half);
+    math::vec3 new_center(root_bounds_.mid_point
+                        + math::vec3(((old_root_index&1)?-1.f:1.f)*root_bounds_.half.x(),
+                                     ((old_root_index&4)?-1.f:1.f)*root_bounds_.half.y(),
+                                     ((old_root_index&2)?-1.f:1.f)*root_bounds_.half.z()));
+    root_bounds_ = BoundingRegion(new_center, new_half);
+
+    // Old root becomes octant old_root_index of the new root, so placed keys
+    // can be remapped without breaking sort order: prefix the Morton code with
+    // the old root octant and go one level deeper. Objects already at max depth
+    // are lifted to the parent of their cell.
+    for(uint32_t ii=0; ii<n_placed_; ++ii)
+    {
+        uint64_t code  = keys_[ii] >> DEPTH_BITS_;
+        uint32_t depth = key_depth(keys_[ii]);
+        code = (uint64_t(old_root_index) << 3*(MAX_LEVEL_-1)) | (code >> 3);
+        depth = std::min(depth+1, MAX_LEVEL_);
+        keys_[ii] = (code << DEPTH_BITS_) | depth;
+    }
+    rebuild_nodes();
+}
+
+template <LOCTREE_ARGLIST>
+void LOCTREE::insert(const DataT& data)
+{
+    // * Detect if object lies outside of bounds
+    // If so, we need to expand root region in the direction of the outlier
+    uint8_t count = 0;
+    while(!traits::collision<BoundingRegion,PrimitiveT>::contains(root_bounds_, data.primitive))
+    {
+        uint8_t old_root_index = 7 - best_fit_octant(root_bounds_, data.primitive);
+        grow(old_root_index);
+
+        if(++count>MAX_DEPTH)
+        {
+            std::cout << "Stopped octree growth, it was going to explode." << std::endl;
+            break;
+        }
+    }
+
+    primitives_.push_back(data.primitive);
+    data_.push_back(data.data);
+    group_ids_.push_back(data.group_id);
+    keys_.push_back(0);
+}
+
+template <LOCTREE_ARGLIST>
+void LOCTREE::insert(const ContentT& data_list)
+{
+    reserve(primitives_.size()+data_list.size());
+    for(auto&& data: data_list)
+        insert(data);
+}
+
+} // namespace wcore
+
+#undef LOCTREE
+#undef LOCTREE_ARGLIST
+
+#endif // LINEAR_OCTREE_HPP
@@ -12,11 +12,17 @@
 #include <sstream>
 #include <algorithm>
 #include <filesystem>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
 
 #include "listener.h"
 #include "singleton.hpp"
 #include "wtypes.h"
 #include "error.h"
+#include "mpsc_ring_buffer.hpp"
 
 namespace wcore
 {
@@ -126,6 +132,20 @@ private:
     }
 };
 
+// Compact message record pushed by producer threads in asynchronous mode
+struct LogRecord
+{
+    std::string message;
+    const char* file = "";          // String literal (__FILE__), not copied
+    LogMessage::TimeStamp timestamp;
+    hash_t      channel = 0;
+    uint32_t    severity = 0;
+    int         line = 0;
+    MsgType     type = MsgType::CANONICAL;
+    LogMode     mode = LogMode::CANONICAL;
+    std::string file_copy;          // Used instead of file when not a literal (forwarded LogMessage)
+};
+
 struct LogChannel
 {
 public:
@@ -143,14 +163,25 @@ class Logger : public Singleton<Logger>, public Listener
 {
 private:
     FileMode file_mode_;               // What to do with the log file (new, overwrite, append)
-    bool widget_scroll_required_;      // When new message logged, widget needs to scroll down
+    std::atomic<bool> widget_scroll_required_; // When new message logged, widget needs to scroll down
     bool backtrace_on_error_;
     LogMessage::TimePoint start_time_; // Start time for timestamp handling
-    uint32_t last_section_size_;       // Size of last section message
-    Severity last_severity_;
+    std::atomic<uint32_t> last_section_size_; // Size of last section message
 
     std::vector<LogMessage> messages_;         // List of logged messages
     std::map<hash_t, LogChannel> channels_; // Map of debugging channels
+    std::mutex messages_mutex_;
+    std::mutex channels_mutex_;
+
+    // Asynchronous mode: producers push records, the logging thread formats and outputs them
+    std::unique_ptr<MPSCRingBuffer<LogRecord>> queue_;
+    std::thread log_thread_;
+    std::atomic<bool> async_;
+    std::atomic<bool> quit_;
+    std::atomic<size_t> processed_;    // Number of records output by the logging thread
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;  // Wakes the logging thread up
+    std::condition_variable flush_cv_; // Signals flushing threads that records were output
 
     // Singleton boilerplate
     Logger (const Logger&)=delete;
@@ -164,6 +195,12 @@ private:
     void parse_tags(const std::string& message, std::string& final, MsgType type);
     // Strip xml tags from message
     void strip_tags(const std::string& message, std::string& stripped, MsgType type);
+    // Store and display message on the current thread
+    void dispatch(const LogMessage& log_message, bool allow_backtrace=true);
+    // Push a record to the queue, waits for free space if queue is full
+    void push(LogRecord&& record);
+    // Logging thread main loop
+    void log_thread_loop();
 
 public:
     // Singleton boilerplate
@@ -197,6 +234,13 @@ public:
     {
         backtrace_on_error_ = value;
     }
+    // (De)Activate asynchronous logging. In asynchronous mode, logging functions only
+    // push a record to a lock-free queue and return, formatting, filtering and output
+    // are performed by a dedicated thread. Must not be called while other threads log.
+    void set_async(bool value, size_t queue_capacity=4096);
+    inline bool is_async() const { return async_.load(std::memory_order_acquire); }
+    // Block until all messages logged so far are output (no-op in synchronous mode)
+    void flush();
 
     // Actual functions used for logging (functor style)
     void operator ()(const std::string& message,
@@ -243,7 +287,7 @@ public:
     void print_reference();
 
     // Clear message list
-    inline void clear() { messages_.clear(); }
+    void clear();
     // Change file mode
     inline void set_mode(FileMode file_mode) { file_mode_ = file_mode; }
 };
@@ -253,12 +297,7 @@ void Logger::printfold(Args&&... args)
 {
     std::ostringstream out;
     (out << ... << args);
-    auto timestamp = std::chrono::high_resolution_clock::now() - start_time_;
-    LogMessage log_message(out.str(), timestamp, MsgType::CANONICAL, LogMode::CANONICAL);
-
-    messages_.push_back(log_message);
-    float sec = std::chrono::duration_cast<std::chrono::duration<float>>(timestamp).count();
-    print_console(log_message.message_, log_message.type_, sec);
+    operator()(out.str(), MsgType::CANONICAL, LogMode::CANONICAL);
 }
 
 namespace dbg
@@ -70,6 +70,9 @@ public:
 
     inline void set_overlay(bool value) { use_overlay_ = value; }
     inline bool has_overlay() const { return use_overlay_; }
+
+    // Hash of all the state sent to shaders, materials with equal hashes can share a draw call
+    std::size_t get_state_hash() const;
 };
 
 inline void Material::set_parallax_height_scale(float value)
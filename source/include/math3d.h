@@ -167,6 +167,17 @@ mat4 scale_translate(const vec3& world_position, float scale);
 
 void translate_matrix(mat4& matrix, const vec3& translation);
 
+// Batch operations. Matrices are kept in registers across the batch when SIMD is available.
+// Results are the same as the equivalent loop of single operations.
+// out[ii] = matrix*in[ii]
+void transform(const mat4& matrix, const vec4* in, vec4* out, size_t count);
+// out[ii] = (matrix*vec4(in[ii],1)).xyz, no perspective division. out may alias in.
+void transform_points(const mat4& matrix, const vec3* in, vec3* out, size_t count);
+// out[ii] = lhs*rhs[ii]. out may alias rhs.
+void multiply(const mat4& lhs, const mat4* rhs, mat4* out, size_t count);
+// out[ii] = lhs[ii]*rhs[ii]
+void multiply(const mat4* lhs, const mat4* rhs, mat4* out, size_t count);
+
 } // namespace math
 
 template<> std::string to_string(const math::vec2& v);
@@ -7,6 +7,13 @@
 #include <iomanip>
 #include <sstream>
 #include <array>
+#include <type_traits>
+#ifdef __SSE__
+    #include <xmmintrin.h>
+#endif
+#ifdef __AVX__
+    #include <immintrin.h>
+#endif
 
 namespace wcore
 {
@@ -20,6 +27,18 @@ namespace detail
             return 0.0;
         return value;
     }
+
+    // Storage alignment. With __OPTIM_ALIGNED_MATH__, float storage whose size is a multiple
+    // of 4 (vec4, mat4...) is aligned on 16 bytes so that SIMD loads never split cache lines.
+    template <unsigned SIZE, typename T>
+    struct storage_align
+    {
+#ifdef __OPTIM_ALIGNED_MATH__
+        static constexpr std::size_t value = (std::is_same<T,float>::value && SIZE%4==0) ? 16 : alignof(T);
+#else
+        static constexpr std::size_t value = alignof(T);
+#endif
+    };
 }
 
 /*
@@ -102,9 +121,11 @@ public:
     template <unsigned D>
     explicit vec(const vec<D,T>& right)
     {
-        for(unsigned ii=0; ii<D; ++ii)
+        // Truncate or zero-pad
+        constexpr unsigned M = (D<N) ? D : N;
+        for(unsigned ii=0; ii<M; ++ii)
             value_[ii] = right[ii];
-        for(unsigned ii=D; ii<N; ++ii)
+        for(unsigned ii=M; ii<N; ++ii)
             value_[ii] = T(0);
     }
 
@@ -132,6 +153,9 @@ public:
         assert(index<N && "vec::operator[] const: index out of bound.");
         return value_[index];
     }
+    // Pointer to first element, for SIMD loads
+    inline T const* get_pointer() const { return value_; }
+    inline T* get_pointer()             { return value_; }
 
     // Generic accessors
     template <unsigned POS, bool U=true, typename=typename std::enable_if<U&&(POS<N)>::type>
@@ -444,7 +468,7 @@ public:
     }
 
 protected:
-    T value_[N];
+    alignas(detail::storage_align<N,T>::value) T value_[N];
 };
 
 using vec2 = vec<2>;
@@ -663,6 +687,10 @@ public:
     {
         return value_;
     }
+    inline T* get_pointer()
+    {
+        return value_;
+    }
 
     /**
      * @brief Copy right matrix to self.
@@ -1065,9 +1093,64 @@ public:
 
 
 private:
-    T value_[Size];
+    alignas(detail::storage_align<Size,T>::value) T value_[Size];
 };
 
+#ifdef __SSE__
+/*
+    SSE specializations of the mat4 products. A column of the result is a linear
+    combination of the columns of the left operand, accumulated in the same order
+    as the generic code, so results are identical to the scalar version.
+*/
+template <>
+inline mat<4,float> mat<4,float>::operator*(const mat<4,float>& right) const
+{
+    mat<4,float> result;
+    __m128 c0 = _mm_loadu_ps(value_);
+    __m128 c1 = _mm_loadu_ps(value_+4);
+    __m128 c2 = _mm_loadu_ps(value_+8);
+    __m128 c3 = _mm_loadu_ps(value_+12);
+#ifdef __AVX__
+    // Two columns of the result per iteration
+    __m256 c00 = _mm256_set_m128(c0, c0);
+    __m256 c11 = _mm256_set_m128(c1, c1);
+    __m256 c22 = _mm256_set_m128(c2, c2);
+    __m256 c33 = _mm256_set_m128(c3, c3);
+    for(unsigned jj=0; jj<4; jj+=2)
+    {
+        const float* r = right.value_ + jj*4;
+        __m256 col = _mm256_mul_ps(c00, _mm256_setr_ps(r[0],r[0],r[0],r[0],r[4],r[4],r[4],r[4]));
+        col = _mm256_add_ps(col, _mm256_mul_ps(c11, _mm256_setr_ps(r[1],r[1],r[1],r[1],r[5],r[5],r[5],r[5])));
+        col = _mm256_add_ps(col, _mm256_mul_ps(c22, _mm256_setr_ps(r[2],r[2],r[2],r[2],r[6],r[6],r[6],r[6])));
+        col = _mm256_add_ps(col, _mm256_mul_ps(c33, _mm256_setr_ps(r[3],r[3],r[3],r[3],r[7],r[7],r[7],r[7])));
+        _mm256_storeu_ps(result.value_ + jj*4, col);
+    }
+#else
+    for(unsigned jj=0; jj<4; ++jj)
+    {
+        const float* r = right.value_ + jj*4;
+        __m128 col = _mm_mul_ps(c0, _mm_set1_ps(r[0]));
+        col = _mm_add_ps(col, _mm_mul_ps(c1, _mm_set1_ps(r[1])));
+        col = _mm_add_ps(col, _mm_mul_ps(c2, _mm_set1_ps(r[2])));
+        col = _mm_add_ps(col, _mm_mul_ps(c3, _mm_set1_ps(r[3])));
+        _mm_storeu_ps(result.value_ + jj*4, col);
+    }
+#endif
+    return result;
+}
+
+template <>
+inline vec<4,float> mat<4,float>::operator*(const vec<4,float>& right) const
+{
+    __m128 col = _mm_mul_ps(_mm_loadu_ps(value_), _mm_set1_ps(right[0]));
+    col = _mm_add_ps(col, _mm_mul_ps(_mm_loadu_ps(value_+4),  _mm_set1_ps(right[1])));
+    col = _mm_add_ps(col, _mm_mul_ps(_mm_loadu_ps(value_+8),  _mm_set1_ps(right[2])));
+    col = _mm_add_ps(col, _mm_mul_ps(_mm_loadu_ps(value_+12), _mm_set1_ps(right[3])));
+    alignas(16) float out[4];
+    _mm_store_ps(out, col);
+    return vec<4,float>(out[0], out[1], out[2], out[3]);
+}
+#endif // __SSE__
 
 using mat2 = mat<2>;
 using mat3 = mat<3>;
@@ -37,6 +37,10 @@ protected:
     BufferToken           buffer_token_;
     bool                  centered_;
 
+    // Simplified index lists on the same vertices, LOD 1 first
+    std::vector<std::vector<uint32_t>> lod_indices_;
+    std::vector<BufferToken>           lod_tokens_;
+
 public:
     Mesh():
     centered_(false){}
@@ -59,8 +63,18 @@ public:
     inline uint32_t get_n_elements() const    { return buffer_token_.n_elements; }
     inline uint32_t get_buffer_offset() const { return buffer_token_.buffer_offset; }
     inline const BufferToken& get_buffer_token() const { return buffer_token_; }
+    // LOD 0 is the full mesh
+    inline const BufferToken& get_buffer_token(uint32_t lod) const
+    {
+        return (lod==0) ? buffer_token_ : lod_tokens_[lod-1];
+    }
 
-    inline void set_batch_category(hash_t category) { buffer_token_.batch_category = category; }
+    inline void set_batch_category(hash_t category)
+    {
+        buffer_token_.batch_category = category;
+        for(auto&& token: lod_tokens_)
+            token.batch_category = category;
+    }
 
     inline bool is_centered() const           { return centered_; }
     inline void set_centered(bool value)      { centered_ = value; }
@@ -68,6 +82,25 @@ public:
     inline const std::vector<VertexT>&  get_vertex_buffer() const { return vertices_; }
     inline const std::vector<uint32_t>& get_index_buffer()  const { return indices_; }
     inline const std::array<float, 6>& get_dimensions() const     { return dimensions_; }
+    inline const std::vector<uint32_t>& get_index_buffer(uint32_t lod) const
+    {
+        return (lod==0) ? indices_ : lod_indices_[lod-1];
+    }
+
+    // * Levels of detail, must be added before the mesh is submitted to a render batch
+    inline uint32_t get_lod_count() const { return 1 + lod_indices_.size(); }
+    inline void add_lod(std::vector<uint32_t>&& indices)
+    {
+        BufferToken token;
+        token.n_elements = indices.size() / 3;
+        lod_tokens_.push_back(token);
+        lod_indices_.push_back(std::move(indices));
+    }
+    inline void clear_lods()
+    {
+        lod_indices_.clear();
+        lod_tokens_.clear();
+    }
 
 
     inline void _set_vertex(uint32_t index, const VertexT& vertex)
@@ -0,0 +1,131 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+#include "math3d.h"
+#include "mesh.hpp"
+
+namespace wcore
+{
+namespace lod
+{
+
+/*
+    Simplify an indexed triangle list with quadric error metrics (Garland & Heckbert).
+    Only half-edge collapses are performed: a vertex is merged into one of its neighbors,
+    so simplified triangles still reference the original vertex buffer, and a LOD chain
+    only costs additional index ranges.
+    Vertices on attribute seams (several vertices at the same position) and on open borders
+    are locked, which prevents cracks and texture distortions.
+    Simplification stops when the triangle count reaches target_triangles, or when no collapse
+    has a (squared distance) error under max_error.
+*/
+std::vector<uint32_t> simplify(const std::vector<math::vec3>& positions,
+                               const std::vector<uint32_t>& indices,
+                               uint32_t target_triangles,
+                               float max_error);
+
+// Generate up to max_levels LODs for a triangle mesh, each keeping a fraction 'reduction'
+// of the triangles of the previous level. max_error is relative to the mesh bounding box diagonal.
+// Generation stops early when a level does not reduce the triangle count significantly.
+// Returns the number of LODs added.
+template <typename VertexT>
+uint32_t generate_lods(Mesh<VertexT>& mesh, uint32_t max_levels, float reduction=0.5f, float max_error=0.02f)
+{
+    const auto& vertices = mesh.get_vertex_buffer();
+    std::vector<math::vec3> positions(vertices.size());
+    for(uint32_t ii=0; ii<vertices.size(); ++ii)
+        positions[ii] = vertices[ii].position_;
+
+    const auto& dims = mesh.get_dimensions();
+    math::vec3 extent(dims[1]-dims[0], dims[3]-dims[2], dims[5]-dims[4]);
+    float abs_error = max_error * extent.norm();
+    abs_error *= abs_error;
+
+    mesh.clear_lods();
+    uint32_t n_added = 0;
+    const std::vector<uint32_t>* source = &mesh.get_index_buffer();
+    for(uint32_t ll=0; ll<max_levels; ++ll)
+    {
+        uint32_t n_tris = source->size()/3;
+        uint32_t target = uint32_t(n_tris*reduction);
+        std::vector<uint32_t> indices = simplify(positions, *source, target, abs_error);
+        // Not worth an additional draw range
+        if(indices.empty() || indices.size()/3 > 0.9f*n_tris)
+            break;
+        mesh.add_lod(std::move(indices));
+        source = &mesh.get_index_buffer(++n_added);
+    }
+    return n_added;
+}
+
+/*
+    Screen space size based LOD selection. LOD l (l>0) is used when the projected size of
+    a model bounding sphere (fraction of the screen half-height) falls under
+    base_size*ratio^(l-1). Switching to another LOD requires the size to cross the
+    threshold by a relative margin (hysteresis) to avoid popping back and forth.
+*/
+struct LodSelector
+{
+    math::vec3 eye;                // Camera position
+    float projection_scale = 1.f;  // P(1,1) = 1/tan(fov/2)
+    float base_size        = 0.3f;
+    float ratio            = 0.5f;
+    float hysteresis       = 0.15f;
+
+    // Projected size of a bounding sphere
+    inline float screen_size(const math::vec3& center, float radius) const
+    {
+        float distance = (center-eye).norm();
+        if(distance <= radius)
+            return 1e6f;
+        return radius*projection_scale/distance;
+    }
+
+    // LOD to use for a given size, disregarding hysteresis
+    inline uint32_t level_for(float size, uint32_t n_lods) const
+    {
+        uint32_t level = 0;
+        float threshold = base_size;
+        while(level+1<n_lods && size<threshold)
+        {
+            ++level;
+            threshold *= ratio;
+        }
+        return level;
+    }
+
+    inline uint32_t select(float size, uint32_t current, uint32_t n_lods) const
+    {
+        // Coarsest and finest acceptable LODs
+        uint32_t coarse = level_for(size*(1.f+hysteresis), n_lods);
+        uint32_t fine   = level_for(size*(1.f-hysteresis), n_lods);
+        if(current < coarse)
+            return coarse;
+        if(current > fine)
+            return fine;
+        return current;
+    }
+
+    // Select LOD of a model from its bounding box vertices
+    inline uint32_t select(const std::array<math::vec3, 8>& box, uint32_t current, uint32_t n_lods) const
+    {
+        math::vec3 center(0.f);
+        for(auto&& vertex: box)
+            center += vertex;
+        center /= 8.f;
+        float radius = 0.f;
+        for(auto&& vertex: box)
+            radius = std::max(radius, (vertex-center).norm());
+        return select(screen_size(center, radius), current, n_lods);
+    }
+};
+
+} // namespace lod
+} // namespace wcore
+
+#endif // MESH_LOD_H
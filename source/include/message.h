@@ -95,19 +95,21 @@ struct NullData : public WData {};
 typedef std::function<bool(const WData&)> WpFunc;
 
 // Delegate creation helper functions
+// Delegates are plain lambdas, the call is inlined in std::function's invoker
+// instead of going through std::bind's argument forwarding machinery
 namespace dlg
 {
     template <typename T, typename INST>
     static WpFunc make_delegate(bool (T::*func)(const WData&), INST& inst)
     {
         T* ptr = static_cast<T*>(&inst);
-        return std::bind(func, ptr, std::placeholders::_1);
+        return [ptr, func](const WData& data) { return (ptr->*func)(data); };
     }
 
     template <typename D>
     static WpFunc make_delegate(bool (*func)(const WData&))
     {
-        return std::bind(func, std::placeholders::_1);
+        return func;
     }
 }
 
@@ -3,8 +3,10 @@
 
 #include <bitset>
 #include <cassert>
+#include <algorithm>
 
 #include "transformation.h"
+#include "transform_hierarchy.h"
 #include "mesh.hpp"
 #include "bounding_boxes.h"
 #include "logger.h"
@@ -65,8 +67,11 @@ protected:
     bool                  frustum_cull_;
     bool                  is_dynamic_;
     bool                  is_terrain_;
-    bool                  visible_;
     uint32_t              shadow_cull_face_;
+    uint32_t              lod_;        // Level of detail selected by last visibility pass
+    TransformHierarchy*   hierarchy_;      // Caches the world matrix once the model is in a scene
+    uint32_t              transform_node_; // Node of this model in hierarchy_
+    uint32_t              bbox_version_;   // Node version bounding boxes were computed at
 
     hash_t reference_;
     bool   has_reference_;
@@ -88,10 +93,23 @@ public:
 
     inline const Mesh<Vertex3P3N3T2U>& get_mesh() const         { return *pmesh_; }
     inline Mesh<Vertex3P3N3T2U>& get_mesh()                     { return *pmesh_; }
-    inline math::mat4 get_model_matrix()                        { return trans_.get_model_matrix(); }
+    // Buffer range of current level of detail
+    inline const BufferToken& get_buffer_token() const          { return pmesh_->get_buffer_token(lod_); }
+    inline uint32_t get_lod() const                             { return lod_; }
+    inline void set_lod(uint32_t lod)                           { lod_ = std::min(lod, pmesh_->get_lod_count()-1); }
+    inline math::mat4 get_model_matrix()                        { return hierarchy_ ? hierarchy_->get_world(transform_node_) : trans_.get_model_matrix(); }
     inline const Transformation& get_transformation() const     { return trans_; }
+    // Call sync_transform() after modifying the transformation through this reference
     inline Transformation& get_transformation()                 { return trans_; }
-    inline void set_transformation(const Transformation& trans) { trans_ = trans; }
+    inline void set_transformation(const Transformation& trans) { trans_ = trans; sync_transform(); }
+
+    // Register in a transform hierarchy, child of an other node if parent is specified
+    void attach_transform(TransformHierarchy& hierarchy, uint32_t parent=TransformHierarchy::NONE);
+    void detach_transform();
+    inline bool has_transform_node() const                      { return hierarchy_ != nullptr; }
+    inline uint32_t get_transform_node() const                  { return transform_node_; }
+    // Copy local transformation to the hierarchy, the node is flagged dirty if it changed
+    inline void sync_transform()                                { if(hierarchy_) hierarchy_->set_local(transform_node_, trans_); }
 
     inline const Material& get_material() const                 { return *pmaterial_; }
     inline Material& get_material()                             { return *pmaterial_; }
@@ -101,15 +119,16 @@ public:
     inline const math::vec3& get_position() const               { return trans_.get_position(); }
 
     inline void set_dynamic(bool value)                         { is_dynamic_ = value; }
+    inline bool is_dynamic() const                              { return is_dynamic_; }
     inline void update_OBB()                                    { obb_.update(get_model_matrix()); }
     inline void update_AABB()                                   { aabb_.update(get_OBB()); }
-    inline AABB& get_AABB()                                     { if(is_dynamic_) update_AABB(); return aabb_; }
-    inline OBB& get_OBB()                                       { if(is_dynamic_) update_OBB(); return obb_; }
+    inline AABB& get_AABB()                                     { if(is_dynamic_) refresh_bounding_boxes(); return aabb_; }
+    inline OBB& get_OBB()                                       { if(is_dynamic_) refresh_bounding_boxes(); return obb_; }
     inline void set_OBB_offset(const math::vec3& offset)        { obb_.set_offset(offset); }
     inline void update_bounding_boxes()                         { update_OBB(); update_AABB(); }
+    // Update bounding boxes if the world matrix changed since they were last computed
+    void refresh_bounding_boxes();
 
-    inline void set_visibility(bool value)                      { visible_ = value; }
-    inline bool is_visible() const                              { return visible_; }
     inline bool is_terrain() const                              { return is_terrain_; }
 
     inline void set_frustum_cull(bool value)                    { frustum_cull_ = value; }
@@ -117,20 +136,20 @@ public:
     inline void set_shadow_cull_face(uint32_t value)            { shadow_cull_face_ = value; }
     inline bool shadow_cull_face() const                        { return shadow_cull_face_; }
 
-    inline void set_position(const math::vec3& newpos)          { trans_.set_position(newpos); }
-    inline void set_orientation(const math::quat& newori)       { trans_.set_orientation(newori); }
-    inline void set_orientation(const math::vec3& newori)       { trans_.set_orientation(math::quat(newori.z(),newori.y(),newori.x())); }
-    inline void reset_orientation()                             { trans_.reset_orientation(); }
+    inline void set_position(const math::vec3& newpos)          { trans_.set_position(newpos); sync_transform(); }
+    inline void set_orientation(const math::quat& newori)       { trans_.set_orientation(newori); sync_transform(); }
+    inline void set_orientation(const math::vec3& newori)       { trans_.set_orientation(math::quat(newori.z(),newori.y(),newori.x())); sync_transform(); }
+    inline void reset_orientation()                             { trans_.reset_orientation(); sync_transform(); }
     inline math::vec3 get_orientation_euler(bool deg=true)      { return trans_.get_orientation_euler(deg); }
-    inline void set_scale(float scale)                          { trans_.set_scale(scale); }
-    inline void rotate(float phi, float theta, float psi)       { trans_.rotate(phi, theta, psi); }
-    inline void rotate(const math::vec3& axis, float angle)     { trans_.rotate(axis, angle); }
-    inline void rotate(math::vec3&& axis, float angle)          { trans_.rotate(std::forward<math::vec3>(axis), angle); }
-    inline void translate(const math::vec3& increment)          { trans_.translate(increment); }
-    inline void translate(float x, float y, float z)            { trans_.translate(x, y, z); }
-    inline void translate_x(float x)                            { trans_.translate_x(x); }
-    inline void translate_y(float y)                            { trans_.translate_y(y); }
-    inline void translate_z(float z)                            { trans_.translate_z(z); }
+    inline void set_scale(float scale)                          { trans_.set_scale(scale); sync_transform(); }
+    inline void rotate(float phi, float theta, float psi)       { trans_.rotate(phi, theta, psi); sync_transform(); }
+    inline void rotate(const math::vec3& axis, float angle)     { trans_.rotate(axis, angle); sync_transform(); }
+    inline void rotate(math::vec3&& axis, float angle)          { trans_.rotate(std::forward<math::vec3>(axis), angle); sync_transform(); }
+    inline void translate(const math::vec3& increment)          { trans_.translate(increment); sync_transform(); }
+    inline void translate(float x, float y, float z)            { trans_.translate(x, y, z); sync_transform(); }
+    inline void translate_x(float x)                            { trans_.translate_x(x); sync_transform(); }
+    inline void translate_y(float y)                            { trans_.translate_y(y); sync_transform(); }
+    inline void translate_z(float z)                            { trans_.translate_z(z); sync_transform(); }
 
     // Reference
     inline void set_reference(hash_t hname) { reference_ = hname; has_reference_ = true; }
@@ -23,6 +23,7 @@ class TerrainChunk;
 class SurfaceMeshFactory;
 class MaterialFactory;
 class TerrainFactory;
+class HeightMap;
 
 struct Vertex3P3N3T2U;
 template <typename VertexT> class Mesh;
@@ -48,6 +49,9 @@ public:
     // Create terrain patch from descriptor and an optional random engine
     std::shared_ptr<TerrainChunk> make_terrain_patch(const TerrainPatchDescriptor& desc,
                                                      OptRngT opt_rng=nullptr);
+    // Generate terrain height map from descriptor, no graphics resource involved
+    // so this can be called from a worker thread
+    HeightMap* make_heightmap(const TerrainPatchDescriptor& desc);
     // Create skybox from cubemap name
     std::shared_ptr<SkyBox> make_skybox(hash_t cubemap_name);
 
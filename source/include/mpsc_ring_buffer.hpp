@@ -0,0 +1,105 @@
+#ifndef MPSC_RING_BUFFER_HPP
+#define MPSC_RING_BUFFER_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cassert>
+
+namespace wcore
+{
+
+/*
+    Bounded lock-free queue, any number of producer threads and a single consumer thread.
+    Each cell holds a sequence number telling whether it is free for the producer that
+    reserved its position, or ready for the consumer. Producers reserve a position with
+    a single CAS, no thread ever waits on another thread inside push / pop.
+    (D. Vyukov's bounded MPMC queue, specialized for a single consumer)
+*/
+template <typename T>
+class MPSCRingBuffer
+{
+public:
+    // Capacity must be a power of 2
+    explicit MPSCRingBuffer(size_t capacity):
+    cells_(new Cell[capacity]),
+    mask_(capacity-1),
+    head_(0),
+    tail_(0)
+    {
+        assert(capacity>=2 && (capacity & (capacity-1)) == 0 && "MPSCRingBuffer: capacity must be a power of 2.");
+        for(size_t ii=0; ii<capacity; ++ii)
+            cells_[ii].sequence.store(ii, std::memory_order_relaxed);
+    }
+
+    MPSCRingBuffer(const MPSCRingBuffer&) = delete;
+    MPSCRingBuffer& operator=(const MPSCRingBuffer&) = delete;
+
+    // Any thread. Return false if queue is full, value is left untouched.
+    bool try_push(T&& value)
+    {
+        Cell* cell;
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if(diff == 0)
+            {
+                // Cell is free, try to reserve it
+                if(head_.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+                return false; // Cell still holds a value from previous lap
+            else
+                pos = head_.load(std::memory_order_relaxed); // Another producer got it
+        }
+
+        cell->data = std::move(value);
+        cell->sequence.store(pos+1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. Return false if queue is empty.
+    bool try_pop(T& value)
+    {
+        Cell& cell = cells_[tail_ & mask_];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if(intptr_t(seq) - intptr_t(tail_+1) < 0)
+            return false;
+
+        value = std::move(cell.data);
+        // Free cell for the producer one lap ahead
+        cell.sequence.store(tail_+mask_+1, std::memory_order_release);
+        ++tail_;
+        return true;
+    }
+
+    // Consumer thread only
+    inline bool empty() const
+    {
+        return intptr_t(cells_[tail_ & mask_].sequence.load(std::memory_order_acquire)) - intptr_t(tail_+1) < 0;
+    }
+
+    // Total number of positions reserved by producers so far
+    inline size_t get_push_count() const { return head_.load(std::memory_order_acquire); }
+    inline size_t get_capacity() const   { return mask_+1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_; // Next position to push to
+    alignas(64) size_t tail_;              // Next position to pop from
+};
+
+} // namespace wcore
+
+#endif // MPSC_RING_BUFFER_HPP
@@ -3,6 +3,8 @@
 
 #include <utility>
 #include <random>
+#include <vector>
+#include <algorithm>
 
 namespace wcore
 {
@@ -39,6 +41,12 @@ public:
         return generator_(xin,yin);
     }
 
+    // Raw noise for count samples at once, requires a policy with batched evaluation
+    inline void sample(const Float* xin, const Float* yin, Float* out, size_t count)
+    {
+        generator_(xin, yin, out, count);
+    }
+
     // Smooth filtering by local average        Kernel is 1/16 1/8 1/16
     Float smoothed_sample(Float x, Float y)            // 1/8  1/4 1/8
     {                                                  // 1/16 1/8 1/16
@@ -77,6 +85,35 @@ public:
         return total / maxAmplitude;
     }
 
+    // Octaved noise for count samples at once, same results as the single sample version
+    void octave_noise(const Float* x, const Float* y, Float* out, size_t count,
+                      size_t octaves, Float frequency, Float persistence)
+    {
+        std::vector<Float> xf(count), yf(count), samples(count);
+        std::fill(out, out+count, Float(0));
+        Float amplitude = 1;
+        Float maxAmplitude = 0;
+
+        for(size_t ii=0; ii<octaves; ++ii)
+        {
+            for(size_t kk=0; kk<count; ++kk)
+            {
+                xf[kk] = x[kk] * frequency;
+                yf[kk] = y[kk] * frequency;
+            }
+            sample(xf.data(), yf.data(), samples.data(), count);
+            for(size_t kk=0; kk<count; ++kk)
+                out[kk] += samples[kk] * amplitude;
+
+            frequency *= 1.95;
+            maxAmplitude += amplitude;
+            amplitude *= persistence;
+        }
+
+        for(size_t kk=0; kk<count; ++kk)
+            out[kk] /= maxAmplitude;
+    }
+
     Float scaled_octave_noise(Float x, Float y, size_t octaves, Float frequency,
                                  Float persistence, Float loBound, Float hiBound)
     {
@@ -8,6 +8,10 @@
 #include <random>
 #include <iterator>
 #include <array>
+#include <type_traits>
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
 
 #include "math3d.h"
 
@@ -106,6 +110,84 @@ private:
     }
 
 
+#ifdef __SSE2__
+    // Same algorithm as the scalar 2D noise, corner contributions are computed
+    // without branches and table lookups are done lane by lane
+    void simplex_2d_x4(const float* xin, const float* yin, float* out) const
+    {
+        const __m128 f2   = _mm_set1_ps(float(F2));
+        const __m128 g2   = _mm_set1_ps(float(G2));
+        const __m128 one  = _mm_set1_ps(1.f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+
+        __m128 x = _mm_loadu_ps(xin);
+        __m128 y = _mm_loadu_ps(yin);
+
+        // Skew the input space to determine which simplex cell we're in
+        __m128 s  = _mm_mul_ps(_mm_add_ps(x, y), f2);
+        __m128 xs = _mm_add_ps(x, s);
+        __m128 ys = _mm_add_ps(y, s);
+        // Floor: truncate then subtract 1 where truncation rounded up
+        __m128 fi = _mm_cvtepi32_ps(_mm_cvttps_epi32(xs));
+        __m128 fj = _mm_cvtepi32_ps(_mm_cvttps_epi32(ys));
+        fi = _mm_sub_ps(fi, _mm_and_ps(_mm_cmpgt_ps(fi, xs), one));
+        fj = _mm_sub_ps(fj, _mm_and_ps(_mm_cmpgt_ps(fj, ys), one));
+
+        // Unskew the cell origin back to (x,y) space
+        __m128 t  = _mm_mul_ps(_mm_add_ps(fi, fj), g2);
+        __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(fi, t));
+        __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(fj, t));
+
+        // Lower triangle if x0>y0
+        __m128 lower = _mm_cmpgt_ps(x0, y0);
+        __m128 i1 = _mm_and_ps(lower, one);
+        __m128 j1 = _mm_andnot_ps(lower, one);
+
+        __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g2);
+        __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, j1), g2);
+        __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), _mm_add_ps(g2, g2));
+        __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, one), _mm_add_ps(g2, g2));
+
+        // Hashed gradient indices of the three simplex corners
+        alignas(16) int32_t ii[4], jj[4], ii1[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(ii), _mm_cvtps_epi32(fi));
+        _mm_store_si128(reinterpret_cast<__m128i*>(jj), _mm_cvtps_epi32(fj));
+        _mm_store_si128(reinterpret_cast<__m128i*>(ii1), _mm_cvtps_epi32(i1));
+        alignas(16) float gx0[4], gy0[4], gx1[4], gy1[4], gx2[4], gy2[4];
+        for(int ll=0; ll<4; ++ll)
+        {
+            int il = ii[ll] & 255;
+            int jl = jj[ll] & 255;
+            int i1l = ii1[ll];
+            int j1l = 1-i1l;
+            int gi0 = perm_mod_12_[il+perm_[jl]];
+            int gi1 = perm_mod_12_[il+i1l+perm_[jl+j1l]];
+            int gi2 = perm_mod_12_[il+1+perm_[jl+1]];
+            gx0[ll] = float(grad3[gi0][0]); gy0[ll] = float(grad3[gi0][1]);
+            gx1[ll] = float(grad3[gi1][0]); gy1[ll] = float(grad3[gi1][1]);
+            gx2[ll] = float(grad3[gi2][0]); gy2[ll] = float(grad3[gi2][1]);
+        }
+
+        // Contribution of a corner, zero outside of its radius
+        auto corner = [&](__m128 xc, __m128 yc, const float* gx, const float* gy)
+        {
+            __m128 tc = _mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(xc, xc)), _mm_mul_ps(yc, yc));
+            tc = _mm_max_ps(tc, zero);
+            tc = _mm_mul_ps(tc, tc);
+            tc = _mm_mul_ps(tc, tc);
+            __m128 dot = _mm_add_ps(_mm_mul_ps(_mm_load_ps(gx), xc), _mm_mul_ps(_mm_load_ps(gy), yc));
+            return _mm_mul_ps(tc, dot);
+        };
+        __m128 n = _mm_add_ps(_mm_add_ps(corner(x0, y0, gx0, gy0),
+                                         corner(x1, y1, gx1, gy1)),
+                                         corner(x2, y2, gx2, gy2));
+
+        // Scale result to [-1,1]
+        _mm_storeu_ps(out, _mm_mul_ps(n, _mm_set1_ps(70.f)));
+    }
+#endif
+
     std::array<short,255> randp_;
     short* perm_;
     short* perm_mod_12_;
@@ -205,6 +287,22 @@ public:
         return 70.0 * (n0 + n1 + n2);
     }
 
+    // Batched 2D raw Simplex noise: out[k] = noise(xin[k], yin[k]) for k in [0,count)
+    // Single precision samples are evaluated 4 at a time when SSE2 is available.
+    void operator()(const Float* xin, const Float* yin, Float* out, size_t count)
+    {
+        size_t kk = 0;
+#ifdef __SSE2__
+        if constexpr(std::is_same<Float, float>::value)
+        {
+            for(; kk+4<=count; kk+=4)
+                simplex_2d_x4(xin+kk, yin+kk, out+kk);
+        }
+#endif
+        for(; kk<count; ++kk)
+            out[kk] = operator()(xin[kk], yin[kk]);
+    }
+
     // 3D raw Simplex noise
     Float operator()(Float xin, Float yin, Float zin)
     {
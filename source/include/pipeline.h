@@ -9,6 +9,7 @@ namespace wcore
 
 class GeometryRenderer;
 class ShadowMapRenderer;
+class HiZRenderer;
 class LightingRenderer;
 class ForwardRenderer;
 class SSAORenderer;
@@ -20,12 +21,16 @@ class DebugRenderer;
 class DebugOverlayRenderer;
 class GuiRenderer;
 class InputHandler;
+class Renderer;
+class Scene;
+class UniformBuffer;
 
 class RenderPipeline : public GameSystem
 {
 private:
     GeometryRenderer*        geometry_renderer_;
     ShadowMapRenderer*       shadow_map_renderer_;
+    HiZRenderer*             hiz_renderer_;
     LightingRenderer*        lighting_renderer_;
     ForwardRenderer*         forward_renderer_;
     SSAORenderer*            SSAO_renderer_;
@@ -37,6 +42,8 @@ private:
     DebugOverlayRenderer*    debug_overlay_renderer_;
     GuiRenderer*             gui_renderer_;
 
+    UniformBuffer*           frame_ubo_; // Backs the frame_data uniform block
+
 public:
 
     RenderPipeline();
@@ -102,6 +109,10 @@ public:
 #endif
 
 private:
+    // Upload camera matrices of current frame to the frame_data uniform block
+    void update_frame_data(Scene* pscene);
+    // Render a pass if its renderer is enabled, within a GPU profiling marker
+    void render_pass(Renderer& renderer, Scene* pscene, const char* name);
 #ifdef __DEBUG__
     void perform_test(); // Anything in here is bound to "k_test_key"
 #endif
@@ -0,0 +1,129 @@
+#ifndef NULL_BUFFER_H
+#define NULL_BUFFER_H
+
+#include "buffer.h"
+
+namespace wcore
+{
+
+// Buffers of the null graphics API: no storage on any device, binds and
+// uploads are reported to the null render device (see null_renderer_api.h)
+
+class NullVertexBuffer: public VertexBuffer
+{
+public:
+    NullVertexBuffer(float* vertex_data, std::size_t size, bool dynamic=false);
+    virtual ~NullVertexBuffer();
+
+    virtual void bind() const override;
+    virtual void unbind() const override;
+
+    virtual void stream(float* vertex_data, std::size_t size, std::size_t offset) const override;
+
+private:
+    uint32_t rd_handle_;
+};
+
+class NullIndexBuffer: public IndexBuffer
+{
+public:
+    NullIndexBuffer(uint32_t* index_data, std::size_t size, bool dynamic=false);
+    virtual ~NullIndexBuffer();
+
+    virtual void bind() const override;
+    virtual void unbind() const override;
+
+    virtual void stream(uint32_t* index_data, std::size_t size, std::size_t offset) const override;
+
+private:
+    uint32_t rd_handle_;
+};
+
+class NullTextureBuffer: public TextureBuffer
+{
+public:
+    NullTextureBuffer(TextureBufferFormat format, std::size_t size=0);
+    virtual ~NullTextureBuffer();
+
+    virtual void bind(uint32_t unit) const override;
+    virtual void unbind() const override;
+
+    virtual void stream(const void* data, std::size_t size) override;
+    virtual bool set_source(const StreamBuffer& buffer, std::size_t offset, std::size_t size) override;
+
+private:
+    uint32_t texture_handle_;
+};
+
+class NullUniformBuffer: public UniformBuffer
+{
+public:
+    NullUniformBuffer(std::size_t size, bool dynamic=true);
+    virtual ~NullUniformBuffer();
+
+    virtual void bind(uint32_t binding) const override;
+
+    virtual void stream(const void* data, std::size_t size, std::size_t offset=0) const override;
+
+private:
+    uint32_t rd_handle_;
+};
+
+// Data is still copied to a client side ring, so that the cost of producers matches
+// the one of a persistently mapped buffer
+class NullStreamBuffer: public StreamBuffer
+{
+public:
+    NullStreamBuffer(std::size_t frame_size, uint32_t n_frames);
+    virtual ~NullStreamBuffer();
+
+    virtual std::size_t write(const void* data, std::size_t size, std::size_t alignment=16) override;
+    virtual void next_frame() override;
+
+    virtual void bind_vertex() const override;
+    virtual void unbind_vertex() const override;
+    virtual void bind_uniform(uint32_t binding, std::size_t offset, std::size_t size) const override;
+
+    virtual std::size_t get_frame_capacity() const override { return frame_size_; }
+
+private:
+    uint32_t rd_handle_;
+    std::size_t frame_size_;
+    uint32_t n_frames_;
+    uint32_t frame_;            // Region written this frame
+    std::size_t head_;          // Write position in current region
+    std::vector<uint8_t> data_;
+};
+
+// Transfers never complete, users keep their previous data
+class NullReadbackBuffer: public ReadbackBuffer
+{
+public:
+    NullReadbackBuffer(std::size_t size);
+    virtual ~NullReadbackBuffer();
+
+    virtual void read(uint32_t width, uint32_t height) override;
+    virtual bool is_ready() const override;
+    virtual const float* map() override;
+    virtual void unmap() override;
+};
+
+class NullVertexArray: public VertexArray
+{
+public:
+    NullVertexArray();
+    virtual ~NullVertexArray();
+
+    virtual void bind() const override;
+    virtual void unbind() const override;
+
+    virtual void set_layout(const BufferLayout& layout) const override;
+    virtual void set_instance_layout(const BufferLayout& layout, uint32_t first_location, std::size_t offset=0) const override;
+
+private:
+    uint32_t rd_handle_;
+};
+
+} // namespace wcore
+
+#endif // NULL_BUFFER_H
@@ -0,0 +1,216 @@
+#ifndef NULL_RENDERER_API_H
+#define NULL_RENDERER_API_H
+
+#include <array>
+#include <vector>
+#include <cassert>
+
+#include "gfx_api.h"
+
+namespace wcore
+{
+
+// Render states tracked by the null device
+enum class NullState: uint8_t
+{
+    Framebuffer,
+    Viewport,
+    Scissor,
+    ScissorTest,
+    CullMode,
+    LineWidth,
+    DepthTest,
+    DepthFunc,
+    DepthLock,
+    StencilTest,
+    StencilFunc,
+    StencilOperator,
+    StencilLock,
+    Blending,
+    ColorLock,
+    ClearColor,
+    PackAlignment,
+    UnpackAlignment,
+    Program,
+    VertexArray,
+    InstanceLayout,
+    VertexBuffer,
+    IndexBuffer,
+    UniformBuffer,
+
+    COUNT
+};
+
+enum class GfxCommandType: uint8_t
+{
+    Draw,          // args: primitive, number of elements, offset
+    DrawInstanced, // args: primitive, number of elements, number of instances
+    Clear,         // args: clear flags
+    SetState,      // args: NullState, first state value
+    BindTexture,   // args: unit, texture handle
+    Upload,        // args: number of bytes
+    Blit,          // args: source handle, destination handle
+    ReadPixels,    // args: width, height
+};
+
+// A command received by the null device
+struct GfxCommand
+{
+    GfxCommandType type;
+    uint32_t arg0;
+    uint32_t arg1;
+    uint32_t arg2;
+};
+
+// Counters accumulated by the null device, per frame and since device creation
+struct GfxStats
+{
+    uint64_t draw_calls        = 0;
+    uint64_t instances         = 0; // Instances drawn, 1 per non-instanced draw call
+    uint64_t elements          = 0; // Primitives drawn
+    uint64_t clears            = 0;
+    uint64_t state_changes     = 0; // Commands that actually changed a state (binds included)
+    uint64_t redundant_states  = 0; // Commands setting a state to its current value
+    uint64_t program_binds     = 0;
+    uint64_t texture_binds     = 0;
+    uint64_t framebuffer_binds = 0;
+    uint64_t uploads           = 0; // Buffer, texture and uniform uploads
+    uint64_t bytes_uploaded    = 0;
+    uint64_t frames            = 0;
+
+    void accumulate(const GfxStats& other);
+};
+
+/*
+    Render device that talks to no graphics API. State and draw commands are
+    checked against the current state, counted, and optionally recorded as a
+    command stream, so that the CPU side of a frame (scene update, culling,
+    batching, render passes) can be run, measured and tested on machines
+    without a GPU nor a display.
+    Textures, shaders, framebuffers and buffers created while the API is
+    GfxAPI::Null get their handles from this device and report their binds
+    and uploads to it.
+    Like the OpenGL context, it must only be used by the render thread.
+*/
+class NullRenderDevice: public RenderDevice
+{
+public:
+    NullRenderDevice();
+    virtual ~NullRenderDevice();
+
+    // * Framebuffer
+    virtual uint32_t get_default_framebuffer() override;
+    virtual void set_default_framebuffer(uint32_t index) override;
+    virtual void bind_default_frame_buffer() override;
+    virtual void bind_framebuffer(uint32_t handle) override;
+    // Fills pixels with zeros
+    virtual void read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels) override;
+
+    // * Draw commands
+    virtual void draw_indexed(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset) override;
+    virtual void draw_indexed_instanced(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset, uint32_t n_instances) override;
+    virtual void set_clear_color(float r, float g, float b, float a) override;
+    virtual void clear(int flags) override;
+    virtual void lock_color_buffer() override;
+
+    // * Depth-stencil state
+    virtual void set_depth_lock(bool value) override;
+    virtual void set_stencil_lock(bool value) override;
+    virtual void set_depth_func(DepthFunc value) override;
+    virtual void set_depth_test_enabled(bool value) override;
+    virtual void set_stencil_func(StencilFunc value, uint16_t a=0, uint16_t b=0) override;
+    virtual void set_stencil_operator(StencilOperator value) override;
+    virtual void set_stencil_test_enabled(bool value) override;
+
+    // * Blending
+    virtual void set_std_blending() override;
+    virtual void set_light_blending() override;
+    virtual void disable_blending() override;
+
+    // * Byte-alignment
+    virtual void set_pack_alignment(uint32_t value) override;
+    virtual void set_unpack_alignment(uint32_t value) override;
+
+    // * Raster state
+    virtual void viewport(float xx, float yy, float width, float height) override;
+    virtual void set_scissor(int32_t xx, int32_t yy, int32_t width, int32_t height) override;
+    virtual void set_scissor_test_enabled(bool value) override;
+    virtual void set_cull_mode(CullMode value) override;
+    virtual void set_line_width(float value) override;
+
+    // * Sync
+    virtual void finish() override;
+    virtual void flush() override;
+
+    // * Debug
+    // Always 0
+    virtual uint32_t get_error() override;
+    virtual void assert_no_error() override;
+
+    // TMP
+    virtual void bind_texture2D(uint32_t unit, uint32_t tex_handle) override;
+    virtual void unbind_texture2D() override;
+
+    // * Null device specifics
+    // Get a new non-zero handle for a device object
+    inline uint32_t create_handle() { return ++last_handle_; }
+    // Set a tracked state, count it as a state change if value differs from the current one
+    void set_state(NullState state, uint32_t v0, uint32_t v1=0, uint32_t v2=0, uint32_t v3=0);
+    // Count a transfer of size bytes from client memory to device
+    void upload(std::size_t size);
+    // Record a command that does not change any tracked state
+    void record(const GfxCommand& command);
+
+    // Close current frame: frame statistics are accumulated and made available
+    // through get_last_frame_stats(), command stream of the frame is kept until next frame ends
+    void end_frame();
+    // Forget all statistics and recorded commands, tracked states are kept
+    void reset_stats();
+
+    // Enable/Disable command recording, statistics are always updated
+    inline void set_recording_enabled(bool value)                 { recording_ = value; }
+    inline bool is_recording_enabled() const                      { return recording_; }
+    // Statistics of the frame being recorded
+    inline const GfxStats& get_frame_stats() const                { return frame_stats_; }
+    // Statistics of the last completed frame
+    inline const GfxStats& get_last_frame_stats() const           { return last_frame_stats_; }
+    // Statistics of all completed frames
+    inline const GfxStats& get_total_stats() const                { return total_stats_; }
+    // Commands of the frame being recorded
+    inline const std::vector<GfxCommand>& get_commands() const    { return commands_; }
+    // Commands of the last completed frame
+    inline const std::vector<GfxCommand>& get_last_commands() const { return last_commands_; }
+
+#ifdef __DEBUG__
+    void dbg_show_statistics() const;
+#endif
+
+private:
+    void bind_texture_unit(uint32_t unit, uint32_t handle);
+
+private:
+    uint32_t default_framebuffer_;
+    uint32_t last_handle_;
+    bool recording_;
+
+    std::array<std::array<uint32_t, 4>, size_t(NullState::COUNT)> state_; // Current value of each state
+    std::array<bool, size_t(NullState::COUNT)> state_set_;                 // State was set at least once
+    std::vector<uint32_t> texture_units_;                                  // Texture bound to each unit
+
+    GfxStats frame_stats_;
+    GfxStats last_frame_stats_;
+    GfxStats total_stats_;
+    std::vector<GfxCommand> commands_;
+    std::vector<GfxCommand> last_commands_;
+};
+
+// Device in use when the graphics API is GfxAPI::Null
+inline NullRenderDevice& null_device()
+{
+    assert(Gfx::get_api() == GfxAPI::Null && "null_device(): graphics API is not GfxAPI::Null.");
+    return static_cast<NullRenderDevice&>(*Gfx::device);
+}
+
+} // namespace wcore
+
+#endif // NULL_RENDERER_API_H
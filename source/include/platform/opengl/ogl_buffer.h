@@ -36,6 +36,83 @@ private:
     uint32_t rd_handle_;
 };
 
+class OGLTextureBuffer: public TextureBuffer
+{
+public:
+    OGLTextureBuffer(TextureBufferFormat format, std::size_t size=0);
+    virtual ~OGLTextureBuffer();
+
+    virtual void bind(uint32_t unit) const override;
+    virtual void unbind() const override;
+
+    virtual void stream(const void* data, std::size_t size) override;
+    virtual bool set_source(const StreamBuffer& buffer, std::size_t offset, std::size_t size) override;
+
+private:
+    uint32_t rd_handle_;
+    uint32_t texture_handle_;
+    uint32_t internal_format_;
+    std::size_t capacity_;
+    bool external_source_; // Texture samples a stream buffer range
+};
+
+class OGLUniformBuffer: public UniformBuffer
+{
+public:
+    OGLUniformBuffer(std::size_t size, bool dynamic=true);
+    virtual ~OGLUniformBuffer();
+
+    virtual void bind(uint32_t binding) const override;
+
+    virtual void stream(const void* data, std::size_t size, std::size_t offset=0) const override;
+
+private:
+    uint32_t rd_handle_;
+};
+
+class OGLStreamBuffer: public StreamBuffer
+{
+public:
+    OGLStreamBuffer(std::size_t frame_size, uint32_t n_frames);
+    virtual ~OGLStreamBuffer();
+
+    virtual std::size_t write(const void* data, std::size_t size, std::size_t alignment=16) override;
+    virtual void next_frame() override;
+
+    virtual void bind_vertex() const override;
+    virtual void unbind_vertex() const override;
+    virtual void bind_uniform(uint32_t binding, std::size_t offset, std::size_t size) const override;
+
+    virtual std::size_t get_frame_capacity() const override { return frame_size_; }
+
+    inline uint32_t get_handle() const { return rd_handle_; }
+
+private:
+    uint32_t rd_handle_;
+    std::size_t frame_size_;
+    uint32_t n_frames_;
+    uint32_t frame_;            // Region written this frame
+    std::size_t head_;          // Write position in current region
+    uint8_t* mapped_;           // Persistent mapping, null if ARB_buffer_storage is not supported
+    std::vector<void*> fences_; // Signaled when the GPU is done with each region
+};
+
+class OGLReadbackBuffer: public ReadbackBuffer
+{
+public:
+    OGLReadbackBuffer(std::size_t size);
+    virtual ~OGLReadbackBuffer();
+
+    virtual void read(uint32_t width, uint32_t height) override;
+    virtual bool is_ready() const override;
+    virtual const float* map() override;
+    virtual void unmap() override;
+
+private:
+    uint32_t rd_handle_;
+    void* fence_; // Sync object signaled when transfer completes
+};
+
 class OGLVertexArray: public VertexArray
 {
 public:
@@ -46,6 +123,7 @@ public:
     virtual void unbind() const override;
 
     virtual void set_layout(const BufferLayout& layout) const override;
+    virtual void set_instance_layout(const BufferLayout& layout, uint32_t first_location, std::size_t offset=0) const override;
 
 private:
     uint32_t rd_handle_;
@@ -20,12 +20,16 @@ public:
     virtual void set_default_framebuffer(uint32_t index) override;
     // Bind the default framebuffer
     virtual void bind_default_frame_buffer() override;
+    // Bind a framebuffer as render target
+    virtual void bind_framebuffer(uint32_t handle) override;
     // Read framebuffer content to an array
     virtual void read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels) override;
 
     // * Draw commands
     // Draw a given number of primitives using currently bound index buffer, starting at a given offset
     virtual void draw_indexed(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset) override;
+    // Same as draw_indexed, repeated n_instances times using per-instance attributes
+    virtual void draw_indexed_instanced(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset, uint32_t n_instances) override;
     // Set the color used to clear any framebuffer
     virtual void set_clear_color(float r, float g, float b, float a) override;
     // Clear currently bound framebuffer
@@ -66,6 +70,10 @@ public:
     // * Raster state
     // Set the position and size of area to draw to
     virtual void viewport(float xx, float yy, float width, float height) override;
+    // Restrict drawing and clearing to a rectangle when scissor test is enabled
+    virtual void set_scissor(int32_t xx, int32_t yy, int32_t width, int32_t height) override;
+    // Enable/Disable scissor test
+    virtual void set_scissor_test_enabled(bool value) override;
     // Set which faces to cull out (front/back/none)
     virtual void set_cull_mode(CullMode value) override;
     // Set the line width for next line primitive draw calls
@@ -76,6 +76,14 @@ using quat = Quaternion;
 
 extern Quaternion slerp(const Quaternion& q0, const Quaternion& q1, float t);
 
+// Model matrix T*R*S of a position, orientation and uniform scale, built directly
+// from the rotation matrix, without matrix products.
+mat4 compose_trs(const vec3& position, const Quaternion& orientation, float scale=1.f);
+// Batch version: out[ii] = compose_trs(positions[ii], orientations[ii], scales[ii])
+// scales can be null for unscaled transformations.
+void compose_trs(const vec3* positions, const Quaternion* orientations, const float* scales,
+                 mat4* out, size_t count);
+
 } // namespace math
 } // namespace wcore
 #endif // QUATERNION_H
@@ -3,9 +3,11 @@
 
 #include "logger.h"
 #include "mesh.hpp"
+#include "vertex_format.h"
 
 #include "buffer.h"
 #include "gfx_api.h"
+#include "geometry_pool.hpp"
 
 namespace wcore
 {
@@ -17,20 +19,30 @@ private:
     VertexBuffer* VBO_;
     IndexBuffer* IBO_;
     VertexArray* VAO_;
+    VertexBuffer* instance_VBO_;
+    uint32_t instance_capacity_;
+    std::size_t instance_offset_; // Instance data location in the stream buffer, if it was streamed there
     DrawPrimitive primitive_;
     hash_t category_;
+    bool pooled_;         // Static geometry is uploaded to a slice of the shared geometry pool
+    GeometrySlice slice_; // Valid if the batch currently lives in the pool
 
     std::vector<VertexT> vertices_;
     std::vector<uint32_t> indices_;
 
 public:
     explicit RenderBatch(hash_t category,
-                         DrawPrimitive primitive = DrawPrimitive::Triangles):
+                         DrawPrimitive primitive = DrawPrimitive::Triangles,
+                         bool pooled = false):
     VBO_(nullptr),
     IBO_(nullptr),
     VAO_(nullptr),
+    instance_VBO_(nullptr),
+    instance_capacity_(0),
+    instance_offset_(StreamBuffer::INVALID_OFFSET),
     primitive_(primitive),
-    category_(category)
+    category_(category),
+    pooled_(pooled)
     {
         DLOGN("New render batch:", "batch");
         DLOGI("Category: <n>" + HRESOLVE(category_) + "</n>", "batch");
@@ -40,6 +52,14 @@ public:
     {
         DLOGN("Destroying render batch cat(<n>" + HRESOLVE(category_) + "</n>)", "batch");
 
+        // Pool buffers are shared, only give the slice back
+        if(slice_.is_valid())
+        {
+            GeometryPool<VertexT>::instance().release(slice_);
+            delete instance_VBO_;
+            return;
+        }
+
         // First unbind
         if(IBO_) IBO_->unbind();
         if(VBO_) VBO_->unbind();
@@ -51,6 +71,7 @@ public:
         // Then delete buffers
         delete IBO_;
         delete VBO_;
+        delete instance_VBO_;
     }
 
     inline uint32_t get_n_vertices() const  { return vertices_.size(); }
@@ -73,6 +94,14 @@ public:
 
         vertices_.insert(vertices_.end(),vertices.begin(),vertices.end());
         indices_.insert(indices_.end(),transformed_indices.begin(),transformed_indices.end());
+
+        // LODs share the vertices, only their index ranges are appended
+        for(uint32_t ll=0; ll<mesh.lod_indices_.size(); ++ll)
+        {
+            mesh.lod_tokens_[ll].buffer_offset = indices_.size();
+            for(uint32_t ind: mesh.lod_indices_[ll])
+                indices_.push_back(ind+vert_offset);
+        }
     }
 
     void upload(bool dynamic=false,
@@ -97,6 +126,9 @@ public:
                             + std::to_string(size_index_kb) + "kB</v>", "batch");
 #endif
 
+        if(pooled_ && !dynamic && upload_pooled(nvert, nind))
+            return;
+
         VAO_ = VertexArray::create();
         VAO_->bind();
 
@@ -120,7 +152,7 @@ public:
 
         VAO_->bind();
         IBO_->bind();
-        Gfx::device->draw_indexed(primitive_, n_elements, offset);
+        Gfx::device->draw_indexed(primitive_, n_elements, slice_.base_index + offset);
         IBO_->unbind();
         //VAO_->unbind();
     }
@@ -129,6 +161,76 @@ public:
     {
         draw(buffer_token.n_elements, buffer_token.buffer_offset);
     }
+
+    // Send per-instance data used by the next instanced draw calls
+    void stream_instances(const std::vector<InstanceData>& instances)
+    {
+        if(instances.empty() || VAO_==nullptr) return;
+
+        // Shared stream buffer region of this frame, if it has room left
+        if(Gfx::stream_buffer)
+        {
+            instance_offset_ = Gfx::stream_buffer->write(instances.data(), instances.size()*sizeof(InstanceData));
+            if(instance_offset_ != StreamBuffer::INVALID_OFFSET)
+                return;
+        }
+
+        // Grow instance buffer if needed
+        if(instances.size() > instance_capacity_)
+        {
+            delete instance_VBO_;
+            instance_capacity_ = std::max(uint32_t(instances.size()), 2*instance_capacity_);
+            DLOGN("Instance buffer of batch cat(<n>" + HRESOLVE(category_) + "</n>) resized to <v>"
+                  + std::to_string(instance_capacity_) + "</v> instances", "batch");
+            instance_VBO_ = VertexBuffer::create(nullptr, instance_capacity_*sizeof(InstanceData), true);
+        }
+        instance_VBO_->stream(reinterpret_cast<float*>(const_cast<InstanceData*>(instances.data())),
+                              instances.size()*sizeof(InstanceData), 0);
+    }
+
+    // Draw n_instances copies of a mesh in a single call, using instance data
+    // [first_instance, first_instance+n_instances) of the last stream_instances() call
+    void draw_instanced(const BufferToken& buffer_token, uint32_t first_instance, uint32_t n_instances) const
+    {
+        if(buffer_token.n_elements==0 || n_instances==0) return;
+
+        VAO_->bind();
+        // Per-instance attributes follow vertex attributes
+        std::size_t base_offset = 0;
+        if(instance_offset_ != StreamBuffer::INVALID_OFFSET)
+        {
+            Gfx::stream_buffer->bind_vertex();
+            base_offset = instance_offset_;
+        }
+        else
+            instance_VBO_->bind();
+        VAO_->set_instance_layout(InstanceData::Layout,
+                                  VertexT::Layout.get_element_count(),
+                                  base_offset + first_instance*sizeof(InstanceData));
+        IBO_->bind();
+        Gfx::device->draw_indexed_instanced(primitive_, buffer_token.n_elements, slice_.base_index + buffer_token.buffer_offset, n_instances);
+        IBO_->unbind();
+    }
+
+private:
+    // Copy batch to a pool slice, returns false if no slice could be allocated
+    bool upload_pooled(uint32_t nvert, uint32_t nind)
+    {
+        auto& pool = GeometryPool<VertexT>::instance();
+        pool.release(slice_);
+        if(!pool.allocate(nvert, nind, slice_))
+            return false;
+
+        // Indices refer to arena vertices
+        std::vector<uint32_t> arena_indices(indices_.begin(), indices_.begin()+nind);
+        for(uint32_t& index: arena_indices)
+            index += slice_.base_vertex;
+        pool.upload(slice_, vertices_, nvert, arena_indices, nind);
+
+        VAO_ = pool.get_vertex_array(slice_);
+        IBO_ = pool.get_index_buffer(slice_);
+        return true;
+    }
 };
 
 }
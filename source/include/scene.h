@@ -8,9 +8,18 @@
 #include "singleton.hpp"
 #include "game_system.h"
 #include "render_batch.hpp"
+#include "command_bucket.hpp"
 #include "chunk.h"
+#include "chunk_grid.hpp"
+#include "hiz_buffer.h"
+#include "mesh_lod.h"
+#include "transform_hierarchy.h"
 #include "wentity.h"
-#include "octree.hpp"
+#ifdef __OPTIM_LINEAR_OCTREE__
+    #include "linear_octree.hpp"
+#else
+    #include "octree.hpp"
+#endif
 #ifndef __DISABLE_EDITOR__
 #include "editor.h"
 #endif
@@ -38,17 +47,30 @@ struct StaticOctreeData
     }
 };
 
+// Range of chunk visibility slots culled by a single job
+struct CullingTask
+{
+    Chunk* chunk;
+    uint32_t begin;
+    uint32_t end;
+};
+
 class Scene: public GameSystem
 {
 private:
+#ifdef __OPTIM_LINEAR_OCTREE__
+    typedef LinearOctree<BoundingRegion, StaticOctreeData> StaticOctree;
+#else
     typedef Octree<BoundingRegion, StaticOctreeData> StaticOctree;
+#endif
 
     RenderBatch<Vertex3P3N3T2U>  instance_render_batch_;
 
-    std::map<uint32_t, Chunk*> chunks_;
+    TransformHierarchy transforms_;            // World matrices of chunk models, outlives chunks
+    ChunkGrid<Chunk*> chunks_;
     std::map<hash_t, std::weak_ptr<Model>> ref_models_;
     std::map<hash_t, std::weak_ptr<Light>> ref_lights_;
-    std::vector<uint64_t> displayable_entities_;
+    std::vector<Model*> displayable_models_;   // Models of entities with a WCModel component
     StaticOctree static_octree;
 
     std::shared_ptr<SkyBox> skybox_;           // Optional skybox
@@ -59,6 +81,34 @@ private:
     uint32_t current_chunk_index_;             // Index of the chunk the camera is in
     math::i32vec2 current_chunk_coords_;       // Coordinates of the chunk the camera is in
     std::vector<uint32_t> chunks_order_;       // Permutation vector for chunk ordering
+    std::vector<CullingTask> culling_tasks_;   // Visibility pass jobs
+    CullingBoxes entity_boxes_;                // Bounding boxes of displayable entities
+    VisibilityBitset entity_visibility_;       // Same order as displayable models
+    uint64_t displayable_version_;             // Entity registry structure version displayable models were gathered at
+    HiZBuffer occlusion_buffer_;               // Filled by the renderer, used by next visibility pass
+    bool occlusion_culling_;                   // Test frustum culling survivors against occlusion buffer
+    float occlusion_max_motion_;               // Occlusion buffer is ignored past this eye displacement, <0: never
+    lod::LodSelector lod_selector_;            // Screen size based LOD selection
+    bool lod_selection_;                       // Select LODs during visibility pass, else LOD 0 is kept
+    lod::LodSelector terrain_lod_selector_;    // Geomipmapping level selection for terrain chunks
+    bool terrain_lod_;                         // Draw terrain chunks at selected level, else at full resolution
+
+    // Hardware instancing
+    struct InstanceRef
+    {
+        const Model* model;
+        uint32_t buffer_offset;     // Mesh location in instance batch
+        std::size_t material_hash;
+    };
+    struct InstanceGroup
+    {
+        uint32_t first;             // First instance in batch
+        uint32_t count;
+    };
+    std::vector<InstanceRef> instance_refs_;     // Visible instances of current frame
+    std::vector<InstanceData> instance_data_;    // Per-instance attributes of current frame
+    std::vector<InstanceGroup> instance_groups_; // One instanced draw call each
+    bool instance_batches_dirty_;                // Visibility changed since instance batches were built
 
 public:
     Scene();
@@ -82,11 +132,24 @@ public:
     inline uint32_t get_current_chunk_index() const                 { return current_chunk_index_; }
     inline uint32_t get_num_loaded_chunks() const                   { return chunks_.size(); }
     inline const math::i32vec2& get_current_chunk_coords() const    { return current_chunk_coords_; }
+    inline HiZBuffer& get_occlusion_buffer()                        { return occlusion_buffer_; }
+    inline const HiZBuffer& get_occlusion_buffer() const            { return occlusion_buffer_; }
+    inline bool is_occlusion_culling_enabled() const                { return occlusion_culling_; }
+    inline void set_occlusion_culling_enabled(bool value)           { occlusion_culling_ = value; }
+    inline float& get_occlusion_max_motion_nc()                     { return occlusion_max_motion_; }
+    inline lod::LodSelector& get_lod_selector()                     { return lod_selector_; }
+    inline bool is_lod_selection_enabled() const                    { return lod_selection_; }
+    inline void set_lod_selection_enabled(bool value)               { lod_selection_ = value; }
+    inline lod::LodSelector& get_terrain_lod_selector()             { return terrain_lod_selector_; }
+    inline bool is_terrain_lod_enabled() const                      { return terrain_lod_; }
+    inline void set_terrain_lod_enabled(bool value)                 { terrain_lod_ = value; }
     inline const math::i32vec2& get_chunk_coordinates(uint32_t chunk_index) const { return chunks_.at(chunk_index)->get_coordinates(); }
+    inline TransformHierarchy& get_transform_hierarchy()            { return transforms_; }
 
-    inline bool has_chunk(uint32_t chunk_index) const               { return chunks_.find(chunk_index) != chunks_.end(); }
+    inline bool has_chunk(uint32_t chunk_index) const               { return chunks_.contains(chunk_index); }
     inline math::vec3 get_chunk_center(uint32_t chunk_index) const;
     inline const Chunk& get_chunk(uint32_t chunk_index) const       { return *chunks_.at(chunk_index); }
+    inline Chunk& get_chunk_nc(uint32_t chunk_index)                { return *chunks_.at(chunk_index); }
     void get_loaded_chunks_coords(std::vector<math::i32vec2>& coord_list) const;
     void get_far_chunks(uint32_t unload_radius, std::vector<uint32_t>& chunk_list) const;
 
@@ -119,17 +182,18 @@ public:
     void add_terrain(std::shared_ptr<TerrainChunk> terrain, uint32_t chunk_index);
     std::weak_ptr<Model> get_model_by_ref(hash_t href);
     std::weak_ptr<Light> get_light_by_ref(hash_t href);
+    // Make child transformation relative to parent, both models must have been added to the scene
+    void set_model_parent(Model& child, const Model& parent);
     inline void add_position_updater(PositionUpdater* updater, uint32_t chunk_index)   { chunks_.at(chunk_index)->add_position_updater(updater); }
     inline void add_rotator(ConstantRotator* rotator, uint32_t chunk_index)            { chunks_.at(chunk_index)->add_rotator(rotator); }
 
     inline void set_skybox(std::shared_ptr<SkyBox> skybox) { skybox_ = skybox; }
 
-    //uint64_t add_entity(std::shared_ptr<WEntity> entity);
-    inline void register_displayable_entity(uint64_t id) { displayable_entities_.push_back(id); }
-
     // Methods
     // Upload given chunk geometry to OpenGL
     inline void load_geometry(uint32_t chunk_index) { if(chunk_index) chunks_.at(chunk_index)->load_geometry(); }
+    // Upload geometry of a chunk whose render batches were filled beforehand (chunk streaming)
+    inline void upload_geometry(uint32_t chunk_index) { if(chunk_index) chunks_.at(chunk_index)->upload_geometry(); }
     // Initialize event listener
     virtual void init_events(InputHandler& handler) override;
     // Update camera and models that use basic updaters
@@ -143,17 +207,20 @@ public:
     // Sort models within each chunk according to distance to light camera
     void sort_models_light();
     // Sort chunks according to distance from their centers to camera
+    // Chunks whose geometry is not uploaded yet are left out
     void sort_chunks();
     // Visit the 4 cardinal neighbors of a given chunk
     void traverse_loaded_neighbor_chunks(uint32_t chunk_index,
                                          std::function<void(Chunk*, wcore::NEIGHBOR)> visitor);
     // Visit category of models in loaded chunks in a specified order
+    // visible_only: skip models culled during the last visibility pass
     void traverse_models(ModelVisitor func,
                          ModelEvaluator ifFunc=wcore::DEFAULT_MODEL_EVALUATOR,
                          wcore::ORDER order=wcore::ORDER::IRRELEVANT,
-                         wcore::MODEL_CATEGORY model_cat=wcore::MODEL_CATEGORY::OPAQUE) const;
+                         wcore::MODEL_CATEGORY model_cat=wcore::MODEL_CATEGORY::OPAQUE,
+                         bool visible_only=false) const;
     // Visit the first model that evaluates to true in evaluator predicate (front to back search)
-    void visit_model_first(ModelVisitor func, ModelEvaluator ifFunc) const;
+    void visit_model_first(ModelVisitor func, ModelEvaluator ifFunc, bool visible_only=false) const;
     // Visit lights in loaded chunks
     void traverse_lights(LightVisitor func,
                          LightEvaluator ifFunc=wcore::DEFAULT_LIGHT_EVALUATOR);
@@ -163,34 +230,71 @@ public:
     void draw_models(std::function<void(const Model&)> prepare,
                      ModelEvaluator evaluate=wcore::DEFAULT_MODEL_EVALUATOR,
                      wcore::ORDER order=wcore::ORDER::IRRELEVANT,
-                     wcore::MODEL_CATEGORY model_cat=wcore::MODEL_CATEGORY::OPAQUE) const;
+                     wcore::MODEL_CATEGORY model_cat=wcore::MODEL_CATEGORY::OPAQUE,
+                     bool visible_only=false) const;
+    // Push models of a category in loaded chunks to a command bucket, make_key(model, chunk_index)
+    // computes the sort key of each command. No graphics API call is made.
+    // Entities are only submitted with opaque models.
+    void submit_models(CommandBucket<DrawCommand>& bucket,
+                       std::function<uint64_t(const Model&, uint32_t)> make_key,
+                       ModelEvaluator evaluate=wcore::DEFAULT_MODEL_EVALUATOR,
+                       bool visible_only=false,
+                       wcore::MODEL_CATEGORY model_cat=wcore::MODEL_CATEGORY::OPAQUE) const;
+    // Push opaque models that intersect a volume (such as a shadow cascade frustum) to a command
+    // bucket. Static models are found with an octree query, visibility bitsets are not used.
+    void submit_shadow_casters(CommandBucket<DrawCommand>& bucket,
+                               const FrustumBox& volume,
+                               std::function<uint64_t(const Model&, uint32_t)> make_key);
+    // Draw a command submitted by submit_models() or submit_shadow_casters()
+    void draw(const DrawCommand& command) const;
+    // Draw visible model instances with a single instanced draw call per mesh and material.
+    // prepare is called once per group, with the group's closest model. Instance batches
+    // are built and streamed by the first call after an update, later passes reuse them.
+    void draw_model_instances(std::function<void(const Model&)> prepare);
+    // Visit models rasterized by the software occlusion buffer (terrains in view)
+    void traverse_occluders(std::function<void(Model&)> func);
     // Draw terrains in loaded chunks
     void draw_terrains(std::function<void(const TerrainChunk&)> prepare,
                        ModelEvaluator evaluate=wcore::DEFAULT_MODEL_EVALUATOR) const;
 
 private:
-    // Find which models are in view frustum
+    // Chunk frustum culling, the chunk the camera is in is always visible
+    bool is_chunk_in_view(Chunk* chunk) const;
+    // Find which models are in view frustum and not occluded, results are stored
+    // in visibility bitsets. Visible models get their level of detail updated.
     void visibility_pass();
+    // Select terrain chunks geomipmapping levels and stitch edges with coarser neighbors
+    void terrain_lod_pass();
+    // Gather visible instances, group them by mesh and material and stream their attributes
+    void build_instance_batches();
+    // Query entity registry for displayable models if entities were added or removed since last time
+    void gather_displayable_models();
+    // Remove models of a chunk from the transform hierarchy, before the chunk is deleted
+    void release_transforms(Chunk* chunk);
 };
 
 inline void Scene::remove_chunk(const math::i32vec2& coords)
 {
-    remove_chunk(std::hash<math::i32vec2>{}(coords));
+    remove_chunk(coords_to_chunk_index(coords));
 }
 inline void Scene::remove_chunk(uint32_t chunk_index)
 {
     static_octree.remove_group(chunk_index);
-    auto it = chunks_.find(chunk_index);
-    if(it!=chunks_.end())
+    Chunk** chunk = chunks_.find(chunk_index);
+    if(chunk)
     {
-        delete it->second;
+        release_transforms(*chunk);
+        delete *chunk;
         chunks_.erase(chunk_index);
     }
 }
 inline void Scene::clear_chunks()
 {
-    for(auto chunkEntry: chunks_)
-        delete chunkEntry.second;
+    for(auto&& [key, chunk]: chunks_)
+    {
+        release_transforms(chunk);
+        delete chunk;
+    }
     chunks_.clear();
 }
 
@@ -205,16 +309,16 @@ inline math::vec3 Scene::get_chunk_center(uint32_t chunk_index) const
 inline uint32_t Scene::get_vertex_count() const
 {
     uint32_t count = 0;
-    for(auto chunk_entry: chunks_)
-        count += chunk_entry.second->get_vertex_count();
+    for(auto&& [key, chunk]: chunks_)
+        count += chunk->get_vertex_count();
     return count;
 }
 
 inline uint32_t Scene::get_triangles_count() const
 {
     uint32_t count = 0;
-    for(auto chunk_entry: chunks_)
-        count += chunk_entry.second->get_triangles_count();
+    for(auto&& [key, chunk]: chunks_)
+        count += chunk->get_triangles_count();
     return count;
 }
 
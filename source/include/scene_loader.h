@@ -10,6 +10,8 @@
 #include "xml_parser.h"
 #include "math3d.h"
 #include "game_system.h"
+#include "chunk_cache.h"
+#include "job_system.h"
 
 #ifdef __PROFILING_CHUNKS__
     #include "clock.hpp"
@@ -31,6 +33,7 @@ template <typename VertexT> class Mesh;
 class HeightMap;
 class PositionUpdater;
 class DaylightSystem;
+struct TerrainPatchDescriptor;
 
 typedef std::shared_ptr<Model> pModel;
 typedef std::shared_ptr<Light> pLight;
@@ -58,6 +61,26 @@ private:
     std::map<uint32_t, rapidxml::xml_node<>*> chunk_patches_;
     std::set<uint32_t> chunk_loaded_once_;
 
+    // Height maps being generated ahead of time by jobs
+    struct PrefetchedHeightmap
+    {
+        math::i32vec2 coords;
+        HeightMap* heightmap = nullptr; // Written by the job, read once job is done
+        JobCounter job;
+    };
+    std::map<uint32_t, std::unique_ptr<PrefetchedHeightmap>> prefetched_heightmaps_;
+    // Discarded prefetches, released once their job is done
+    std::vector<std::unique_ptr<PrefetchedHeightmap>> dropped_prefetches_;
+    // Generated terrain is baked to disk and mapped back on later visits
+    ChunkCache chunk_cache_;
+    // Pending chunk bakes, must be waited on before chunk_cache_ is reinitialized
+    JobCounter bake_jobs_;
+    // Baked chunk being loaded, its placements are used instead of parsing them
+    std::unique_ptr<BakedChunk> baked_chunk_;
+    uint32_t baked_transform_cursor_;
+    // Generated chunk being loaded, baked once its placements are known
+    std::shared_ptr<ChunkBakeData> pending_bake_;
+
     uint32_t chunk_size_m_;
     uint32_t chunk_size_;
     float    lattice_scale_;
@@ -87,6 +110,20 @@ public:
     void load_global(DaylightSystem& daylight);
     // Load a chunk, send geometry to driver if finalize set to true
     uint32_t load_chunk(const math::i32vec2& chunk_coords, bool finalize=true);
+    // Start generating chunk terrain in a job, so that a later
+    // call to load_chunk() does not stall. Return false if nothing to do.
+    bool prefetch_chunk(const math::i32vec2& chunk_coords);
+    inline bool is_prefetched(uint32_t chunk_index) const { return prefetched_heightmaps_.find(chunk_index) != prefetched_heightmaps_.end(); }
+    // Height map of this chunk is still being generated, load_chunk() would wait for it
+    bool is_prefetch_pending(uint32_t chunk_index) const;
+    // Number of prefetch jobs not done yet, dropped ones included
+    uint32_t get_prefetch_job_count() const;
+    // Discard prefetched data for chunks farther than radius from center chunk
+    void drop_prefetched_chunks(const math::i32vec2& center, uint32_t radius);
+    // Wait for all prefetch jobs and discard their data
+    void clear_prefetched_chunks();
+    // Release discarded prefetches whose job is done
+    void release_dropped_prefetches();
 
     pModel load_model_instance(hash_t name, uint32_t chunk_index, hash_t href=0);
     pLight load_point_light(uint32_t chunk_index, hash_t href=0);
@@ -121,10 +158,11 @@ public:
 private:
     // LOWER LEVEL PARSERS ---------------------------------------------
     void parse_transformation(rapidxml::xml_node<>* trn_node, Transformation& trans);
-    void parse_transformation(rapidxml::xml_node<>* trn_node,
-                              uint32_t n_instances,
-                              std::vector<Transformation>& trans_vector,
-                              std::mt19937& rng);
+    // Return the number of random draws consumed
+    uint32_t parse_transformation(rapidxml::xml_node<>* trn_node,
+                                  uint32_t n_instances,
+                                  std::vector<Transformation>& trans_vector,
+                                  std::mt19937& rng);
     Mesh<Vertex3P>* parse_line_mesh(rapidxml::xml_node<>* mesh_node);
     void parse_bezier_interpolator(rapidxml::xml_node<>* bez_node,
                                    std::vector<math::vec3>& controls,
@@ -148,7 +186,15 @@ private:
     void ground_model(Model& model, uint32_t chunk_index);
     void ground_model(LineModel& model, uint32_t chunk_index);
     bool is_pos_relative(rapidxml::xml_node<>* parent);
+    bool make_patch_descriptor(rapidxml::xml_node<>* patch,
+                               const math::i32vec2& chunk_coords,
+                               TerrainPatchDescriptor& desc);
     uint32_t get_num_controls(rapidxml::xml_node<>* cspline_node);
+    // Next count baked transforms of the chunk being loaded, nullptr if not baked
+    const BakedTransform* next_baked_transforms(uint32_t count);
+    void bake_transform(const Transformation& trans);
+    // Create a light, Motion and href are parsed from light node if not null
+    void make_light(const BakedLight& params, rapidxml::xml_node<>* light_node, uint32_t chunk_index);
 };
 
 template <typename CS>
@@ -6,6 +6,7 @@
 #include <set>
 #include <map>
 #include <algorithm>
+#include <cstring>
 
 #include "math3d.h"
 #include "wtypes.h"
@@ -17,6 +18,14 @@ class Texture;
 class Material;
 class Light;
 
+// Binding points of the engine-wide uniform blocks. Blocks declared in shaders
+// are bound to these points by name at link time.
+enum class UniformBlock: uint32_t
+{
+    FRAME  = 0, // "frame_data", camera matrices, updated once per frame (see frame_data.glsl)
+    OBJECT = 1, // "object_data", model matrix, one range per draw (see object_data.glsl)
+};
+
 // Allows flexible shader resource query
 struct ShaderResource
 {
@@ -98,6 +107,8 @@ private:
     bool link();
     // Associate each active uniform to its uniform hname engine-side
     void setup_uniform_map();
+    // Bind each active uniform block to its engine-wide binding point
+    void setup_uniform_blocks();
     // Print the error report generated when shader compilation failed, populate a set of error line numbers
     void shader_error_report(uint32_t ShaderID, std::set<int>& errlines);
     // Print the error report generated on program linking failure
@@ -114,7 +125,42 @@ private:
     uint32_t GeometryShaderID_;
     uint32_t FragmentShaderID_;
 
-    std::map<hash_t, int32_t> uniform_locations_; // [uniform hname, location]
+    // Active uniform, with a copy of the last value uploaded so that redundant uploads can be skipped.
+    // Uniform values are program state, so the copy stays valid across use() / unuse().
+    struct UniformSlot
+    {
+        static constexpr uint32_t CACHE_SIZE = 64; // Enough for a mat4
+
+        hash_t name;
+        int32_t location;
+        mutable uint32_t cached_size; // 0 when no value was uploaded yet
+        alignas(16) mutable uint8_t cached[CACHE_SIZE];
+
+        // Return false if value is the one last uploaded, otherwise remember it and return true
+        inline bool update(const void* value, uint32_t size) const
+        {
+            // Too big to be cached, the cached value is not the last one uploaded anymore
+            if(size > CACHE_SIZE)
+            {
+                cached_size = 0;
+                return true;
+            }
+            if(cached_size == size && memcmp(cached, value, size) == 0)
+                return false;
+            memcpy(cached, value, size);
+            cached_size = size;
+            return true;
+        }
+    };
+
+    // Find an active uniform by hname, nullptr if not found.
+    // With the null graphics API, there is no program to query and slots are created on first use.
+    const UniformSlot* find_uniform(hash_t name) const;
+    // Check if a uniform value must be sent to the device: false if it is the value last
+    // uploaded, or if there is no device (the upload is then only accounted for)
+    bool upload_needed(const UniformSlot& slot, const void* value, uint32_t size) const;
+
+    mutable std::vector<UniformSlot> uniforms_; // Active uniforms sorted by hname, resolved at link time
 
     std::vector<hash_t> defines_; // list of all the defines specified
     static std::vector<std::string> global_defines_; // list of all the global defines
@@ -166,6 +212,8 @@ bool Shader::send_uniforms<Material>(const Material& material) const;
 
 template <>
 bool Shader::send_uniform_array<float>(hash_t name, float* array, int size) const;
+template <>
+bool Shader::send_uniform_array<math::mat4>(hash_t name, math::mat4* array, int size) const;
 
 }
 
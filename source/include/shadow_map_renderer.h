@@ -1,8 +1,12 @@
 #ifndef SHADOW_MAP_RENDERER_H
 #define SHADOW_MAP_RENDERER_H
 
+#include <array>
+
 #include "renderer.h"
 #include "shader.h"
+#include "command_bucket.hpp"
+#include "bounding_boxes.h"
 
 #ifdef __EXPERIMENTAL_VSM_BLUR__
     #include "ping_pong_buffer.h"
@@ -11,21 +15,48 @@
 namespace wcore
 {
 
+struct ShadowCascade
+{
+    math::mat4 light_matrix; // Light view-projection matrix the cascade was last rendered with
+    float far_depth;         // View space distance of the cascade far bound
+};
+
+/*
+    Directional light shadows are rendered to cascaded shadow maps. The view frustum
+    is sliced along the view axis, and each slice is covered by its own orthographic light
+    frustum. Cascades are packed side by side in a single shadow map atlas (cascade ii
+    occupies the horizontal tile ii), so the lighting pass only needs one sampler.
+    Casters are culled per cascade against the light frustum, with an octree query for
+    static models.
+    Far cascades can be refreshed at a lower rate (root.render.shadowmap.far_cascade_interval),
+    refreshes of different cascades are staggered over frames.
+*/
 class ShadowMapRenderer : public Renderer
 {
 public:
+    static constexpr uint32_t MAX_CASCADES = 4;
+
     explicit ShadowMapRenderer();
     virtual ~ShadowMapRenderer();
 
-    inline const math::mat4& get_light_matrix() const { return light_matrix_; }
+    inline const math::mat4& get_light_matrix() const { return cascades_[0].light_matrix; }
     inline float get_normal_offset() const            { return normal_offset_; }
     inline float& get_normal_offset()                 { return normal_offset_; }
     inline void set_normal_offset(float value)        { normal_offset_ = value; }
 
+    inline uint32_t get_cascade_count() const                        { return n_cascades_; }
+    inline const ShadowCascade& get_cascade(uint32_t index) const    { return cascades_[index]; }
+
     virtual void render(Scene* pscene) override;
 
+    // Size of a texel of a single cascade, in cascade texture coordinates
     static math::vec2 SHADOW_TEXEL_SIZE;
 
+private:
+    // Fit cascade orthographic light frustum to a view frustum slice, and compute
+    // the corresponding world space culling volume
+    void fit_cascade(uint32_t index, const math::mat4& light_view, const math::mat4& light_view_inv);
+
 private:
     Shader sm_shader_;
 #ifdef __EXPERIMENTAL_VSM_BLUR__
@@ -33,7 +64,15 @@ private:
 #endif
 
     float normal_offset_;
-    math::mat4 light_matrix_; // Last light view-projection matrix
+    float split_lambda_;             // Logarithmic / uniform cascade split blend
+    uint32_t n_cascades_;
+    uint32_t far_cascade_interval_;  // Cascades past the first are refreshed every n frames
+    uint32_t frame_index_;
+
+    std::array<ShadowCascade, MAX_CASCADES> cascades_;
+    FrustumBox view_box_;            // Copy of view frustum box, with cascade splits
+    FrustumBox cascade_box_;         // Culling volume of current cascade
+    CommandBucket<DrawCommand> caster_bucket_;
 
     static uint32_t SHADOW_WIDTH;
     static uint32_t SHADOW_HEIGHT;
@@ -64,6 +64,10 @@ public:
                                                    bool& mesh_is_instance,
                                                    OptRngT opt_rng=nullptr);
 
+private:
+    // Generate LOD chain of a procedural mesh
+    void make_lods(SurfaceMesh& mesh) const;
+
 private:
     std::map<hash_t, SurfaceMeshDescriptor> instance_descriptors_;
     std::map<hash_t, std::shared_ptr<SurfaceMesh>> cache_; // Owns loaded meshes
@@ -72,6 +76,10 @@ private:
 
     ObjLoader* obj_loader_;
     WeshLoader* wesh_loader_;
+
+    uint32_t lod_levels_;   // Max number of LODs per procedural mesh
+    float lod_reduction_;   // Triangle count ratio between successive LODs
+    float lod_max_error_;   // Simplification error bound, relative to mesh size
 };
 
 } // namespace wcore
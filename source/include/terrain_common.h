@@ -2,10 +2,16 @@
 #define TERRAIN_COMMON_H
 
 #include <vector>
+#include <memory>
 
 namespace wcore
 {
 
+class HeightMap;
+struct Vertex3P3N3T2U;
+template <typename VertexT> class Mesh;
+using SurfaceMesh = Mesh<Vertex3P3N3T2U>;
+
 struct TerrainPatchDescriptor
 {
     uint32_t chunk_size;
@@ -19,6 +25,8 @@ struct TerrainPatchDescriptor
     rapidxml::xml_node<>* generator_node;
     rapidxml::xml_node<>* height_modifier_node;
     std::vector<rapidxml::xml_node<>*> material_nodes;
+    HeightMap* heightmap = nullptr; // Pre-generated height map (chunk streaming), ownership is transferred
+    std::shared_ptr<SurfaceMesh> mesh;  // Pre-generated terrain mesh (baked chunk), height map must be set
 };
 
 } // namespace wcore
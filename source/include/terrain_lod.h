@@ -0,0 +1,70 @@
+#ifndef TERRAIN_LOD_H
+#define TERRAIN_LOD_H
+
+#include <vector>
+#include <cstdint>
+
+#include "w_symbols.h"
+
+namespace wcore
+{
+namespace lod
+{
+
+/*
+    Geomipmapping index layout for grid terrain meshes.
+    The vertex grid is width x length, vertex (ii,jj) has index ii*length+jj (ii along x,
+    jj along z, as produced by factory::make_terrain_tri_mesh()). Level l samples the grid
+    every 2^l vertices along each axis, the last row and column are always sampled.
+    A level is split in index ranges that share the same vertices:
+        - a body range, which covers all cells but the outer ring
+        - one border strip per side, which links the body to the grid edge. The grid edge
+          of a strip can be sampled at a coarser level (edge level), so that it matches the
+          edge of a coarser neighbor chunk exactly and no crack appears at the seam.
+    All ranges of a level are enumerated by range_index(), range 0 of level l is its body.
+*/
+class TerrainLodLayout
+{
+public:
+    TerrainLodLayout();
+    TerrainLodLayout(uint32_t width, uint32_t length, uint32_t max_levels);
+
+    inline uint32_t get_level_count() const { return n_levels_; }
+    // Total number of index ranges
+    inline uint32_t get_range_count() const { return level_base_.empty() ? 0 : level_base_.back(); }
+
+    // Range index of the body of a level
+    inline uint32_t body_range(uint32_t level) const { return level_base_[level]; }
+    // Range index of a border strip, edge_level must be in [level, level count)
+    inline uint32_t edge_range(uint32_t level, NEIGHBOR side, uint32_t edge_level) const
+    {
+        return level_base_[level] + 1 + uint32_t(side)*(n_levels_-level) + (edge_level-level);
+    }
+
+    // Triangle lists (counter-clockwise when viewed from above)
+    std::vector<uint32_t> make_body(uint32_t level) const;
+    std::vector<uint32_t> make_edge(uint32_t level, NEIGHBOR side, uint32_t edge_level) const;
+    // All ranges in range index order
+    std::vector<std::vector<uint32_t>> make_ranges() const;
+
+private:
+    // Sampled coordinates along an axis of given vertex count
+    static std::vector<uint32_t> samples(uint32_t count, uint32_t level);
+    inline uint32_t vertex(uint32_t ii, uint32_t jj) const { return ii*length_+jj; }
+    // Append triangle (ii,jj) coordinates, fix winding so that it faces +y
+    void push_triangle(std::vector<uint32_t>& indices,
+                       uint32_t i0, uint32_t j0,
+                       uint32_t i1, uint32_t j1,
+                       uint32_t i2, uint32_t j2) const;
+
+private:
+    uint32_t width_;
+    uint32_t length_;
+    uint32_t n_levels_;
+    std::vector<uint32_t> level_base_; // First range of each level, plus total count
+};
+
+} // namespace lod
+} // namespace wcore
+
+#endif // TERRAIN_LOD_H
@@ -2,8 +2,11 @@
 #define TERRAIN_PATCH_H
 
 #include <set>
+#include <array>
+#include <functional>
 
 #include "model.h"
+#include "terrain_lod.h"
 
 namespace wcore
 {
@@ -24,21 +27,45 @@ private:
     Texture* splatmap_;
     bool use_splat_;
 
+    // Geomipmapping
+    lod::TerrainLodLayout lod_layout_;
+    uint32_t lod_level_;
+    std::array<uint32_t, 4> edge_levels_; // Edge sampling level of each side, indexed by NEIGHBOR
+
     static uint32_t chunk_size_;
+    static uint32_t max_lod_levels_;
 
 public:
     static inline void set_chunk_size(uint32_t value) { chunk_size_ = value; }
     static inline uint32_t get_chunk_size()           { return chunk_size_; }
+    static inline void set_max_lod_levels(uint32_t value) { max_lod_levels_ = value; }
 
     TerrainChunk(HeightMap* phm,
                  Material* pmat,
                  float latticeScale=1.0f,
                  float textureScale=1.0f);
+    // Use a mesh generated ahead of time from this height map
+    TerrainChunk(HeightMap* phm,
+                 std::shared_ptr<SurfaceMesh> pmesh,
+                 Material* pmat);
 
     virtual ~TerrainChunk();
 
     inline const HeightMap& get_heightmap() const { return *heightmap_; }
 
+    // * Geomipmapping
+    // Level 0 is the full resolution grid, each level halves the resolution
+    inline uint32_t get_lod_level_count() const { return lod_layout_.get_level_count(); }
+    inline uint32_t get_lod_level() const       { return lod_level_; }
+    inline void set_lod_level(uint32_t level);
+    // Sampling level of the edge shared with a neighbor, set to the coarsest level of both
+    // chunks to avoid cracks. Edges are never finer than the chunk level.
+    inline void set_edge_level(NEIGHBOR side, uint32_t level) { edge_levels_[uint32_t(side)] = level; }
+    inline uint32_t get_edge_level(NEIGHBOR side) const;
+    // Visit the buffer tokens of all index ranges to draw at current level (body and 4 border strips).
+    // If no level was generated, the full mesh token is visited.
+    void traverse_lod_tokens(std::function<void(const BufferToken&)> visitor) const;
+
     // Terrain geometry accessors
     inline Vertex3P3N3T2U& north(uint32_t index) const;
     inline Vertex3P3N3T2U& south(uint32_t index) const;
@@ -51,8 +78,23 @@ public:
     inline bool is_multi_textured() const;
     inline const Material& get_alternative_material() const;
     inline const Texture& get_splatmap() const;
+
+private:
+    // Add geomipmapping index ranges to the mesh
+    void make_lod_ranges();
 };
 
+inline void TerrainChunk::set_lod_level(uint32_t level)
+{
+    lod_level_ = (lod_layout_.get_level_count()>0) ? std::min(level, lod_layout_.get_level_count()-1) : 0;
+}
+
+inline uint32_t TerrainChunk::get_edge_level(NEIGHBOR side) const
+{
+    uint32_t level = std::max(lod_level_, edge_levels_[uint32_t(side)]);
+    return (lod_layout_.get_level_count()>0) ? std::min(level, lod_layout_.get_level_count()-1) : 0;
+}
+
 inline Vertex3P3N3T2U& TerrainChunk::east(uint32_t index) const
 {
     return (*pmesh_)[(chunk_size_-1)*chunk_size_+index];
@@ -39,6 +39,7 @@ enum class TextureWrap: uint8_t
 enum class TextureIF
 {
     R8,
+    R32F,
     RGB8,
     RGBA8,
     RG16F,
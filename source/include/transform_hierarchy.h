@@ -0,0 +1,98 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+#include "math3d.h"
+
+namespace wcore
+{
+
+class Transformation;
+
+/*
+    Local transforms (position, orientation, uniform scale) and cached world matrices
+    of scene objects, in contiguous arrays indexed by node.
+    A node whose local transform changed is flagged dirty, its world matrix (and the
+    ones of its descendants) are recomputed by the next update(), once per frame, level
+    by level so that each level can be processed in parallel. Every recomputation bumps
+    the node version, so that dependent data (bounding boxes) can be refreshed only when
+    the world matrix actually changed.
+*/
+class TransformHierarchy
+{
+public:
+    static constexpr uint32_t NONE = uint32_t(-1);
+
+    TransformHierarchy();
+
+    // Allocate a node with given local transform, child of parent if any
+    uint32_t create(const Transformation& local, uint32_t parent=NONE);
+    // Release a node, its children become roots and keep their local transform
+    void destroy(uint32_t node);
+    void clear();
+
+    // Copy local transform, node is flagged dirty only if it differs from the current one
+    void set_local(uint32_t node, const Transformation& local);
+    // Parent must not be a descendant of node
+    void set_parent(uint32_t node, uint32_t parent);
+
+    // Recompute world matrices of dirty nodes and of their descendants.
+    // Returns the number of world matrices recomputed.
+    uint32_t update();
+
+    // World matrix, brought up to date if the node (or an ancestor) changed since last update().
+    // Not thread safe unless the hierarchy is up to date.
+    inline const math::mat4& get_world(uint32_t node);
+    // Incremented each time the world matrix of this node is recomputed
+    inline uint32_t get_version(uint32_t node) const      { assert(is_alive(node)); return version_[node]; }
+    inline uint32_t get_parent(uint32_t node) const       { assert(is_alive(node)); return parent_[node]; }
+    inline bool is_alive(uint32_t node) const             { return node < alive_.size() && alive_[node]; }
+    inline uint32_t size() const                          { return uint32_t(alive_.size() - free_.size()); }
+
+private:
+    inline bool needs_update(uint32_t node) const;
+    void compute_world(uint32_t node);
+    // Resolve node and its ancestors outside of update()
+    void resolve(uint32_t node);
+    // Sort live nodes by depth, parents before children
+    void rebuild_order();
+    uint32_t get_depth(uint32_t node) const;
+
+    // * Local transforms
+    std::vector<math::vec3> position_;
+    std::vector<math::quat> orientation_;
+    std::vector<float>      scale_;
+    // * Links
+    std::vector<uint32_t>   parent_;
+    // * World transforms
+    std::vector<math::mat4> world_;
+    std::vector<uint32_t>   version_;
+    std::vector<uint32_t>   parent_version_; // Version of parent the world matrix was computed with
+    std::vector<uint8_t>    dirty_;
+    std::vector<uint8_t>    alive_;
+
+    std::vector<uint32_t> free_;          // Released nodes, reused first
+    std::vector<uint32_t> order_;         // Live nodes sorted by depth
+    std::vector<uint32_t> level_offsets_; // Start of each depth level in order_, plus end
+    bool order_dirty_;                    // Nodes were created, destroyed or reparented
+};
+
+inline bool TransformHierarchy::needs_update(uint32_t node) const
+{
+    uint32_t parent = parent_[node];
+    return dirty_[node] || (parent != NONE && version_[parent] != parent_version_[node]);
+}
+
+inline const math::mat4& TransformHierarchy::get_world(uint32_t node)
+{
+    assert(is_alive(node) && "[TransformHierarchy] Invalid node.");
+    resolve(node);
+    return world_[node];
+}
+
+} // namespace wcore
+
+#endif // TRANSFORM_HIERARCHY_H
@@ -45,6 +45,7 @@ public:
     inline std::vector<BufferLayoutElement>::const_iterator end() const   { return elements_.end(); }
 
     inline uint32_t get_stride() const { return stride_; }
+    inline uint32_t get_element_count() const { return elements_.size(); }
 
 private:
     std::vector<BufferLayoutElement> elements_;
@@ -116,6 +117,15 @@ public:
     }
 };
 
+// Per-instance attributes for hardware instanced draw calls
+struct InstanceData
+{
+public:
+    math::mat4 model_matrix_;
+
+    static BufferLayout Layout;
+};
+
 struct VertexAnim
 {
 public:
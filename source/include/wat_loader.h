@@ -10,6 +10,9 @@
     [   Block0   ]  [     Block1   ]  [        Block2       ]
     [[R][G][B][A]]  [[R][G][B]  [A]]  [[R]  [G] [B]      [A]]
       Albedo           Normal  Depth  Metal AO  Rough  UNUSED
+
+    When read from a mapped file view, texture blocks are not copied: the
+    descriptor points inside the mapping, which must outlive texture creation.
 */
 
 #include <filesystem>
@@ -19,6 +22,7 @@
 
 #include "math3d.h"
 #include "material_common.h"
+#include "io_utils.h"
 
 namespace fs = std::filesystem;
 
@@ -59,12 +63,15 @@ class WatLoader
 {
 public:
     void read(std::istream& stream, MaterialDescriptor& descriptor, bool read_texture_data);
+    // Read descriptor from a mapped file, texture data is referenced in place
+    bool read(const io::FileView& view, MaterialDescriptor& descriptor);
     void write(std::ostream& stream, const MaterialDescriptor& descriptor);
 
 private:
     void read_header(std::istream& stream, WatHeaderWrapper& header);
     void write_header(std::ostream& stream, WatHeaderWrapper& header);
     bool header_sanity_check(const WatHeader& header);
+    void read_descriptor(const WatHeader& header, MaterialDescriptor& descriptor, bool owns_data);
 };
 
 } // namespace wcore
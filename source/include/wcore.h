@@ -36,13 +36,17 @@ public:
     // * Global state access
     void SetFrameSize(uint32_t width, uint32_t height, bool fullscreen=false);
     void SetWindowSize(uint32_t width, uint32_t height);
+    // Run without window nor graphics device, for n_frames frames (0: until closed).
+    // Must be called before Init(), can be called from the argument parser.
+    void SetHeadless(uint32_t n_frames=0);
 
     // * Base API
     // Register a resource archive
     bool UseResourceArchive(const char* filename, hash_t key);
     // Register and launch systems
     // Can pass a context here or leave it null. If let null, a
-    // GLFW context will be created automatically
+    // GLFW context will be created automatically, or a headless
+    // context for headless runs
     void Init(int argc,
               char const *argv[],
               void(*parse_arguments)(int, char const **)=nullptr,
@@ -54,6 +54,10 @@ public:
         return (components_.find(index) != components_.end());
     }
 
+    // Copy all components to an entity of an archetype registry, the entity is then
+    // only used as a blueprint
+    void copy_components(EntityRegistry& registry, EntityHandle handle) const;
+
 protected:
     std::unordered_map<std::type_index, WComponent*> components_;
 
@@ -11,12 +11,19 @@
     [array of uint32_t]   -> index buffer content
 
     Header contains among other things the number of vertices and indices.
+
+    Files can also be read from a mapped file view (see FileSystem::map_file()),
+    in which case vertex and index data are accessed in place.
 */
 
 #include <filesystem>
 #include <fstream>
 #include <memory>
 #include <cassert>
+#include <cstring>
+#include <vector>
+
+#include "io_utils.h"
 
 namespace fs = std::filesystem;
 
@@ -44,9 +51,27 @@ typedef union
     uint8_t padding[WESH_HEADER_SIZE];
 } WeshHeaderWrapper;
 
+// Vertex and index data inside a mapped .wesh file, valid while the view lives.
+// Data may not be aligned, copy it with memcpy or send it to the driver as is.
+struct WeshView
+{
+    io::FileView file;
+    const uint8_t* vertex_data = nullptr;
+    const uint8_t* index_data = nullptr;
+    uint32_t vertex_size = 0;
+    uint32_t n_vertices = 0;
+    uint32_t n_indices = 0;
+};
+
 class WeshLoader
 {
 public:
+    // Locate mesh data in a mapped file, no copy involved
+    bool read(const io::FileView& view, WeshView& mesh_view, size_t vertex_size);
+
+    template<typename VertexT>
+    std::shared_ptr<Mesh<VertexT>> read(const io::FileView& view);
+
     template<typename VertexT>
     bool read(std::istream& stream,
               std::vector<VertexT>& vertices,
@@ -127,6 +152,21 @@ std::shared_ptr<Mesh<VertexT>> WeshLoader::read(std::istream& stream)
     return std::make_shared<Mesh<VertexT>>(std::move(vdata), std::move(idata));
 }
 
+template<typename VertexT>
+std::shared_ptr<Mesh<VertexT>> WeshLoader::read(const io::FileView& view)
+{
+    WeshView mesh_view;
+    if(!read(view, mesh_view, sizeof(VertexT)))
+        return nullptr;
+
+    // Single copy from the mapping to the mesh buffers
+    std::vector<VertexT> vdata(mesh_view.n_vertices);
+    std::vector<uint32_t> idata(mesh_view.n_indices);
+    memcpy(vdata.data(), mesh_view.vertex_data, size_t(mesh_view.n_vertices)*sizeof(VertexT));
+    memcpy(idata.data(), mesh_view.index_data, size_t(mesh_view.n_indices)*sizeof(uint32_t));
+    return std::make_shared<Mesh<VertexT>>(std::move(vdata), std::move(idata));
+}
+
 template<typename VertexT>
 void WeshLoader::write(std::ostream& stream, const Mesh<VertexT>& mesh)
 {
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+
 #include "bounding_boxes.h"
 #include "model.h"
 #include "logger.h"
@@ -121,8 +124,7 @@ void OBB::update(const math::mat4& parent_model_matrix)
     proper_transform_ = parent_model_matrix * proper_transform_;
 
     // Compute OBB vertices
-    for(uint32_t ii=0; ii<8; ++ii)
-        vertices_[ii] = proper_transform_ * CENTERED_CUBE_VERTICES[ii];
+    math::transform_points(proper_transform_, CENTERED_CUBE_VERTICES.data(), vertices_.data(), 8);
 }
 
 
@@ -163,18 +165,8 @@ const std::vector<uint32_t> FrustumBox::planePoints = {3, 0, 3, 7, 3, 2};
 
 FrustumBox::FrustumBox()
 {
-    // For shadowmap frustum splits, unused atm.
-    float lambda = 0.5f;
-    float near = 0.1f;
-    float far = 100.0f;
-    uint32_t m = 4;
-    for(uint32_t ii=0; ii<m; ++ii)
-    {
-        float cLog = near * pow(far/near, ii/(1.0f*(m-1)))/far - near/far;
-        float cUni = ii/(1.0f*(m-1));
-        float cii  = lambda * cLog + (1.0f-lambda) * cUni;
-        splits_.push_back(cii);
-    }
+    // Default shadow map cascade splits
+    set_splits(3, 0.5f, 0.1f, 100.0f);
 }
 
 FrustumBox::~FrustumBox()
@@ -215,14 +207,21 @@ void FrustumBox::update(const Camera& camera)
     vec3 right_far (right * (wfar * 0.5f));
 
     // Now compute vertices in world space using vector addition
-    vertices_[0] = nc - up_near + right_near; // RBN
-    vertices_[1] = fc - up_far  + right_far;  // RBF
-    vertices_[2] = fc - up_far  - right_far;  // LBF
-    vertices_[3] = nc - up_near - right_near; // LBN
-    vertices_[4] = nc + up_near + right_near; // RTN
-    vertices_[5] = fc + up_far  + right_far;  // RTF
-    vertices_[6] = fc + up_far  - right_far;  // LTF
-    vertices_[7] = nc + up_near - right_near; // LTN
+    std::array<vec3, 8> corners;
+    corners[0] = nc - up_near + right_near; // RBN
+    corners[1] = fc - up_far  + right_far;  // RBF
+    corners[2] = fc - up_far  - right_far;  // LBF
+    corners[3] = nc - up_near - right_near; // LBN
+    corners[4] = nc + up_near + right_near; // RTN
+    corners[5] = fc + up_far  + right_far;  // RTF
+    corners[6] = fc + up_far  - right_far;  // LTF
+    corners[7] = nc + up_near - right_near; // LTN
+    update(corners);
+}
+
+void FrustumBox::update(const std::array<vec3, 8>& corners)
+{
+    vertices_ = corners;
 
     // Compute axis-aligned bounds
     math::compute_extent(vertices_, extent_);
@@ -236,9 +235,40 @@ void FrustumBox::update(const Camera& camera)
     normals_[5] = normal_F();
 }
 
+void FrustumBox::set_splits(uint32_t n_splits, float lambda, float near, float far)
+{
+    // Practical split scheme (Zhang et al. 2006, Parallel-Split Shadow Maps)
+    splits_.resize(n_splits+1);
+    for(uint32_t ii=0; ii<=n_splits; ++ii)
+    {
+        float ratio = ii/float(n_splits);
+        float cLog = near * std::pow(far/near, ratio);
+        float cUni = near + (far-near) * ratio;
+        float cii  = lambda * cLog + (1.0f-lambda) * cUni;
+        splits_[ii] = (cii-near)/(far-near);
+    }
+    splits_.front() = 0.0f;
+    splits_.back()  = 1.0f;
+}
+
+void FrustumBox::split_corners(uint32_t splitIndex, std::array<vec3, 8>& destination) const
+{
+    float t0 = splits_[splitIndex];
+    float t1 = splits_[splitIndex+1];
+    // Near / far vertex pairs: (RBN,RBF) (LBN,LBF) (RTN,RTF) (LTN,LTF)
+    static const uint32_t pairs[4][2] = {{0,1}, {3,2}, {4,5}, {7,6}};
+    for(uint32_t ii=0; ii<4; ++ii)
+    {
+        const vec3& vn = vertices_[pairs[ii][0]];
+        const vec3& vf = vertices_[pairs[ii][1]];
+        destination[pairs[ii][0]] = lerp(vn, vf, t0);
+        destination[pairs[ii][1]] = lerp(vn, vf, t1);
+    }
+}
+
 math::vec3 FrustumBox::split_center(uint32_t splitIndex) const
 {
-    splitIndex = fmax(splitIndex, splits_.size()-2);
+    splitIndex = std::min(splitIndex, uint32_t(splits_.size()-2));
     //vec3 RBii = lerp(RBN(),RBF(),splits_[splitIndex]);
     vec3 LBii = lerp(LBN(),LBF(),splits_[splitIndex]);
     vec3 RBii1 = lerp(RBN(),RBF(),splits_[splitIndex+1]);
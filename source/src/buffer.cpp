@@ -3,6 +3,7 @@
 #include "logger.h"
 
 #include "platform/opengl/ogl_buffer.h"
+#include "platform/null/null_buffer.h"
 
 namespace wcore
 {
@@ -17,6 +18,9 @@ VertexBuffer* VertexBuffer::create(float* vertex_data, std::size_t size, bool dy
 
         case GfxAPI::OpenGL:
             return new OGLVertexBuffer(vertex_data, size, dynamic);
+
+        case GfxAPI::Null:
+            return new NullVertexBuffer(vertex_data, size, dynamic);
     }
 }
 
@@ -30,6 +34,73 @@ IndexBuffer* IndexBuffer::create(uint32_t* index_data, std::size_t size, bool dy
 
         case GfxAPI::OpenGL:
             return new OGLIndexBuffer(index_data, size, dynamic);
+
+        case GfxAPI::Null:
+            return new NullIndexBuffer(index_data, size, dynamic);
+    }
+}
+
+TextureBuffer* TextureBuffer::create(TextureBufferFormat format, std::size_t size)
+{
+    switch(Gfx::get_api())
+    {
+        case GfxAPI::None:
+            DLOGF("TextureBuffer: not implemented for GfxAPI::None.", "batch");
+            return nullptr;
+
+        case GfxAPI::OpenGL:
+            return new OGLTextureBuffer(format, size);
+
+        case GfxAPI::Null:
+            return new NullTextureBuffer(format, size);
+    }
+}
+
+StreamBuffer* StreamBuffer::create(std::size_t frame_size, uint32_t n_frames)
+{
+    switch(Gfx::get_api())
+    {
+        case GfxAPI::None:
+            DLOGF("StreamBuffer: not implemented for GfxAPI::None.", "batch");
+            return nullptr;
+
+        case GfxAPI::OpenGL:
+            return new OGLStreamBuffer(frame_size, n_frames);
+
+        case GfxAPI::Null:
+            return new NullStreamBuffer(frame_size, n_frames);
+    }
+}
+
+UniformBuffer* UniformBuffer::create(std::size_t size, bool dynamic)
+{
+    switch(Gfx::get_api())
+    {
+        case GfxAPI::None:
+            DLOGF("UniformBuffer: not implemented for GfxAPI::None.", "batch");
+            return nullptr;
+
+        case GfxAPI::OpenGL:
+            return new OGLUniformBuffer(size, dynamic);
+
+        case GfxAPI::Null:
+            return new NullUniformBuffer(size, dynamic);
+    }
+}
+
+ReadbackBuffer* ReadbackBuffer::create(std::size_t size)
+{
+    switch(Gfx::get_api())
+    {
+        case GfxAPI::None:
+            DLOGF("ReadbackBuffer: not implemented for GfxAPI::None.", "batch");
+            return nullptr;
+
+        case GfxAPI::OpenGL:
+            return new OGLReadbackBuffer(size);
+
+        case GfxAPI::Null:
+            return new NullReadbackBuffer(size);
     }
 }
 
@@ -43,6 +114,9 @@ VertexArray* VertexArray::create()
 
         case GfxAPI::OpenGL:
             return new OGLVertexArray();
+
+        case GfxAPI::Null:
+            return new NullVertexArray();
     }
 }
 
@@ -0,0 +1,94 @@
+#include <algorithm>
+
+#include "buffer_allocator.h"
+#include "logger.h"
+
+namespace wcore
+{
+
+AllocatorStats& AllocatorStats::operator+=(const AllocatorStats& other)
+{
+    capacity      += other.capacity;
+    used          += other.used;
+    largest_free   = std::max(largest_free, other.largest_free);
+    n_allocations += other.n_allocations;
+    n_free_blocks += other.n_free_blocks;
+    return *this;
+}
+
+BufferAllocator::BufferAllocator(std::size_t capacity):
+capacity_(capacity),
+used_(0)
+{
+    if(capacity_)
+        free_blocks_.insert({0, capacity_});
+}
+
+std::size_t BufferAllocator::allocate(std::size_t size)
+{
+    if(size == 0)
+        return INVALID_OFFSET;
+
+    // * First fit
+    auto it = std::find_if(free_blocks_.begin(), free_blocks_.end(),
+                           [size](const auto& block) { return block.second >= size; });
+    if(it == free_blocks_.end())
+        return INVALID_OFFSET;
+
+    // * Split block, remainder stays free
+    std::size_t offset = it->first;
+    std::size_t remainder = it->second - size;
+    free_blocks_.erase(it);
+    if(remainder)
+        free_blocks_.insert({offset+size, remainder});
+
+    allocations_.insert({offset, size});
+    used_ += size;
+    return offset;
+}
+
+void BufferAllocator::release(std::size_t offset)
+{
+    auto alloc_it = allocations_.find(offset);
+    if(alloc_it == allocations_.end())
+    {
+        DLOGE("[BufferAllocator] Releasing unknown block at offset " + std::to_string(offset), "batch");
+        return;
+    }
+    std::size_t size = alloc_it->second;
+    allocations_.erase(alloc_it);
+    used_ -= size;
+
+    // * Merge with next free block
+    auto next = free_blocks_.lower_bound(offset);
+    if(next != free_blocks_.end() && next->first == offset+size)
+    {
+        size += next->second;
+        next = free_blocks_.erase(next);
+    }
+    // * Merge with previous free block
+    if(next != free_blocks_.begin())
+    {
+        auto prev = std::prev(next);
+        if(prev->first + prev->second == offset)
+        {
+            prev->second += size;
+            return;
+        }
+    }
+    free_blocks_.insert(next, {offset, size});
+}
+
+AllocatorStats BufferAllocator::get_stats() const
+{
+    AllocatorStats stats;
+    stats.capacity      = capacity_;
+    stats.used          = used_;
+    stats.n_allocations = uint32_t(allocations_.size());
+    stats.n_free_blocks = uint32_t(free_blocks_.size());
+    for(auto&& [offset, size]: free_blocks_)
+        stats.largest_free = std::max(stats.largest_free, size);
+    return stats;
+}
+
+} // namespace wcore
@@ -1,9 +1,12 @@
 #include "chunk.h"
 #include "model.h"
 #include "terrain_patch.h"
+#include "chunk_grid.hpp"
 #include "material.h"
 #include "camera.h"
 #include "motion.hpp"
+#include "hiz_buffer.h"
+#include "mesh_lod.h"
 
 #ifdef __PROFILING_CHUNKS__
 #include "clock.hpp"
@@ -32,12 +35,13 @@ cLightEvaluator DEFAULT_CLIGHT_EVALUATOR([](const Light& p){return true;});
 
 Chunk::Chunk(i32vec2 coords):
 coords_(coords),
-index_(std::hash<i32vec2>{}(coords)),
-render_batch_("opaque"_h),
-terrain_render_batch_("terrain"_h),
-blend_render_batch_("blend"_h),
-line_render_batch_("line"_h, DrawPrimitive::Lines),
-terrain_(nullptr)
+index_(coords_to_chunk_index(coords)),
+render_batch_("opaque"_h, DrawPrimitive::Triangles, true),
+terrain_render_batch_("terrain"_h, DrawPrimitive::Triangles, true),
+blend_render_batch_("blend"_h, DrawPrimitive::Triangles, true),
+line_render_batch_("line"_h, DrawPrimitive::Lines, true),
+terrain_(nullptr),
+uploaded_(false)
 {
 
 }
@@ -130,85 +134,79 @@ void Chunk::sort_models(pCamera camera)
 void Chunk::traverse_models(ModelVisitor func,
                             ModelEvaluator ifFunc,
                             wcore::ORDER order,
-                            wcore::MODEL_CATEGORY model_cat) const
+                            wcore::MODEL_CATEGORY model_cat,
+                            bool visible_only) const
 {
 #ifdef __PROFILING_CHUNKS__
         profile_clock_.restart();
 #endif
 
+    // Visibility slot offsets
+    const uint32_t models_offset = model_instances_.size();
+    const uint32_t blend_offset  = models_offset + models_.size();
+    auto visit = [&](const pModel& pmodel, uint32_t slot)
+    {
+        if(visible_only && !is_visible(slot))
+            return;
+        if(ifFunc(*pmodel))
+            func(*pmodel, index_);
+    };
+
     if(model_cat == wcore::MODEL_CATEGORY::OPAQUE || model_cat == wcore::MODEL_CATEGORY::IRRELEVANT)
     {
         if(order == wcore::ORDER::IRRELEVANT)
         {
             // Static instances
-            for(pModel pmodel : model_instances_)
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
+            for(uint32_t ii=0; ii<model_instances_.size(); ++ii)
+                visit(model_instances_[ii], ii);
             // Static models
-            for(pModel pmodel : models_)
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
+            for(uint32_t ii=0; ii<models_.size(); ++ii)
+                visit(models_[ii], models_offset+ii);
         }
         else if(order == wcore::ORDER::FRONT_TO_BACK)
         {
             // Sorted static instances
             for(uint32_t ii=0; ii<model_instances_order_.size(); ++ii)
             {
-                pModel pmodel = model_instances_[model_instances_order_[ii]];
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
+                uint32_t index = model_instances_order_[ii];
+                visit(model_instances_[index], index);
             }
             // Sorted static models
             for(uint32_t ii=0; ii<models_order_.size(); ++ii)
             {
-                pModel pmodel = models_[models_order_[ii]];
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
+                uint32_t index = models_order_[ii];
+                visit(models_[index], models_offset+index);
             }
         }
         else if(order == wcore::ORDER::BACK_TO_FRONT)
         {
             // Sorted static instances
             for(auto rit=model_instances_order_.rbegin(); rit != model_instances_order_.rend(); ++rit)
-            {
-                pModel pmodel = model_instances_[*rit];
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
-            }
+                visit(model_instances_[*rit], *rit);
             // Sorted static models
             for(auto rit=models_order_.rbegin(); rit != models_order_.rend(); ++rit)
-            {
-                pModel pmodel = models_[*rit];
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
-            }
+                visit(models_[*rit], models_offset+*rit);
         }
     }
     if(model_cat == wcore::MODEL_CATEGORY::TRANSPARENT || model_cat == wcore::MODEL_CATEGORY::IRRELEVANT)
     {
         if(order == wcore::ORDER::IRRELEVANT)
         {
-            for(pModel pmodel : models_blend_)
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
+            for(uint32_t ii=0; ii<models_blend_.size(); ++ii)
+                visit(models_blend_[ii], blend_offset+ii);
         }
         else if(order == wcore::ORDER::BACK_TO_FRONT)
         {
             for(uint32_t ii=0; ii<blend_models_order_.size(); ++ii)
             {
-                pModel pmodel = models_blend_[blend_models_order_[ii]];
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
+                uint32_t index = blend_models_order_[ii];
+                visit(models_blend_[index], blend_offset+index);
             }
         }
         else if(order == wcore::ORDER::FRONT_TO_BACK)
         {
             for(auto rit=blend_models_order_.rbegin(); rit != blend_models_order_.rend(); ++rit)
-            {
-                pModel pmodel = models_blend_[*rit];
-                if(ifFunc(*pmodel))
-                    func(*pmodel, index_);
-            }
+                visit(models_blend_[*rit], blend_offset+*rit);
         }
     }
 
@@ -218,12 +216,16 @@ void Chunk::traverse_models(ModelVisitor func,
 #endif
 }
 
-bool Chunk::visit_model_first(ModelVisitor func, ModelEvaluator ifFunc) const
+bool Chunk::visit_model_first(ModelVisitor func, ModelEvaluator ifFunc, bool visible_only) const
 {
     // Sorted static models
+    const uint32_t models_offset = model_instances_.size();
     for(uint32_t ii=0; ii<models_order_.size(); ++ii)
     {
-        pModel pmodel = models_[models_order_[ii]];
+        uint32_t index = models_order_[ii];
+        if(visible_only && !is_visible(models_offset+index))
+            continue;
+        pModel pmodel = models_[index];
         if(ifFunc(*pmodel))
         {
             func(*pmodel, index_);
@@ -244,6 +246,73 @@ bool Chunk::visit_model_first(ModelVisitor func, ModelEvaluator ifFunc) const
     return false;
 }
 
+void Chunk::traverse_model_instances(cModelVisitor func, bool visible_only) const
+{
+    // Instances come first in visibility slots
+    for(uint32_t ii=0; ii<model_instances_order_.size(); ++ii)
+    {
+        uint32_t index = model_instances_order_[ii];
+        if(visible_only && !is_visible(index))
+            continue;
+        func(*model_instances_[index], index_);
+    }
+}
+
+uint32_t Chunk::prepare_culling()
+{
+    uint32_t n_slots = model_instances_.size() + models_.size() + models_blend_.size();
+    if(culling_boxes_.size() != n_slots)
+        culling_boxes_.resize(n_slots);
+    if(visibility_.size() != n_slots)
+        visibility_.resize(n_slots, true);
+    return n_slots;
+}
+
+void Chunk::cull(const FrustumPlanes& planes, uint32_t begin, uint32_t end,
+                 const HiZBuffer* hiz, const lod::LodSelector* lods)
+{
+    const uint32_t models_offset = model_instances_.size();
+    const uint32_t blend_offset  = models_offset + models_.size();
+    end = std::min(end, culling_boxes_.size());
+
+    // * Gather bounding boxes
+    for(uint32_t slot=begin; slot<end; ++slot)
+    {
+        Model& model = (slot < models_offset) ? *model_instances_[slot]
+                     : (slot < blend_offset)  ? *models_[slot-models_offset]
+                                              : *models_blend_[slot-blend_offset];
+        // Non cullable models are passed
+        if(!model.can_frustum_cull())
+            culling_boxes_.set_no_cull(slot);
+        else
+            culling_boxes_.set(slot, model.get_OBB().get_vertices());
+    }
+
+    // * Batched plane tests
+    culling_boxes_.cull(planes, begin, end, visibility_);
+
+    // * Occlusion tests and LOD selection on boxes that passed frustum culling
+    bool occlusion = (hiz != nullptr && hiz->is_valid());
+    if(!occlusion && lods == nullptr)
+        return;
+    for(uint32_t slot=begin; slot<end; ++slot)
+    {
+        if(!visibility_.test(slot))
+            continue;
+        Model& model = (slot < models_offset) ? *model_instances_[slot]
+                     : (slot < blend_offset)  ? *models_[slot-models_offset]
+                                              : *models_blend_[slot-blend_offset];
+        if(occlusion && model.can_frustum_cull() && hiz->is_occluded(model.get_OBB().get_vertices()))
+        {
+            visibility_.reset(slot);
+            continue;
+        }
+        uint32_t n_lods = model.get_mesh().get_lod_count();
+        if(lods && n_lods > 1)
+            model.set_lod(lods->select(model.get_OBB().get_vertices(), model.get_lod(), n_lods));
+    }
+}
+
 
 void Chunk::traverse_line_models(std::function<void(pLineModel)> func)
 {
@@ -282,36 +351,42 @@ void Chunk::traverse_lights(cLightVisitor func,
 
 void Chunk::load_geometry()
 {
-    // Submit models mesh to render batch then upload to OpenGL
+    submit_geometry();
+    upload_geometry();
+}
+
+// Only touches CPU side buffers, can be called from a worker thread
+// as long as the chunk is not drawn / modified in the meantime
+void Chunk::submit_geometry()
+{
+    // Submit models mesh to render batch
     for(pModel pmodel: models_)
-    {
-#ifdef __DEBUG__
-        std::stringstream ss;
-        ss << "[Chunk] <i>Submitting</i> model: nv=" << pmodel->get_mesh().get_nv()
-           << "\tni=" << pmodel->get_mesh().get_ni()
-           << "\tne=" << pmodel->get_mesh().get_n_elements();
-        DLOG(ss.str(), "model", Severity::DET);
-#endif //__DEBUG__
         render_batch_.submit(pmodel->get_mesh());
-    }
-    render_batch_.upload();
 
     // Terrain
     if(terrain_ != nullptr)
-    {
         terrain_render_batch_.submit(terrain_->get_mesh());
-        terrain_render_batch_.upload();
-    }
 
     // Geometry with alpha blending
     for(pModel pmodel: models_blend_)
         blend_render_batch_.submit(pmodel->get_mesh());
-    blend_render_batch_.upload();
 
     // Line geometry
     for(pLineModel pmodel: line_models_)
         line_render_batch_.submit(pmodel->get_mesh());
+}
+
+// Must be called from the thread owning the graphics context
+void Chunk::upload_geometry()
+{
+#ifdef __DEBUG__
+    DLOG("[Chunk] <i>Uploading</i> chunk: <n>" + std::to_string(index_) + "</n>", "chunk", Severity::DET);
+#endif
+    render_batch_.upload();
+    terrain_render_batch_.upload();
+    blend_render_batch_.upload();
     line_render_batch_.upload();
+    uploaded_ = true;
 }
 
 void Chunk::add_position_updater(PositionUpdater* updater)
@@ -357,6 +432,16 @@ void Chunk::update(float dt)
     {
         (*cr)(dt);
     }
+    // Position updaters write to model positions through references
+    if(!position_updaters_.empty())
+    {
+        for(auto&& pmdl: models_)
+            if(pmdl->is_dynamic()) pmdl->sync_transform();
+        for(auto&& pmdl: models_blend_)
+            if(pmdl->is_dynamic()) pmdl->sync_transform();
+        for(auto&& pmdl: model_instances_)
+            if(pmdl->is_dynamic()) pmdl->sync_transform();
+    }
 }
 
 void Chunk::dbg_show_statistics()
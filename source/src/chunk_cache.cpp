@@ -0,0 +1,311 @@
+#include <fstream>
+#include <cstring>
+#include <thread>
+#include <functional>
+
+#include "chunk_cache.h"
+#include "height_map.h"
+#include "mesh.hpp"
+#include "vertex_format.h"
+#include "logger.h"
+
+#define WCHK_MAGIC 0x4B484357 // ASCII(WCHK)
+#define WCHK_VERSION_MAJOR 1
+#define WCHK_VERSION_MINOR 1
+
+namespace wcore
+{
+
+using namespace math;
+
+// Size of baked data following the header
+static inline size_t payload_size(const WchkHeader& header)
+{
+    return size_t(header.hm_width)*header.hm_length*sizeof(float)
+         + size_t(header.n_vertices)*header.vertex_size
+         + size_t(header.n_indices)*sizeof(uint32_t)
+         + size_t(header.n_transforms)*sizeof(BakedTransform)
+         + size_t(header.n_batches)*sizeof(uint32_t)
+         + size_t(header.n_lights)*sizeof(BakedLight);
+}
+
+HeightMap* BakedChunk::make_heightmap() const
+{
+    return new HeightMap(header_->hm_width, header_->hm_length, heights_, header_->hm_scale);
+}
+
+std::shared_ptr<SurfaceMesh> BakedChunk::make_terrain_mesh() const
+{
+    std::vector<Vertex3P3N3T2U> vertices(header_->n_vertices);
+    std::vector<uint32_t> indices(indices_, indices_+header_->n_indices);
+    memcpy(vertices.data(), vertices_, header_->n_vertices*sizeof(Vertex3P3N3T2U));
+    return std::make_shared<SurfaceMesh>(std::move(vertices), std::move(indices));
+}
+
+ChunkCache::ChunkCache():
+source_stamp_(0)
+{
+
+}
+
+void ChunkCache::init(const fs::path& folder, const std::string& level_name, uint64_t source_stamp)
+{
+    level_name_ = level_name;
+    source_stamp_ = source_stamp;
+
+    std::error_code ec;
+    fs::create_directories(folder, ec);
+    if(ec)
+    {
+        DLOGE("[ChunkCache] Cannot create cache folder:", "chunk");
+        DLOGI("<p>" + folder.string() + "</p>", "chunk");
+        folder_.clear();
+        return;
+    }
+    folder_ = folder;
+}
+
+uint64_t ChunkCache::make_stamp(const std::string& level_content)
+{
+    // 64 bits FNV-1a
+    uint64_t stamp = 0xcbf29ce484222325ull;
+    for(char c: level_content)
+    {
+        stamp ^= uint8_t(c);
+        stamp *= 0x100000001b3ull;
+    }
+    return stamp;
+}
+
+fs::path ChunkCache::get_path(const i32vec2& chunk_coords) const
+{
+    return folder_ / ("chunk_" + level_name_ + "_" + std::to_string(chunk_coords.x())
+                                            + "_" + std::to_string(chunk_coords.y()) + ".wchk");
+}
+
+bool ChunkCache::header_sanity_check(const WchkHeader& header,
+                                     const i32vec2& chunk_coords,
+                                     size_t file_size) const
+{
+    // Baked data is only a copy of generated data, any mismatch
+    // means the chunk must be baked again
+    if(header.magic != WCHK_MAGIC
+    || header.version_major != WCHK_VERSION_MAJOR
+    || header.version_minor != WCHK_VERSION_MINOR)
+        return false;
+
+    if(header.source_stamp != source_stamp_
+    || header.chunk_x != int32_t(chunk_coords.x())
+    || header.chunk_z != int32_t(chunk_coords.y()))
+        return false;
+
+    if(header.vertex_size != sizeof(Vertex3P3N3T2U))
+        return false;
+
+    // Truncated file
+    if(file_size < WCHK_HEADER_SIZE + payload_size(header))
+    {
+        DLOGW("[ChunkCache] Truncated baked chunk file.", "chunk");
+        return false;
+    }
+
+    return true;
+}
+
+std::unique_ptr<BakedChunk> ChunkCache::fetch(const i32vec2& chunk_coords) const
+{
+    if(!is_enabled())
+        return nullptr;
+
+    auto baked = std::make_unique<BakedChunk>();
+    if(!baked->file_.open(get_path(chunk_coords)))
+        return nullptr;
+    if(baked->file_.size() < WCHK_HEADER_SIZE)
+        return nullptr;
+
+    // Sections are 4 bytes aligned, they can be accessed in place
+    const uint8_t* data = baked->file_.data();
+    baked->header_ = reinterpret_cast<const WchkHeader*>(data);
+    if(!header_sanity_check(*baked->header_, chunk_coords, baked->file_.size()))
+        return nullptr;
+
+    const WchkHeader& header = *baked->header_;
+    data += WCHK_HEADER_SIZE;
+    baked->heights_ = reinterpret_cast<const float*>(data);
+    data += size_t(header.hm_width)*header.hm_length*sizeof(float);
+    baked->vertices_ = reinterpret_cast<const Vertex3P3N3T2U*>(data);
+    data += size_t(header.n_vertices)*header.vertex_size;
+    baked->indices_ = reinterpret_cast<const uint32_t*>(data);
+    data += size_t(header.n_indices)*sizeof(uint32_t);
+    baked->transforms_ = reinterpret_cast<const BakedTransform*>(data);
+    data += size_t(header.n_transforms)*sizeof(BakedTransform);
+    baked->batch_draws_ = reinterpret_cast<const uint32_t*>(data);
+    data += size_t(header.n_batches)*sizeof(uint32_t);
+    baked->lights_ = reinterpret_cast<const BakedLight*>(data);
+
+    return baked;
+}
+
+bool ChunkCache::is_baked(const i32vec2& chunk_coords) const
+{
+    if(!is_enabled())
+        return false;
+
+    fs::path path = get_path(chunk_coords);
+    std::ifstream ifs(path, std::ios::binary|std::ios::ate);
+    if(!ifs.is_open())
+        return false;
+    size_t file_size = size_t(ifs.tellg());
+    if(file_size < WCHK_HEADER_SIZE)
+        return false;
+
+    WchkHeaderWrapper header;
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+    return header_sanity_check(header.h, chunk_coords, file_size);
+}
+
+ChunkBakeData::ChunkBakeData(const i32vec2& chunk_coords,
+                             const HeightMap& heightmap,
+                             const SurfaceMesh& terrain_mesh):
+chunk_coords(chunk_coords),
+hm_width(heightmap.get_width()),
+hm_length(heightmap.get_length()),
+hm_scale(heightmap.get_scale()),
+heights(heightmap.data(), heightmap.data() + size_t(hm_width)*hm_length),
+vertices(terrain_mesh.get_vertex_buffer()),
+indices(terrain_mesh.get_index_buffer())
+{
+
+}
+
+// Header of a baked chunk, stamped with current level version
+static WchkHeaderWrapper make_header(const i32vec2& chunk_coords,
+                                     uint64_t source_stamp,
+                                     uint32_t hm_width,
+                                     uint32_t hm_length,
+                                     float hm_scale,
+                                     size_t n_vertices,
+                                     size_t n_indices,
+                                     size_t n_transforms,
+                                     size_t n_batches,
+                                     size_t n_lights)
+{
+    WchkHeaderWrapper header;
+    memset(&header, 0, sizeof(header));
+    header.h.magic         = WCHK_MAGIC;
+    header.h.version_major = WCHK_VERSION_MAJOR;
+    header.h.version_minor = WCHK_VERSION_MINOR;
+    header.h.source_stamp  = source_stamp;
+    header.h.chunk_x       = chunk_coords.x();
+    header.h.chunk_z       = chunk_coords.y();
+    header.h.hm_width      = hm_width;
+    header.h.hm_length     = hm_length;
+    header.h.hm_scale      = hm_scale;
+    header.h.vertex_size   = sizeof(Vertex3P3N3T2U);
+    header.h.n_vertices    = n_vertices;
+    header.h.n_indices     = n_indices;
+    header.h.n_transforms  = n_transforms;
+    header.h.n_batches     = n_batches;
+    header.h.n_lights      = n_lights;
+    return header;
+}
+
+bool ChunkCache::store(const i32vec2& chunk_coords,
+                       const HeightMap& heightmap,
+                       const SurfaceMesh& terrain_mesh) const
+{
+    if(!is_enabled())
+        return false;
+
+    const auto& vertices = terrain_mesh.get_vertex_buffer();
+    const auto& indices  = terrain_mesh.get_index_buffer();
+    WchkHeaderWrapper header = make_header(chunk_coords, source_stamp_,
+                                           heightmap.get_width(),
+                                           heightmap.get_length(),
+                                           heightmap.get_scale(),
+                                           vertices.size(),
+                                           indices.size(),
+                                           0, 0, 0);
+    return write_chunk(chunk_coords, header, heightmap.data(), vertices.data(), indices.data(),
+                       nullptr, nullptr, nullptr);
+}
+
+bool ChunkCache::store(const ChunkBakeData& data) const
+{
+    if(!is_enabled())
+        return false;
+
+    WchkHeaderWrapper header = make_header(data.chunk_coords, source_stamp_,
+                                           data.hm_width,
+                                           data.hm_length,
+                                           data.hm_scale,
+                                           data.vertices.size(),
+                                           data.indices.size(),
+                                           data.transforms.size(),
+                                           data.batch_draws.size(),
+                                           data.lights.size());
+    return write_chunk(data.chunk_coords, header, data.heights.data(), data.vertices.data(), data.indices.data(),
+                       data.transforms.data(), data.batch_draws.data(), data.lights.data());
+}
+
+bool ChunkCache::write_chunk(const i32vec2& chunk_coords,
+                             const WchkHeaderWrapper& header,
+                             const float* heights,
+                             const Vertex3P3N3T2U* vertices,
+                             const uint32_t* indices,
+                             const BakedTransform* transforms,
+                             const uint32_t* batch_draws,
+                             const BakedLight* lights) const
+{
+    // Write to a temporary file first, so that a chunk being mapped
+    // by another instance of the engine is never seen half written.
+    // Temporary file is named after the writing thread, as the same chunk
+    // can be baked by two jobs at once if it is reloaded quickly.
+    fs::path path = get_path(chunk_coords);
+    fs::path tmp_path = path;
+    tmp_path += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary);
+        if(!ofs.is_open())
+        {
+            DLOGE("[ChunkCache] Cannot write baked chunk:", "chunk");
+            DLOGI("<p>" + tmp_path.string() + "</p>", "chunk");
+            return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(heights),
+                  size_t(header.h.hm_width)*header.h.hm_length*sizeof(float));
+        ofs.write(reinterpret_cast<const char*>(vertices), size_t(header.h.n_vertices)*sizeof(Vertex3P3N3T2U));
+        ofs.write(reinterpret_cast<const char*>(indices), size_t(header.h.n_indices)*sizeof(uint32_t));
+        ofs.write(reinterpret_cast<const char*>(transforms), size_t(header.h.n_transforms)*sizeof(BakedTransform));
+        ofs.write(reinterpret_cast<const char*>(batch_draws), size_t(header.h.n_batches)*sizeof(uint32_t));
+        ofs.write(reinterpret_cast<const char*>(lights), size_t(header.h.n_lights)*sizeof(BakedLight));
+        if(!ofs.good())
+        {
+            DLOGE("[ChunkCache] Stream error while baking chunk.", "chunk");
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+void ChunkCache::clear() const
+{
+    if(!is_enabled())
+        return;
+
+    std::string prefix = "chunk_" + level_name_ + "_";
+    std::error_code ec;
+    for(auto&& entry: fs::directory_iterator(folder_, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if(name.compare(0, prefix.size(), prefix) == 0)
+            fs::remove(entry.path(), ec);
+    }
+}
+
+} // namespace wcore
@@ -1,4 +1,4 @@
-#include <thread>
+#include <algorithm>
 
 #include "chunk_manager.h"
 #include "config.h"
@@ -8,6 +8,10 @@
 #include "input_handler.h"
 #include "debug_info.h"
 #include "game_clock.h"
+#include "clock.hpp"
+#include "geometry_pool.hpp"
+#include "vertex_format.h"
+#include "job_system.h"
 
 namespace wcore
 {
@@ -23,19 +27,33 @@ view_radius_(2)
 #ifdef __OPT_CHUNK_LOAD_FULL_DISK__
 ,last_chunk_(0)
 #endif
+,stream_budget_ms_(2.f)
+,prefetch_horizon_s_(1.f)
+,last_cam_pos_(0.f)
+,cam_velocity_(0.f)
+,predicted_coords_(0)
+,last_prefetch_chunk_(0)
+,max_prefetch_jobs_(8)
 {
     // Get configuration
     uint32_t vr=2;
     if(CONFIG.get("root.render.chunk.load_distance"_h, vr))
-        view_radius_ = uint8_t(fmin(5,vr));
+        view_radius_ = uint8_t(std::min<uint32_t>(MAX_VIEW_RADIUS,vr));
+    CONFIG.get("root.render.chunk.stream_budget_ms"_h, stream_budget_ms_);
+    CONFIG.get("root.render.chunk.prefetch_horizon"_h, prefetch_horizon_s_);
+    CONFIG.get("root.render.chunk.max_prefetch_jobs"_h, max_prefetch_jobs_);
+    max_prefetch_jobs_ = std::max(max_prefetch_jobs_, 1u);
 
     // Register debug info fields
     DINFO.register_text_slot("sdiNGeom"_h, vec3(0.5,0.0,1.0));
+    DINFO.register_text_slot("sdiGeomPool"_h, vec3(0.5,0.0,1.0));
 }
 
 ChunkManager::~ChunkManager()
 {
-
+    // Worker threads may still be filling render batches
+    for(auto&& streaming: upload_queue_)
+        JOBS.wait(*streaming.submit_job);
 }
 
 void ChunkManager::init_events(InputHandler& handler)
@@ -56,6 +74,7 @@ void ChunkManager::load_start()
     i32vec2 chunk_coords((uint32_t)floor(cam_pos.x()/ck_size_m),
                          (uint32_t)floor(cam_pos.z()/ck_size_m));
     ploader->load_chunk(chunk_coords);
+    last_cam_pos_ = cam_pos;
 
 #ifdef __OPT_CHUNK_LOAD_DIRECTION_HINT__
     // load neighbors
@@ -144,19 +163,14 @@ void ChunkManager::update(const GameClock& clock)
                     continue;
                 i32vec2 candidate(chunk_coords.x()+ii*hint_x,
                                   chunk_coords.y()+jj*hint_z);
-                uint32_t c_index = std::hash<i32vec2>{}(candidate);
+                uint32_t c_index = coords_to_chunk_index(candidate);
                 if(pscene->has_chunk(c_index))
                     continue;
 
                 /*std::stringstream ss;
                 ss << candidate;
                 DLOGI(ss.str());*/
-                ploader->load_chunk(candidate);
-                /*std::thread th_load_ck([&]()
-                {
-                    ploader->load_chunk(candidate);
-                });
-                th_load_ck.detach();*/
+                load_queue_.push_back(candidate);
             }
         }
 
@@ -165,6 +179,10 @@ void ChunkManager::update(const GameClock& clock)
 
         last_quadrant_ = cur_quadrant;
     }
+
+    // Load queued chunks and upload finished ones within frame budget
+    if(process_queues())
+        pscene->sort_chunks();
 }
 #endif
 #ifdef __OPT_CHUNK_LOAD_FULL_DISK__
@@ -174,18 +192,19 @@ void ChunkManager::update(const GameClock& clock)
 
     // Locate game systems
     Scene* pscene        = locate<Scene>("Scene"_h);
-    SceneLoader* ploader = locate<SceneLoader>("SceneLoader"_h);
 
-    //float dt = clock.get_scaled_frame_duration();
+    // * Predict where the camera is heading and prefetch terrain there
+    prefetch(pscene->get_camera().get_position(), clock.get_frame_duration());
 
     // * Check if camera enters new chunk
     // get current chunk coordinates
     const i32vec2& chunk_coords = pscene->get_current_chunk_coords();
     uint32_t current_chunk = pscene->get_current_chunk_index();
 
-    // * If so, check for loadable neighbors in full visibility disk
+    // * If so, queue loadable neighbors in full visibility disk
     if(current_chunk!=last_chunk_)
     {
+        load_queue_.clear();
         for(int ii=-view_radius_; ii<=view_radius_; ++ii)
         {
             for(int jj=-view_radius_; jj<=view_radius_; ++jj)
@@ -198,21 +217,36 @@ void ChunkManager::update(const GameClock& clock)
                 int new_y = int(chunk_coords.y())+jj;
                 if(new_x<0 || new_y<0)
                     continue;
-                // Check if chunk already loaded
+                // Check if chunk already loaded (or streaming)
                 i32vec2 candidate(new_x, new_y);
-                uint32_t c_index = std::hash<i32vec2>{}(candidate);
+                uint32_t c_index = coords_to_chunk_index(candidate);
                 if(pscene->has_chunk(c_index))
                     continue;
-                // Load chunk
-                ploader->load_chunk(candidate);
+                load_queue_.push_back(candidate);
             }
         }
 
+        // Load chunks closest to where the camera is heading first
+        auto dist2 = [&](const i32vec2& coords)
+        {
+            int dx = int(coords.x())-int(predicted_coords_.x());
+            int dy = int(coords.y())-int(predicted_coords_.y());
+            return dx*dx+dy*dy;
+        };
+        std::sort(load_queue_.begin(), load_queue_.end(),
+        [&](const i32vec2& a, const i32vec2& b)
+        {
+            return dist2(a) < dist2(b);
+        });
+
         // * And unload chunks that escaped the visibility disk
         std::vector<uint32_t> unload_candidates;
         pscene->get_far_chunks(view_radius_+1, unload_candidates);
         for(uint32_t index: unload_candidates)
+        {
+            finish_streaming(index);
             pscene->remove_chunk(index);
+        }
 
         // Sort chunks
         pscene->sort_chunks();
@@ -220,17 +254,204 @@ void ChunkManager::update(const GameClock& clock)
         last_chunk_ = current_chunk;
     }
 
+    // * Load queued chunks and upload finished ones within frame budget
+    if(process_queues())
+        pscene->sort_chunks();
+
 #ifdef __PROFILING_CHUNKS__
     // Display debug info
     if(DINFO.active())
     {
         std::stringstream ss;
         ss << "Vertex count: " << pscene->get_vertex_count()
-           << " Triangles count: " << pscene->get_triangles_count();
+           << " Triangles count: " << pscene->get_triangles_count()
+           << " Streaming: " << load_queue_.size() << "/" << upload_queue_.size();
         DINFO.display("sdiNGeom"_h, ss.str());
+
+        GeometryPoolStats pool_stats = GeometryPool<Vertex3P3N3T2U>::instance().get_stats();
+        ss.str("");
+        ss << "Geometry pool: " << pool_stats.n_arenas << " arenas"
+           << " Occupancy: " << int(100*pool_stats.vertices.occupancy()) << "%/"
+                             << int(100*pool_stats.indices.occupancy()) << "%"
+           << " Fragmentation: " << int(100*pool_stats.vertices.fragmentation()) << "%/"
+                                 << int(100*pool_stats.indices.fragmentation()) << "%";
+        DINFO.display("sdiGeomPool"_h, ss.str());
     }
 #endif
 }
 #endif
 
+void ChunkManager::cancel_streaming()
+{
+    Scene* pscene = locate<Scene>("Scene"_h);
+
+    load_queue_.clear();
+    for(auto&& streaming: upload_queue_)
+    {
+        JOBS.wait(*streaming.submit_job);
+        pscene->remove_chunk(streaming.chunk_index);
+    }
+    upload_queue_.clear();
+
+#ifdef __OPT_CHUNK_LOAD_FULL_DISK__
+    // Force a neighborhood scan on next update
+    last_chunk_ = 0;
+#endif
+}
+
+void ChunkManager::stream_chunk(const i32vec2& chunk_coords)
+{
+    Scene* pscene        = locate<Scene>("Scene"_h);
+    SceneLoader* ploader = locate<SceneLoader>("SceneLoader"_h);
+
+    // Parsing and object creation stay on this thread, as materials
+    // allocate graphics resources. Terrain height map was hopefully
+    // generated in the background already, see prefetch().
+    uint32_t chunk_index = ploader->load_chunk(chunk_coords, false);
+    if(chunk_index == 0)
+        return;
+
+    // Concatenating meshes into render batches is CPU work only.
+    // The chunk is not drawn nor updated until its geometry is uploaded.
+    Chunk* chunk = &pscene->get_chunk_nc(chunk_index);
+    upload_queue_.push_back(StreamingChunk{chunk_index, std::make_unique<JobCounter>()});
+    JOBS.schedule([chunk]()
+    {
+        chunk->submit_geometry();
+    }, upload_queue_.back().submit_job.get());
+}
+
+void ChunkManager::finish_streaming(uint32_t chunk_index)
+{
+    auto it = std::find_if(upload_queue_.begin(), upload_queue_.end(),
+    [&](const StreamingChunk& streaming)
+    {
+        return streaming.chunk_index == chunk_index;
+    });
+    if(it == upload_queue_.end())
+        return;
+
+    JOBS.wait(*it->submit_job);
+    upload_queue_.erase(it);
+}
+
+void ChunkManager::prefetch(const vec3& cam_pos, float dt)
+{
+    // Locate game systems
+    Scene* pscene        = locate<Scene>("Scene"_h);
+    SceneLoader* ploader = locate<SceneLoader>("SceneLoader"_h);
+
+    // * Estimate camera velocity, smoothed over a few frames
+    if(dt > 0.f)
+        cam_velocity_ = cam_velocity_.lerp((cam_pos-last_cam_pos_)/dt, 0.1f);
+    last_cam_pos_ = cam_pos;
+
+    // * Extrapolate camera position, no further than view radius
+    uint32_t ck_size_m = ploader->get_chunk_size_meters();
+    vec3 offset(prefetch_horizon_s_*cam_velocity_);
+    float max_offset = float(view_radius_*ck_size_m);
+    if(offset.norm() > max_offset)
+        offset = max_offset*offset.normalized();
+    vec3 predicted(cam_pos+offset);
+    predicted_coords_ = i32vec2((uint32_t)floor(fmax(predicted.x(),0.f)/ck_size_m),
+                                (uint32_t)floor(fmax(predicted.z(),0.f)/ck_size_m));
+
+    uint32_t predicted_chunk = coords_to_chunk_index(predicted_coords_);
+    if(predicted_chunk != last_prefetch_chunk_)
+    {
+        last_prefetch_chunk_ = predicted_chunk;
+
+        // * Queue chunks of the visibility disk around predicted position, nearest first
+        prefetch_queue_.clear();
+        for(int ii=-view_radius_; ii<=view_radius_; ++ii)
+        {
+            for(int jj=-view_radius_; jj<=view_radius_; ++jj)
+            {
+                if((ii*ii+jj*jj)>view_radius_*view_radius_)
+                    continue;
+                int new_x = int(predicted_coords_.x())+ii;
+                int new_y = int(predicted_coords_.y())+jj;
+                if(new_x<0 || new_y<0)
+                    continue;
+                prefetch_queue_.push_back(i32vec2(new_x, new_y));
+            }
+        }
+        auto dist2 = [&](const i32vec2& coords)
+        {
+            int dx = int(coords.x())-int(predicted_coords_.x());
+            int dy = int(coords.y())-int(predicted_coords_.y());
+            return dx*dx+dy*dy;
+        };
+        std::sort(prefetch_queue_.begin(), prefetch_queue_.end(),
+        [&](const i32vec2& a, const i32vec2& b)
+        {
+            return dist2(a) < dist2(b);
+        });
+
+        // * Discard data prefetched in a direction we turned away from
+        ploader->drop_prefetched_chunks(pscene->get_current_chunk_coords(), 2*view_radius_+1);
+    }
+
+    // * Generate terrain of queued chunks, a bounded number of jobs at a time
+    // so that a prediction jump does not flood the job system
+    uint32_t in_flight = ploader->get_prefetch_job_count();
+    while(!prefetch_queue_.empty() && in_flight < max_prefetch_jobs_)
+    {
+        const i32vec2& candidate = prefetch_queue_.front();
+        if(!pscene->has_chunk(coords_to_chunk_index(candidate))
+        && ploader->prefetch_chunk(candidate))
+            ++in_flight;
+        prefetch_queue_.pop_front();
+    }
+}
+
+bool ChunkManager::process_queues()
+{
+    Scene* pscene = locate<Scene>("Scene"_h);
+
+    nanoClock clock;
+    auto budget_spent = [&]()
+    {
+        auto period = clock.get_elapsed_time();
+        return 1e3f*std::chrono::duration_cast<std::chrono::duration<float>>(period).count() > stream_budget_ms_;
+    };
+
+    // * Upload chunks whose render batches are ready, in request order
+    bool uploaded = false;
+    while(!upload_queue_.empty() && !budget_spent())
+    {
+        StreamingChunk& streaming = upload_queue_.front();
+        // Without worker threads, jobs only run when waited for
+        if(!streaming.submit_job->is_done() && JOBS.get_worker_count()>0)
+            break;
+        JOBS.wait(*streaming.submit_job);
+
+        pscene->upload_geometry(streaming.chunk_index);
+        pscene->populate_static_octree(streaming.chunk_index);
+        upload_queue_.pop_front();
+        uploaded = true;
+    }
+
+    // * Load new chunks with remaining budget, at least one per frame.
+    // Chunks whose height map is still generated by a prefetch job are
+    // skipped until it is ready, rather than waited for on this thread.
+    // Without worker threads, jobs only run when waited for.
+    SceneLoader* ploader = locate<SceneLoader>("SceneLoader"_h);
+    bool can_skip = JOBS.get_worker_count()>0;
+    bool first = true;
+    for(auto it=load_queue_.begin(); it!=load_queue_.end() && (first || !budget_spent());)
+    {
+        if(can_skip && ploader->is_prefetch_pending(coords_to_chunk_index(*it)))
+        {
+            ++it;
+            continue;
+        }
+        stream_chunk(*it);
+        it = load_queue_.erase(it);
+        first = false;
+    }
+
+    return uploaded;
+}
+
 }
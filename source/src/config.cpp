@@ -69,6 +69,10 @@ void Config::init()
     bool backtrace_on_error = false;
     get("root.debug.logger.print_backtrace_on_error"_h,  backtrace_on_error);
     dbg::LOG.set_backtrace_on_error(backtrace_on_error);
+    // Output messages from a dedicated thread
+    bool async_logging = false;
+    get("root.debug.logger.async"_h,  async_logging);
+    dbg::LOG.set_async(async_logging);
 #endif
 
     initialized_ = true;
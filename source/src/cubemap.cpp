@@ -2,6 +2,8 @@
 #include <cassert>
 
 #include "cubemap.h"
+#include "gfx_api.h"
+#include "platform/null/null_renderer_api.h"
 #include "material_common.h"
 #include "pixel_buffer.h"
 #include "png_loader.h"
@@ -27,9 +29,17 @@ Cubemap::Cubemap(const CubemapDescriptor& descriptor)
     }
 #endif
 
+    // Images are still loaded with the null graphics API, only the transfer is accounted for
+    bool headless = (Gfx::get_api() == GfxAPI::Null);
+
     // Generate cubemap texture and bind it
-    glGenTextures(1, &texture_id_);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id_);
+    if(headless)
+        texture_id_ = null_device().create_handle();
+    else
+    {
+        glGenTextures(1, &texture_id_);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id_);
+    }
 
     // Load texture data
     for(GLuint ii=0; ii<6; ++ii)
@@ -49,6 +59,13 @@ Cubemap::Cubemap(const CubemapDescriptor& descriptor)
             px_buf->debug_display();
 #endif
 
+        if(headless)
+        {
+            null_device().upload(std::size_t(px_buf->get_width())*px_buf->get_height()*3);
+            delete px_buf;
+            continue;
+        }
+
         glTexImage2D(
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + ii,
             0,
@@ -64,6 +81,9 @@ Cubemap::Cubemap(const CubemapDescriptor& descriptor)
         delete px_buf;
     }
 
+    if(headless)
+        return;
+
     // Texture parameters
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -79,6 +99,12 @@ Cubemap::~Cubemap()
 
 void Cubemap::bind()
 {
+    if(Gfx::get_api() == GfxAPI::Null)
+    {
+        null_device().bind_texture2D(0, texture_id_);
+        return;
+    }
+
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id_);
 }
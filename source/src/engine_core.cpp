@@ -3,6 +3,7 @@
 
 #include "engine_core.h"
 #include "glfwcontext.h"
+#include "gfx_api.h"
 #include "config.h"
 #include "globals.h"
 #include "game_system.h"
@@ -10,6 +11,7 @@
 #include "error.h"
 #include "input_handler.h"
 #include "logger.h"
+#include "frame_profiler.h"
 
 //GUI
 #ifndef __DISABLE_EDITOR__
@@ -144,6 +146,7 @@ bool EngineCore::onMouseFocus(const WData& data)
 
 void EngineCore::handle_events()
 {
+    W_PROFILE_SCOPE("Events");
 #ifndef __DISABLE_EDITOR__
     if(context_->imgui_initialized())
     {
@@ -157,16 +160,20 @@ void EngineCore::handle_events()
     handler_.handle_mouse(*context_);
     handler_.handle_keybindings(*context_);
 #endif
+    // Sync point: deliver input events queued this frame
+    handler_.dispatch_deferred();
 }
 
 void EngineCore::update(float dt)
 {
     if(game_clock_.is_game_paused())
         return;
+    W_PROFILE_SCOPE("Update");
     game_clock_.update(dt);
 
-    for(auto&& system: game_systems_)
-        system->update(game_clock_);
+    game_systems_.update(game_clock_);
+    // Sync point: deliver events queued by game systems, possibly from worker threads
+    handler_.dispatch_deferred();
 
     // To allow frame by frame update
     game_clock_.release_flags();
@@ -211,6 +218,11 @@ int EngineCore::run()
 #ifdef __PROFILING_STOP_AFTER_X_SAMPLES__
     uint32_t n_frames = 0;
 #endif //__PROFILING_STOP_AFTER_X_SAMPLES__
+#ifdef __PROFILE__
+    bool profiler_enabled = false;
+    CONFIG.get("root.debug.profiler.enabled"_h, profiler_enabled);
+    PROFILER.set_enabled(profiler_enabled);
+#endif
 
 #ifdef __DEBUG__
     DLOGT("-------- Game loop start --------", "profile");
@@ -220,6 +232,9 @@ int EngineCore::run()
         // Restart timers
         frame_clock.restart();
         clock.restart();
+#ifdef __PROFILE__
+        PROFILER.begin_frame();
+#endif
 
         // GAME UPDATES
 #ifdef __PROFILING_EngineCore__
@@ -243,30 +258,36 @@ int EngineCore::run()
 
         // RENDER
 #ifdef __PROFILING_EngineCore__
-        glFinish();
+        Gfx::device->finish();
         profile_clock.restart();
 #endif //__PROFILING_EngineCore__
 
         // Render game
-        if(!game_clock_.is_game_paused())
-            render();
+        {
+            W_PROFILE_SCOPE("Render");
+            if(!game_clock_.is_game_paused())
+                render();
+        }
 
         // GUI
+        {
+            W_PROFILE_SCOPE("GUI");
 #ifndef __DISABLE_EDITOR__
-        if(render_editor_GUI_)
-            generate_editor_widgets();
+            if(render_editor_GUI_)
+                generate_editor_widgets();
 #endif
 
-        // Render GUI
+            // Render GUI
 #ifndef __DISABLE_EDITOR__
-        if(render_editor_GUI_)
-            context_->imgui_render();
+            if(render_editor_GUI_)
+                context_->imgui_render();
 #endif
-        render_gui_func_(); // Game GUI
+            render_gui_func_(); // Game GUI
+        }
 
 #ifdef __PROFILING_EngineCore__
         {
-            glFinish();
+            Gfx::device->finish();
             auto period = profile_clock.get_elapsed_time();
             dt_profile_render = std::chrono::duration_cast<std::chrono::duration<float>>(period).count();
             render_time_fifo.push(dt_profile_render);
@@ -274,8 +295,11 @@ int EngineCore::run()
 #endif //__PROFILING_EngineCore__
 
         // Finish game loop
-        context_->swap_buffers();
-        context_->poll_events();
+        {
+            W_PROFILE_SCOPE("Swap buffers");
+            context_->swap_buffers();
+            context_->poll_events();
+        }
 
         // Sleep for the rest of the frame
         auto frame_d = clock.restart();
@@ -286,7 +310,12 @@ int EngineCore::run()
         idle_time_fifo.push(sleep_time);
 #endif //__PROFILING_EngineCore__
 
-        std::this_thread::sleep_for(sleep_duration);
+        // Headless runs are used to measure frame cost, frames are not throttled
+        if(Gfx::get_api() != GfxAPI::Null)
+            std::this_thread::sleep_for(sleep_duration);
+#ifdef __PROFILE__
+        PROFILER.end_frame();
+#endif
 
         frame_d = frame_clock.restart();
         dt = std::chrono::duration_cast<std::chrono::duration<float>>(frame_d).count();
@@ -323,10 +352,15 @@ int EngineCore::run()
 #endif //__PROFILING_EngineCore__
 
     fs::path log_path;
-    if(CONFIG.get<fs::path>("root.folders.log"_h, log_path))
-        dbg::LOG.write(log_path / "debug.log");
-    else
-        dbg::LOG.write(fs::path("debug.log"));
+    if(!CONFIG.get<fs::path>("root.folders.log"_h, log_path))
+        log_path = fs::path(".");
+    dbg::LOG.write(log_path / "debug.log");
+
+#ifdef __PROFILE__
+    // Last recorded frames for offline analysis
+    if(PROFILER.is_enabled())
+        PROFILER.export_chrome_trace(log_path / "trace.json");
+#endif
 
     return 0;
 }
@@ -0,0 +1,137 @@
+#include "entity_registry.h"
+#include "logger.h"
+
+namespace wcore
+{
+
+EntityRegistry::EntityRegistry():
+structure_version_(0)
+{
+    // Archetype 0 holds entities without components
+    archetypes_.push_back(std::make_unique<Archetype>());
+    archetype_index_.insert({0ull, 0u});
+}
+
+EntityRegistry::~EntityRegistry() = default;
+
+EntityHandle EntityRegistry::create()
+{
+    // * Recycle a free index if any, its generation was bumped when it was freed
+    uint32_t index;
+    if(!free_indices_.empty())
+    {
+        index = free_indices_.back();
+        free_indices_.pop_back();
+    }
+    else
+    {
+        index = uint32_t(records_.size());
+        records_.push_back(Record());
+    }
+
+    EntityHandle handle{index, records_[index].generation};
+    Archetype& empty = *archetypes_[0];
+    records_[index].archetype = 0;
+    records_[index].row = uint32_t(empty.entities.size());
+    empty.entities.push_back(handle);
+    ++structure_version_;
+    return handle;
+}
+
+bool EntityRegistry::destroy(EntityHandle handle)
+{
+    if(!is_alive(handle))
+    {
+        DLOGW("[EntityRegistry] Destroying stale entity handle <v>" + std::to_string(handle.index) + "</v>", "entity");
+        return false;
+    }
+
+    Record& record = records_[handle.index];
+    remove_row(*archetypes_[record.archetype], record.row);
+    record.archetype = INVALID_ARCHETYPE;
+    ++record.generation;
+    free_indices_.push_back(handle.index);
+    ++structure_version_;
+    return true;
+}
+
+void EntityRegistry::clear()
+{
+    // Archetypes are kept, their columns are only emptied
+    for(auto&& arch: archetypes_)
+    {
+        for(uint32_t ii=0; ii<detail::MAX_COMPONENT_TYPES; ++ii)
+            if(arch->columns[ii])
+                arch->columns[ii] = arch->columns[ii]->make_empty();
+        arch->entities.clear();
+    }
+    // Live handles must become stale
+    free_indices_.clear();
+    for(uint32_t ii=0; ii<records_.size(); ++ii)
+    {
+        if(records_[ii].archetype != INVALID_ARCHETYPE)
+            ++records_[ii].generation;
+        records_[ii].archetype = INVALID_ARCHETYPE;
+        free_indices_.push_back(ii);
+    }
+    ++structure_version_;
+}
+
+uint32_t EntityRegistry::get_archetype(uint64_t signature, uint32_t source, bool& created)
+{
+    auto it = archetype_index_.find(signature);
+    created = (it == archetype_index_.end());
+    if(!created)
+        return it->second;
+
+    // * Clone columns shared with source archetype
+    std::unique_ptr<Archetype> arch(new Archetype());
+    arch->signature = signature;
+    const Archetype& src = *archetypes_[source];
+    for(uint32_t ii=0; ii<detail::MAX_COMPONENT_TYPES; ++ii)
+        if((signature & (1ull << ii)) && src.columns[ii])
+            arch->columns[ii] = src.columns[ii]->make_empty();
+
+    uint32_t index = uint32_t(archetypes_.size());
+    archetypes_.push_back(std::move(arch));
+    archetype_index_.insert({signature, index});
+    return index;
+}
+
+void EntityRegistry::move_entity(EntityHandle handle, uint32_t target)
+{
+    Record& record = records_[handle.index];
+    Archetype& src = *archetypes_[record.archetype];
+    Archetype& dst = *archetypes_[target];
+
+    // * Move shared components to the end of target columns
+    uint64_t shared = src.signature & dst.signature;
+    for(uint32_t ii=0; ii<detail::MAX_COMPONENT_TYPES; ++ii)
+        if(shared & (1ull << ii))
+            src.columns[ii]->move_append(record.row, *dst.columns[ii]);
+
+    // * Fill the hole in source, components that were not moved are destroyed
+    uint32_t row = record.row;
+    dst.entities.push_back(handle);
+    record.archetype = target;
+    record.row = uint32_t(dst.entities.size()-1);
+    remove_row(src, row);
+    ++structure_version_;
+}
+
+void EntityRegistry::remove_row(Archetype& archetype, uint32_t row)
+{
+    for(uint32_t ii=0; ii<detail::MAX_COMPONENT_TYPES; ++ii)
+        if(archetype.signature & (1ull << ii))
+            archetype.columns[ii]->swap_remove(row);
+
+    uint32_t last = uint32_t(archetype.entities.size()-1);
+    if(row != last)
+    {
+        archetype.entities[row] = archetype.entities[last];
+        records_[archetype.entities[row].index].row = row;
+    }
+    archetype.entities.pop_back();
+}
+
+} // namespace wcore
@@ -2,7 +2,6 @@
 #include "sound_system.h"
 #include "game_object_factory.h"
 #include "basic_components.h"
-#include "scene.h"
 #include "logger.h"
 
 namespace wcore
@@ -10,11 +9,9 @@ namespace wcore
 
 static SoundSystem* s_sound_system = nullptr;
 static GameObjectFactory* s_game_object_factory = nullptr;
-static Scene* s_scene = nullptr;
 
 
-EntitySystem::EntitySystem():
-unique_id_(0)
+EntitySystem::EntitySystem()
 {
 
 }
@@ -26,7 +23,6 @@ void EntitySystem::init_self()
     // Locate game systems
     s_sound_system        = locate<SoundSystem>("SoundSystem"_h);
     s_game_object_factory = locate<GameObjectFactory>("GameObjectFactory"_h);
-    s_scene               = locate<Scene>("Scene"_h);
 
     DLOGN("Registering component factories.", "entity");
     // Register component factory methods in entity factory
@@ -46,53 +42,55 @@ void EntitySystem::init_self()
     DLOGES("entity", Severity::LOW);
 }
 
-// TMP
-static std::vector<uint64_t> sound_emitting_entities;
-static std::map<uint64_t, int> sound_channels;
-
 void EntitySystem::update(const GameClock& clock)
 {
+    flush_pending();
+
     // TMP
     // Use model's position vector as reference position
-    for(uint64_t ent_id: sound_emitting_entities)
+    registry_.query<component::WCSoundEmitter, component::WCModel>(
+    [&](EntityHandle handle, component::WCSoundEmitter& emitter, component::WCModel& model)
     {
-        int channel_id = sound_channels[ent_id];
-        if(channel_id == 0)
-        {
-            hash_t sound_name     = entities_[ent_id]->get_component<component::WCSoundEmitter>()->sound_name;
-            const math::vec3& pos = entities_[ent_id]->get_component<component::WCModel>()->model->get_position();
-
-            sound_channels[ent_id] = s_sound_system->play_sound(sound_name,
-                                                                pos);
-        }
+        const math::vec3& pos = model.model->get_position();
+        if(emitter.channel == 0)
+            emitter.channel = s_sound_system->play_sound(emitter.sound_name, pos);
         else
-        {
-            // update position
-            const math::vec3& pos = entities_[ent_id]->get_component<component::WCModel>()->model->get_position();
-            s_sound_system->set_channel_position(channel_id, pos);
-        }
-    }
+            s_sound_system->set_channel_position(emitter.channel, pos); // update position
+    });
 }
 
-uint64_t EntitySystem::add_entity(std::shared_ptr<WEntity> entity)
+void EntitySystem::add_entity(std::shared_ptr<WEntity> blueprint)
 {
-    uint64_t id = get_unique_id();
-    entities_.insert(std::pair(id, entity));
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_creations_.push_back(blueprint);
+}
 
-    // * Subscribe entity to systems depending on signature (component composition)
-    // Check for displayable components
-    if(entity->has_component<component::WCModel>())
+void EntitySystem::remove_entity(EntityHandle handle)
+{
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_destructions_.push_back(handle);
+}
+
+void EntitySystem::flush_pending()
+{
+    std::vector<std::shared_ptr<WEntity>> creations;
+    std::vector<EntityHandle> destructions;
     {
-        s_scene->register_displayable_entity(id);
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        creations.swap(pending_creations_);
+        destructions.swap(pending_destructions_);
     }
-    // TMP
-    if(entity->has_component<component::WCSoundEmitter>())
+
+    for(EntityHandle handle: destructions)
+        registry_.destroy(handle);
+
+    // Systems find entities by component composition through registry queries,
+    // there is no need to subscribe them
+    for(auto&& blueprint: creations)
     {
-        sound_emitting_entities.push_back(id);
-        sound_channels.insert(std::pair(id,0));
+        EntityHandle handle = registry_.create();
+        blueprint->copy_components(registry_, handle);
     }
-
-    return id;
 }
 
 
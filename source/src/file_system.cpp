@@ -13,6 +13,8 @@ namespace wcore
 struct FileSystem::Impl
 {
     std::map<hash_t, zipios::ZipFile> archives; // Open archives
+    std::map<hash_t, fs::path> archive_paths;
+    std::map<hash_t, std::shared_ptr<io::MappedFile>> archive_mappings; // Mapped on demand
     std::map<hash_t, std::map<hash_t, std::string>> vpaths; // Virtual paths inside loaded archives
     XMLParser xml_parser; // To parse the manifests inside archives
 };
@@ -53,6 +55,7 @@ bool FileSystem::open_archive(const fs::path& file_path, hash_t key)
 
     // Open and register archive
     pimpl_->archives.insert(std::pair(key, zipios::ZipFile(file_path.string().c_str())));
+    pimpl_->archive_paths[key] = file_path;
 
     // * Parse manifest inside archive
     DLOGI("<i>Reading manifest.</i>", "ios");
@@ -100,6 +103,9 @@ bool FileSystem::close_archive(hash_t key)
     // Close pack and remove entry
     it->second.close();
     pimpl_->archives.erase(it);
+    pimpl_->archive_paths.erase(key);
+    // Views still in use keep their own reference to the mapping
+    pimpl_->archive_mappings.erase(key);
     return true;
 }
 
@@ -204,6 +210,96 @@ std::shared_ptr<std::istream> FileSystem::get_file_as_stream(const char* filenam
     return nullptr;
 }
 
+io::FileView FileSystem::map_file(const fs::path& file_path)
+{
+    auto mapping = std::make_shared<io::MappedFile>();
+    if(!mapping->open(file_path))
+        return io::FileView();
+
+    DLOGN("[FileSystem] Mapping file:", "ios");
+    DLOGI("<p>" + file_path.string() + "</p>", "ios");
+
+    const uint8_t* data = mapping->data();
+    size_t size = mapping->size();
+    return io::FileView{std::move(mapping), data, size};
+}
+
+// Size of the fixed part of a zip local file header
+static constexpr size_t ZIP_LOCAL_HEADER_SIZE = 30;
+static constexpr uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+
+static inline uint16_t read_le16(const uint8_t* p) { return uint16_t(p[0] | (p[1]<<8)); }
+static inline uint32_t read_le32(const uint8_t* p) { return uint32_t(p[0] | (p[1]<<8) | (p[2]<<16) | (uint32_t(p[3])<<24)); }
+
+io::FileView FileSystem::map_file(const char* virtual_path, hash_t archive)
+{
+    auto it = pimpl_->archives.find(archive);
+    if(it == pimpl_->archives.end())
+        return io::FileView();
+
+    // Compressed entries cannot be accessed in place
+    zipios::FileEntry::pointer_t entry(it->second.getEntry(virtual_path));
+    if(!entry || entry->getMethod() != zipios::StorageMethod::STORED)
+        return io::FileView();
+
+    // Map the whole archive once
+    auto& mapping = pimpl_->archive_mappings[archive];
+    if(mapping == nullptr)
+    {
+        mapping = std::make_shared<io::MappedFile>();
+        if(!mapping->open(pimpl_->archive_paths[archive]))
+        {
+            mapping = nullptr;
+            return io::FileView();
+        }
+    }
+
+    // Entry offset points to the local header, whose variable length
+    // fields may differ from the central directory ones
+    size_t offset = size_t(entry->getEntryOffset());
+    if(offset + ZIP_LOCAL_HEADER_SIZE > mapping->size())
+        return io::FileView();
+    const uint8_t* header = mapping->data() + offset;
+    if(read_le32(header) != ZIP_LOCAL_HEADER_SIGNATURE)
+        return io::FileView();
+
+    size_t data_offset = offset + ZIP_LOCAL_HEADER_SIZE + read_le16(header+26) + read_le16(header+28);
+    size_t size = entry->getSize();
+    if(data_offset + size > mapping->size())
+        return io::FileView();
+
+    DLOGN("[FileSystem] Mapping file from archive:", "ios");
+    DLOGI(std::string("archive: ") + std::to_string(archive) + " -> <n>" + HRESOLVE(archive) + "</n>", "ios");
+    DLOGI(std::string("<h>vpath</h>:   <p>") + virtual_path + "</p>", "ios");
+
+    return io::FileView{mapping, mapping->data() + data_offset, size};
+}
+
+io::FileView FileSystem::map_file(const char* filename,
+                                  hash_t folder_node,
+                                  hash_t archive)
+{
+    // * Same lookup order as get_file_as_stream(), but failure is silent
+    fs::path file_path;
+    if(CONFIG.get(folder_node, file_path))
+    {
+        file_path /= filename;
+        if(fs::exists(file_path))
+            return map_file(file_path);
+    }
+
+    auto itvpaths = pimpl_->vpaths.find(archive);
+    if(itvpaths != pimpl_->vpaths.end())
+    {
+        const auto& vpaths = itvpaths->second;
+        auto itvpath = vpaths.find(folder_node);
+        if(itvpath != vpaths.end())
+            return map_file((itvpath->second+filename).c_str(), archive);
+    }
+
+    return io::FileView();
+}
+
 std::string FileSystem::get_file_as_string(const char* filename,
                                            hash_t folder_node,
                                            hash_t archive)
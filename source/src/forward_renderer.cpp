@@ -41,8 +41,27 @@ void ForwardRenderer::render(Scene* pscene)
     // Draw transparent geometry
     Gfx::device->set_std_blending();
 
-    pscene->draw_models([&](const Model& model)
+    // * Sort transparent models back to front, materials can't be grouped
+    // as blending depends on draw order
+    const vec3& campos = pscene->get_camera().get_position();
+    float inv_far = 1.f/pscene->get_camera().get_far();
+    uint32_t shader_id = forward_stage_shader_.get_program_id();
+    transparent_bucket_.clear();
+    pscene->submit_models(transparent_bucket_, [&](const Model& model, uint32_t chunk_index)
     {
+        float depth = (model.get_position()-campos).norm()*inv_far;
+        return sort_key::make(sort_key::PASS_FORWARD, shader_id, 0,
+                              sort_key::quantize_depth(depth, true),
+                              chunk_index);
+    },
+    wcore::DEFAULT_MODEL_EVALUATOR,
+    false,
+    wcore::MODEL_CATEGORY::TRANSPARENT);
+    transparent_bucket_.sort();
+
+    transparent_bucket_.execute([&](uint64_t, const DrawCommand& command)
+    {
+        const Model& model = *command.model;
         // Get model matrix and compute products
         mat4 M = const_cast<Model&>(model).get_model_matrix();
         mat4 MVP = PV*M;
@@ -60,10 +79,8 @@ void ForwardRenderer::render(Scene* pscene)
             forward_stage_shader_.send_uniform("mt.v4_tint"_h, vec4(material.get_albedo(),
                                                                   material.get_alpha()));
         }
-    },
-    wcore::DEFAULT_MODEL_EVALUATOR,
-    wcore::ORDER::BACK_TO_FRONT,
-    wcore::MODEL_CATEGORY::TRANSPARENT);
+        pscene->draw(command);
+    });
 
     Gfx::device->disable_blending();
     forward_stage_shader_.unuse();
@@ -3,6 +3,7 @@
 
 #include "frame_buffer.h"
 #include "gfx_api.h"
+#include "platform/null/null_renderer_api.h"
 #include "texture.h"
 #include "logger.h"
 #include "error.h"
@@ -28,6 +29,15 @@ height_(texture.get_height())
         DLOGI("height: <v>" + std::to_string(height_) + "</v>", "fbo");
     #endif
 
+    // No attachment to configure without a device
+    if(Gfx::get_api() == GfxAPI::Null)
+    {
+        frame_buffer_ = null_device().create_handle();
+        for(uint32_t ii=0; ii<n_textures_; ++ii)
+            texture_indices_.push_back(texture[ii]);
+        return;
+    }
+
     /*
         If there is a depth attachment, it means we need to do z-testing
         in the next render pass. So we need to do sampling. So we need a
@@ -161,14 +171,17 @@ height_(texture.get_height())
 
 FrameBuffer::~FrameBuffer()
 {
-    if(frame_buffer_) glDeleteFramebuffers(1, &frame_buffer_);
-    if(render_buffer_) glDeleteRenderbuffers(1, &render_buffer_);
+    if(Gfx::get_api() != GfxAPI::Null)
+    {
+        if(frame_buffer_) glDeleteFramebuffers(1, &frame_buffer_);
+        if(render_buffer_) glDeleteRenderbuffers(1, &render_buffer_);
+    }
     if(draw_buffers_) delete [] draw_buffers_;
 }
 
 void FrameBuffer::rebind_draw_buffers() const
 {
-    if(draw_buffers_)
+    if(draw_buffers_ && Gfx::get_api() != GfxAPI::Null)
     {
         //glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
         glDrawBuffers(n_textures_, draw_buffers_);
@@ -177,12 +190,12 @@ void FrameBuffer::rebind_draw_buffers() const
 
 void FrameBuffer::bind_as_render_target() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+    Gfx::device->bind_framebuffer(frame_buffer_);
 
 #ifdef __PROFILING_SET_1x1_VIEWPORT__
-    glViewport(0, 0, 1, 1);
+    Gfx::device->viewport(0, 0, 1, 1);
 #else
-    glViewport(0, 0, width_, height_);
+    Gfx::device->viewport(0, 0, width_, height_);
 #endif
 }
 
@@ -200,6 +213,12 @@ void FrameBuffer::with_render_target(std::function<void(void)> doFunc) const
 
 void FrameBuffer::blit_depth(FrameBuffer& destination) const
 {
+    if(Gfx::get_api() == GfxAPI::Null)
+    {
+        null_device().record({GfxCommandType::Blit, frame_buffer_, destination.frame_buffer_, 0});
+        return;
+    }
+
     // write depth buffer to destination framebuffer
     glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer_);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination.frame_buffer_);
@@ -217,6 +236,12 @@ void FrameBuffer::blit_depth(FrameBuffer& destination) const
 
 void FrameBuffer::blit_depth_default_fb(uint32_t screenWidth, uint32_t screenHeight)
 {
+    if(Gfx::get_api() == GfxAPI::Null)
+    {
+        null_device().record({GfxCommandType::Blit, frame_buffer_, Gfx::device->get_default_framebuffer(), 0});
+        return;
+    }
+
     // write depth buffer to default framebuffer
     glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer_);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, Gfx::device->get_default_framebuffer());
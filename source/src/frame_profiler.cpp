@@ -0,0 +1,241 @@
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <iomanip>
+
+#include "frame_profiler.h"
+#include "logger.h"
+
+#ifndef __DISABLE_EDITOR__
+    #include "imgui/imgui.h"
+#endif
+
+namespace wcore
+{
+
+// Nesting level of CPU markers in this thread
+static thread_local uint32_t marker_depth = 0;
+// Number of threads that were given an index
+static std::atomic<uint32_t> thread_count(0);
+
+FrameProfiler::FrameProfiler():
+enabled_(false),
+start_time_(std::chrono::high_resolution_clock::now()),
+n_frames_(0)
+{
+
+}
+
+void FrameProfiler::begin_frame()
+{
+    current_.index = n_frames_;
+    current_.start = now();
+}
+
+void FrameProfiler::end_frame()
+{
+    if(!is_enabled())
+        return;
+
+    // Gather events of all threads. Events are kept in the order they ended,
+    // sort them by start time so that parents come before their children.
+    current_.duration = now() - current_.start;
+    uint32_t n_buffers = std::min(thread_count.load(std::memory_order_acquire), MAX_THREADS);
+    for(uint32_t ii=0; ii<n_buffers; ++ii)
+    {
+        ThreadEvents& buffer = thread_events_[ii];
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        current_.events.insert(current_.events.end(), buffer.events.begin(), buffer.events.end());
+        buffer.events.clear();
+    }
+    std::sort(current_.events.begin(), current_.events.end(),
+              [](const ProfileEvent& a, const ProfileEvent& b)
+              {
+                  return a.start < b.start;
+              });
+
+    FrameProfile& slot = frames_[n_frames_ % MAX_FRAMES];
+    std::swap(slot, current_);
+    ++n_frames_;
+
+    // Reuse storage of the frame that was overwritten
+    current_.events.clear();
+    current_.index = n_frames_;
+    current_.start = now();
+    current_.duration = 0;
+}
+
+void FrameProfiler::push_event(const ProfileEvent& event)
+{
+    // Only contended while end_frame() drains this buffer
+    ThreadEvents& buffer = thread_events_[std::min(thread_index(), MAX_THREADS-1)];
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(event);
+}
+
+uint32_t FrameProfiler::thread_index()
+{
+    static thread_local uint32_t index = thread_count.fetch_add(1, std::memory_order_acq_rel);
+    return index;
+}
+
+const char* FrameProfiler::intern_name(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(names_mutex_);
+    for(auto&& interned: names_)
+        if(interned == name)
+            return interned.c_str();
+    names_.push_back(name);
+    return names_.back().c_str();
+}
+
+// Sum of the durations of the events named name in a frame, in s
+static float total_duration(const FrameProfile& frame, const char* name)
+{
+    uint64_t total = 0;
+    for(auto&& event: frame.events)
+        if(event.name == name || strcmp(event.name, name) == 0)
+            total += event.duration;
+    return total * 1e-9f;
+}
+
+FinalStatistics FrameProfiler::get_stats(const char* name) const
+{
+    if(get_frame_count() == 0)
+        return FinalStatistics();
+
+    MovingAverage durations(MAX_FRAMES);
+    for(size_t ii=get_frame_count(); ii>0; --ii)
+        durations.push(total_duration(get_frame(ii-1), name));
+    return durations.get_stats();
+}
+
+float FrameProfiler::get_last_duration(const char* name) const
+{
+    if(get_frame_count() == 0)
+        return 0.f;
+    return total_duration(get_frame(0), name);
+}
+
+static void write_json_string(std::ofstream& ofs, const char* str)
+{
+    ofs << '"';
+    for(const char* c=str; *c; ++c)
+    {
+        if(*c == '"' || *c == '\\')
+            ofs << '\\';
+        ofs << *c;
+    }
+    ofs << '"';
+}
+
+bool FrameProfiler::export_chrome_trace(const fs::path& path) const
+{
+    std::ofstream ofs(path);
+    if(!ofs.is_open())
+    {
+        DLOGE("[FrameProfiler] Cannot write trace file:", "profile");
+        DLOGI("<p>" + path.string() + "</p>", "profile");
+        return false;
+    }
+
+    // Complete events ("X"), timestamps in µs. GPU markers get their own track.
+    ofs << "{\"traceEvents\":[" << std::endl;
+    ofs << std::fixed << std::setprecision(3);
+    std::set<uint32_t> threads;
+    bool first = true;
+    for(size_t ii=get_frame_count(); ii>0; --ii)
+    {
+        const FrameProfile& frame = get_frame(ii-1);
+        if(!first) ofs << "," << std::endl;
+        first = false;
+        ofs << "{\"name\":\"Frame " << frame.index << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+            << ",\"ts\":" << frame.start*1e-3 << ",\"dur\":" << frame.duration*1e-3 << "}";
+
+        for(auto&& event: frame.events)
+        {
+            uint32_t tid = (event.thread == GPU_THREAD) ? 1 : event.thread + 2;
+            threads.insert(tid);
+            ofs << "," << std::endl << "{\"name\":";
+            write_json_string(ofs, event.name);
+            ofs << ",\"cat\":\"" << ((event.thread == GPU_THREAD) ? "gpu" : "cpu")
+                << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+                << ",\"ts\":" << event.start*1e-3 << ",\"dur\":" << event.duration*1e-3 << "}";
+        }
+    }
+
+    // Track names
+    ofs << (first ? "" : ",") << std::endl
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+    for(uint32_t tid: threads)
+    {
+        ofs << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"";
+        if(tid == 1) ofs << "GPU";
+        else         ofs << "Thread " << tid-2;
+        ofs << "\"}}";
+    }
+    ofs << std::endl << "]}" << std::endl;
+
+    DLOGN("[FrameProfiler] Exported <z>" + std::to_string(get_frame_count()) + "</z> frames to:", "profile");
+    DLOGI("<p>" + path.string() + "</p>", "profile");
+    return ofs.good();
+}
+
+#ifndef __DISABLE_EDITOR__
+void FrameProfiler::generate_widget()
+{
+    if(get_frame_count() == 0)
+    {
+        ImGui::Text("No frame recorded.");
+        return;
+    }
+
+    const FrameProfile& frame = get_frame(0);
+    ImGui::Text("Frame %lu: %.3f ms", (unsigned long)frame.index, frame.duration*1e-6f);
+    ImGui::Separator();
+
+    // Last frame markers, per thread, indented by nesting level
+    ImGui::Columns(3, "##profilecols", false);
+    ImGui::Text("Marker");   ImGui::NextColumn();
+    ImGui::Text("Last (ms)"); ImGui::NextColumn();
+    ImGui::Text("Mean (ms)"); ImGui::NextColumn();
+    for(auto&& event: frame.events)
+    {
+        ImGui::Text("%s%*s%s", (event.thread == GPU_THREAD) ? "[GPU] " : "",
+                    int(2*event.depth), "", event.name);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", event.duration*1e-6f);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", 1e3f*get_stats(event.name).mean);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+#endif
+
+ProfileScope::ProfileScope(const char* name):
+name_(name),
+start_(0),
+depth_(0),
+active_(PROFILER.is_enabled())
+{
+    if(active_)
+    {
+        depth_ = marker_depth++;
+        start_ = PROFILER.now();
+    }
+}
+
+ProfileScope::~ProfileScope()
+{
+    if(!active_)
+        return;
+
+    uint64_t stop = PROFILER.now();
+    --marker_depth;
+    PROFILER.push_event({name_, start_, stop-start_, FrameProfiler::thread_index(), depth_});
+}
+
+} // namespace wcore
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cmath>
+#ifdef __SSE__
+    #include <xmmintrin.h>
+#endif
+
+#include "frustum_culling.h"
+#include "bounding_boxes.h"
+
+namespace wcore
+{
+
+using namespace math;
+
+void VisibilityBitset::resize(uint32_t size, bool value)
+{
+    size_ = size;
+    words_.assign((size+63)/64, value ? ~uint64_t(0) : uint64_t(0));
+}
+
+uint32_t VisibilityBitset::count() const
+{
+    uint32_t result = 0;
+    for(uint32_t ww=0; ww<words_.size(); ++ww)
+    {
+        // Unused bits of the last word may be set
+        uint64_t word = words_[ww];
+        if(ww == words_.size()-1 && (size_&63))
+            word &= (uint64_t(1) << (size_&63)) - 1;
+        result += __builtin_popcountll(word);
+    }
+    return result;
+}
+
+void FrustumPlanes::update(const FrustumBox& frustum_box)
+{
+    const std::array<vec3, 6>& normals = frustum_box.get_normals();
+    for(uint32_t ii=0; ii<6; ++ii)
+    {
+        nx[ii] = normals[ii].x();
+        ny[ii] = normals[ii].y();
+        nz[ii] = normals[ii].z();
+        // Signed distance of the origin
+        d[ii]  = frustum_box.dist_to_plane(ii, vec3(0.f));
+    }
+}
+
+void CullingBoxes::resize(uint32_t size)
+{
+    size_   = size;
+    stride_ = (size+3) & ~3u;
+    data_.assign(N_STREAMS*stride_, 0.f);
+    no_cull_.resize(size, false);
+}
+
+void CullingBoxes::set(uint32_t index, const std::array<vec3, 8>& vertices)
+{
+    // Vertex 0 is (+x,-y,+z) and vertex 6 (-x,+y,-z) in box space,
+    // neighbors of vertex 0 along each axis are 3 (x), 4 (y) and 1 (z)
+    vec3 center = 0.5f*(vertices[0]+vertices[6]);
+    vec3 u = 0.5f*(vertices[0]-vertices[3]);
+    vec3 v = 0.5f*(vertices[4]-vertices[0]);
+    vec3 w = 0.5f*(vertices[0]-vertices[1]);
+
+    stream(CX)[index] = center.x(); stream(CY)[index] = center.y(); stream(CZ)[index] = center.z();
+    stream(UX)[index] = u.x();      stream(UY)[index] = u.y();      stream(UZ)[index] = u.z();
+    stream(VX)[index] = v.x();      stream(VY)[index] = v.y();      stream(VZ)[index] = v.z();
+    stream(WX)[index] = w.x();      stream(WY)[index] = w.y();      stream(WZ)[index] = w.z();
+    no_cull_.reset(index);
+}
+
+void CullingBoxes::cull(const FrustumPlanes& planes, uint32_t begin, uint32_t end, VisibilityBitset& visibility,
+                        bool use_simd) const
+{
+    end = std::min(end, size_);
+    for(uint32_t start=begin; start<end; start+=64)
+    {
+        uint32_t count = std::min(64u, end-start);
+        uint64_t mask = (use_simd ? cull_word(planes, start, count) : cull_word_scalar(planes, start, count))
+                      | no_cull_.get_word(start>>6);
+        visibility.set_word(start>>6, mask);
+    }
+}
+
+// A box is outside the frustum iif all its vertices are below the same plane,
+// that is iif the signed distance of its center plus its projected radius
+// on the plane normal is negative for one of the planes:
+// r = |n.u| + |n.v| + |n.w|
+#ifdef __SSE__
+uint64_t CullingBoxes::cull_word(const FrustumPlanes& planes, uint32_t begin, uint32_t count) const
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.f);
+    const __m128 zero = _mm_setzero_ps();
+
+    uint64_t result = 0;
+    // Streams are padded to a multiple of 4, last batch may test padding boxes
+    for(uint32_t ii=0; ii<count; ii+=4)
+    {
+        uint32_t idx = begin+ii;
+        __m128 cx = _mm_loadu_ps(stream(CX)+idx);
+        __m128 cy = _mm_loadu_ps(stream(CY)+idx);
+        __m128 cz = _mm_loadu_ps(stream(CZ)+idx);
+        __m128 ux = _mm_loadu_ps(stream(UX)+idx);
+        __m128 uy = _mm_loadu_ps(stream(UY)+idx);
+        __m128 uz = _mm_loadu_ps(stream(UZ)+idx);
+        __m128 vx = _mm_loadu_ps(stream(VX)+idx);
+        __m128 vy = _mm_loadu_ps(stream(VY)+idx);
+        __m128 vz = _mm_loadu_ps(stream(VZ)+idx);
+        __m128 wx = _mm_loadu_ps(stream(WX)+idx);
+        __m128 wy = _mm_loadu_ps(stream(WY)+idx);
+        __m128 wz = _mm_loadu_ps(stream(WZ)+idx);
+
+        __m128 outside = _mm_setzero_ps();
+        for(uint32_t pp=0; pp<6; ++pp)
+        {
+            __m128 nx = _mm_set1_ps(planes.nx[pp]);
+            __m128 ny = _mm_set1_ps(planes.ny[pp]);
+            __m128 nz = _mm_set1_ps(planes.nz[pp]);
+
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+                                     _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(planes.d[pp])));
+            __m128 ru = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, ux), _mm_mul_ps(ny, uy)), _mm_mul_ps(nz, uz));
+            __m128 rv = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, vx), _mm_mul_ps(ny, vy)), _mm_mul_ps(nz, vz));
+            __m128 rw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, wx), _mm_mul_ps(ny, wy)), _mm_mul_ps(nz, wz));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign_mask, ru),
+                                                  _mm_andnot_ps(sign_mask, rv)),
+                                                  _mm_andnot_ps(sign_mask, rw));
+
+            outside = _mm_or_ps(outside, _mm_cmple_ps(_mm_add_ps(dist, radius), zero));
+        }
+        uint64_t visible = uint64_t(~_mm_movemask_ps(outside) & 0xf);
+        result |= visible << ii;
+    }
+
+    // Clear padding bits
+    if(count < 64)
+        result &= (uint64_t(1) << count) - 1;
+    return result;
+}
+#else
+uint64_t CullingBoxes::cull_word(const FrustumPlanes& planes, uint32_t begin, uint32_t count) const
+{
+    return cull_word_scalar(planes, begin, count);
+}
+#endif
+
+uint64_t CullingBoxes::cull_word_scalar(const FrustumPlanes& planes, uint32_t begin, uint32_t count) const
+{
+    uint64_t result = 0;
+    for(uint32_t ii=0; ii<count; ++ii)
+    {
+        uint32_t idx = begin+ii;
+        bool outside = false;
+        for(uint32_t pp=0; pp<6 && !outside; ++pp)
+        {
+            float nx = planes.nx[pp];
+            float ny = planes.ny[pp];
+            float nz = planes.nz[pp];
+            float dist   = nx*stream(CX)[idx] + ny*stream(CY)[idx] + nz*stream(CZ)[idx] + planes.d[pp];
+            float radius = std::fabs(nx*stream(UX)[idx] + ny*stream(UY)[idx] + nz*stream(UZ)[idx])
+                         + std::fabs(nx*stream(VX)[idx] + ny*stream(VY)[idx] + nz*stream(VZ)[idx])
+                         + std::fabs(nx*stream(WX)[idx] + ny*stream(WY)[idx] + nz*stream(WZ)[idx]);
+            outside = (dist + radius <= 0.f);
+        }
+        if(!outside)
+            result |= (uint64_t(1) << ii);
+    }
+    return result;
+}
+
+} // namespace wcore
@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <thread>
+
 #include "game_system.h"
+#include "job_system.h"
 #include "logger.h"
+#include "frame_profiler.h"
+#include "intern_string.h"
 
 namespace wcore
 {
@@ -53,6 +59,193 @@ void GameSystemContainer::register_game_system(hash_t name, GameSystem* system,
 
     game_systems_map_.insert(std::make_pair(name, system));
     game_systems_.push_back(system);
+
+    node_index_.insert(std::make_pair(name, uint32_t(update_nodes_.size())));
+    update_nodes_.push_back(UpdateNode());
+    update_nodes_.back().system = system;
+#ifdef __PROFILE__
+    #ifdef __DEBUG__
+    update_nodes_.back().profile_name = PROFILER.intern_name(HRESOLVE(name));
+    #else
+    update_nodes_.back().profile_name = PROFILER.intern_name(std::to_string(name));
+    #endif
+#endif
+    graph_dirty_ = true;
+}
+
+void GameSystemContainer::add_dependency(hash_t name, hash_t dependency)
+{
+    auto it_sys = node_index_.find(name);
+    auto it_dep = node_index_.find(dependency);
+    if(it_sys == node_index_.end() || it_dep == node_index_.end())
+    {
+        DLOGE("[GameSystemContainer] Cannot declare dependency, unknown game system:", "core");
+        DLOGI(HRESOLVE(name) + " -> " + HRESOLVE(dependency), "core");
+        return;
+    }
+
+    update_nodes_[it_sys->second].dependencies.push_back(it_dep->second);
+    graph_dirty_ = true;
+}
+
+void GameSystemContainer::set_worker_update(hash_t name, bool value)
+{
+    auto it = node_index_.find(name);
+    if(it == node_index_.end())
+    {
+        DLOGE("[GameSystemContainer] Unknown game system:", "core");
+        DLOGI(std::to_string(name) + " -> " + HRESOLVE(name), "core");
+        return;
+    }
+
+    update_nodes_[it->second].worker_update = value;
+    graph_dirty_ = true;
+}
+
+void GameSystemContainer::build_update_graph()
+{
+    uint32_t n_nodes = uint32_t(update_nodes_.size());
+
+    // * Compute dependents lists
+    for(auto&& node: update_nodes_)
+    {
+        node.dependents.clear();
+        node.n_dependencies = 0;
+    }
+    int last_main = -1;
+    for(uint32_t ii=0; ii<n_nodes; ++ii)
+    {
+        UpdateNode& node = update_nodes_[ii];
+        std::vector<uint32_t> dependencies(node.dependencies);
+        // Systems updated on the calling thread keep their relative order
+        if(!node.worker_update)
+        {
+            if(last_main>=0)
+                dependencies.push_back(uint32_t(last_main));
+            last_main = int(ii);
+        }
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+
+        for(uint32_t dep: dependencies)
+        {
+            if(dep == ii) continue;
+            update_nodes_[dep].dependents.push_back(ii);
+            ++node.n_dependencies;
+        }
+    }
+
+    // * Check for cycles (Kahn's algorithm)
+    std::vector<uint32_t> in_degree(n_nodes);
+    std::vector<uint32_t> ready;
+    for(uint32_t ii=0; ii<n_nodes; ++ii)
+    {
+        in_degree[ii] = update_nodes_[ii].n_dependencies;
+        if(in_degree[ii] == 0)
+            ready.push_back(ii);
+    }
+    uint32_t n_visited = 0;
+    while(!ready.empty())
+    {
+        uint32_t index = ready.back();
+        ready.pop_back();
+        ++n_visited;
+        for(uint32_t dependent: update_nodes_[index].dependents)
+            if(--in_degree[dependent] == 0)
+                ready.push_back(dependent);
+    }
+    graph_valid_ = (n_visited == n_nodes);
+    if(!graph_valid_)
+    {
+        DLOGE("[GameSystemContainer] Cyclic update dependencies.", "core");
+        DLOGI("Falling back to serial update.", "core");
+    }
+
+    remaining_deps_.reset(new std::atomic<uint32_t>[n_nodes]);
+    graph_dirty_ = false;
+}
+
+void GameSystemContainer::update(const GameClock& clock)
+{
+    if(graph_dirty_)
+        build_update_graph();
+    if(!graph_valid_)
+    {
+        update_serial(clock);
+        return;
+    }
+
+    // * Reset frame state and start with systems that have no dependency
+    uint32_t n_nodes = uint32_t(update_nodes_.size());
+    n_updated_.store(0);
+    main_ready_.clear();
+    for(uint32_t ii=0; ii<n_nodes; ++ii)
+        remaining_deps_[ii].store(update_nodes_[ii].n_dependencies, std::memory_order_relaxed);
+    for(uint32_t ii=0; ii<n_nodes; ++ii)
+        if(update_nodes_[ii].n_dependencies == 0)
+            schedule_update(ii, clock);
+
+    // * Update main thread systems as they become ready, help workers otherwise
+    while(n_updated_.load(std::memory_order_acquire) < n_nodes)
+    {
+        int next = -1;
+        {
+            std::lock_guard<std::mutex> lock(main_ready_mutex_);
+            if(!main_ready_.empty())
+            {
+                auto it = std::min_element(main_ready_.begin(), main_ready_.end());
+                next = int(*it);
+                main_ready_.erase(it);
+            }
+        }
+
+        if(next>=0)
+        {
+            update_system(uint32_t(next), clock);
+            release_dependents(uint32_t(next), clock);
+        }
+        else if(!JOBS.run_pending_job())
+            std::this_thread::yield();
+    }
+}
+
+void GameSystemContainer::update_serial(const GameClock& clock)
+{
+    for(uint32_t ii=0; ii<update_nodes_.size(); ++ii)
+        update_system(ii, clock);
+}
+
+void GameSystemContainer::update_system(uint32_t index, const GameClock& clock)
+{
+    W_PROFILE_SCOPE(update_nodes_[index].profile_name);
+    update_nodes_[index].system->update(clock);
+}
+
+void GameSystemContainer::schedule_update(uint32_t index, const GameClock& clock)
+{
+    if(update_nodes_[index].worker_update)
+    {
+        JOBS.schedule([this, index, &clock]()
+        {
+            update_system(index, clock);
+            release_dependents(index, clock);
+        });
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(main_ready_mutex_);
+        main_ready_.push_back(index);
+    }
+}
+
+void GameSystemContainer::release_dependents(uint32_t index, const GameClock& clock)
+{
+    for(uint32_t dependent: update_nodes_[index].dependents)
+        if(remaining_deps_[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            schedule_update(dependent, clock);
+
+    // Dependents are scheduled before this system counts as updated
+    n_updated_.fetch_add(1, std::memory_order_release);
 }
 
 void GameSystemContainer::init_game_systems()
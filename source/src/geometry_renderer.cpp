@@ -13,6 +13,7 @@
 #include "material.h"
 #include "texture.h"
 #include "buffer_module.h"
+#include "buffer.h"
 
 #ifndef __DISABLE_EDITOR__
     #include "imgui/imgui.h"
@@ -24,20 +25,74 @@ namespace wcore
 
 using namespace math;
 
+// CPU side of the object_data uniform block (object_data.glsl), std140 layout.
+// Padded to 256 bytes, the largest uniform buffer offset alignment, so that
+// consecutive objects can be bound at their own offset.
+struct ObjectData
+{
+    math::mat4 model;
+    float padding[48];
+};
+static_assert(sizeof(ObjectData) == 256, "ObjectData must be padded to uniform buffer offset alignment.");
+
 
 GeometryRenderer::GeometryRenderer():
 geometry_pass_shader_(ShaderResource("gpass.vert;gpass.geom;gpass.frag")),
 terrain_shader_(ShaderResource("gpass.vert;gpass.geom;gpass.frag", "VARIANT_SPLAT")),
 null_shader_(ShaderResource("null.vert;null.frag")),
+instanced_shader_(ShaderResource("gpass.vert;gpass.geom;gpass.frag", "VARIANT_INSTANCED")),
+null_instanced_shader_(ShaderResource("null.vert;null.frag", "VARIANT_INSTANCED")),
 wireframe_mix_(0.0f),
 min_parallax_distance_(20.f),
 allow_normal_mapping_(true),
-allow_parallax_mapping_(true)
+allow_parallax_mapping_(true),
+allow_hardware_instancing_(true)
 {
     CONFIG.get("root.render.override.allow_normal_mapping"_h, allow_normal_mapping_);
     CONFIG.get("root.render.override.allow_parallax_mapping"_h, allow_parallax_mapping_);
+    CONFIG.get("root.render.override.allow_hardware_instancing"_h, allow_hardware_instancing_);
 
     Gfx::device->set_clear_color(0.f,0.f,0.f,1.f);
+    object_ubo_ = UniformBuffer::create(sizeof(math::mat4));
+}
+
+GeometryRenderer::~GeometryRenderer()
+{
+    delete object_ubo_;
+}
+
+void GeometryRenderer::bind_object_data(std::size_t base_offset, uint32_t index, const mat4& model_matrix)
+{
+    if(base_offset != StreamBuffer::INVALID_OFFSET)
+    {
+        Gfx::stream_buffer->bind_uniform(uint32_t(UniformBlock::OBJECT), base_offset + index*sizeof(ObjectData),
+                                         sizeof(math::mat4));
+        return;
+    }
+    object_ubo_->stream(&model_matrix, sizeof(math::mat4));
+    object_ubo_->bind(uint32_t(UniformBlock::OBJECT));
+}
+
+void GeometryRenderer::prepare_material(Shader& shader, const Model& model, const vec3& campos, bool bind_textures)
+{
+    // material uniforms
+    shader.send_uniforms(model.get_material());
+    // overrides
+    if(!allow_normal_mapping_)
+        shader.send_uniform("mt.b_use_normal_map"_h, false);
+    if(!allow_parallax_mapping_)
+        shader.send_uniform("mt.b_use_parallax_map"_h, false);
+    else
+    {
+        // use parallax mapping only if object is close enough
+        float dist = (model.get_position()-campos).norm();
+        shader.send_uniform("mt.b_use_parallax_map"_h, (dist < min_parallax_distance_));
+    }
+    if(bind_textures && model.get_material().is_textured())
+    {
+        // bind current material texture units if any
+        model.get_material().bind_texture();
+    }
 }
 
 void GeometryRenderer::render(Scene* pscene)
@@ -56,6 +111,14 @@ void GeometryRenderer::render(Scene* pscene)
 
     Shader* shader = &geometry_pass_shader_;
 
+    // With hardware instancing, model instances are drawn separately, one draw call per mesh & material
+    ModelEvaluator evaluate = wcore::DEFAULT_MODEL_EVALUATOR;
+    if(allow_hardware_instancing_)
+        evaluate = [](Model& model)
+        {
+            return model.get_mesh().get_buffer_token().batch_category != "instance"_h;
+        };
+
     Gfx::device->set_cull_mode(CullMode::Back);
     shader->use();
     // Wireframe mix
@@ -67,47 +130,65 @@ void GeometryRenderer::render(Scene* pscene)
 
     Gfx::device->clear(CLEAR_COLOR_FLAG | CLEAR_DEPTH_FLAG); // Suppressed valgrind false positive in valgrind.supp
 
-    pscene->draw_models([&](const Model& model)
+    // * Generate sort keys: materials are grouped to avoid redundant texture binds and
+    // uniform uploads, front to back within a material group
+    float inv_far = 1.f/pscene->get_camera().get_far();
+    uint32_t shader_id = shader->get_program_id();
+    opaque_bucket_.clear();
+    pscene->submit_models(opaque_bucket_, [&](const Model& model, uint32_t chunk_index)
     {
-        // Get model matrix and compute products
-        mat4 M = const_cast<Model&>(model).get_model_matrix();
-        mat4 MV = V*M;
-        mat4 MVP = PV*M;
-
-        // normal matrix for light calculation
-        //shader->send_uniform("tr.m3_Normal"_h, M.submatrix(3,3)); // Transposed inverse of M if non uniform scales
-        shader->send_uniform("tr.m3_Normal"_h, MV.submatrix(3,3)); // Transposed inverse of M if non uniform scales
-        // model matrix
-        //shader->send_uniform("tr.m4_Model"_h, M);
-        shader->send_uniform("tr.m4_ModelView"_h, MV);
-        // MVP matrix
-        shader->send_uniform("tr.m4_ModelViewProjection"_h, MVP);
-        // material uniforms
-        shader->send_uniforms(model.get_material());
-        // overrides
-        if(!allow_normal_mapping_)
-            shader->send_uniform("mt.b_use_normal_map"_h, false);
-        if(!allow_parallax_mapping_)
-            shader->send_uniform("mt.b_use_parallax_map"_h, false);
-        else
-        {
-            // use parallax mapping only if object is close enough
-            float dist = (model.get_position()-campos).norm();
-            shader->send_uniform("mt.b_use_parallax_map"_h, (dist < min_parallax_distance_));
-        }
-        if(model.get_material().is_textured())
-        {
-            // bind current material texture units if any
-            model.get_material().bind_texture();
-        }
+        float depth = (model.get_position()-campos).norm()*inv_far;
+        return sort_key::make(sort_key::PASS_GBUFFER, shader_id,
+                              sort_key::fold_material(model.get_material().get_state_hash()),
+                              sort_key::quantize_depth(depth),
+                              chunk_index);
     },
-    [&](const Model& model) // evaluator predicate
+    evaluate,
+    true); // Visibility is evaluated during update by Scene::visibility_pass()
+    opaque_bucket_.sort();
+
+    // * Model matrices of all commands are written to the stream buffer at once,
+    // each draw only binds its range of the object_data block
+    object_data_.resize(opaque_bucket_.size());
+    uint32_t object_index = 0;
+    opaque_bucket_.execute([&](uint64_t, const DrawCommand& command)
     {
-        return model.is_visible(); // Visibility is evaluated during update by Scene::visibility_pass()
-    },
-    wcore::ORDER::FRONT_TO_BACK);
+        object_data_[object_index++].model = const_cast<Model*>(command.model)->get_model_matrix();
+    });
+    std::size_t object_offset = StreamBuffer::INVALID_OFFSET;
+    if(Gfx::stream_buffer && !object_data_.empty())
+        object_offset = Gfx::stream_buffer->write(object_data_.data(), object_data_.size()*sizeof(ObjectData), 256);
+
+    // * Execute draw commands in key order
+    const Texture* last_texture = nullptr;
+    object_index = 0;
+    opaque_bucket_.execute([&](uint64_t key, const DrawCommand& command)
+    {
+        const Model& model = *command.model;
+        const Material& material = model.get_material();
+        const Texture* texture = material.is_textured() ? &material.get_texture() : nullptr;
+        // Model matrix, view-dependent products are computed from the frame_data block
+        bind_object_data(object_offset, object_index, object_data_[object_index].model);
+        ++object_index;
+        // material uniforms and textures
+        prepare_material(*shader, model, campos, texture != last_texture);
+        last_texture = texture;
+        pscene->draw(command);
+    });
     shader->unuse();
 
+    // MODEL INSTANCES
+    if(allow_hardware_instancing_)
+    {
+        instanced_shader_.use();
+        instanced_shader_.send_uniform("rd.f_wireframe_mix"_h, wireframe_mix_);
+        pscene->draw_model_instances([&](const Model& model)
+        {
+            prepare_material(instanced_shader_, model, campos);
+        });
+        instanced_shader_.unuse();
+    }
+
 
     // TERRAINS
     // Terrains are heavily occluded by the static geometry on top,
@@ -122,17 +203,12 @@ void GeometryRenderer::render(Scene* pscene)
         shader->use();
         shader->send_uniform("rd.f_wireframe_mix"_h, wireframe_mix_);
 
-        // Get model matrix and compute products
-        mat4 M = const_cast<TerrainChunk&>(terrain).get_model_matrix();
-        mat4 MV = V*M;
-        mat4 MVP = PV*M;
-
-        // normal matrix for light calculation
-        shader->send_uniform("tr.m3_Normal"_h, MV.submatrix(3,3)); // Transposed inverse of M if non uniform scales
-        // model matrix
-        shader->send_uniform("tr.m4_ModelView"_h, MV);
-        // MVP matrix
-        shader->send_uniform("tr.m4_ModelViewProjection"_h, MVP);
+        // Model matrix, few terrain chunks are drawn, each has its own write
+        const mat4& model_matrix = const_cast<TerrainChunk&>(terrain).get_model_matrix();
+        std::size_t terrain_offset = StreamBuffer::INVALID_OFFSET;
+        if(Gfx::stream_buffer)
+            terrain_offset = Gfx::stream_buffer->write(&model_matrix, sizeof(math::mat4), 256);
+        bind_object_data(terrain_offset, 0, model_matrix);
         // material uniforms
         shader->send_uniforms(terrain.get_material());
         if(terrain.get_material().is_textured())
@@ -192,11 +268,10 @@ void GeometryRenderer::render(Scene* pscene)
         // MVP matrix
         null_shader_.send_uniform("m4_ModelViewProjection"_h, MVP);
     },
-    [&](const Model& model) // evaluator predicate
-    {
-        return model.is_visible(); // Visibility is evaluated during update by Scene::visibility_pass()
-    },
-    wcore::ORDER::FRONT_TO_BACK);
+    evaluate,
+    wcore::ORDER::FRONT_TO_BACK,
+    wcore::MODEL_CATEGORY::OPAQUE,
+    true); // Visibility is evaluated during update by Scene::visibility_pass()
 
     pscene->draw_terrains([&](const TerrainChunk& terrain)
     {
@@ -208,8 +283,17 @@ void GeometryRenderer::render(Scene* pscene)
         null_shader_.send_uniform("m4_ModelViewProjection"_h, MVP);
     });
 
-    bfd_buffer.unbind_as_target();
     null_shader_.unuse();
+
+    if(allow_hardware_instancing_)
+    {
+        null_instanced_shader_.use();
+        null_instanced_shader_.send_uniform("m4_ViewProjection"_h, PV);
+        pscene->draw_model_instances([&](const Model& model) {});
+        null_instanced_shader_.unuse();
+    }
+
+    bfd_buffer.unbind_as_target();
     Gfx::device->set_cull_mode(CullMode::Back);
     // EXP back face depth buffer ---------------------------------------------
 
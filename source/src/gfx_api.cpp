@@ -1,7 +1,9 @@
 #include <map>
 
 #include "gfx_api.h"
+#include "buffer.h"
 #include "platform/opengl/ogl_renderer_api.h"
+#include "platform/null/null_renderer_api.h"
 #include "logger.h"
 
 namespace wcore
@@ -9,6 +11,7 @@ namespace wcore
 
 GfxAPI Gfx::api_ = GfxAPI::OpenGL;
 std::unique_ptr<RenderDevice> Gfx::device = std::make_unique<OGLRenderDevice>();
+std::unique_ptr<StreamBuffer> Gfx::stream_buffer = nullptr;
 
 RenderDevice::~RenderDevice()
 {
@@ -21,6 +24,8 @@ void Gfx::set_api(GfxAPI api)
 
     if(api_ == GfxAPI::OpenGL)
         device = std::make_unique<OGLRenderDevice>();
+    else if(api_ == GfxAPI::Null)
+        device = std::make_unique<NullRenderDevice>();
 }
 
 } // namespace wcore
@@ -1,5 +1,11 @@
 #include <GL/glew.h>
+#include <map>
+#include <memory>
+#include <cstring>
+
 #include "gpu_query_timer.h"
+#include "gfx_api.h"
+#include "frame_profiler.h"
 
 #include <iostream>
 namespace wcore
@@ -10,6 +16,9 @@ query_back_buffer_(0),
 query_front_buffer_(1)
 {
     query_ID_ = new unsigned int[2];
+    // No device to query, elapsed time is always 0
+    if(Gfx::get_api() == GfxAPI::Null)
+        return;
 
     glGenQueries(1, &query_ID_[query_back_buffer_]);
     glGenQueries(1, &query_ID_[query_front_buffer_]);
@@ -26,11 +35,15 @@ GPUQueryTimer::~GPUQueryTimer()
 
 void GPUQueryTimer::start()
 {
+    if(Gfx::get_api() == GfxAPI::Null)
+        return;
     glBeginQuery(GL_TIME_ELAPSED, query_ID_[query_back_buffer_]);
 }
 
 float GPUQueryTimer::stop()
 {
+    if(Gfx::get_api() == GfxAPI::Null)
+        return 0.f;
     glEndQuery(GL_TIME_ELAPSED);
     glGetQueryObjectuiv(query_ID_[query_front_buffer_], GL_QUERY_RESULT, (GLuint*)&timer_);
     swap_query_buffers();
@@ -52,4 +65,42 @@ void GPUQueryTimer::swap_query_buffers()
     }
 }
 
+struct CStrLess
+{
+    inline bool operator()(const char* a, const char* b) const { return strcmp(a, b) < 0; }
+};
+
+// One query timer per GPU marker name, only used by the render thread
+static std::map<const char*, std::unique_ptr<GPUQueryTimer>, CStrLess> s_marker_timers;
+static bool s_marker_active = false;
+
+GPUProfileScope::GPUProfileScope(const char* name):
+name_(name),
+timer_(nullptr),
+start_(0)
+{
+    if(!PROFILER.is_enabled() || s_marker_active)
+        return;
+
+    auto it = s_marker_timers.find(name);
+    if(it == s_marker_timers.end())
+        it = s_marker_timers.insert(std::make_pair(name, std::make_unique<GPUQueryTimer>())).first;
+
+    timer_ = it->second.get();
+    s_marker_active = true;
+    start_ = PROFILER.now();
+    timer_->start();
+}
+
+GPUProfileScope::~GPUProfileScope()
+{
+    if(timer_ == nullptr)
+        return;
+
+    float dt = timer_->stop();
+    s_marker_active = false;
+    // GPU work is placed on the trace where it was issued
+    PROFILER.push_event({name_, start_, uint64_t(1e9*double(dt)), FrameProfiler::GPU_THREAD, 0});
+}
+
 } // namespace wcore
@@ -0,0 +1,84 @@
+#include "headless_context.h"
+#include "gfx_api.h"
+#include "platform/null/null_renderer_api.h"
+#include "globals.h"
+
+namespace wcore
+{
+
+HeadlessContext::HeadlessContext(uint32_t max_frames):
+max_frames_(max_frames),
+frame_count_(0),
+running_(true),
+cursor_x_(0.0),
+cursor_y_(0.0)
+{
+
+}
+
+HeadlessContext::~HeadlessContext()
+{
+
+}
+
+uint16_t HeadlessContext::get_key_state(uint16_t key)
+{
+    return W_KEY_RELEASE;
+}
+
+uint8_t HeadlessContext::get_mouse_buttons_state()
+{
+    return 0;
+}
+
+void HeadlessContext::get_window_size(int& width, int& height)
+{
+    width  = GLB.WIN_W;
+    height = GLB.WIN_H;
+}
+
+void HeadlessContext::get_cursor_position(double& x, double& y)
+{
+    x = cursor_x_;
+    y = cursor_y_;
+}
+
+void HeadlessContext::set_cursor_position(double x, double y)
+{
+    cursor_x_ = x;
+    cursor_y_ = y;
+}
+
+void HeadlessContext::toggle_hard_cursor()
+{
+
+}
+
+void HeadlessContext::hide_hard_cursor()
+{
+
+}
+
+void HeadlessContext::show_hard_cursor()
+{
+
+}
+
+bool HeadlessContext::window_required()
+{
+    return running_ && (max_frames_ == 0 || frame_count_ < max_frames_);
+}
+
+void HeadlessContext::swap_buffers()
+{
+    ++frame_count_;
+    if(Gfx::get_api() == GfxAPI::Null)
+        null_device().end_frame();
+}
+
+void HeadlessContext::poll_events()
+{
+
+}
+
+} // namespace wcore
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "height_map.h"
 #include "logger.h"
 
@@ -14,6 +16,15 @@ HeightMap::HeightMap(uint32_t width, uint32_t length, float height, float scale)
         heights_[ii] = height;
 }
 
+HeightMap::HeightMap(uint32_t width, uint32_t length, const float* heights, float scale)
+: width_(width)
+, length_(length)
+, scale_(scale)
+, heights_(new float[width_*length_])
+{
+    std::copy(heights, heights+width_*length_, heights_);
+}
+
 HeightMap::HeightMap(const HeightMap& hm)
 : width_(hm.width_)
 , length_(hm.length_)
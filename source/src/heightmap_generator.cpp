@@ -7,6 +7,7 @@
 #include "math3d.h"
 #include "logger.h"
 #include "xml_utils.hpp"
+#include "job_system.h"
 
 namespace wcore
 {
@@ -35,6 +36,7 @@ void DropletErosionProps::parse_xml(rapidxml::xml_node<char>* node)
     xml::parse_node(node, "MinSlope", minSlope);
     xml::parse_node(node, "Epsilon", epsilon);
     xml::parse_node(node, "Seed", seed);
+    xml::parse_node(node, "TileSize", tile_size);
 }
 
 void PlateauErosionProps::parse_xml(rapidxml::xml_node<char>* node)
@@ -50,7 +52,7 @@ void PlateauErosionProps::parse_xml(rapidxml::xml_node<char>* node)
 // This class will associate each generator to an index, and will be
 // able to generate heightmaps given a generator index and a SimplexNoiseProps.
 // ---------------------------------------------------------------------
-NoiseGenerator2D<SimplexNoise<>> HeightmapGenerator::RNG_simplex_;
+HeightmapGenerator::SimplexGenerator HeightmapGenerator::RNG_simplex_;
 
 
 void HeightmapGenerator::init_simplex_generator(std::mt19937& rng)
@@ -60,25 +62,39 @@ void HeightmapGenerator::init_simplex_generator(std::mt19937& rng)
 
 void HeightmapGenerator::heightmap_from_simplex_noise(HeightMap& hm,
                                                       const SimplexNoiseProps& info)
+{
+    heightmap_from_simplex_noise(hm, info, RNG_simplex_);
+}
+
+void HeightmapGenerator::heightmap_from_simplex_noise(HeightMap& hm,
+                                                      const SimplexNoiseProps& info,
+                                                      SimplexGenerator& generator)
 {
     assert(hm.get_width()%2==0 && "HeightmapGenerator: Width must be even.");
     assert(hm.get_length()%2==0 && "HeightmapGenerator: Length must be even.");
     uint32_t width  = hm.get_width();
     uint32_t length = hm.get_length();
 
-    for(uint32_t ii=0; ii<width; ++ii)
+    // Rows are independent, each one is sampled in a single batch
+    JOBS.parallel_for(0, width, [&](uint32_t ii)
     {
+        std::vector<float> xs(length, info.scale*(info.startX+ii));
+        std::vector<float> zs(length);
+        std::vector<float> samples(length);
+        for(uint32_t jj=0; jj<length; ++jj)
+            zs[jj] = info.scale*(info.startZ+jj);
+
+        generator.octave_noise(xs.data(), zs.data(), samples.data(), length,
+                               info.octaves,
+                               info.frequency,
+                               info.persistence);
+
         for(uint32_t jj=0; jj<length; ++jj)
         {
-            float samp = RNG_simplex_.octave_noise(info.scale*(info.startX+ii),
-                                                   info.scale*(info.startZ+jj),
-                                                   info.octaves,
-                                                   info.frequency,
-                                                   info.persistence);
-            samp *= (info.hiBound - info.loBound)/2;
+            float samp = samples[jj] * (info.hiBound - info.loBound)/2;
             hm.set_height(ii, jj, samp + (info.hiBound + info.loBound)/2);
         }
-    }
+    });
 }
 // ---------------------------------------------------------------------
 
@@ -120,8 +136,22 @@ inline float edge_factor(float x, float xmax, float dx)
     return std::max(0.f, std::min(1.f, x/dx) * std::min(1.f, (xmax-x)/dx));
 }
 
-void HeightmapGenerator::erode_droplets(HeightMap& hmap,
-                    const DropletErosionProps& params)
+namespace
+{
+// Cells a droplet is allowed to move to, bounds included
+struct DropletBounds
+{
+    int x0, x1, z0, z1;
+};
+
+// Simulate n_droplets droplets starting at random positions inside bounds.
+// A droplet reads and writes heights up to 1 cell before and 2 cells after its bounds.
+void simulate_droplets(HeightMap& hmap,
+                       std::vector<vec2>& erosion,
+                       const DropletErosionProps& params,
+                       const DropletBounds& bounds,
+                       uint32_t n_droplets,
+                       std::mt19937& rng)
 {
     uint32_t HMAP_WIDTH   = hmap.get_width(),  // max X
              HMAP_LENGTH  = hmap.get_length(), // max Z
@@ -131,14 +161,10 @@ void HeightmapGenerator::erode_droplets(HeightMap& hmap,
           epsilon = params.epsilon;
 
     // RNG stuff
-    std::mt19937 rng;
-    rng.seed(params.seed);
-    std::uniform_int_distribution<uint32_t> rnd_x(0, HMAP_WIDTH-1);
-    std::uniform_int_distribution<uint32_t> rnd_z(0, HMAP_LENGTH-1);
+    std::uniform_int_distribution<uint32_t> rnd_x(bounds.x0, bounds.x1);
+    std::uniform_int_distribution<uint32_t> rnd_z(bounds.z0, bounds.z1);
     std::uniform_real_distribution<float>   rnd_a(0, 2*M_PI);
 
-    std::vector<vec2> erosion(HMAP_WIDTH*HMAP_LENGTH, vec2(0));
-
     #define HMAP_INDEX(X, Z) fmin(fmax( (X) ,0),HMAP_WIDTH-1) * HMAP_LENGTH + fmin(fmax( (Z) ,0),HMAP_LENGTH-1)
     #define DEPOSIT_AT(X, Z, W) \
     { \
@@ -155,11 +181,7 @@ void HeightmapGenerator::erode_droplets(HeightMap& hmap,
         (H)+=ds; \
     }
 
-    // Statistics
-    uint64_t longPaths = 0, randomDirs = 0, sumLen = 0;
-
-    // Main loop
-    for(uint32_t iter=0; iter<params.iterations; ++iter)
+    for(uint32_t iter=0; iter<n_droplets; ++iter)
     {
         // Generate random 2D position
         uint32_t xi = rnd_x(rng);
@@ -196,7 +218,6 @@ void HeightmapGenerator::erode_droplets(HeightMap& hmap,
                 float a = rnd_a(rng);
                 dx = cosf(a);
                 dz = sinf(a);
-                ++randomDirs;
             }
             else
             {
@@ -211,7 +232,7 @@ void HeightmapGenerator::erode_droplets(HeightMap& hmap,
             // Sample next height
             int nxi = int(floorf(nxp));
             int nzi = int(floorf(nzp));
-            if(nxi<0 || nxi>HMAP_WIDTH-1 || nzi<0 || nzi>HMAP_LENGTH-1)
+            if(nxi<bounds.x0 || nxi>bounds.x1 || nzi<bounds.z0 || nzi>bounds.z1)
                 break;
 
             float nxf = nxp-nxi;
@@ -322,14 +343,62 @@ void HeightmapGenerator::erode_droplets(HeightMap& hmap,
             h01 = nh01;
             h11 = nh11;
         }
-
-        if (nmoves>=MAX_PATH_LEN)
-            ++longPaths;
-        sumLen += nmoves;
     }
     #undef DEPOSIT
     #undef DEPOSIT_AT
     #undef HMAP_INDEX
 }
+} // anonymous namespace
+
+void HeightmapGenerator::erode_droplets(HeightMap& hmap,
+                    const DropletErosionProps& params)
+{
+    int width  = int(hmap.get_width());
+    int length = int(hmap.get_length());
+    std::vector<vec2> erosion(width*length, vec2(0));
+
+    // * Sequential: droplets can go anywhere
+    if(params.tile_size == 0)
+    {
+        std::mt19937 rng;
+        rng.seed(params.seed);
+        simulate_droplets(hmap, erosion, params, {0, width-1, 0, length-1}, params.iterations, rng);
+        return;
+    }
+
+    // * Tiled: droplets are confined to their tile and each tile has its own RNG seed.
+    // Tiles are processed in 4 passes such that tiles of a pass are at least
+    // one tile apart, their droplets never touch the same cells. Result
+    // does not depend on the number of threads or on scheduling.
+    int tile_size = std::max(int(params.tile_size), 4);
+    int n_tiles_x = (width  + tile_size-1) / tile_size;
+    int n_tiles_z = (length + tile_size-1) / tile_size;
+    uint32_t n_tiles = uint32_t(n_tiles_x*n_tiles_z);
+
+    for(int pass=0; pass<4; ++pass)
+    {
+        std::vector<uint32_t> tiles;
+        for(int tz=pass/2; tz<n_tiles_z; tz+=2)
+            for(int tx=pass%2; tx<n_tiles_x; tx+=2)
+                tiles.push_back(uint32_t(tz*n_tiles_x + tx));
+
+        JOBS.parallel_for(0, uint32_t(tiles.size()), [&](uint32_t ii)
+        {
+            uint32_t tile = tiles[ii];
+            int tx = int(tile) % n_tiles_x;
+            int tz = int(tile) / n_tiles_x;
+            DropletBounds bounds{tx*tile_size, std::min((tx+1)*tile_size, width)-1,
+                                 tz*tile_size, std::min((tz+1)*tile_size, length)-1};
+
+            // Droplets are spread evenly between tiles
+            uint32_t n_droplets = params.iterations / n_tiles
+                                + ((tile < params.iterations % n_tiles) ? 1 : 0);
+
+            std::seed_seq seq{params.seed, tile};
+            std::mt19937 rng(seq);
+            simulate_droplets(hmap, erosion, params, bounds, n_droplets, rng);
+        }, 1);
+    }
+}
 
 }
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "hiz_buffer.h"
+
+namespace wcore
+{
+
+using namespace math;
+
+HiZBuffer::HiZBuffer():
+width_(0),
+height_(0),
+valid_(false),
+has_eye_(false)
+{
+    view_projection_.init_identity();
+}
+
+void HiZBuffer::resize(uint32_t width, uint32_t height)
+{
+    width_  = std::max(width, 1u);
+    height_ = std::max(height, 1u);
+    valid_  = false;
+
+    // * Level sizes are halved (rounded up) till 1x1
+    level_sizes_.clear();
+    uint32_t ww = width_;
+    uint32_t hh = height_;
+    level_sizes_.push_back({ww, hh});
+    while(ww>1 || hh>1)
+    {
+        ww = (ww+1)/2;
+        hh = (hh+1)/2;
+        level_sizes_.push_back({ww, hh});
+    }
+
+    levels_.resize(level_sizes_.size());
+    for(uint32_t ll=0; ll<levels_.size(); ++ll)
+        levels_[ll].assign(level_sizes_[ll].first*level_sizes_[ll].second, 1.f);
+}
+
+void HiZBuffer::set_depth(const float* depth, const mat4& view_projection)
+{
+    std::copy(depth, depth + width_*height_, levels_[0].begin());
+    view_projection_ = view_projection;
+    update_eye();
+}
+
+void HiZBuffer::build()
+{
+    for(uint32_t ll=1; ll<levels_.size(); ++ll)
+    {
+        const std::vector<float>& src = levels_[ll-1];
+        std::vector<float>& dst = levels_[ll];
+        uint32_t src_w = level_sizes_[ll-1].first;
+        uint32_t src_h = level_sizes_[ll-1].second;
+        uint32_t dst_w = level_sizes_[ll].first;
+        uint32_t dst_h = level_sizes_[ll].second;
+
+        for(uint32_t yy=0; yy<dst_h; ++yy)
+        {
+            // Odd sizes: last texel of a row / column covers a single source texel
+            uint32_t y0 = 2*yy;
+            uint32_t y1 = std::min(y0+1, src_h-1);
+            for(uint32_t xx=0; xx<dst_w; ++xx)
+            {
+                uint32_t x0 = 2*xx;
+                uint32_t x1 = std::min(x0+1, src_w-1);
+                dst[yy*dst_w+xx] = std::max(std::max(src[y0*src_w+x0], src[y0*src_w+x1]),
+                                            std::max(src[y1*src_w+x0], src[y1*src_w+x1]));
+            }
+        }
+    }
+    valid_ = true;
+}
+
+void HiZBuffer::clear(const mat4& view_projection)
+{
+    std::fill(levels_[0].begin(), levels_[0].end(), 1.f);
+    view_projection_ = view_projection;
+    update_eye();
+}
+
+void HiZBuffer::update_eye()
+{
+    // The eye is the only point projected to clip space x=y=w=0,
+    // so it is the image of direction (0,0,1,0) by the inverse matrix
+    mat4 inv_vp;
+    has_eye_ = inverse(view_projection_, inv_vp);
+    if(!has_eye_)
+        return;
+    vec4 eye = inv_vp*vec4(0.f, 0.f, 1.f, 0.f);
+    // Orthographic projection: eye at infinity
+    has_eye_ = (std::fabs(eye.w()) > 1e-7f);
+    if(has_eye_)
+        eye_ = vec3(eye.x(), eye.y(), eye.z())/eye.w();
+}
+
+float HiZBuffer::get_eye_distance(const vec3& point) const
+{
+    if(!has_eye_)
+        return std::numeric_limits<float>::infinity();
+    return (point-eye_).norm();
+}
+
+void HiZBuffer::rasterize_triangle(const vec3& p0, const vec3& p1, const vec3& p2)
+{
+    rasterize_clip(view_projection_*vec4(p0, 1.f),
+                   view_projection_*vec4(p1, 1.f),
+                   view_projection_*vec4(p2, 1.f));
+}
+
+void HiZBuffer::rasterize_clip(const vec4& c0, const vec4& c1, const vec4& c2)
+{
+    // * Skip triangles crossing the near plane or behind the camera
+    const vec4* clip[3] = {&c0, &c1, &c2};
+    float sx[3], sy[3], sz[3];
+    for(int ii=0; ii<3; ++ii)
+    {
+        const vec4& cc = *clip[ii];
+        if(cc.w() <= 0.f || cc.z() < -cc.w())
+            return;
+        float inv_w = 1.f/cc.w();
+        // Screen coordinates in pixels, depth in [0,1]
+        sx[ii] = (0.5f*cc.x()*inv_w + 0.5f) * width_;
+        sy[ii] = (0.5f*cc.y()*inv_w + 0.5f) * height_;
+        sz[ii] = 0.5f*cc.z()*inv_w + 0.5f;
+    }
+
+    // * Counter-clockwise winding, occluders are double sided
+    float area = (sx[1]-sx[0])*(sy[2]-sy[0]) - (sy[1]-sy[0])*(sx[2]-sx[0]);
+    if(area == 0.f)
+        return;
+    if(area < 0.f)
+    {
+        std::swap(sx[1], sx[2]);
+        std::swap(sy[1], sy[2]);
+        std::swap(sz[1], sz[2]);
+        area = -area;
+    }
+    float inv_area = 1.f/area;
+
+    // * Screen bounding box, clipped
+    float fx0 = std::min(std::min(sx[0], sx[1]), sx[2]);
+    float fx1 = std::max(std::max(sx[0], sx[1]), sx[2]);
+    float fy0 = std::min(std::min(sy[0], sy[1]), sy[2]);
+    float fy1 = std::max(std::max(sy[0], sy[1]), sy[2]);
+    if(fx1 < 0.f || fy1 < 0.f || fx0 >= float(width_) || fy0 >= float(height_))
+        return;
+    int32_t x0 = std::max(int32_t(std::floor(fx0)), 0);
+    int32_t x1 = std::min(int32_t(std::ceil(fx1)), int32_t(width_)-1);
+    int32_t y0 = std::max(int32_t(std::floor(fy0)), 0);
+    int32_t y1 = std::min(int32_t(std::ceil(fy1)), int32_t(height_)-1);
+
+    // * Half-space test at pixel centers
+    auto edge = [&](int aa, int bb, float px, float py)
+    {
+        return (sx[bb]-sx[aa])*(py-sy[aa]) - (sy[bb]-sy[aa])*(px-sx[aa]);
+    };
+    std::vector<float>& depth = levels_[0];
+    for(int32_t yy=y0; yy<=y1; ++yy)
+    {
+        float py = yy + 0.5f;
+        for(int32_t xx=x0; xx<=x1; ++xx)
+        {
+            float px = xx + 0.5f;
+            float w0 = edge(1, 2, px, py);
+            float w1 = edge(2, 0, px, py);
+            float w2 = edge(0, 1, px, py);
+            if(w0 < 0.f || w1 < 0.f || w2 < 0.f)
+                continue;
+
+            // Window depth is affine in screen space
+            float zz = (w0*sz[0] + w1*sz[1] + w2*sz[2]) * inv_area;
+            float& dst = depth[yy*width_+xx];
+            dst = std::min(dst, zz);
+        }
+    }
+}
+
+bool HiZBuffer::is_occluded(const std::array<vec3, 8>& vertices) const
+{
+    if(!valid_)
+        return false;
+
+    // * Screen rectangle and closest depth of box
+    float x_min =  1.f, x_max = -1.f;
+    float y_min =  1.f, y_max = -1.f;
+    float z_min =  1.f;
+    for(auto&& vertex: vertices)
+    {
+        vec4 clip = view_projection_*vec4(vertex, 1.f);
+        // Crossing near plane
+        if(clip.w() <= 0.f || clip.z() < -clip.w())
+            return false;
+        float inv_w = 1.f/clip.w();
+        float nx = clip.x()*inv_w;
+        float ny = clip.y()*inv_w;
+        x_min = std::min(x_min, nx);
+        x_max = std::max(x_max, nx);
+        y_min = std::min(y_min, ny);
+        y_max = std::max(y_max, ny);
+        z_min = std::min(z_min, 0.5f*clip.z()*inv_w + 0.5f);
+    }
+    // Partly off screen: the depth of the hidden part is unknown
+    if(x_min < -1.f || x_max > 1.f || y_min < -1.f || y_max > 1.f)
+        return false;
+
+    auto to_texel = [](float ndc, uint32_t size)
+    {
+        float pixel = (0.5f*ndc + 0.5f) * size;
+        return std::min(uint32_t(pixel), size-1);
+    };
+    uint32_t x0 = to_texel(x_min, width_);
+    uint32_t x1 = to_texel(x_max, width_);
+    uint32_t y0 = to_texel(y_min, height_);
+    uint32_t y1 = to_texel(y_max, height_);
+
+    // * Coarsest level where rectangle spans at most 2x2 texels
+    uint32_t level = 0;
+    while(level+1<levels_.size() && ((x1>>level)-(x0>>level) > 1 || (y1>>level)-(y0>>level) > 1))
+        ++level;
+    x0 >>= level; x1 >>= level;
+    y0 >>= level; y1 >>= level;
+
+    float max_depth = 0.f;
+    for(uint32_t yy=y0; yy<=y1; ++yy)
+        for(uint32_t xx=x0; xx<=x1; ++xx)
+            max_depth = std::max(max_depth, get_depth(level, xx, yy));
+
+    return z_min > max_depth;
+}
+
+} // namespace wcore
@@ -0,0 +1,139 @@
+#include "hiz_renderer.h"
+#include "hiz_buffer.h"
+#include "buffer.h"
+#include "gfx_api.h"
+#include "scene.h"
+#include "camera.h"
+#include "texture.h"
+#include "config.h"
+#include "globals.h"
+#include "logger.h"
+#include "geometry_common.h"
+#include "model.h"
+
+namespace wcore
+{
+
+using namespace math;
+
+HiZRenderer::HiZRenderer():
+hiz_shader_(ShaderResource("hiz.vert;hiz.frag")),
+width_(GLB.WIN_W/8),
+height_(GLB.WIN_H/8),
+frame_index_(0),
+software_(false)
+{
+    bool enabled = true;
+    uint32_t divisor = 8;
+    CONFIG.get("root.render.occlusion.enabled"_h, enabled);
+    CONFIG.get("root.render.occlusion.software"_h, software_);
+    CONFIG.get("root.render.occlusion.divisor"_h, divisor);
+    set_enabled(enabled);
+
+    divisor = std::max(divisor, 1u);
+    width_  = std::max(GLB.WIN_W/divisor, 1u);
+    height_ = std::max(GLB.WIN_H/divisor, 1u);
+
+    readback_.fill(nullptr);
+    pending_.fill(false);
+    if(!software_)
+    {
+        depth_buffer_ = std::make_unique<BufferModule>
+        (
+            "hizbuffer",
+            std::make_unique<Texture>
+            (
+                std::initializer_list<TextureUnitInfo>
+                {
+                    TextureUnitInfo("hizTex"_h, TextureFilter::MIN_NEAREST, TextureIF::R32F),
+                },
+                width_,
+                height_,
+                TextureWrap::CLAMP_TO_EDGE
+            )
+        );
+        for(uint32_t ii=0; ii<N_READBACK; ++ii)
+            readback_[ii] = ReadbackBuffer::create(width_*height_*sizeof(float));
+    }
+
+    DLOGN("[HiZRenderer] Occlusion buffer:", "batch");
+    DLOGI(std::to_string(width_) + "x" + std::to_string(height_)
+        + (software_ ? " (software)" : " (GPU readback)"), "batch");
+}
+
+HiZRenderer::~HiZRenderer()
+{
+    for(auto* readback: readback_)
+        delete readback;
+}
+
+void HiZRenderer::render(Scene* pscene)
+{
+    HiZBuffer& hiz = pscene->get_occlusion_buffer();
+    if(hiz.get_width() != width_ || hiz.get_height() != height_)
+        hiz.resize(width_, height_);
+
+    if(software_)
+        render_software(pscene);
+    else
+        render_gpu(pscene);
+}
+
+void HiZRenderer::render_gpu(Scene* pscene)
+{
+    HiZBuffer& hiz = pscene->get_occlusion_buffer();
+    uint32_t current = frame_index_ % N_READBACK;
+    ++frame_index_;
+
+    // * Consume the transfer started N_READBACK frames ago, before its buffer is reused.
+    // If the GPU is late, previous Hi-Z content is kept.
+    if(pending_[current] && readback_[current]->is_ready())
+    {
+        const float* data = readback_[current]->map();
+        if(data)
+        {
+            hiz.set_depth(data, readback_vp_[current]);
+            hiz.build();
+        }
+        readback_[current]->unmap();
+        pending_[current] = false;
+    }
+
+    // * Max-reduce G-Buffer depth
+    auto& g_buffer = GMODULES::GET("gbuffer"_h);
+
+    hiz_shader_.use();
+    hiz_shader_.send_uniform<int>("depthTex"_h, 0);
+    hiz_shader_.send_uniform("v2_scale"_h, vec2(float(GLB.WIN_W)/width_, float(GLB.WIN_H)/height_));
+    g_buffer.bind_as_source(0,2); // depth
+
+    depth_buffer_->bind_as_target();
+    Gfx::device->viewport(0, 0, width_, height_);
+    CGEOM.draw("quad"_h);
+
+    // * Start asynchronous readback
+    readback_[current]->read(width_, height_);
+    readback_vp_[current] = pscene->get_camera().get_view_projection_matrix();
+    pending_[current] = true;
+
+    depth_buffer_->unbind_as_target();
+    g_buffer.unbind_as_source();
+    hiz_shader_.unuse();
+    Gfx::device->viewport(0, 0, GLB.WIN_W, GLB.WIN_H);
+}
+
+void HiZRenderer::render_software(Scene* pscene)
+{
+    HiZBuffer& hiz = pscene->get_occlusion_buffer();
+    hiz.clear(pscene->get_camera().get_view_projection_matrix());
+
+    // * Terrains are the occluders
+    pscene->traverse_occluders([&](Model& model)
+    {
+        const auto& mesh = model.get_mesh();
+        hiz.rasterize_mesh(mesh.get_vertex_buffer(), mesh.get_index_buffer(), model.get_model_matrix());
+    });
+    hiz.build();
+}
+
+} // namespace wcore
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "informer.h"
 
 namespace wcore
@@ -7,7 +9,9 @@ size_t Informer::N_INST = 0;
 
 Informer::Informer()
 :subscriber_map_(),
-delegate_ids_(),
+n_delegates_(0),
+dispatch_depth_(0),
+needs_compaction_(false),
 id_(++N_INST)
 {
     //ctor
@@ -20,19 +24,110 @@ Informer::~Informer()
 
 WDelegateID Informer::add_delegate(hash_t chan, WpFunc delegate)
 {
-    subscriber_map_[chan].push_back(delegate);
     // Make a unique delegate ID
     WDelegateID del_id = chan;
-    del_id ^= subscriber_map_[chan].size() + 0x9e3779b9 + (del_id<<6) + (del_id>>2);
-    auto it = subscriber_map_[chan].end();
-    --it;
-    delegate_ids_.insert(std::make_pair(del_id,it));
+    del_id ^= (++n_delegates_) + 0x9e3779b9 + (del_id<<6) + (del_id>>2);
+
+    // Tables must not grow while a delegate is executing, delegates added during
+    // a dispatch are inserted after it
+    if(dispatch_depth_)
+    {
+        pending_delegates_.push_back(std::make_pair(chan, Delegate{del_id, delegate, false}));
+        needs_compaction_ = true;
+    }
+    else
+        insert_delegate(chan, Delegate{del_id, delegate, false});
     return del_id;
 }
 
+void Informer::insert_delegate(hash_t chan, Delegate&& delegate)
+{
+    int channel = find_channel(chan);
+    if(channel < 0)
+    {
+        channel = int(subscriber_map_.size());
+        subscriber_map_.push_back(std::make_pair(chan, DelegateList()));
+    }
+    subscriber_map_[channel].second.push_back(std::move(delegate));
+}
+
 void Informer::remove_delegate(hash_t chan, WDelegateID del_id)
 {
-    subscriber_map_.at(chan).erase(delegate_ids_.at(del_id));
+    auto pending = std::find_if(pending_delegates_.begin(), pending_delegates_.end(),
+                                [del_id](const auto& p) { return p.second.id == del_id; });
+    if(pending != pending_delegates_.end())
+    {
+        pending_delegates_.erase(pending);
+        return;
+    }
+
+    int channel = find_channel(chan);
+    if(channel < 0)
+        return;
+    DelegateList& dlist = subscriber_map_[channel].second;
+    auto it = std::find_if(dlist.begin(), dlist.end(), [del_id](const Delegate& d) { return d.id == del_id; });
+    if(it == dlist.end())
+        return;
+
+    // Delegate lists are traversed by index during a dispatch, only flag the delegate
+    if(dispatch_depth_)
+    {
+        it->removed = true;
+        needs_compaction_ = true;
+    }
+    else
+        dlist.erase(it);
+}
+
+void Informer::dispatch(uint32_t channel_index, WData& data)
+{
+    ++dispatch_depth_;
+    // Delegates may subscribe or unsubscribe during the dispatch, list is accessed by index
+    for(uint32_t ii=0; ii<subscriber_map_[channel_index].second.size(); ++ii)
+    {
+        const Delegate& delegate = subscriber_map_[channel_index].second[ii]; // Stable, see add_delegate()
+        // Execute delegate and break if event was consumed
+        if(!delegate.removed && !delegate.func(data))
+            break;
+    }
+    --dispatch_depth_;
+
+    if(dispatch_depth_ == 0 && needs_compaction_)
+    {
+        for(auto&& [chan, dlist]: subscriber_map_)
+            dlist.erase(std::remove_if(dlist.begin(), dlist.end(), [](const Delegate& d) { return d.removed; }),
+                        dlist.end());
+        for(auto&& [chan, delegate]: pending_delegates_)
+            insert_delegate(chan, std::move(delegate));
+        pending_delegates_.clear();
+        needs_compaction_ = false;
+    }
+}
+
+void Informer::enable_deferred(size_t capacity)
+{
+    if(!event_queue_)
+        event_queue_ = std::make_unique<EventQueue>(capacity);
+}
+
+uint32_t Informer::dispatch_deferred()
+{
+    if(!event_queue_)
+        return 0;
+
+    // Channel lookup is cached across consecutive events of the same channel
+    hash_t last_chan = 0;
+    int channel = -1;
+    return event_queue_->consume([&](EventRecord& record)
+    {
+        if(record.get_channel() != last_chan || channel < 0)
+        {
+            last_chan = record.get_channel();
+            channel = find_channel(last_chan);
+        }
+        if(channel >= 0)
+            dispatch(uint32_t(channel), record.get_data());
+    });
 }
 
 }
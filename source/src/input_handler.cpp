@@ -17,6 +17,9 @@ using namespace rapidxml;
 InputHandler::InputHandler():
 mouse_lock_(true)
 {
+    // Mouse events are never consumed, they are queued and delivered in bulk.
+    // Keyboard events are posted immediately, as listeners may consume them.
+    enable_deferred();
     import_key_bindings();
 }
 
@@ -200,7 +203,7 @@ void InputHandler::handle_mouse(AbstractContext& context)
             float dx = float(dxi)/win_width;
             float dy = float(dyi)/win_height;
 
-            post("input.mouse.locked"_h, MouseData(dx, dy, buttons));
+            post_deferred("input.mouse.locked"_h, MouseData(dx, dy, buttons));
         }
     }
     // Cursor is unlocked -> edit mode
@@ -212,18 +215,18 @@ void InputHandler::handle_mouse(AbstractContext& context)
             // Cursor has moved out of the window
             if(mouse_out && !last_mouse_out)
             {
-                post("input.mouse.focus"_h, MouseFocusData(true));
+                post_deferred("input.mouse.focus"_h, MouseFocusData(true));
             }
             // Cursor has moved into the window
             else if(!mouse_out && last_mouse_out)
             {
-                post("input.mouse.focus"_h, MouseFocusData(false));
+                post_deferred("input.mouse.focus"_h, MouseFocusData(false));
             }
         }
         if((!mouse_out && (xpos != last_x || ypos != last_y)) || last_mouse_locked)
-            post("input.mouse.unlocked"_h, MouseData(float(xpos/GLB.WIN_W), 1.0f-float(ypos/GLB.WIN_H), buttons));
+            post_deferred("input.mouse.unlocked"_h, MouseData(float(xpos/GLB.WIN_W), 1.0f-float(ypos/GLB.WIN_H), buttons));
         if(buttons && (buttons!=last_mouse_button_state))
-            post("input.mouse.click"_h, MouseData(float(xpos/GLB.WIN_W), 1.0f-float(ypos/GLB.WIN_H), buttons));
+            post_deferred("input.mouse.click"_h, MouseData(float(xpos/GLB.WIN_W), 1.0f-float(ypos/GLB.WIN_H), buttons));
 
     }
 
@@ -1,6 +1,13 @@
 #include <fstream>
 #include <memory>
 #include <map>
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define W_HAS_MMAP
+#endif
 
 #include "io_utils.h"
 #include "config.h"
@@ -92,5 +99,109 @@ std::vector<char> get_binary_file_as_vector(const fs::path& file_path)
     return result;
 }
 
+MappedFile::MappedFile():
+data_(nullptr),
+size_(0)
+{
+
+}
+
+MappedFile::MappedFile(const fs::path& file_path):
+MappedFile()
+{
+    open(file_path);
+}
+
+MappedFile::MappedFile(MappedFile&& other):
+MappedFile()
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    if(this != &other)
+    {
+        close();
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+#ifndef W_HAS_MMAP
+        std::swap(buffer_, other.buffer_);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef W_HAS_MMAP
+bool MappedFile::open(const fs::path& file_path)
+{
+    close();
+
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Mapping stays valid after the descriptor is closed
+    void* addr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED)
+    {
+        DLOGE("Unable to map file:", "ios");
+        DLOGI("file name= " + file_path.string(), "ios");
+        return false;
+    }
+
+    data_ = static_cast<const uint8_t*>(addr);
+    size_ = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(data_)
+        munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+#else
+bool MappedFile::open(const fs::path& file_path)
+{
+    close();
+
+    std::ifstream ifs(file_path, std::ios::binary|std::ios::ate);
+    if(!ifs.is_open())
+        return false;
+
+    buffer_.resize(size_t(ifs.tellg()));
+    if(buffer_.empty())
+        return false;
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(&buffer_[0], buffer_.size());
+
+    data_ = reinterpret_cast<const uint8_t*>(buffer_.data());
+    size_ = buffer_.size();
+    return true;
+}
+
+void MappedFile::close()
+{
+    buffer_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+#endif
+
 } // namespace io
 } // namespace wcore
@@ -0,0 +1,201 @@
+#include "job_system.h"
+#include "logger.h"
+
+namespace wcore
+{
+
+// Index of the job queue owned by the current thread, 0 for non-worker threads
+static thread_local uint32_t t_queue_index = 0;
+
+JobSystem::JobSystem():
+pending_(0),
+quit_(false)
+{
+    queues_.push_back(std::make_unique<WorkQueue>());
+}
+
+JobSystem::~JobSystem()
+{
+    shutdown();
+}
+
+void JobSystem::init(uint32_t n_workers)
+{
+    if(!workers_.empty())
+        return;
+
+    if(n_workers == 0)
+    {
+        uint32_t n_cores = std::thread::hardware_concurrency();
+        n_workers = (n_cores>1) ? n_cores-1 : 0;
+    }
+
+    DLOGN("[JobSystem] Spawning <v>" + std::to_string(n_workers) + "</v> worker threads.", "core");
+
+    quit_.store(false);
+    for(uint32_t ii=0; ii<n_workers; ++ii)
+        queues_.push_back(std::make_unique<WorkQueue>());
+    for(uint32_t ii=0; ii<n_workers; ++ii)
+        workers_.emplace_back(&JobSystem::worker_loop, this, ii+1);
+}
+
+void JobSystem::shutdown()
+{
+    if(workers_.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        quit_.store(true);
+    }
+    wake_cv_.notify_all();
+    for(auto&& worker: workers_)
+        worker.join();
+    workers_.clear();
+}
+
+void JobSystem::schedule(JobFunction&& func, JobCounter* counter)
+{
+    if(counter)
+        counter->value_.fetch_add(1, std::memory_order_relaxed);
+    push(Job{std::move(func), counter});
+}
+
+void JobSystem::schedule_after(JobCounter& dependency, JobFunction&& func, JobCounter* counter)
+{
+    // Counter is incremented right away so that waiting on it also waits for the dependency
+    if(counter)
+        counter->value_.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex_);
+        if(!dependency.is_done())
+        {
+            dependency.continuations_.push_back(Job{std::move(func), counter});
+            return;
+        }
+    }
+    push(Job{std::move(func), counter});
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    // Help instead of blocking
+    Job job;
+    while(!counter.is_done())
+    {
+        if(pop(job))
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+    // Last job may still be releasing continuations, counter must not die before
+    std::lock_guard<std::mutex> lock(counter.mutex_);
+}
+
+bool JobSystem::run_pending_job()
+{
+    Job job;
+    if(!pop(job))
+        return false;
+    execute(job);
+    return true;
+}
+
+void JobSystem::push(Job&& job)
+{
+    WorkQueue& queue = *queues_[t_queue_index];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    pending_.fetch_add(1, std::memory_order_release);
+
+    // Lock so that a worker about to sleep cannot miss the notification
+    if(!workers_.empty())
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+}
+
+bool JobSystem::pop(Job& job)
+{
+    if(pending_.load(std::memory_order_acquire) == 0)
+        return false;
+
+    // * Own queue first, most recent job
+    uint32_t own = t_queue_index;
+    {
+        WorkQueue& queue = *queues_[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // * Then steal the oldest job of another queue
+    uint32_t n_queues = uint32_t(queues_.size());
+    for(uint32_t ii=1; ii<n_queues; ++ii)
+    {
+        WorkQueue& queue = *queues_[(own+ii)%n_queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(Job& job)
+{
+    job.func();
+
+    JobCounter* counter = job.counter;
+    if(counter == nullptr)
+        return;
+
+    // Last job of this counter: release jobs depending on it.
+    // Counter may be destroyed as soon as the lock is released.
+    std::vector<Job> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex_);
+        if(counter->value_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            continuations.swap(counter->continuations_);
+    }
+    for(auto&& continuation: continuations)
+        push(std::move(continuation));
+}
+
+void JobSystem::worker_loop(uint32_t queue_index)
+{
+    t_queue_index = queue_index;
+
+    Job job;
+    while(true)
+    {
+        if(pop(job))
+        {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait(lock, [this]()
+        {
+            return quit_.load() || pending_.load(std::memory_order_acquire) > 0;
+        });
+        if(quit_.load() && pending_.load(std::memory_order_acquire) == 0)
+            return;
+    }
+}
+
+} // namespace wcore
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+
+#include "light_grid.h"
+
+namespace wcore
+{
+
+using namespace math;
+
+LightGrid::LightGrid(uint32_t tile_size):
+tile_size_(tile_size),
+screen_width_(0),
+screen_height_(0),
+tiles_x_(0),
+tiles_y_(0)
+{
+
+}
+
+void LightGrid::resize(uint32_t screen_width, uint32_t screen_height)
+{
+    if(screen_width == screen_width_ && screen_height == screen_height_)
+        return;
+
+    screen_width_  = screen_width;
+    screen_height_ = screen_height;
+    tiles_x_ = (screen_width  + tile_size_ - 1) / tile_size_;
+    tiles_y_ = (screen_height + tile_size_ - 1) / tile_size_;
+    tile_data_.assign(2*tiles_x_*tiles_y_, 0);
+}
+
+void LightGrid::clear()
+{
+    rects_.clear();
+    light_data_.clear();
+    light_indices_.clear();
+}
+
+// Bounds of a sphere along one screen axis, in the plane spanned by this axis and the view axis.
+// c_a and c_z are the sphere center coordinates in this plane, near_z the (negative) near plane depth.
+// The two returned points are the tangent points of the sphere silhouette, clipped by the near plane.
+// (Mara & McGuire 2013, 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere)
+static void sphere_axis_bounds(float c_a, float c_z, float radius, float near_z, float bounds[2][2])
+{
+    float r2 = radius*radius;
+    float c_len2 = c_a*c_a + c_z*c_z;
+    float t2 = c_len2 - r2;
+    bool camera_inside = (t2 <= 0.f);
+
+    float vx = 0.f, vy = 0.f;
+    if(!camera_inside)
+    {
+        float inv_len = 1.f/std::sqrt(c_len2);
+        vx = std::sqrt(t2)*inv_len;
+        vy = radius*inv_len;
+    }
+
+    bool clip_sphere = (c_z + radius >= near_z);
+    float k = clip_sphere ? std::sqrt(std::max(r2 - (near_z-c_z)*(near_z-c_z), 0.f)) : 0.f;
+    for(int ii=0; ii<2; ++ii)
+    {
+        if(!camera_inside)
+        {
+            // Rotate center by -/+ silhouette half-angle, lower bound first
+            bounds[ii][0] = (vx*c_a + vy*c_z) * vx;
+            bounds[ii][1] = (vx*c_z - vy*c_a) * vx;
+        }
+        bool clip_bound = camera_inside || (bounds[ii][1] > near_z);
+        if(clip_sphere && clip_bound)
+        {
+            bounds[ii][0] = c_a - k;
+            bounds[ii][1] = near_z;
+        }
+        vy = -vy;
+        k = -k;
+    }
+}
+
+// Project sphere bounds along one axis to NDC, p_scale and p_offset are the projection
+// matrix coefficients for this axis
+static void project_axis(float bounds[2][2], float p_scale, float p_offset, float& ndc_min, float& ndc_max)
+{
+    float n0 = (p_scale*bounds[0][0] + p_offset*bounds[0][1]) / -bounds[0][1];
+    float n1 = (p_scale*bounds[1][0] + p_offset*bounds[1][1]) / -bounds[1][1];
+    ndc_min = std::min(n0, n1);
+    ndc_max = std::max(n0, n1);
+}
+
+bool LightGrid::compute_tile_rect(const vec3& view_pos, float radius, const mat4& P, TileRect& rect) const
+{
+    // Near plane depth from projection matrix, view looks down -z
+    float near_z = -P(2,3)/(P(2,2)-1.f);
+    if(view_pos.z() - radius >= near_z)
+        return false;
+
+    float bounds[2][2];
+    float x_min, x_max, y_min, y_max;
+    sphere_axis_bounds(view_pos.x(), view_pos.z(), radius, near_z, bounds);
+    project_axis(bounds, P(0,0), P(0,2), x_min, x_max);
+    sphere_axis_bounds(view_pos.y(), view_pos.z(), radius, near_z, bounds);
+    project_axis(bounds, P(1,1), P(1,2), y_min, y_max);
+
+    if(x_max < -1.f || x_min > 1.f || y_max < -1.f || y_min > 1.f)
+        return false;
+
+    // NDC to tile coordinates
+    auto to_tile = [this](float ndc, uint32_t screen_size, uint32_t n_tiles)
+    {
+        float pixel = (0.5f*std::min(std::max(ndc, -1.f), 1.f) + 0.5f) * screen_size;
+        return std::min(uint32_t(pixel) / tile_size_, n_tiles-1);
+    };
+    rect.x0 = to_tile(x_min, screen_width_,  tiles_x_);
+    rect.x1 = to_tile(x_max, screen_width_,  tiles_x_);
+    rect.y0 = to_tile(y_min, screen_height_, tiles_y_);
+    rect.y1 = to_tile(y_max, screen_height_, tiles_y_);
+    return true;
+}
+
+bool LightGrid::push_light(const vec3& view_pos, float radius, const vec3& color,
+                           float ambient_strength, const mat4& P)
+{
+    TileRect rect;
+    if(!compute_tile_rect(view_pos, radius, P, rect))
+        return false;
+
+    rects_.push_back(rect);
+    light_data_.push_back(vec4(view_pos, radius));
+    light_data_.push_back(vec4(color, ambient_strength));
+    return true;
+}
+
+void LightGrid::build()
+{
+    // * Count lights per tile
+    std::fill(tile_data_.begin(), tile_data_.end(), 0);
+    for(auto&& rect: rects_)
+        for(uint32_t ty=rect.y0; ty<=rect.y1; ++ty)
+            for(uint32_t tx=rect.x0; tx<=rect.x1; ++tx)
+                ++tile_data_[2*(ty*tiles_x_+tx)+1];
+
+    // * Prefix sum for list offsets
+    uint32_t offset = 0;
+    for(uint32_t ii=0; ii<tiles_x_*tiles_y_; ++ii)
+    {
+        tile_data_[2*ii] = offset;
+        offset += tile_data_[2*ii+1];
+    }
+
+    // * Scatter light indices, counts are rebuilt on the way
+    light_indices_.resize(offset);
+    for(uint32_t ii=0; ii<tiles_x_*tiles_y_; ++ii)
+        tile_data_[2*ii+1] = 0;
+    for(uint32_t light=0; light<rects_.size(); ++light)
+    {
+        const TileRect& rect = rects_[light];
+        for(uint32_t ty=rect.y0; ty<=rect.y1; ++ty)
+        {
+            for(uint32_t tx=rect.x0; tx<=rect.x1; ++tx)
+            {
+                uint32_t* tile = &tile_data_[2*(ty*tiles_x_+tx)];
+                light_indices_[tile[0] + tile[1]++] = light;
+            }
+        }
+    }
+}
+
+} // namespace wcore
@@ -12,26 +12,37 @@
 #include "model.h"
 #include "geometry_common.h"
 #include "buffer_module.h"
+#include "buffer.h"
+#include "frame_profiler.h"
 
 namespace wcore
 {
 
-LightingRenderer::LightingRenderer():
+LightingRenderer::LightingRenderer(const ShadowMapRenderer& shadow_map_renderer):
 lpass_dir_shader_(ShaderResource("lpass_exp.vert;lpass_exp.frag", "VARIANT_DIRECTIONAL")),
 lpass_point_shader_(ShaderResource("lpass_exp.vert;lpass_exp.frag", "VARIANT_POINT")),
+lpass_tiled_shader_(ShaderResource("lpass_exp.vert;lpass_exp.frag", "VARIANT_TILED")),
 null_shader_(ShaderResource("null.vert;null.frag")),
+shadow_map_renderer_(shadow_map_renderer),
+light_data_buffer_(TextureBuffer::create(TextureBufferFormat::RGBA32F)),
+tile_buffer_(TextureBuffer::create(TextureBufferFormat::RG32UI)),
+light_index_buffer_(TextureBuffer::create(TextureBufferFormat::R32UI)),
 SSAO_enabled_(true),
 SSR_enabled_(true),
 shadow_enabled_(true),
 lighting_enabled_(true),
 dirlight_enabled_(true),
+tiled_lighting_enabled_(true),
 bright_threshold_(1.0f),
 bright_knee_(0.1f),
 shadow_slope_bias_(0.1f)
 {
     CONFIG.get("root.render.override.allow_shadow_mapping"_h, shadow_enabled_);
+    CONFIG.get("root.render.lighting.tiled"_h, tiled_lighting_enabled_);
 }
 
+LightingRenderer::~LightingRenderer() = default;
+
 static const math::mat4 biasMatrix
 (
     0.5, 0.0, 0.0, 0.5,
@@ -43,112 +54,238 @@ static const math::mat4 biasMatrix
 static uint32_t SHADOW_TEX = 3;
 static uint32_t SSAO_TEX = 4;
 static uint32_t SSR_TEX = 5;
+static uint32_t LIGHT_DATA_TEX = 6;
+static uint32_t TILE_TEX = 7;
+static uint32_t LIGHT_INDEX_TEX = 8;
 
-void LightingRenderer::render(Scene* pscene)
+void LightingRenderer::render_point_lights_stencil(Scene* pscene)
 {
-    auto& ssao_buffer   = GMODULES::GET("SSAObuffer"_h);
-    auto& ssr_buffer    = GMODULES::GET("SSRbuffer"_h);
-    auto& l_buffer      = GMODULES::GET("lbuffer"_h);
-    auto& g_buffer      = GMODULES::GET("gbuffer"_h);
-    auto& shadow_buffer = GMODULES::GET("shadowmap"_h);
+    auto& ssao_buffer = GMODULES::GET("SSAObuffer"_h);
+    auto& l_buffer    = GMODULES::GET("lbuffer"_h);
+    auto& g_buffer    = GMODULES::GET("gbuffer"_h);
 
-    // Get camera matrices
-    const math::mat4& V = pscene->get_camera().get_view_matrix();       // Camera View matrix
-    const math::mat4& P = pscene->get_camera().get_projection_matrix(); // Camera Projection matrix
-    math::mat4 V_inv;
-    math::inverse_affine(V, V_inv);
+    const math::mat4& V = pscene->get_camera().get_view_matrix();
+    const math::mat4& P = pscene->get_camera().get_projection_matrix();
     math::mat4 PV(P*V);
-
     math::vec4 proj_params(1.0f/P(0,0), 1.0f/P(1,1), P(2,2)-1.0f, P(2,3));
 
-    if(lighting_enabled_)
+    g_buffer.bind_as_source();
+    l_buffer.bind_as_target();
+    //g_buffer.blit_depth(l_buffer); // [OPT] Find a workaround
+    Gfx::device->set_depth_lock(true);
+    Gfx::device->clear(CLEAR_COLOR_FLAG);
+
+    Gfx::device->set_stencil_test_enabled(true);
+    Gfx::device->set_depth_func(DepthFunc::Less);
+    Gfx::device->set_stencil_operator(StencilOperator::LightVolume);
+
+    pscene->traverse_lights([&](const Light& light, uint32_t chunk_index)
     {
-        g_buffer.bind_as_source();
-        l_buffer.bind_as_target();
-        //g_buffer.blit_depth(l_buffer); // [OPT] Find a workaround
-        Gfx::device->set_depth_lock(true);
-        Gfx::device->clear(CLEAR_COLOR_FLAG);
+        // Get light properties
+        if(light.get_geometry() == 0) return;
+        math::mat4 M = light.get_model_matrix();
+        // Is cam inside light volume?
+        //bool inside = light.surrounds_camera(*pscene->get_camera());
 
-        Gfx::device->set_stencil_test_enabled(true);
-        Gfx::device->set_depth_func(DepthFunc::Less);
-        Gfx::device->set_stencil_operator(StencilOperator::LightVolume);
+    // -------- STENCIL PASS
+        Gfx::device->lock_color_buffer(); // Do not write to color buffers
+        Gfx::device->clear(CLEAR_STENCIL_FLAG);
+        Gfx::device->set_depth_test_enabled(true);
+        Gfx::device->set_cull_mode(CullMode::None); // Disable face culling, we want to process all polygons
+        Gfx::device->set_stencil_func(StencilFunc::Always); // Stencil test always succeeds, we just need stencil operation
 
-        pscene->traverse_lights([&](const Light& light, uint32_t chunk_index)
+        // Use null technique (void fragment shader)
+        // Only stencil operation is important
+        null_shader_.use();
+        null_shader_.send_uniform("m4_ModelViewProjection"_h, PV*M);
+        CGEOM.draw("sphere"_h);
+        null_shader_.unuse();
+
+        // Restore writing to color buffers
+        l_buffer.rebind_draw_buffers();
+
+    // ---- LIGHT PASS
+        Gfx::device->set_stencil_lock(true);
+        Gfx::device->set_stencil_func(StencilFunc::NotEqual, 0, 0xFF);
+        Gfx::device->set_depth_test_enabled(false);
+        Gfx::device->set_light_blending();
+        Gfx::device->set_cull_mode(CullMode::Front);
+
+        lpass_point_shader_.use();
+        //lpass_point_shader_.send_uniform("rd.b_lighting_enabled"_h, lighting_enabled_);
+        // view position uniform
+        //lpass_point_shader_.send_uniform("rd.v3_viewPos"_h, pscene->get_camera()->get_position());
+        // G-Buffer texture samplers
+        lpass_point_shader_.send_uniforms(g_buffer.get_texture());
+        // Bright pass threshold
+        lpass_point_shader_.send_uniform("rd.f_bright_threshold"_h, std::max(bright_threshold_, bright_knee_));
+        lpass_point_shader_.send_uniform("rd.f_bright_knee"_h, bright_knee_);
+        // Screen size
+        lpass_point_shader_.send_uniform("rd.v2_screenSize"_h,
+                                         math::vec2(g_buffer.get_width(),g_buffer.get_height()));
+        // Light uniforms
+        lpass_point_shader_.send_uniform("lt.v3_lightPosition"_h, V*light.get_position());
+        lpass_point_shader_.send_uniforms(light);
+        lpass_point_shader_.send_uniform("m4_ModelViewProjection"_h, PV*M);
+        //lpass_point_shader_.send_uniform("m4_ModelView"_h, V*M);
+        // For position reconstruction
+        lpass_point_shader_.send_uniform("rd.v4_proj_params"_h, proj_params);
+
+        // SSAO
+        if(SSAO_enabled_)
         {
-            // Get light properties
-            if(light.get_geometry() == 0) return;
-            math::mat4 M = light.get_model_matrix();
-            // Is cam inside light volume?
-            //bool inside = light.surrounds_camera(*pscene->get_camera());
-
-        // -------- STENCIL PASS
-            Gfx::device->lock_color_buffer(); // Do not write to color buffers
-            Gfx::device->clear(CLEAR_STENCIL_FLAG);
-            Gfx::device->set_depth_test_enabled(true);
-            Gfx::device->set_cull_mode(CullMode::None); // Disable face culling, we want to process all polygons
-            Gfx::device->set_stencil_func(StencilFunc::Always); // Stencil test always succeeds, we just need stencil operation
-
-            // Use null technique (void fragment shader)
-            // Only stencil operation is important
-            null_shader_.use();
-            null_shader_.send_uniform("m4_ModelViewProjection"_h, PV*M);
-            CGEOM.draw("sphere"_h);
-            null_shader_.unuse();
-
-            // Restore writing to color buffers
-            l_buffer.rebind_draw_buffers();
-
-        // ---- LIGHT PASS
-            Gfx::device->set_stencil_lock(true);
-            Gfx::device->set_stencil_func(StencilFunc::NotEqual, 0, 0xFF);
-            Gfx::device->set_depth_test_enabled(false);
-            Gfx::device->set_light_blending();
-            Gfx::device->set_cull_mode(CullMode::Front);
-
-            lpass_point_shader_.use();
-            //lpass_point_shader_.send_uniform("rd.b_lighting_enabled"_h, lighting_enabled_);
-            // view position uniform
-            //lpass_point_shader_.send_uniform("rd.v3_viewPos"_h, pscene->get_camera()->get_position());
-            // G-Buffer texture samplers
-            lpass_point_shader_.send_uniforms(g_buffer.get_texture());
-            // Bright pass threshold
-            lpass_point_shader_.send_uniform("rd.f_bright_threshold"_h, std::max(bright_threshold_, bright_knee_));
-            lpass_point_shader_.send_uniform("rd.f_bright_knee"_h, bright_knee_);
-            // Screen size
-            lpass_point_shader_.send_uniform("rd.v2_screenSize"_h,
-                                             math::vec2(g_buffer.get_width(),g_buffer.get_height()));
-            // Light uniforms
-            lpass_point_shader_.send_uniform("lt.v3_lightPosition"_h, V*light.get_position());
-            lpass_point_shader_.send_uniforms(light);
-            lpass_point_shader_.send_uniform("m4_ModelViewProjection"_h, PV*M);
-            //lpass_point_shader_.send_uniform("m4_ModelView"_h, V*M);
-            // For position reconstruction
-            lpass_point_shader_.send_uniform("rd.v4_proj_params"_h, proj_params);
-
-            // SSAO
-            if(SSAO_enabled_)
-            {
-                ssao_buffer.get_texture().bind(SSAO_TEX,0); // Bind ssao[0] to texture unit SSAO_TEX
-                lpass_point_shader_.send_uniform<int>("SSAOTex"_h, SSAO_TEX);
-            }
-            lpass_point_shader_.send_uniform("rd.b_enableSSAO"_h, SSAO_enabled_);
+            ssao_buffer.get_texture().bind(SSAO_TEX,0); // Bind ssao[0] to texture unit SSAO_TEX
+            lpass_point_shader_.send_uniform<int>("SSAOTex"_h, SSAO_TEX);
+        }
+        lpass_point_shader_.send_uniform("rd.b_enableSSAO"_h, SSAO_enabled_);
 
-            CGEOM.draw("sphere"_h);
-            lpass_point_shader_.unuse();
+        CGEOM.draw("sphere"_h);
+        lpass_point_shader_.unuse();
 
-            Gfx::device->disable_blending();
-            Gfx::device->set_cull_mode(CullMode::None);
-            Gfx::device->set_stencil_lock(false);
+        Gfx::device->disable_blending();
+        Gfx::device->set_cull_mode(CullMode::None);
+        Gfx::device->set_stencil_lock(false);
+    },
+    [&](const Light& light)
+    {
+        return light.is_in_frustum(pscene->get_camera());
+    });
+    Gfx::device->set_stencil_test_enabled(false);
+
+    // Render directional light shadow to shadow buffer
+    g_buffer.unbind_as_source();
+    l_buffer.unbind_as_target();
+}
+
+void LightingRenderer::render_point_lights_tiled(Scene* pscene)
+{
+    auto& ssao_buffer = GMODULES::GET("SSAObuffer"_h);
+    auto& l_buffer    = GMODULES::GET("lbuffer"_h);
+    auto& g_buffer    = GMODULES::GET("gbuffer"_h);
+
+    const math::mat4& V = pscene->get_camera().get_view_matrix();
+    const math::mat4& P = pscene->get_camera().get_projection_matrix();
+    math::vec4 proj_params(1.0f/P(0,0), 1.0f/P(1,1), P(2,2)-1.0f, P(2,3));
+
+    // * Bin visible point lights into screen-space tiles
+    {
+        W_PROFILE_SCOPE("Light culling");
+        light_grid_.resize(g_buffer.get_width(), g_buffer.get_height());
+        light_grid_.clear();
+        pscene->traverse_lights([&](const Light& light, uint32_t chunk_index)
+        {
+            if(light.get_geometry() == 0) return;
+            light_grid_.push_light(V*light.get_position(),
+                                   light.get_radius(),
+                                   light.get_color()*light.get_brightness(),
+                                   light.get_ambient_strength(),
+                                   P);
         },
         [&](const Light& light)
         {
             return light.is_in_frustum(pscene->get_camera());
         });
-        Gfx::device->set_stencil_test_enabled(false);
+        light_grid_.build();
+    }
 
-        // Render directional light shadow to shadow buffer
+    g_buffer.bind_as_source();
+    l_buffer.bind_as_target();
+    Gfx::device->set_depth_lock(true);
+    Gfx::device->clear(CLEAR_COLOR_FLAG);
+    if(light_grid_.get_light_count() == 0)
+    {
         g_buffer.unbind_as_source();
         l_buffer.unbind_as_target();
+        return;
+    }
+
+    // * Upload light lists to the stream buffer ring, buffer textures sample their range.
+    // Fall back to orphaning their own store if the ring is full or ranges are not supported
+    auto upload = [](TextureBuffer& tbo, const void* data, std::size_t size)
+    {
+        std::size_t offset = StreamBuffer::INVALID_OFFSET;
+        if(Gfx::stream_buffer)
+            offset = Gfx::stream_buffer->write(data, size, 256);
+        if(offset == StreamBuffer::INVALID_OFFSET || !tbo.set_source(*Gfx::stream_buffer, offset, size))
+            tbo.stream(data, size);
+    };
+    const auto& light_data = light_grid_.get_light_data();
+    const auto& tile_data = light_grid_.get_tile_data();
+    const auto& light_indices = light_grid_.get_light_indices();
+    upload(*light_data_buffer_, light_data.data(), light_data.size()*sizeof(math::vec4));
+    upload(*tile_buffer_, tile_data.data(), tile_data.size()*sizeof(uint32_t));
+    upload(*light_index_buffer_, light_indices.data(), light_indices.size()*sizeof(uint32_t));
+
+    // * Single full-screen pass over all tiles
+    Gfx::device->set_depth_test_enabled(false);
+    Gfx::device->set_light_blending();
+    Gfx::device->set_cull_mode(CullMode::Back);
+
+    math::mat4 Id;
+    Id.init_identity();
+    lpass_tiled_shader_.use();
+    // G-Buffer texture samplers
+    lpass_tiled_shader_.send_uniforms(g_buffer.get_texture());
+    // Bright pass threshold
+    lpass_tiled_shader_.send_uniform("rd.f_bright_threshold"_h, std::max(bright_threshold_, bright_knee_));
+    lpass_tiled_shader_.send_uniform("rd.f_bright_knee"_h, bright_knee_);
+    // Screen size
+    lpass_tiled_shader_.send_uniform("rd.v2_screenSize"_h,
+                                     math::vec2(g_buffer.get_width(),g_buffer.get_height()));
+    // For position reconstruction
+    lpass_tiled_shader_.send_uniform("rd.v4_proj_params"_h, proj_params);
+    lpass_tiled_shader_.send_uniform("m4_ModelViewProjection"_h, Id);
+
+    // Light lists
+    light_data_buffer_->bind(LIGHT_DATA_TEX);
+    tile_buffer_->bind(TILE_TEX);
+    light_index_buffer_->bind(LIGHT_INDEX_TEX);
+    lpass_tiled_shader_.send_uniform<int>("lightDataTex"_h, LIGHT_DATA_TEX);
+    lpass_tiled_shader_.send_uniform<int>("tileTex"_h, TILE_TEX);
+    lpass_tiled_shader_.send_uniform<int>("lightIndexTex"_h, LIGHT_INDEX_TEX);
+    lpass_tiled_shader_.send_uniform<int>("i_tileSize"_h, int(light_grid_.get_tile_size()));
+    lpass_tiled_shader_.send_uniform<int>("i_tilesX"_h, int(light_grid_.get_tiles_x()));
+
+    // SSAO
+    if(SSAO_enabled_)
+    {
+        ssao_buffer.get_texture().bind(SSAO_TEX,0); // Bind ssao[0] to texture unit SSAO_TEX
+        lpass_tiled_shader_.send_uniform<int>("SSAOTex"_h, SSAO_TEX);
+    }
+    lpass_tiled_shader_.send_uniform("rd.b_enableSSAO"_h, SSAO_enabled_);
+
+    CGEOM.draw("quad"_h);
+    lpass_tiled_shader_.unuse();
+
+    Gfx::device->disable_blending();
+    Gfx::device->set_cull_mode(CullMode::None);
+
+    g_buffer.unbind_as_source();
+    l_buffer.unbind_as_target();
+}
+
+void LightingRenderer::render(Scene* pscene)
+{
+    auto& ssao_buffer   = GMODULES::GET("SSAObuffer"_h);
+    auto& ssr_buffer    = GMODULES::GET("SSRbuffer"_h);
+    auto& l_buffer      = GMODULES::GET("lbuffer"_h);
+    auto& g_buffer      = GMODULES::GET("gbuffer"_h);
+    auto& shadow_buffer = GMODULES::GET("shadowmap"_h);
+
+    // Get camera matrices
+    const math::mat4& V = pscene->get_camera().get_view_matrix();       // Camera View matrix
+    const math::mat4& P = pscene->get_camera().get_projection_matrix(); // Camera Projection matrix
+    math::mat4 V_inv;
+    math::inverse_affine(V, V_inv);
+
+    math::vec4 proj_params(1.0f/P(0,0), 1.0f/P(1,1), P(2,2)-1.0f, P(2,3));
+
+    if(lighting_enabled_)
+    {
+        if(tiled_lighting_enabled_)
+            render_point_lights_tiled(pscene);
+        else
+            render_point_lights_stencil(pscene);
     }
 
     if(!dirlight_enabled_) return;
@@ -188,15 +325,29 @@ void LightingRenderer::render(Scene* pscene)
         lpass_dir_shader_.send_uniform("rd.b_shadow_enabled"_h, shadow_enabled_);
         if(shadow_enabled_)
         {
-            math::mat4 lightMatrix = biasMatrix*pscene->get_light_camera().get_view_projection_matrix()*V_inv;
+            // Cascade light matrices, from view space
+            uint32_t n_cascades = shadow_map_renderer_.get_cascade_count();
+            math::mat4 light_matrices[ShadowMapRenderer::MAX_CASCADES];
+            math::vec4 cascade_far(0.f);
+            for(uint32_t ii=0; ii<n_cascades; ++ii)
+            {
+                const ShadowCascade& cascade = shadow_map_renderer_.get_cascade(ii);
+                light_matrices[ii] = biasMatrix*cascade.light_matrix*V_inv;
+                cascade_far[ii] = cascade.far_depth;
+            }
 
             shadow_buffer.get_texture().bind(SHADOW_TEX,0); // Bind shadow[0] to texture unit SHADOW_TEX
             lpass_dir_shader_.send_uniform<int>("shadowTex"_h, SHADOW_TEX);
-            lpass_dir_shader_.send_uniform("m4_LightSpace"_h, lightMatrix);
+            lpass_dir_shader_.send_uniform_array("m4_LightSpace[0]"_h, light_matrices, n_cascades);
+            lpass_dir_shader_.send_uniform("rd.v4_cascadeFar"_h, cascade_far);
+            lpass_dir_shader_.send_uniform<int>("rd.i_cascadeCount"_h, n_cascades);
 #ifdef __EXPERIMENTAL_VARIANCE_SHADOW_MAPPING__
             shadow_buffer.get_texture().generate_mipmaps(0);
 #else
-            lpass_dir_shader_.send_uniform("rd.v2_shadowTexelSize"_h, ShadowMapRenderer::SHADOW_TEXEL_SIZE);
+            // Cascades are laid out horizontally in the atlas
+            lpass_dir_shader_.send_uniform("rd.v2_shadowTexelSize"_h,
+                                           math::vec2(ShadowMapRenderer::SHADOW_TEXEL_SIZE.x()/n_cascades,
+                                                      ShadowMapRenderer::SHADOW_TEXEL_SIZE.y()));
             lpass_dir_shader_.send_uniform("rd.f_shadowBias"_h, shadow_bias_ * ShadowMapRenderer::SHADOW_TEXEL_SIZE.x());
 #endif
         }
@@ -64,6 +64,11 @@ static std::map<MsgType, std::string> ICON =
 };
 
 static const uint32_t CHANNEL_STYLE_PALETTE = 4u;
+// Max time a record waits in the queue before the logging thread outputs it
+static const std::chrono::milliseconds LOG_THREAD_POLL_INTERVAL(2);
+
+// Severity of last message logged by this thread, for Severity::REPEAT
+static thread_local Severity last_severity = Severity::DET;
 
 LogChannel::LogChannel(std::string&& name,
                        std::array<float,3>&& color,
@@ -80,10 +85,14 @@ color(std::move(color))
 Logger::Logger()
 : Listener()
 , file_mode_(FileMode::OVERWRITE)
+, widget_scroll_required_(false)
 , backtrace_on_error_(false)
 , start_time_(std::chrono::high_resolution_clock::now())
-, last_severity_(Severity::DET)
+, last_section_size_(0)
 , messages_()
+, async_(false)
+, quit_(false)
+, processed_(0)
 {
     // Create a default debugging channel
     register_channel("core", 3u);
@@ -91,7 +100,91 @@ Logger::Logger()
 
 Logger::~Logger()
 {
+    // Output pending messages and join logging thread
+    set_async(false);
+}
+
+void Logger::set_async(bool value, size_t queue_capacity)
+{
+    if(value == is_async())
+        return;
 
+    if(value)
+    {
+        queue_ = std::make_unique<MPSCRingBuffer<LogRecord>>(queue_capacity);
+        processed_.store(0, std::memory_order_relaxed);
+        quit_.store(false, std::memory_order_relaxed);
+        log_thread_ = std::thread(&Logger::log_thread_loop, this);
+        async_.store(true, std::memory_order_release);
+    }
+    else
+    {
+        async_.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            quit_.store(true, std::memory_order_release);
+        }
+        wake_cv_.notify_one();
+        log_thread_.join();
+        queue_.reset();
+    }
+}
+
+void Logger::log_thread_loop()
+{
+    LogRecord record;
+    while(true)
+    {
+        // Read quit flag before draining, so that records pushed before
+        // shutdown are all output
+        bool quit = quit_.load(std::memory_order_acquire);
+
+        while(queue_->try_pop(record))
+        {
+            const char* file = record.file_copy.empty() ? record.file : record.file_copy.c_str();
+            LogMessage logm(std::move(record.message), record.timestamp, record.type, record.mode,
+                            record.severity, record.channel, file, record.line);
+            // Backtrace of this thread is meaningless, producer prints it
+            dispatch(logm, false);
+            processed_.fetch_add(1, std::memory_order_release);
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        flush_cv_.notify_all();
+        if(quit)
+            break;
+        wake_cv_.wait_for(lock, LOG_THREAD_POLL_INTERVAL);
+    }
+}
+
+void Logger::push(LogRecord&& record)
+{
+    while(!queue_->try_push(std::move(record)))
+    {
+        // Queue is full, let the logging thread catch up
+        wake_cv_.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+void Logger::flush()
+{
+    if(!is_async() || std::this_thread::get_id() == log_thread_.get_id())
+        return;
+
+    size_t ticket = queue_->get_push_count();
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+    flush_cv_.wait(lock, [&]()
+    {
+        return processed_.load(std::memory_order_acquire) >= ticket;
+    });
+}
+
+void Logger::clear()
+{
+    std::lock_guard<std::mutex> lock(messages_mutex_);
+    messages_.clear();
 }
 
 // Matches tagged text <X>text text text</X>. Tag must be single character.
@@ -184,20 +277,25 @@ void Logger::register_channel(const char* name, uint32_t verbosity)
     hash_t hname = H_(name);
 
     // Detect duplicate channel or hash collision
-    auto it = channels_.find(hname);
-    if(it != channels_.end())
+    std::string duplicate;
     {
-        operator ()("[Logger] Ignoring duplicate channel or collision detected: " + it->second.name,
-                    MsgType::WARNING, LogMode::CANONICAL, Severity::WARN, "core"_h);
-        return;
-    }
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        auto it = channels_.find(hname);
+        if(it == channels_.end())
+        {
+            // Generate a random color style for channel name display
+            math::vec3 bgcolor_f = color::random_color(hname+CHANNEL_STYLE_PALETTE, 1.f, 0.4f);
 
-    // Generate a random color style for channel name display
-    math::vec3 bgcolor_f = color::random_color(hname+CHANNEL_STYLE_PALETTE, 1.f, 0.4f);
+            // Add channel
+            channels_.insert(std::make_pair(hname,
+                             LogChannel(std::string(name), bgcolor_f.to_array(), verbosity)));
+            return;
+        }
+        duplicate = it->second.name;
+    }
 
-    // Add channel
-    channels_.insert(std::make_pair(hname,
-                     LogChannel(std::string(name), bgcolor_f.to_array(), verbosity)));
+    operator ()("[Logger] Ignoring duplicate channel or collision detected: " + duplicate,
+                MsgType::WARNING, LogMode::CANONICAL, Severity::WARN, "core"_h);
 }
 
 void Logger::operator ()(const std::string& message,
@@ -208,11 +306,7 @@ void Logger::operator ()(const std::string& message,
                          const char* file,
                          int line)
 {
-    if(severity == Severity::REPEAT) severity = last_severity_;
-    else last_severity_ = Severity(severity);
-    auto timestamp = std::chrono::high_resolution_clock::now() - start_time_;
-    LogMessage logm(message, timestamp, type, mode, severity, channel, file, line);
-    operator ()(logm);
+    operator ()(std::string(message), type, mode, severity, channel, file, line);
 }
 
 void Logger::operator ()(std::string&& message,
@@ -223,27 +317,63 @@ void Logger::operator ()(std::string&& message,
                          const char* file,
                          int line)
 {
-    if(severity == Severity::REPEAT) severity = last_severity_;
-    else last_severity_ = Severity(severity);
+    if(severity == Severity::REPEAT) severity = last_severity;
+    else last_severity = Severity(severity);
     auto timestamp = std::chrono::high_resolution_clock::now() - start_time_;
-    LogMessage logm(std::forward<std::string>(message), timestamp, type, mode, severity, channel, file, line);
-    operator ()(logm);
+
+    if(!is_async())
+    {
+        LogMessage logm(std::move(message), timestamp, type, mode, severity, channel, file, line);
+        dispatch(logm);
+        return;
+    }
+
+    push(LogRecord{std::move(message), file, timestamp, channel, severity, line, type, mode});
+
+    // Errors must be output before the program goes on (or dies)
+    bool critical = (3u - std::min(severity, 3u)) < 2;
+    if(type == MsgType::FATAL || (critical && backtrace_on_error_))
+    {
+        flush();
+        if(critical && backtrace_on_error_)
+            print_backtrace();
+    }
 }
 
 void Logger::operator ()(const LogMessage& log_message)
+{
+    if(!is_async())
+    {
+        dispatch(log_message);
+        return;
+    }
+
+    // Message does not outlive this call, its file name is copied
+    push(LogRecord{log_message.message_, "", log_message.timestamp_, log_message.channel_,
+                   3u - log_message.verbosity_level, log_message.line_, log_message.type_, log_message.mode_,
+                   log_message.file_});
+    if(log_message.type_ == MsgType::FATAL)
+        flush();
+}
+
+void Logger::dispatch(const LogMessage& log_message, bool allow_backtrace)
 {
     // Push message if it needs to be output to a file
     if(((uint8_t)log_message.mode_ & (uint8_t)LogMode::TEXTFILE) != 0)
+    {
+        std::lock_guard<std::mutex> lock(messages_mutex_);
         messages_.push_back(log_message);
+    }
 
     // Display message on console if required and verbosity level is sufficient
     if(((uint8_t)log_message.mode_ & (uint8_t)LogMode::CONSOLE) != 0)
     {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
         uint32_t cur_verbosity = get_channel_verbosity(log_message.channel_);
         if(cur_verbosity >= log_message.verbosity_level)
         {
             print_console(log_message);
-            if(log_message.verbosity_level < 2 && backtrace_on_error_)
+            if(log_message.verbosity_level < 2 && backtrace_on_error_ && allow_backtrace)
                 print_backtrace();
         }
     }
@@ -283,6 +413,7 @@ void Logger::generate_widget()
         ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0,1));
         if(copy) ImGui::LogToClipboard();
 
+        std::unique_lock<std::mutex> lock(messages_mutex_);
         if(Filter.IsActive())
         {
             for(uint32_t ii=0; ii<messages_.size(); ++ii)
@@ -299,6 +430,7 @@ void Logger::generate_widget()
                 ImGui::TextUnformatted(messages_[ii].message_.c_str());
             }
         }
+        lock.unlock();
 
         if (widget_scroll_required_)
             ImGui::SetScrollHere(1.0f);
@@ -365,6 +497,8 @@ void Logger::write(const fs::path& log_path)
     std::ofstream log(log_path);
     log << "-------------------------" << std::endl;
     log << "[TIME STAMP] [MTYPE] [MESSAGE]" << std::endl;
+    flush();
+    std::lock_guard<std::mutex> lock(messages_mutex_);
     for(const LogMessage& logmsg : messages_)
     {
         float timestamp = std::chrono::duration_cast<std::chrono::duration<float>>(logmsg.timestamp_).count();
@@ -73,6 +73,14 @@ void Material::bind_texture() const
     texture_->bind_all();
 }
 
+std::size_t Material::get_state_hash() const
+{
+    std::size_t ret = 0;
+    detail::hash_combine(ret, texture_.get(), albedo_, metallic_, roughness_, parallax_height_scale_,
+                         alpha_, textured_, use_normal_map_, use_parallax_map_, use_overlay_, blend_);
+    return ret;
+}
+
 bool Material::has_texture(TextureUnit unit) const
 {
     if(texture_)
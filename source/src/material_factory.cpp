@@ -183,20 +183,28 @@ Material* MaterialFactory::make_material(MaterialDescriptor& descriptor)
     else
     {
         std::shared_ptr<Texture> ptex = nullptr;
+        // Mapped Watfile, must outlive texture creation
+        io::FileView wat_view;
         if(descriptor.is_textured)
         {
             // Load texture from Watfile
             if(descriptor.texture_descriptor.is_wat)
             {
-                auto pstream = FILESYSTEM.get_file_as_stream(descriptor.texture_descriptor.wat_location.c_str(), "root.folders.texture"_h, "pack0"_h);
-                if(pstream == nullptr)
+                // Texture data is referenced in place when the file can be mapped,
+                // else (compressed archive entry) it is read through a stream
+                wat_view = FILESYSTEM.map_file(descriptor.texture_descriptor.wat_location.c_str(), "root.folders.texture"_h, "pack0"_h);
+                if(!wat_view || !wat_loader_->read(wat_view, descriptor))
                 {
-                    DLOGE("[MaterialFactory] Unable to open file:", "material");
-                    DLOGI("<p>" + std::string(descriptor.texture_descriptor.wat_location) + "</p>", "material");
-                    fatal();
+                    auto pstream = FILESYSTEM.get_file_as_stream(descriptor.texture_descriptor.wat_location.c_str(), "root.folders.texture"_h, "pack0"_h);
+                    if(pstream == nullptr)
+                    {
+                        DLOGE("[MaterialFactory] Unable to open file:", "material");
+                        DLOGI("<p>" + std::string(descriptor.texture_descriptor.wat_location) + "</p>", "material");
+                        fatal();
+                    }
+                    // Read texture data
+                    wat_loader_->read(*pstream, descriptor, true);
                 }
-                // Read texture data
-                wat_loader_->read(*pstream, descriptor, true);
             }
             // Load texture from multiple PNG files
             else
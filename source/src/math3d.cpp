@@ -1,6 +1,10 @@
 #include <random>
 #include "math3d.h"
 
+#ifdef __SSE__
+    #include <xmmintrin.h>
+#endif
+
 namespace wcore
 {
 namespace math
@@ -193,6 +197,100 @@ bool transposed_inverse_affine(const mat4& m, mat4& Inverse)
     return true;
 }
 
+#ifdef __SSE__
+/*
+    General 4*4 inverse by 2*2 blocks. With M = |A B|, the inverse is 1/|M| * |X Y|
+                                                |C D|                        |Z W|
+    where the adjugates of X, Y, Z, W only involve 2*2 products:
+        X# = |D|A - B(D#C)    Y# = |B|C - D(A#B)#
+        Z# = |C|B - A(D#C)#   W# = |A|D - C(A#B)
+        |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    Storage is column major, so this works on the transpose of M, and the inverse of
+    the transpose is stored as the transpose of the inverse: columns need no reordering.
+    2*2 blocks are held in a register as (m00, m01, m10, m11). SSE1 only.
+*/
+#define WCORE_SHUFFLE(A, B, X, Y, Z, W) _mm_shuffle_ps((A), (B), _MM_SHUFFLE((W),(Z),(Y),(X)))
+#define WCORE_SWIZZLE(A, X, Y, Z, W) WCORE_SHUFFLE(A, A, X, Y, Z, W)
+
+// A*B
+static inline __m128 mat2_mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, WCORE_SWIZZLE(b, 0,3,0,3)),
+                      _mm_mul_ps(WCORE_SWIZZLE(a, 1,0,3,2), WCORE_SWIZZLE(b, 2,1,2,1)));
+}
+// A#*B
+static inline __m128 mat2_adj_mul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(WCORE_SWIZZLE(a, 3,3,0,0), b),
+                      _mm_mul_ps(WCORE_SWIZZLE(a, 1,1,2,2), WCORE_SWIZZLE(b, 2,3,0,1)));
+}
+// A*B#
+static inline __m128 mat2_mul_adj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, WCORE_SWIZZLE(b, 3,0,3,0)),
+                      _mm_mul_ps(WCORE_SWIZZLE(a, 1,0,3,2), WCORE_SWIZZLE(b, 2,1,2,1)));
+}
+
+static bool inverse_sse(const mat4& m, mat4& Inverse)
+{
+    __m128 c0 = _mm_loadu_ps(m.get_pointer());
+    __m128 c1 = _mm_loadu_ps(m.get_pointer()+4);
+    __m128 c2 = _mm_loadu_ps(m.get_pointer()+8);
+    __m128 c3 = _mm_loadu_ps(m.get_pointer()+12);
+
+    // * Sub matrices and their determinants (|A| |B| |C| |D|)
+    __m128 A = _mm_movelh_ps(c0, c1);
+    __m128 B = _mm_movehl_ps(c1, c0);
+    __m128 C = _mm_movelh_ps(c2, c3);
+    __m128 D = _mm_movehl_ps(c3, c2);
+
+    __m128 det_sub = _mm_sub_ps(_mm_mul_ps(WCORE_SHUFFLE(c0, c2, 0,2,0,2), WCORE_SHUFFLE(c1, c3, 1,3,1,3)),
+                                _mm_mul_ps(WCORE_SHUFFLE(c0, c2, 1,3,1,3), WCORE_SHUFFLE(c1, c3, 0,2,0,2)));
+    __m128 det_A = WCORE_SWIZZLE(det_sub, 0,0,0,0);
+    __m128 det_B = WCORE_SWIZZLE(det_sub, 1,1,1,1);
+    __m128 det_C = WCORE_SWIZZLE(det_sub, 2,2,2,2);
+    __m128 det_D = WCORE_SWIZZLE(det_sub, 3,3,3,3);
+
+    // * Adjugates of the blocks of the inverse
+    __m128 D_C = mat2_adj_mul(D, C);
+    __m128 A_B = mat2_adj_mul(A, B);
+    __m128 X_ = _mm_sub_ps(_mm_mul_ps(det_D, A), mat2_mul(B, D_C));
+    __m128 W_ = _mm_sub_ps(_mm_mul_ps(det_A, D), mat2_mul(C, A_B));
+    __m128 Y_ = _mm_sub_ps(_mm_mul_ps(det_B, C), mat2_mul_adj(D, A_B));
+    __m128 Z_ = _mm_sub_ps(_mm_mul_ps(det_C, B), mat2_mul_adj(A, D_C));
+
+    // * Determinant
+    __m128 tr = _mm_mul_ps(A_B, WCORE_SWIZZLE(D_C, 0,2,1,3));
+    tr = _mm_add_ps(tr, WCORE_SWIZZLE(tr, 2,3,0,1));
+    tr = _mm_add_ps(tr, WCORE_SWIZZLE(tr, 1,0,3,2));
+    __m128 det_M = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_A, det_D), _mm_mul_ps(det_B, det_C)), tr);
+
+    float det = _mm_cvtss_f32(det_M);
+    #ifdef ENABLE_DETERMINANT_DISCRIMINATION_OPT
+    if (std::abs(det) <= float(DET_DISCRIMINATION_MIN))
+    #else
+    if (det == 0.0)
+    #endif
+        return false;
+
+    // * Scale by (1/|M|, -1/|M|, -1/|M|, 1/|M|) and apply adjugate while storing
+    __m128 rdet_M = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det_M);
+    X_ = _mm_mul_ps(X_, rdet_M);
+    Y_ = _mm_mul_ps(Y_, rdet_M);
+    Z_ = _mm_mul_ps(Z_, rdet_M);
+    W_ = _mm_mul_ps(W_, rdet_M);
+
+    _mm_storeu_ps(Inverse.get_pointer(),    WCORE_SHUFFLE(X_, Y_, 3,1,3,1));
+    _mm_storeu_ps(Inverse.get_pointer()+4,  WCORE_SHUFFLE(X_, Y_, 2,0,2,0));
+    _mm_storeu_ps(Inverse.get_pointer()+8,  WCORE_SHUFFLE(Z_, W_, 3,1,3,1));
+    _mm_storeu_ps(Inverse.get_pointer()+12, WCORE_SHUFFLE(Z_, W_, 2,0,2,0));
+    return true;
+}
+
+#undef WCORE_SWIZZLE
+#undef WCORE_SHUFFLE
+#endif // __SSE__
+
 // Optimized code for 4*4 inverse computation
 bool inverse(const mat4& m, mat4& Inverse)
 {
@@ -203,6 +301,9 @@ bool inverse(const mat4& m, mat4& Inverse)
     }
     #endif
 
+    #ifdef __SSE__
+    return inverse_sse(m, Inverse);
+    #else
     float det;
 
     Inverse[0]  = m[5]*(m[10]*m[15] - m[11]*m[14]) - m[9]*(m[6]*m[15] -
@@ -257,6 +358,7 @@ bool inverse(const mat4& m, mat4& Inverse)
         return true;
     }
     return false;
+    #endif // __SSE__
 }
 
 // Optimized code for 4*4 TRANSPOSED inverse computation
@@ -403,6 +505,86 @@ void translate_matrix(mat4& matrix, const vec3& translation)
 }
 
 
+void transform(const mat4& matrix, const vec4* in, vec4* out, size_t count)
+{
+#ifdef __SSE__
+    // Matrix columns stay in registers for the whole batch
+    __m128 c0 = _mm_loadu_ps(matrix.get_pointer());
+    __m128 c1 = _mm_loadu_ps(matrix.get_pointer()+4);
+    __m128 c2 = _mm_loadu_ps(matrix.get_pointer()+8);
+    __m128 c3 = _mm_loadu_ps(matrix.get_pointer()+12);
+    for(size_t ii=0; ii<count; ++ii)
+    {
+        const float* v = in[ii].get_pointer();
+        __m128 res = _mm_mul_ps(c0, _mm_set1_ps(v[0]));
+        res = _mm_add_ps(res, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+        res = _mm_add_ps(res, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+        res = _mm_add_ps(res, _mm_mul_ps(c3, _mm_set1_ps(v[3])));
+        _mm_storeu_ps(out[ii].get_pointer(), res);
+    }
+#else
+    for(size_t ii=0; ii<count; ++ii)
+        out[ii] = matrix*in[ii];
+#endif
+}
+
+void transform_points(const mat4& matrix, const vec3* in, vec3* out, size_t count)
+{
+#ifdef __SSE__
+    __m128 c0 = _mm_loadu_ps(matrix.get_pointer());
+    __m128 c1 = _mm_loadu_ps(matrix.get_pointer()+4);
+    __m128 c2 = _mm_loadu_ps(matrix.get_pointer()+8);
+    __m128 c3 = _mm_loadu_ps(matrix.get_pointer()+12);
+    for(size_t ii=0; ii<count; ++ii)
+    {
+        const float* v = in[ii].get_pointer();
+        __m128 res = _mm_mul_ps(c0, _mm_set1_ps(v[0]));
+        res = _mm_add_ps(res, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+        res = _mm_add_ps(res, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+        res = _mm_add_ps(res, c3);
+        // vec3 is 12 bytes, a 16 bytes store would overflow the last element
+        float* o = out[ii].get_pointer();
+        _mm_storel_pi(reinterpret_cast<__m64*>(o), res);
+        _mm_store_ss(o+2, _mm_movehl_ps(res, res));
+    }
+#else
+    for(size_t ii=0; ii<count; ++ii)
+        out[ii] = vec3(matrix*vec4(in[ii], 1.f));
+#endif
+}
+
+void multiply(const mat4& lhs, const mat4* rhs, mat4* out, size_t count)
+{
+#ifdef __SSE__
+    __m128 c0 = _mm_loadu_ps(lhs.get_pointer());
+    __m128 c1 = _mm_loadu_ps(lhs.get_pointer()+4);
+    __m128 c2 = _mm_loadu_ps(lhs.get_pointer()+8);
+    __m128 c3 = _mm_loadu_ps(lhs.get_pointer()+12);
+    for(size_t ii=0; ii<count; ++ii)
+    {
+        // Output may alias rhs, a column of rhs is fully read before the same column is written
+        for(unsigned jj=0; jj<4; ++jj)
+        {
+            const float* r = rhs[ii].get_pointer() + jj*4;
+            __m128 col = _mm_mul_ps(c0, _mm_set1_ps(r[0]));
+            col = _mm_add_ps(col, _mm_mul_ps(c1, _mm_set1_ps(r[1])));
+            col = _mm_add_ps(col, _mm_mul_ps(c2, _mm_set1_ps(r[2])));
+            col = _mm_add_ps(col, _mm_mul_ps(c3, _mm_set1_ps(r[3])));
+            _mm_storeu_ps(out[ii].get_pointer() + jj*4, col);
+        }
+    }
+#else
+    for(size_t ii=0; ii<count; ++ii)
+        out[ii] = lhs*rhs[ii];
+#endif
+}
+
+void multiply(const mat4* lhs, const mat4* rhs, mat4* out, size_t count)
+{
+    for(size_t ii=0; ii<count; ++ii)
+        out[ii] = lhs[ii]*rhs[ii];
+}
+
 static std::mt19937 genv3;
 
 void srand_vec3(uint32_t seed)
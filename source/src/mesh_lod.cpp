@@ -0,0 +1,242 @@
+#include <queue>
+#include <unordered_map>
+#include <cmath>
+
+#include "mesh_lod.h"
+
+namespace wcore
+{
+namespace lod
+{
+
+using namespace math;
+
+// Symmetric 4x4 error quadric, upper triangle
+// Planes are area weighted, and the error is normalized by the accumulated area so that
+// it stays an (area averaged) squared distance, which scales like the bounding box diagonal squared
+struct Quadric
+{
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double area = 0;
+
+    // Squared distance to plane n.p + d = 0, weighted
+    void add_plane(double nx, double ny, double nz, double d, double weight)
+    {
+        a00 += weight*nx*nx; a01 += weight*nx*ny; a02 += weight*nx*nz; a03 += weight*nx*d;
+        a11 += weight*ny*ny; a12 += weight*ny*nz; a13 += weight*ny*d;
+        a22 += weight*nz*nz; a23 += weight*nz*d;
+        a33 += weight*d*d;
+        area += weight;
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        area += q.area;
+        return *this;
+    }
+
+    double evaluate(const vec3& p) const
+    {
+        if(area <= 0.0)
+            return 0.0;
+        double x = p.x(), y = p.y(), z = p.z();
+        return (a00*x*x + 2*a01*x*y + 2*a02*x*z + 2*a03*x
+              + a11*y*y + 2*a12*y*z + 2*a13*y
+              + a22*z*z + 2*a23*z
+              + a33) / area;
+    }
+};
+
+// Candidate collapse of vertex 'from' into vertex 'to'
+struct Collapse
+{
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t from_version;
+    uint32_t to_version;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+static inline vec3 triangle_normal(const vec3& p0, const vec3& p1, const vec3& p2)
+{
+    return (p1-p0).cross(p2-p0);
+}
+
+std::vector<uint32_t> simplify(const std::vector<vec3>& positions,
+                               const std::vector<uint32_t>& indices,
+                               uint32_t target_triangles,
+                               float max_error)
+{
+    const uint32_t n_vertices = positions.size();
+    const uint32_t n_triangles = indices.size()/3;
+    std::vector<uint32_t> tris(indices.begin(), indices.begin()+3*n_triangles);
+
+    // * Weld vertices by position, vertices of a class share a quadric
+    std::unordered_map<vec3, uint32_t> class_map;
+    std::vector<uint32_t> vclass(n_vertices);
+    std::vector<uint32_t> class_size;
+    for(uint32_t ii=0; ii<n_vertices; ++ii)
+    {
+        auto it = class_map.find(positions[ii]);
+        if(it == class_map.end())
+        {
+            it = class_map.insert({positions[ii], uint32_t(class_size.size())}).first;
+            class_size.push_back(0);
+        }
+        vclass[ii] = it->second;
+        ++class_size[it->second];
+    }
+
+    // * Quadrics, adjacency and border detection
+    std::vector<Quadric> quadrics(class_size.size());
+    std::vector<std::vector<uint32_t>> vertex_tris(n_vertices);
+    std::unordered_map<uint64_t, uint32_t> edge_count;
+    for(uint32_t tt=0; tt<n_triangles; ++tt)
+    {
+        const vec3& p0 = positions[tris[3*tt+0]];
+        const vec3& p1 = positions[tris[3*tt+1]];
+        const vec3& p2 = positions[tris[3*tt+2]];
+        vec3 normal = triangle_normal(p0, p1, p2);
+        float double_area = normal.norm();
+        if(double_area > 0.f)
+        {
+            normal /= double_area;
+            double d = -normal.dot(p0);
+            for(int cc=0; cc<3; ++cc)
+                quadrics[vclass[tris[3*tt+cc]]].add_plane(normal.x(), normal.y(), normal.z(), d, 0.5*double_area);
+        }
+        for(int cc=0; cc<3; ++cc)
+        {
+            vertex_tris[tris[3*tt+cc]].push_back(tt);
+            uint64_t ca = vclass[tris[3*tt+cc]];
+            uint64_t cb = vclass[tris[3*tt+(cc+1)%3]];
+            ++edge_count[(std::min(ca,cb) << 32) | std::max(ca,cb)];
+        }
+    }
+
+    std::vector<bool> locked_class(class_size.size(), false);
+    for(auto&& [key, count]: edge_count)
+    {
+        if(count == 1)
+        {
+            locked_class[key >> 32] = true;
+            locked_class[key & 0xffffffff] = true;
+        }
+    }
+    std::vector<bool> locked(n_vertices);
+    for(uint32_t ii=0; ii<n_vertices; ++ii)
+        locked[ii] = locked_class[vclass[ii]] || class_size[vclass[ii]] > 1;
+
+    // * Initial candidates
+    std::vector<bool> tri_alive(n_triangles, true);
+    std::vector<uint32_t> version(n_vertices, 0);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+    auto push_candidate = [&](uint32_t from, uint32_t to)
+    {
+        if(locked[from] || vclass[from] == vclass[to])
+            return;
+        Quadric q = quadrics[vclass[from]];
+        q += quadrics[vclass[to]];
+        heap.push({q.evaluate(positions[to]), from, to, version[from], version[to]});
+    };
+    for(uint32_t tt=0; tt<n_triangles; ++tt)
+    {
+        for(int cc=0; cc<3; ++cc)
+        {
+            uint32_t va = tris[3*tt+cc];
+            uint32_t vb = tris[3*tt+(cc+1)%3];
+            push_candidate(va, vb);
+            push_candidate(vb, va);
+        }
+    }
+
+    // * Greedy collapses, cheapest first
+    uint32_t n_alive = n_triangles;
+    while(n_alive > target_triangles && !heap.empty())
+    {
+        Collapse collapse = heap.top();
+        heap.pop();
+        if(collapse.cost > max_error)
+            break;
+        uint32_t from = collapse.from;
+        uint32_t to   = collapse.to;
+        // Stale candidate
+        if(collapse.from_version != version[from] || collapse.to_version != version[to])
+            continue;
+
+        // Reject collapses that flip a triangle
+        bool flips = false;
+        for(uint32_t tt: vertex_tris[from])
+        {
+            if(!tri_alive[tt]) continue;
+            uint32_t* tri = &tris[3*tt];
+            if(vclass[tri[0]]==vclass[to] || vclass[tri[1]]==vclass[to] || vclass[tri[2]]==vclass[to])
+                continue;
+            vec3 p[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+            vec3 old_normal = triangle_normal(p[0], p[1], p[2]);
+            for(int cc=0; cc<3; ++cc)
+                if(tri[cc]==from) p[cc] = positions[to];
+            vec3 new_normal = triangle_normal(p[0], p[1], p[2]);
+            if(new_normal.dot(old_normal) <= 0.f)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if(flips)
+            continue;
+
+        // Triangles around the collapsed edge vanish, others are reattached
+        for(uint32_t tt: vertex_tris[from])
+        {
+            if(!tri_alive[tt]) continue;
+            uint32_t* tri = &tris[3*tt];
+            if(vclass[tri[0]]==vclass[to] || vclass[tri[1]]==vclass[to] || vclass[tri[2]]==vclass[to])
+            {
+                tri_alive[tt] = false;
+                --n_alive;
+                continue;
+            }
+            for(int cc=0; cc<3; ++cc)
+                if(tri[cc]==from) tri[cc] = to;
+            vertex_tris[to].push_back(tt);
+        }
+        vertex_tris[from].clear();
+        quadrics[vclass[to]] += quadrics[vclass[from]];
+        ++version[from];
+        ++version[to];
+
+        // Costs of edges around 'to' changed
+        for(uint32_t tt: vertex_tris[to])
+        {
+            if(!tri_alive[tt]) continue;
+            for(int cc=0; cc<3; ++cc)
+            {
+                uint32_t other = tris[3*tt+cc];
+                if(other == to) continue;
+                push_candidate(to, other);
+                push_candidate(other, to);
+            }
+        }
+    }
+
+    // * Surviving triangles, original order is kept for vertex cache locality
+    std::vector<uint32_t> result;
+    result.reserve(3*n_alive);
+    for(uint32_t tt=0; tt<n_triangles; ++tt)
+        if(tri_alive[tt])
+            result.insert(result.end(), tris.begin()+3*tt, tris.begin()+3*tt+3);
+    return result;
+}
+
+} // namespace lod
+} // namespace wcore
@@ -19,8 +19,11 @@ aabb_(),
 frustum_cull_(true),
 is_dynamic_(false),
 is_terrain_(false),
-visible_(false),
 shadow_cull_face_(0),
+lod_(0),
+hierarchy_(nullptr),
+transform_node_(TransformHierarchy::NONE),
+bbox_version_(0),
 reference_(0),
 has_reference_(false)
 #ifndef __DISABLE_EDITOR__
@@ -39,6 +42,7 @@ has_reference_(false)
 
 Model::~Model()
 {
+    detach_transform();
 #ifndef __DISABLE_EDITOR__
     if(selection_reset_)
         (editor_->*selection_reset_)();
@@ -47,6 +51,42 @@ Model::~Model()
     delete pmaterial_;
 }
 
+void Model::attach_transform(TransformHierarchy& hierarchy, uint32_t parent)
+{
+    detach_transform();
+    hierarchy_ = &hierarchy;
+    transform_node_ = hierarchy.create(trans_, parent);
+    bbox_version_ = 0;
+}
+
+void Model::detach_transform()
+{
+    if(!hierarchy_)
+        return;
+    hierarchy_->destroy(transform_node_);
+    hierarchy_ = nullptr;
+    transform_node_ = TransformHierarchy::NONE;
+}
+
+void Model::refresh_bounding_boxes()
+{
+    // Without hierarchy, there is no way to tell whether the transformation changed
+    if(!hierarchy_)
+    {
+        obb_.update(trans_.get_model_matrix());
+        aabb_.update(obb_);
+        return;
+    }
+
+    const mat4& world = hierarchy_->get_world(transform_node_);
+    uint32_t version = hierarchy_->get_version(transform_node_);
+    if(version == bbox_version_)
+        return;
+    obb_.update(world);
+    aabb_.update(obb_);
+    bbox_version_ = version;
+}
+
 void Model::set_material(Material* material)
 {
     delete pmaterial_;
@@ -57,6 +97,7 @@ void Model::set_material(Material* material)
 void Model::set_mesh(std::shared_ptr<SurfaceMesh> pmesh)
 {
     pmesh_ = pmesh;
+    lod_ = 0;
     DLOGN("[Model] Swapped mesh.", "model");
 }
 
@@ -9,6 +9,7 @@
 #include "texture.h"
 #include "surface_mesh.h"
 #include "terrain_patch.h"
+#include "height_map.h"
 #include "model.h"
 #include "sky.h"
 #include "logger.h"
@@ -172,17 +173,24 @@ std::shared_ptr<TerrainChunk> ModelFactory::make_terrain_patch(const TerrainPatc
     {
         DLOGW("[ModelFactory] Incomplete material declaration.", "parsing");
         delete pmat;
+        delete desc.heightmap;
         return nullptr;
     }
 
-    HeightMap* heightmap = terrain_factory_->make_heightmap(desc);
+    // Height map may have been generated ahead of time by a streaming worker
+    HeightMap* heightmap = desc.heightmap ? desc.heightmap : terrain_factory_->make_heightmap(desc);
 
-    auto ret = std::make_shared<TerrainChunk>(
-        heightmap,
-        pmat,
-        desc.lattice_scale,
-        desc.texture_scale
-    );
+    // Mesh may have been baked along with the height map
+    std::shared_ptr<TerrainChunk> ret;
+    if(desc.mesh && desc.heightmap)
+        ret = std::make_shared<TerrainChunk>(heightmap, desc.mesh, pmat);
+    else
+        ret = std::make_shared<TerrainChunk>(
+            heightmap,
+            pmat,
+            desc.lattice_scale,
+            desc.texture_scale
+        );
 
     // Try to load splatmap
     // Splatmap name is like: splat_[map_name]_[chunk_x]_[chunk_z].png
@@ -227,6 +235,11 @@ std::shared_ptr<TerrainChunk> ModelFactory::make_terrain_patch(const TerrainPatc
     return ret;
 }
 
+HeightMap* ModelFactory::make_heightmap(const TerrainPatchDescriptor& desc)
+{
+    return terrain_factory_->make_heightmap(desc);
+}
+
 std::shared_ptr<SkyBox> ModelFactory::make_skybox(hash_t cubemap_name)
 {
     Cubemap* cmap = material_factory_->make_cubemap(cubemap_name);
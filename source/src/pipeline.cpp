@@ -12,6 +12,7 @@
 #include "debug_renderer.h"
 #include "debug_overlay_renderer.h"
 #include "shadow_map_renderer.h"
+#include "hiz_renderer.h"
 #include "gui_renderer.h"
 
 #include "geometry_common.h"
@@ -20,6 +21,11 @@
 #include "input_handler.h"
 #include "scene.h"
 #include "shader.h"
+#include "config.h"
+#include "frame_profiler.h"
+#include "gpu_query_timer.h"
+#include "buffer.h"
+#include "camera.h"
 
 #ifndef __DISABLE_EDITOR__
     #include "imgui/imgui.h"
@@ -27,15 +33,21 @@
     #include "editor_tweaks.h"
 #endif
 
-#ifdef __PROFILE__
-    #include "moving_average.h"
-    #include "gfx_api.h"
-    #define PROFILING_MAX_SAMPLES 1000
-#endif
-
 namespace wcore
 {
 
+// CPU side of the frame_data uniform block (frame_data.glsl), std140 layout
+struct FrameData
+{
+    math::mat4 view;
+    math::mat4 projection;
+    math::mat4 view_projection;
+    math::vec4 proj_params;
+    math::vec2 screen_size;
+    float padding[2];
+};
+static_assert(sizeof(FrameData) == 224, "FrameData must match std140 layout of frame_data block.");
+
 RenderPipeline::RenderPipeline()
 {
     GMODULES::REGISTER(std::make_unique<BufferModule>
@@ -127,8 +139,9 @@ RenderPipeline::RenderPipeline()
     GeometryCommon::Instance();
 
     geometry_renderer_        = new GeometryRenderer();
+    hiz_renderer_             = new HiZRenderer();
     shadow_map_renderer_      = new ShadowMapRenderer();
-    lighting_renderer_        = new LightingRenderer();
+    lighting_renderer_        = new LightingRenderer(*shadow_map_renderer_);
     forward_renderer_         = new ForwardRenderer();
     SSAO_renderer_            = new SSAORenderer();
     SSR_renderer_             = new SSRRenderer();
@@ -139,12 +152,21 @@ RenderPipeline::RenderPipeline()
     debug_overlay_renderer_   = new DebugOverlayRenderer(*text_renderer_);
     gui_renderer_             = new GuiRenderer();
 
+    frame_ubo_ = UniformBuffer::create(sizeof(FrameData));
+
+    // Shared ring buffer for per-frame dynamic data, triple buffered
+    uint32_t stream_buffer_kb = 4096;
+    CONFIG.get("root.render.stream_buffer.frame_size_kb"_h, stream_buffer_kb);
+    Gfx::stream_buffer.reset(StreamBuffer::create(stream_buffer_kb*1024, 3));
+
     DINFO.register_text_renderer(text_renderer_);
     text_renderer_->load_face("arial");
 }
 
 RenderPipeline::~RenderPipeline()
 {
+    Gfx::stream_buffer.reset();
+    delete frame_ubo_;
     delete gui_renderer_;
     delete debug_overlay_renderer_;
     delete debug_renderer_;
@@ -156,6 +178,7 @@ RenderPipeline::~RenderPipeline()
     delete forward_renderer_;
     delete lighting_renderer_;
     delete shadow_map_renderer_;
+    delete hiz_renderer_;
     delete geometry_renderer_;
 
     GeometryCommon::Kill();
@@ -296,10 +319,39 @@ bool RenderPipeline::onMouseEvent(const WData& data)
     return true; // Do NOT consume event
 }
 
+// Marker names of render passes
+static const char* PASS_GEOMETRY   = "Geometry pass";
+static const char* PASS_HIZ        = "Hi-Z";
+static const char* PASS_SSAO       = "SSAO";
+static const char* PASS_SSR        = "SSR";
+static const char* PASS_SHADOW     = "Shadow mapping";
+static const char* PASS_LIGHTING   = "Lighting pass";
+static const char* PASS_BLOOM      = "Bloom pass";
+static const char* PASS_FORWARD    = "Forward pass";
+static const char* PASS_POSTPROC   = "Post processing";
+static const char* PASS_DEBUG      = "Debug pass";
+static const char* PASS_OVERLAY    = "Debug overlay";
+static const char* PASS_TEXT       = "Text pass";
+
 #ifdef __PROFILE__
 static bool profile_renderers = false;
 static uint32_t frame_cnt = 0;
-static float last_render_time_ = 0.0f;
+
+static const std::vector<const char*> PROFILED_PASSES
+{
+    PASS_GEOMETRY, PASS_HIZ, PASS_SSAO, PASS_SSR, PASS_SHADOW, PASS_LIGHTING,
+    PASS_BLOOM, PASS_FORWARD, PASS_POSTPROC
+};
+
+#ifndef __DISABLE_EDITOR__
+static fs::path get_trace_path()
+{
+    fs::path log_path;
+    if(CONFIG.get<fs::path>("root.folders.log"_h, log_path))
+        return log_path / "trace.json";
+    return fs::path("trace.json");
+}
+#endif
 #endif
 
 #ifndef __DISABLE_EDITOR__
@@ -364,7 +416,8 @@ void RenderPipeline::generate_widget()
             if(ImGui::Button("Profile renderers"))
             {
                 profile_renderers = !profile_renderers;
-                Renderer::PROFILING_ACTIVE = profile_renderers;
+                if(profile_renderers)
+                    PROFILER.set_enabled(true);
             }
 #endif
             ImGui::TreePop();
@@ -375,7 +428,7 @@ void RenderPipeline::generate_widget()
     ImGui::SetNextTreeNodeOpen(false, ImGuiCond_Once);
     if(ImGui::CollapsingHeader("Pipeline control"))
     {
-        ImGui::BeginChild("##pipelinectl", ImVec2(0, 3*ImGui::GetItemsLineHeightWithSpacing()));
+        ImGui::BeginChild("##pipelinectl", ImVec2(0, 4*ImGui::GetItemsLineHeightWithSpacing()));
         ImGui::Columns(2, nullptr, false);
         ImGui::Checkbox("Lighting",       &lighting_renderer_->get_lighting_enabled_nc());
         ImGui::Checkbox("Shadow Mapping", &lighting_renderer_->get_shadow_enabled_nc());
@@ -383,6 +436,7 @@ void RenderPipeline::generate_widget()
         {
             lighting_renderer_->set_SSAO_enabled(SSAO_renderer_->is_enabled());
         }
+        ImGui::Checkbox("Tiled lights",   &lighting_renderer_->get_tiled_lighting_enabled_nc());
         ImGui::NextColumn();
         if(ImGui::Checkbox("SSR", &SSR_renderer_->get_enabled()))
         {
@@ -393,6 +447,13 @@ void RenderPipeline::generate_widget()
             post_processing_renderer_->set_bloom_enabled(bloom_renderer_->is_enabled());
         }
         ImGui::Checkbox("Forward pass", &forward_renderer_->get_enabled());
+        if(ImGui::Checkbox("Occlusion culling", &hiz_renderer_->get_enabled()))
+        {
+            Scene* pscene = locate<Scene>("Scene"_h);
+            pscene->set_occlusion_culling_enabled(hiz_renderer_->is_enabled());
+            pscene->get_occlusion_buffer().invalidate();
+        }
+        ImGui::SliderFloat("Occlusion max motion", &locate<Scene>("Scene"_h)->get_occlusion_max_motion_nc(), -1.0f, 10.0f);
         ImGui::EndChild();
 
         ImGui::Separator();
@@ -594,19 +655,23 @@ void RenderPipeline::generate_widget()
         ImGui::SetNextTreeNodeOpen(false, ImGuiCond_Once); // will segfault if set to true (!)
         if(ImGui::CollapsingHeader("Render time"))
         {
-            ImGui::PlotVar("Draw time", 1e3*last_render_time_, 0.0f, 16.66f);
-            ImGui::PlotVar("Geometry pass", 1e3*geometry_renderer_->last_dt(), 0.0f, 16.66f);
+            // GPU time of each pass, as recorded by the frame profiler
+            float draw_time = 0.f;
+            for(const char* pass: PROFILED_PASSES)
+                draw_time += PROFILER.get_last_duration(pass);
+            ImGui::PlotVar("Draw time", 1e3*draw_time, 0.0f, 16.66f);
+            ImGui::PlotVar(PASS_GEOMETRY, 1e3*PROFILER.get_last_duration(PASS_GEOMETRY), 0.0f, 16.66f);
             if(SSAO_renderer_->is_enabled())
-                ImGui::PlotVar("SSAO", 1e3*SSAO_renderer_->last_dt(), 0.0f, 16.66f);
+                ImGui::PlotVar(PASS_SSAO, 1e3*PROFILER.get_last_duration(PASS_SSAO), 0.0f, 16.66f);
             if(SSR_renderer_->is_enabled())
-                ImGui::PlotVar("SSR", 1e3*SSR_renderer_->last_dt(), 0.0f, 16.66f);
+                ImGui::PlotVar(PASS_SSR, 1e3*PROFILER.get_last_duration(PASS_SSR), 0.0f, 16.66f);
             if(shadow_map_renderer_->is_enabled())
-                ImGui::PlotVar("Shadow mapping", 1e3*shadow_map_renderer_->last_dt(), 0.0f, 16.66f);
-            ImGui::PlotVar("Lighting pass", 1e3*lighting_renderer_->last_dt(), 0.0f, 16.66f);
-            ImGui::PlotVar("Forward pass", 1e3*forward_renderer_->last_dt(), 0.0f, 16.66f);
+                ImGui::PlotVar(PASS_SHADOW, 1e3*PROFILER.get_last_duration(PASS_SHADOW), 0.0f, 16.66f);
+            ImGui::PlotVar(PASS_LIGHTING, 1e3*PROFILER.get_last_duration(PASS_LIGHTING), 0.0f, 16.66f);
+            ImGui::PlotVar(PASS_FORWARD, 1e3*PROFILER.get_last_duration(PASS_FORWARD), 0.0f, 16.66f);
             if(bloom_renderer_->is_enabled())
-                ImGui::PlotVar("Bloom pass", 1e3*bloom_renderer_->last_dt(), 0.0f, 16.66f);
-            ImGui::PlotVar("Post processing", 1e3*post_processing_renderer_->last_dt(), 0.0f, 16.66f);
+                ImGui::PlotVar(PASS_BLOOM, 1e3*PROFILER.get_last_duration(PASS_BLOOM), 0.0f, 16.66f);
+            ImGui::PlotVar(PASS_POSTPROC, 1e3*PROFILER.get_last_duration(PASS_POSTPROC), 0.0f, 16.66f);
 
             if(++frame_cnt>200)
             {
@@ -614,6 +679,14 @@ void RenderPipeline::generate_widget()
                 ImGui::PlotVarFlushOldEntries();
             }
         }
+
+        ImGui::SetNextTreeNodeOpen(false, ImGuiCond_Once);
+        if(ImGui::CollapsingHeader("Frame markers"))
+        {
+            if(ImGui::Button("Export trace"))
+                PROFILER.export_chrome_trace(get_trace_path());
+            PROFILER.generate_widget();
+        }
         ImGui::End();
     }
 #endif
@@ -637,31 +710,58 @@ void RenderPipeline::render()
     }
 #endif
 
-    geometry_renderer_->Render(pscene);
-    SSAO_renderer_->Render(pscene);
-    SSR_renderer_->Render(pscene);
-    shadow_map_renderer_->Render(pscene);
-    lighting_renderer_->Render(pscene);
-    bloom_renderer_->Render(pscene);
-    forward_renderer_->Render(pscene);
-    post_processing_renderer_->Render(pscene);
-    debug_renderer_->Render(pscene);
-    debug_overlay_renderer_->Render(pscene);
-    text_renderer_->Render(pscene);
+    update_frame_data(pscene);
+
+    render_pass(*geometry_renderer_, pscene, PASS_GEOMETRY);
+    render_pass(*hiz_renderer_, pscene, PASS_HIZ);
+    render_pass(*SSAO_renderer_, pscene, PASS_SSAO);
+    render_pass(*SSR_renderer_, pscene, PASS_SSR);
+    render_pass(*shadow_map_renderer_, pscene, PASS_SHADOW);
+    render_pass(*lighting_renderer_, pscene, PASS_LIGHTING);
+    render_pass(*bloom_renderer_, pscene, PASS_BLOOM);
+    render_pass(*forward_renderer_, pscene, PASS_FORWARD);
+    render_pass(*post_processing_renderer_, pscene, PASS_POSTPROC);
+    render_pass(*debug_renderer_, pscene, PASS_DEBUG);
+    render_pass(*debug_overlay_renderer_, pscene, PASS_OVERLAY);
+    render_pass(*text_renderer_, pscene, PASS_TEXT);
+
+    // All draw calls reading this frame's dynamic data were submitted
+    if(Gfx::stream_buffer)
+        Gfx::stream_buffer->next_frame();
+}
 
-#ifdef __PROFILE__
-    if(profile_renderers)
+void RenderPipeline::update_frame_data(Scene* pscene)
+{
+    const Camera& camera = pscene->get_camera();
+    const math::mat4& P = camera.get_projection_matrix();
+
+    FrameData data;
+    data.view            = camera.get_view_matrix();
+    data.projection      = P;
+    data.view_projection = P*data.view;
+    data.proj_params     = math::vec4(1.0f/P(0,0), 1.0f/P(1,1), P(2,2)-1.0f, P(2,3));
+    data.screen_size     = math::vec2(GLB.WIN_W, GLB.WIN_H);
+
+    // Uniform buffer offsets must be aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, at most 256
+    std::size_t offset = StreamBuffer::INVALID_OFFSET;
+    if(Gfx::stream_buffer)
+        offset = Gfx::stream_buffer->write(&data, sizeof(FrameData), 256);
+    if(offset != StreamBuffer::INVALID_OFFSET)
+        Gfx::stream_buffer->bind_uniform(uint32_t(UniformBlock::FRAME), offset, sizeof(FrameData));
+    else
     {
-        last_render_time_ = geometry_renderer_->last_dt()
-                          + SSAO_renderer_->last_dt()
-                          + SSR_renderer_->last_dt()
-                          + shadow_map_renderer_->last_dt()
-                          + lighting_renderer_->last_dt()
-                          + bloom_renderer_->last_dt()
-                          + forward_renderer_->last_dt()
-                          + post_processing_renderer_->last_dt();
+        frame_ubo_->stream(&data, sizeof(FrameData));
+        frame_ubo_->bind(uint32_t(UniformBlock::FRAME));
     }
-#endif
+}
+
+void RenderPipeline::render_pass(Renderer& renderer, Scene* pscene, const char* name)
+{
+    if(!renderer.is_enabled())
+        return;
+
+    W_PROFILE_GPU_SCOPE(name);
+    renderer.Render(pscene);
 }
 
 void RenderPipeline::render_gui()
@@ -676,29 +776,12 @@ void RenderPipeline::dbg_show_statistics()
     #ifdef __PROFILE__
     if(profile_renderers)
     {
-        FinalStatistics geom_stats = geometry_renderer_->get_stats();
-        FinalStatistics SSAO_stats = SSAO_renderer_->get_stats();
-        FinalStatistics shadow_stats = shadow_map_renderer_->get_stats();
-        FinalStatistics lighting_stats = lighting_renderer_->get_stats();
-        FinalStatistics forward_stats = forward_renderer_->get_stats();
-        FinalStatistics bloom_stats = bloom_renderer_->get_stats();
-        FinalStatistics pp_stats = post_processing_renderer_->get_stats();
-        uint32_t n_iter = geom_stats.npoints;
-
-        DLOGN("Geometry pass statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
-        geom_stats.debug_print(1e6, "µs", "profile");
-        DLOGN("SSAO pass statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
-        SSAO_stats.debug_print(1e6, "µs", "profile");
-        DLOGN("Shadow pass statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
-        shadow_stats.debug_print(1e6, "µs", "profile");
-        DLOGN("Lighting pass statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
-        lighting_stats.debug_print(1e6, "µs", "profile");
-        DLOGN("Forward pass statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
-        forward_stats.debug_print(1e6, "µs", "profile");
-        DLOGN("Bloom pass statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
-        bloom_stats.debug_print(1e6, "µs", "profile");
-        DLOGN("Post-processing pass statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
-        pp_stats.debug_print(1e6, "µs", "profile");
+        uint32_t n_iter = PROFILER.get_frame_count();
+        for(const char* pass: PROFILED_PASSES)
+        {
+            DLOGN(std::string(pass) + " statistics (over <z>" + std::to_string(n_iter) + "</z> points): ", "profile");
+            PROFILER.get_stats(pass).debug_print(1e6, "µs", "profile");
+        }
     }
     #endif
 }
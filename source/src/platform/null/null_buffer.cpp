@@ -0,0 +1,250 @@
+#include <cstring>
+
+#include "platform/null/null_buffer.h"
+#include "platform/null/null_renderer_api.h"
+#include "logger.h"
+
+namespace wcore
+{
+
+NullVertexBuffer::NullVertexBuffer(float* vertex_data, std::size_t size, bool dynamic):
+rd_handle_(null_device().create_handle())
+{
+    if(vertex_data)
+        null_device().upload(size);
+
+    DLOGI("Null VBO created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+NullVertexBuffer::~NullVertexBuffer()
+{
+    DLOGI("Null VBO destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+void NullVertexBuffer::bind() const
+{
+    null_device().set_state(NullState::VertexBuffer, rd_handle_);
+}
+
+void NullVertexBuffer::unbind() const
+{
+    null_device().set_state(NullState::VertexBuffer, 0);
+}
+
+void NullVertexBuffer::stream(float* vertex_data, std::size_t size, std::size_t offset) const
+{
+    bind();
+    null_device().upload(size);
+}
+
+
+
+NullIndexBuffer::NullIndexBuffer(uint32_t* index_data, std::size_t size, bool dynamic):
+rd_handle_(null_device().create_handle())
+{
+    if(index_data)
+        null_device().upload(size);
+
+    DLOGI("Null IBO created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+NullIndexBuffer::~NullIndexBuffer()
+{
+    DLOGI("Null IBO destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+void NullIndexBuffer::bind() const
+{
+    null_device().set_state(NullState::IndexBuffer, rd_handle_);
+}
+
+void NullIndexBuffer::unbind() const
+{
+    null_device().set_state(NullState::IndexBuffer, 0);
+}
+
+void NullIndexBuffer::stream(uint32_t* index_data, std::size_t size, std::size_t offset) const
+{
+    bind();
+    null_device().upload(size);
+}
+
+
+
+NullTextureBuffer::NullTextureBuffer(TextureBufferFormat format, std::size_t size):
+texture_handle_(null_device().create_handle())
+{
+    DLOGI("Null TBO created. id=" + std::to_string(texture_handle_), "batch");
+}
+
+NullTextureBuffer::~NullTextureBuffer()
+{
+    DLOGI("Null TBO destroyed. id=" + std::to_string(texture_handle_), "batch");
+}
+
+void NullTextureBuffer::bind(uint32_t unit) const
+{
+    null_device().bind_texture2D(unit, texture_handle_);
+}
+
+void NullTextureBuffer::unbind() const
+{
+    null_device().unbind_texture2D();
+}
+
+void NullTextureBuffer::stream(const void* data, std::size_t size)
+{
+    if(size)
+        null_device().upload(size);
+}
+
+bool NullTextureBuffer::set_source(const StreamBuffer& buffer, std::size_t offset, std::size_t size)
+{
+    // Upload was counted by the stream buffer write
+    return true;
+}
+
+
+
+NullUniformBuffer::NullUniformBuffer(std::size_t size, bool dynamic):
+rd_handle_(null_device().create_handle())
+{
+    DLOGI("Null UBO created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+NullUniformBuffer::~NullUniformBuffer()
+{
+    DLOGI("Null UBO destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+void NullUniformBuffer::bind(uint32_t binding) const
+{
+    null_device().set_state(NullState::UniformBuffer, binding, rd_handle_);
+}
+
+void NullUniformBuffer::stream(const void* data, std::size_t size, std::size_t offset) const
+{
+    null_device().upload(size);
+}
+
+
+
+NullStreamBuffer::NullStreamBuffer(std::size_t frame_size, uint32_t n_frames):
+rd_handle_(null_device().create_handle()),
+frame_size_(frame_size),
+n_frames_(n_frames),
+frame_(0),
+head_(0),
+data_(frame_size*n_frames)
+{
+    DLOGI("Null stream buffer created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+NullStreamBuffer::~NullStreamBuffer()
+{
+    DLOGI("Null stream buffer destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+std::size_t NullStreamBuffer::write(const void* data, std::size_t size, std::size_t alignment)
+{
+    std::size_t aligned = ((head_+alignment-1)/alignment)*alignment;
+    if(size==0 || aligned+size > frame_size_)
+        return INVALID_OFFSET;
+
+    std::size_t offset = frame_*frame_size_ + aligned;
+    std::memcpy(data_.data()+offset, data, size);
+    null_device().upload(size);
+
+    head_ = aligned+size;
+    return offset;
+}
+
+void NullStreamBuffer::next_frame()
+{
+    frame_ = (frame_+1) % n_frames_;
+    head_ = 0;
+}
+
+void NullStreamBuffer::bind_vertex() const
+{
+    null_device().set_state(NullState::VertexBuffer, rd_handle_);
+}
+
+void NullStreamBuffer::unbind_vertex() const
+{
+    null_device().set_state(NullState::VertexBuffer, 0);
+}
+
+void NullStreamBuffer::bind_uniform(uint32_t binding, std::size_t offset, std::size_t size) const
+{
+    null_device().set_state(NullState::UniformBuffer, binding, rd_handle_, uint32_t(offset), uint32_t(size));
+}
+
+
+
+NullReadbackBuffer::NullReadbackBuffer(std::size_t size)
+{
+
+}
+
+NullReadbackBuffer::~NullReadbackBuffer()
+{
+
+}
+
+void NullReadbackBuffer::read(uint32_t width, uint32_t height)
+{
+    null_device().record({GfxCommandType::ReadPixels, width, height, 0});
+}
+
+bool NullReadbackBuffer::is_ready() const
+{
+    return false;
+}
+
+const float* NullReadbackBuffer::map()
+{
+    return nullptr;
+}
+
+void NullReadbackBuffer::unmap()
+{
+
+}
+
+
+
+NullVertexArray::NullVertexArray():
+rd_handle_(null_device().create_handle())
+{
+    DLOGI("Null VAO created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+NullVertexArray::~NullVertexArray()
+{
+    DLOGI("Null VAO destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+void NullVertexArray::bind() const
+{
+    null_device().set_state(NullState::VertexArray, rd_handle_);
+}
+
+void NullVertexArray::unbind() const
+{
+    null_device().set_state(NullState::VertexArray, 0);
+}
+
+// Vertex attribute layout is set once at creation, it is not tracked
+void NullVertexArray::set_layout(const BufferLayout& layout) const
+{
+
+}
+
+// Instance attributes are re-pointed before each instanced draw call
+void NullVertexArray::set_instance_layout(const BufferLayout& layout, uint32_t first_location, std::size_t offset) const
+{
+    null_device().set_state(NullState::InstanceLayout, rd_handle_, first_location, uint32_t(offset));
+}
+
+} // namespace wcore
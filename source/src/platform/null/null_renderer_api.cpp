@@ -0,0 +1,316 @@
+#include <cstring>
+#include <sstream>
+
+#include "platform/null/null_renderer_api.h"
+#include "logger.h"
+
+namespace wcore
+{
+
+void GfxStats::accumulate(const GfxStats& other)
+{
+    draw_calls        += other.draw_calls;
+    instances         += other.instances;
+    elements          += other.elements;
+    clears            += other.clears;
+    state_changes     += other.state_changes;
+    redundant_states  += other.redundant_states;
+    program_binds     += other.program_binds;
+    texture_binds     += other.texture_binds;
+    framebuffer_binds += other.framebuffer_binds;
+    uploads           += other.uploads;
+    bytes_uploaded    += other.bytes_uploaded;
+    frames            += other.frames;
+}
+
+NullRenderDevice::NullRenderDevice():
+default_framebuffer_(0),
+last_handle_(0),
+recording_(true)
+{
+    state_set_.fill(false);
+}
+
+NullRenderDevice::~NullRenderDevice()
+{
+
+}
+
+void NullRenderDevice::set_state(NullState state, uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3)
+{
+    auto& current = state_[size_t(state)];
+    if(state_set_[size_t(state)] && current[0] == v0 && current[1] == v1 && current[2] == v2 && current[3] == v3)
+    {
+        ++frame_stats_.redundant_states;
+        return;
+    }
+
+    current = {v0, v1, v2, v3};
+    state_set_[size_t(state)] = true;
+    ++frame_stats_.state_changes;
+    if(state == NullState::Program)
+        ++frame_stats_.program_binds;
+    else if(state == NullState::Framebuffer)
+        ++frame_stats_.framebuffer_binds;
+
+    if(recording_)
+        commands_.push_back({GfxCommandType::SetState, uint32_t(state), v0, v1});
+}
+
+void NullRenderDevice::bind_texture_unit(uint32_t unit, uint32_t handle)
+{
+    if(unit >= texture_units_.size())
+        texture_units_.resize(unit+1, 0);
+    if(texture_units_[unit] == handle)
+    {
+        ++frame_stats_.redundant_states;
+        return;
+    }
+
+    texture_units_[unit] = handle;
+    ++frame_stats_.state_changes;
+    ++frame_stats_.texture_binds;
+
+    if(recording_)
+        commands_.push_back({GfxCommandType::BindTexture, unit, handle, 0});
+}
+
+void NullRenderDevice::upload(std::size_t size)
+{
+    ++frame_stats_.uploads;
+    frame_stats_.bytes_uploaded += size;
+
+    if(recording_)
+        commands_.push_back({GfxCommandType::Upload, uint32_t(size), 0, 0});
+}
+
+void NullRenderDevice::record(const GfxCommand& command)
+{
+    if(recording_)
+        commands_.push_back(command);
+}
+
+void NullRenderDevice::end_frame()
+{
+    frame_stats_.frames = 1;
+    total_stats_.accumulate(frame_stats_);
+    last_frame_stats_ = frame_stats_;
+    frame_stats_ = GfxStats();
+
+    // Keep capacity, a frame usually issues as many commands as the previous one
+    std::swap(commands_, last_commands_);
+    commands_.clear();
+}
+
+void NullRenderDevice::reset_stats()
+{
+    frame_stats_ = GfxStats();
+    last_frame_stats_ = GfxStats();
+    total_stats_ = GfxStats();
+    commands_.clear();
+    last_commands_.clear();
+}
+
+#ifdef __DEBUG__
+void NullRenderDevice::dbg_show_statistics() const
+{
+    if(total_stats_.frames == 0)
+        return;
+
+    float n_frames = float(total_stats_.frames);
+    DLOGN("[NullRenderDevice] Statistics over <v>" + std::to_string(total_stats_.frames) + "</v> frames (mean per frame):", "profile");
+    DLOGI("Draw calls:     <v>" + std::to_string(total_stats_.draw_calls/n_frames) + "</v>", "profile");
+    DLOGI("Instances:      <v>" + std::to_string(total_stats_.instances/n_frames) + "</v>", "profile");
+    DLOGI("Primitives:     <v>" + std::to_string(total_stats_.elements/n_frames) + "</v>", "profile");
+    DLOGI("State changes:  <v>" + std::to_string(total_stats_.state_changes/n_frames) + "</v> (<v>"
+        + std::to_string(total_stats_.redundant_states/n_frames) + "</v> redundant)", "profile");
+    DLOGI("Program binds:  <v>" + std::to_string(total_stats_.program_binds/n_frames) + "</v>", "profile");
+    DLOGI("Texture binds:  <v>" + std::to_string(total_stats_.texture_binds/n_frames) + "</v>", "profile");
+    DLOGI("FBO binds:      <v>" + std::to_string(total_stats_.framebuffer_binds/n_frames) + "</v>", "profile");
+    DLOGI("Uploads:        <v>" + std::to_string(total_stats_.uploads/n_frames) + "</v>", "profile");
+    DLOGI("Bytes uploaded: <v>" + std::to_string(total_stats_.bytes_uploaded/n_frames) + "</v>", "profile");
+}
+#endif
+
+uint32_t NullRenderDevice::get_default_framebuffer()
+{
+    return default_framebuffer_;
+}
+
+void NullRenderDevice::set_default_framebuffer(uint32_t index)
+{
+    default_framebuffer_ = index;
+}
+
+void NullRenderDevice::bind_default_frame_buffer()
+{
+    set_state(NullState::Framebuffer, default_framebuffer_);
+}
+
+void NullRenderDevice::bind_framebuffer(uint32_t handle)
+{
+    set_state(NullState::Framebuffer, handle);
+}
+
+void NullRenderDevice::read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels)
+{
+    std::memset(pixels, 0, 4*width*height);
+    record({GfxCommandType::ReadPixels, width, height, 0});
+}
+
+void NullRenderDevice::draw_indexed(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset)
+{
+    ++frame_stats_.draw_calls;
+    ++frame_stats_.instances;
+    frame_stats_.elements += n_elements;
+    record({GfxCommandType::Draw, uint32_t(primitive), n_elements, offset});
+}
+
+void NullRenderDevice::draw_indexed_instanced(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset, uint32_t n_instances)
+{
+    ++frame_stats_.draw_calls;
+    frame_stats_.instances += n_instances;
+    frame_stats_.elements += uint64_t(n_elements)*n_instances;
+    record({GfxCommandType::DrawInstanced, uint32_t(primitive), n_elements, n_instances});
+}
+
+static inline uint32_t float_bits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    return bits;
+}
+
+void NullRenderDevice::set_clear_color(float r, float g, float b, float a)
+{
+    set_state(NullState::ClearColor, float_bits(r), float_bits(g), float_bits(b), float_bits(a));
+}
+
+void NullRenderDevice::clear(int flags)
+{
+    ++frame_stats_.clears;
+    record({GfxCommandType::Clear, uint32_t(flags), 0, 0});
+}
+
+void NullRenderDevice::lock_color_buffer()
+{
+    set_state(NullState::ColorLock, 1);
+}
+
+void NullRenderDevice::set_depth_lock(bool value)
+{
+    set_state(NullState::DepthLock, value);
+}
+
+void NullRenderDevice::set_stencil_lock(bool value)
+{
+    set_state(NullState::StencilLock, value);
+}
+
+void NullRenderDevice::set_depth_func(DepthFunc value)
+{
+    set_state(NullState::DepthFunc, uint32_t(value));
+}
+
+void NullRenderDevice::set_depth_test_enabled(bool value)
+{
+    set_state(NullState::DepthTest, value);
+}
+
+void NullRenderDevice::set_stencil_func(StencilFunc value, uint16_t a, uint16_t b)
+{
+    set_state(NullState::StencilFunc, uint32_t(value), a, b);
+}
+
+void NullRenderDevice::set_stencil_operator(StencilOperator value)
+{
+    set_state(NullState::StencilOperator, uint32_t(value));
+}
+
+void NullRenderDevice::set_stencil_test_enabled(bool value)
+{
+    set_state(NullState::StencilTest, value);
+}
+
+// Blending state values: 0 disabled, 1 standard, 2 additive (light)
+void NullRenderDevice::set_std_blending()
+{
+    set_state(NullState::Blending, 1);
+}
+
+void NullRenderDevice::set_light_blending()
+{
+    set_state(NullState::Blending, 2);
+}
+
+void NullRenderDevice::disable_blending()
+{
+    set_state(NullState::Blending, 0);
+}
+
+void NullRenderDevice::set_pack_alignment(uint32_t value)
+{
+    set_state(NullState::PackAlignment, value);
+}
+
+void NullRenderDevice::set_unpack_alignment(uint32_t value)
+{
+    set_state(NullState::UnpackAlignment, value);
+}
+
+void NullRenderDevice::viewport(float xx, float yy, float width, float height)
+{
+    set_state(NullState::Viewport, float_bits(xx), float_bits(yy), float_bits(width), float_bits(height));
+}
+
+void NullRenderDevice::set_scissor(int32_t xx, int32_t yy, int32_t width, int32_t height)
+{
+    set_state(NullState::Scissor, uint32_t(xx), uint32_t(yy), uint32_t(width), uint32_t(height));
+}
+
+void NullRenderDevice::set_scissor_test_enabled(bool value)
+{
+    set_state(NullState::ScissorTest, value);
+}
+
+void NullRenderDevice::set_cull_mode(CullMode value)
+{
+    set_state(NullState::CullMode, uint32_t(value));
+}
+
+void NullRenderDevice::set_line_width(float value)
+{
+    set_state(NullState::LineWidth, float_bits(value));
+}
+
+void NullRenderDevice::finish()
+{
+
+}
+
+void NullRenderDevice::flush()
+{
+
+}
+
+uint32_t NullRenderDevice::get_error()
+{
+    return 0;
+}
+
+void NullRenderDevice::assert_no_error()
+{
+
+}
+
+void NullRenderDevice::bind_texture2D(uint32_t unit, uint32_t tex_handle)
+{
+    bind_texture_unit(unit, tex_handle);
+}
+
+void NullRenderDevice::unbind_texture2D()
+{
+    bind_texture_unit(0, 0);
+}
+
+} // namespace wcore
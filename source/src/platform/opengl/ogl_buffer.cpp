@@ -1,4 +1,6 @@
 #include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
 #include <ctti/type_id.hpp>
 
 #include "platform/opengl/ogl_buffer.h"
@@ -87,6 +89,304 @@ void OGLIndexBuffer::stream(uint32_t* index_data, std::size_t size, std::size_t
 
 
 
+static GLenum texture_buffer_format_to_ogl(TextureBufferFormat format)
+{
+    switch(format)
+    {
+        case TextureBufferFormat::R32UI:   return GL_R32UI;
+        case TextureBufferFormat::RG32UI:  return GL_RG32UI;
+        case TextureBufferFormat::RGBA32F: return GL_RGBA32F;
+    }
+
+    DLOGF("Unknown TextureBufferFormat", "batch");
+    return 0;
+}
+
+OGLTextureBuffer::OGLTextureBuffer(TextureBufferFormat format, std::size_t size):
+rd_handle_(0),
+texture_handle_(0),
+internal_format_(texture_buffer_format_to_ogl(format)),
+capacity_(size),
+external_source_(false)
+{
+    glGenBuffers(1, &rd_handle_);
+    glBindBuffer(GL_TEXTURE_BUFFER, rd_handle_);
+    glBufferData(GL_TEXTURE_BUFFER, capacity_, nullptr, GL_STREAM_DRAW);
+
+    // Buffer texture view of the buffer store
+    glGenTextures(1, &texture_handle_);
+    glBindTexture(GL_TEXTURE_BUFFER, texture_handle_);
+    glTexBuffer(GL_TEXTURE_BUFFER, internal_format_, rd_handle_);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    DLOGI("OpenGL TBO created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+OGLTextureBuffer::~OGLTextureBuffer()
+{
+    glDeleteTextures(1, &texture_handle_);
+    glDeleteBuffers(1, &rd_handle_);
+
+    DLOGI("OpenGL TBO destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+void OGLTextureBuffer::bind(uint32_t unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture_handle_);
+}
+
+void OGLTextureBuffer::unbind() const
+{
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void OGLTextureBuffer::stream(const void* data, std::size_t size)
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, rd_handle_);
+    if(size > capacity_)
+        capacity_ = std::max(size, 2*capacity_);
+    // Orphan previous store so that we don't wait for draw calls still reading it.
+    // The buffer texture follows the new data store.
+    glBufferData(GL_TEXTURE_BUFFER, capacity_, nullptr, GL_STREAM_DRAW);
+    if(size)
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    // Texture was sampling a stream buffer range, get back to own store
+    if(external_source_)
+    {
+        glBindTexture(GL_TEXTURE_BUFFER, texture_handle_);
+        glTexBuffer(GL_TEXTURE_BUFFER, internal_format_, rd_handle_);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        external_source_ = false;
+    }
+}
+
+bool OGLTextureBuffer::set_source(const StreamBuffer& buffer, std::size_t offset, std::size_t size)
+{
+    if(!GLEW_ARB_texture_buffer_range)
+        return false;
+
+    // Offset alignment (GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT) is at most 256
+    glBindTexture(GL_TEXTURE_BUFFER, texture_handle_);
+    glTexBufferRange(GL_TEXTURE_BUFFER, internal_format_, static_cast<const OGLStreamBuffer&>(buffer).get_handle(),
+                     (GLintptr)offset, (GLsizeiptr)size);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    external_source_ = true;
+    return true;
+}
+
+
+
+
+OGLUniformBuffer::OGLUniformBuffer(std::size_t size, bool dynamic):
+rd_handle_(0)
+{
+    GLenum draw_type = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+
+    glGenBuffers(1, &rd_handle_);
+    glBindBuffer(GL_UNIFORM_BUFFER, rd_handle_);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, draw_type);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    DLOGI("OpenGL UBO created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+OGLUniformBuffer::~OGLUniformBuffer()
+{
+    glDeleteBuffers(1, &rd_handle_);
+
+    DLOGI("OpenGL UBO destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+void OGLUniformBuffer::bind(uint32_t binding) const
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, rd_handle_);
+}
+
+void OGLUniformBuffer::stream(const void* data, std::size_t size, std::size_t offset) const
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, rd_handle_);
+    glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+
+
+OGLStreamBuffer::OGLStreamBuffer(std::size_t frame_size, uint32_t n_frames):
+rd_handle_(0),
+frame_size_(frame_size),
+n_frames_(n_frames),
+frame_(0),
+head_(0),
+mapped_(nullptr),
+fences_(n_frames, nullptr)
+{
+    std::size_t total_size = frame_size_*n_frames_;
+
+    glGenBuffers(1, &rd_handle_);
+    glBindBuffer(GL_ARRAY_BUFFER, rd_handle_);
+    if(GLEW_ARB_buffer_storage)
+    {
+        // Immutable storage, mapped once for the lifetime of the buffer
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, total_size, nullptr, flags);
+        mapped_ = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, total_size, flags));
+    }
+    else
+        glBufferData(GL_ARRAY_BUFFER, total_size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    DLOGI("OpenGL stream buffer created. id=" + std::to_string(rd_handle_)
+        + (mapped_ ? " (persistent)" : " (unsynchronized maps)"), "batch");
+}
+
+OGLStreamBuffer::~OGLStreamBuffer()
+{
+    for(void* fence: fences_)
+        if(fence)
+            glDeleteSync(static_cast<GLsync>(fence));
+    if(mapped_)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, rd_handle_);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &rd_handle_);
+
+    DLOGI("OpenGL stream buffer destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+std::size_t OGLStreamBuffer::write(const void* data, std::size_t size, std::size_t alignment)
+{
+    std::size_t aligned = ((head_+alignment-1)/alignment)*alignment;
+    if(size==0 || aligned+size > frame_size_)
+        return INVALID_OFFSET;
+
+    std::size_t offset = frame_*frame_size_ + aligned;
+    if(mapped_)
+        std::memcpy(mapped_+offset, data, size);
+    else
+    {
+        // The region is not read by the GPU anymore (fenced), no need to synchronize
+        glBindBuffer(GL_ARRAY_BUFFER, rd_handle_);
+        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if(ptr)
+        {
+            std::memcpy(ptr, data, size);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if(!ptr)
+            return INVALID_OFFSET;
+    }
+
+    head_ = aligned+size;
+    return offset;
+}
+
+void OGLStreamBuffer::next_frame()
+{
+    // Fence region of this frame, then move to the oldest region
+    fences_[frame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame_ = (frame_+1) % n_frames_;
+    head_ = 0;
+
+    // The GPU is normally done with it since n_frames-1 frames, this seldom waits
+    if(fences_[frame_])
+    {
+        GLsync fence = static_cast<GLsync>(fences_[frame_]);
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            DLOGW("[StreamBuffer] Waiting for GPU to release region " + std::to_string(frame_), "batch");
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        glDeleteSync(fence);
+        fences_[frame_] = nullptr;
+    }
+}
+
+void OGLStreamBuffer::bind_vertex() const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, rd_handle_);
+}
+
+void OGLStreamBuffer::unbind_vertex() const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OGLStreamBuffer::bind_uniform(uint32_t binding, std::size_t offset, std::size_t size) const
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, rd_handle_, (GLintptr)offset, (GLsizeiptr)size);
+}
+
+
+
+
+OGLReadbackBuffer::OGLReadbackBuffer(std::size_t size):
+rd_handle_(0),
+fence_(nullptr)
+{
+    glGenBuffers(1, &rd_handle_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rd_handle_);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    DLOGI("OpenGL PBO created. id=" + std::to_string(rd_handle_), "batch");
+}
+
+OGLReadbackBuffer::~OGLReadbackBuffer()
+{
+    if(fence_)
+        glDeleteSync(static_cast<GLsync>(fence_));
+    glDeleteBuffers(1, &rd_handle_);
+
+    DLOGI("OpenGL PBO destroyed. id=" + std::to_string(rd_handle_), "batch");
+}
+
+void OGLReadbackBuffer::read(uint32_t width, uint32_t height)
+{
+    // With a pack buffer bound, glReadPixels returns immediately
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rd_handle_);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if(fence_)
+        glDeleteSync(static_cast<GLsync>(fence_));
+    fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool OGLReadbackBuffer::is_ready() const
+{
+    if(!fence_)
+        return false;
+    // Zero timeout: only poll
+    GLenum status = glClientWaitSync(static_cast<GLsync>(fence_), 0, 0);
+    return (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED);
+}
+
+const float* OGLReadbackBuffer::map()
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rd_handle_);
+    return static_cast<const float*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+}
+
+void OGLReadbackBuffer::unmap()
+{
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glDeleteSync(static_cast<GLsync>(fence_));
+    fence_ = nullptr;
+}
+
 OGLVertexArray::OGLVertexArray()
 {
     glGenVertexArrays(1, &rd_handle_);
@@ -145,5 +445,31 @@ void OGLVertexArray::set_layout(const BufferLayout& layout) const
     }
 }
 
+void OGLVertexArray::set_instance_layout(const BufferLayout& layout, uint32_t first_location, std::size_t offset) const
+{
+    uint32_t index = first_location;
+    for(const auto& element: layout)
+    {
+        // Matrices occupy one attribute location per column
+        uint32_t n_columns = 1;
+        if(element.type == ShaderDataType::Mat3)      n_columns = 3;
+        else if(element.type == ShaderDataType::Mat4) n_columns = 4;
+        uint32_t n_components = element.get_component_count()/n_columns;
+
+        for(uint32_t cc=0; cc<n_columns; ++cc)
+        {
+            glEnableVertexAttribArray(index);
+            glVertexAttribPointer(index,
+                                  n_components,
+                                  shader_data_type_to_ogl_base_type(element.type),
+                                  element.normalized ? GL_TRUE : GL_FALSE,
+                                  layout.get_stride(),
+                                  (const void*)(uint64_t)(offset + element.offset + cc*n_components*sizeof(float)));
+            glVertexAttribDivisor(index, 1);
+            ++index;
+        }
+    }
+}
+
 
 } // namespace wcore
@@ -34,6 +34,19 @@ void OGLRenderDevice::viewport(float xx, float yy, float width, float height)
     glViewport(xx, yy, width, height);
 }
 
+void OGLRenderDevice::set_scissor(int32_t xx, int32_t yy, int32_t width, int32_t height)
+{
+    glScissor(xx, yy, width, height);
+}
+
+void OGLRenderDevice::set_scissor_test_enabled(bool value)
+{
+    if(value)
+        glEnable(GL_SCISSOR_TEST);
+    else
+        glDisable(GL_SCISSOR_TEST);
+}
+
 uint32_t OGLRenderDevice::get_default_framebuffer()
 {
     return default_framebuffer_;
@@ -49,6 +62,11 @@ void OGLRenderDevice::bind_default_frame_buffer()
     glBindFramebuffer(GL_FRAMEBUFFER, default_framebuffer_);
 }
 
+void OGLRenderDevice::bind_framebuffer(uint32_t handle)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, handle);
+}
+
 
 void OGLRenderDevice::draw_indexed(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset)
 {
@@ -58,6 +76,15 @@ void OGLRenderDevice::draw_indexed(DrawPrimitive primitive, uint32_t n_elements,
                    (void*)(offset * sizeof(GLuint)));
 }
 
+void OGLRenderDevice::draw_indexed_instanced(DrawPrimitive primitive, uint32_t n_elements, uint32_t offset, uint32_t n_instances)
+{
+    glDrawElementsInstanced(OGLPrimitive[primitive],
+                            uint32_t(primitive)*n_elements,
+                            GL_UNSIGNED_INT,
+                            (void*)(offset * sizeof(GLuint)),
+                            n_instances);
+}
+
 void OGLRenderDevice::read_framebuffer_rgba(uint32_t width, uint32_t height, unsigned char* pixels)
 {
     set_pack_alignment(1);
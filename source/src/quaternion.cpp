@@ -4,6 +4,10 @@
 #include "quaternion.h"
 #include "math3d.h"
 
+#ifdef __SSE__
+    #include <xmmintrin.h>
+#endif
+
 namespace wcore
 {
 namespace math
@@ -200,6 +204,27 @@ Quaternion operator-(const Quaternion& lhs, const Quaternion& rhs)
     return Quaternion(lhs.value_ - rhs.value_);
 }
 
+#ifdef __SSE__
+// Hamilton product as lw*(rx,ry,rz,rw) + lx*(rw,-rz,ry,-rx) + ly*(rz,rw,-rx,-ry) + lz*(-ry,rx,rw,-rz)
+// Terms are summed in the same order as the scalar version below, results are identical.
+Quaternion operator*(const Quaternion& lhs, const Quaternion& rhs)
+{
+    const float* l = lhs.value_.get_pointer();
+    __m128 r = _mm_loadu_ps(rhs.value_.get_pointer());
+    __m128 r_wzyx = _mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(0,1,2,3)), _mm_setr_ps(0.f, -0.f, 0.f, -0.f));
+    __m128 r_zwxy = _mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(1,0,3,2)), _mm_setr_ps(0.f, 0.f, -0.f, -0.f));
+    __m128 r_yxwz = _mm_xor_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(2,3,0,1)), _mm_setr_ps(-0.f, 0.f, 0.f, -0.f));
+
+    __m128 res = _mm_mul_ps(_mm_set1_ps(l[3]), r);
+    res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(l[0]), r_wzyx));
+    res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(l[1]), r_zwxy));
+    res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(l[2]), r_yxwz));
+
+    Quaternion result;
+    _mm_storeu_ps(result.value_.get_pointer(), res);
+    return result;
+}
+#else
 Quaternion operator*(const Quaternion& lhs, const Quaternion& rhs)
 {
     float w = lhs.value_[3]*rhs.value_[3] - lhs.value_[0]*rhs.value_[0] - lhs.value_[1]*rhs.value_[1] - lhs.value_[2]*rhs.value_[2];
@@ -209,6 +234,7 @@ Quaternion operator*(const Quaternion& lhs, const Quaternion& rhs)
 
     return Quaternion(x, y, z, w);
 }
+#endif // __SSE__
 
 Quaternion operator/(const Quaternion& lhs, const Quaternion& rhs)
 {
@@ -281,5 +307,26 @@ Quaternion slerp(const Quaternion& q0, const Quaternion& q1, float t)
     return (v0 * s0) + (v1 * s1);
 }
 
+mat4 compose_trs(const vec3& position, const Quaternion& orientation, float scale)
+{
+    // R*S scales the first three columns of R, then T only sets the last column
+    mat4 result(orientation.get_rotation_matrix());
+    if(scale != 1.0f)
+        for(unsigned col=0; col<3; ++col)
+            for(unsigned row=0; row<3; ++row)
+                result[4*col+row] *= scale;
+    result[12] = position[0];
+    result[13] = position[1];
+    result[14] = position[2];
+    return result;
+}
+
+void compose_trs(const vec3* positions, const Quaternion* orientations, const float* scales,
+                 mat4* out, size_t count)
+{
+    for(size_t ii=0; ii<count; ++ii)
+        out[ii] = compose_trs(positions[ii], orientations[ii], scales ? scales[ii] : 1.0f);
+}
+
 } // namespace math
 } // namespace wcore
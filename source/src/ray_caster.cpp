@@ -145,12 +145,14 @@ SceneQueryResult RayCaster::ray_scene_query(const Ray& ray)
     [&](const Model& model) // Evaluator -> breaks from traversal loop when return value is false
     {
         // Skip terrains for now
-        if(model.is_terrain() || !model.is_visible())
+        if(model.is_terrain())
             return false;
         //return ray_collides_AABB(ray, model.get_AABB(), data);
         return ray_collides_OBB(ray, model, data);
     },
-    ORDER::FRONT_TO_BACK);
+    ORDER::FRONT_TO_BACK,
+    MODEL_CATEGORY::OPAQUE,
+    true); // Only objects in view frustum
     return result;
 }
 
@@ -187,11 +189,12 @@ SceneQueryResult RayCaster::ray_scene_query_first(const Ray& ray)
     [&](const Model& model) // Evaluator -> breaks from traversal loop when return value is false
     {
         // Skip terrains for now
-        if(model.is_terrain() || !model.is_visible())
+        if(model.is_terrain())
             return false;
         //return ray_collides_AABB(ray, model.get_AABB(), data);
         return ray_collides_OBB(ray, model, data);
-    });
+    },
+    true); // Only objects in view frustum
     return result;
 }
 
@@ -7,6 +7,7 @@
 #include "scene.h"
 #include "camera.h"
 #include "texture.h"
+#include "material.h"
 #include "sky.h"
 #include "logger.h"
 #include "debug_info.h"
@@ -21,6 +22,7 @@
 #include "camera_controller.h"
 #include "basic_components.h"
 #include "entity_system.h"
+#include "job_system.h"
 
 #ifndef __DISABLE_EDITOR__
     #include "imgui/imgui.h"
@@ -38,8 +40,27 @@ skybox_(nullptr),
 camera_(std::make_shared<Camera>(GLB.WIN_W, GLB.WIN_H)),
 light_camera_(std::make_shared<Camera>(1, 1)),
 chunk_size_m_(32),
-current_chunk_index_(0)
-{
+current_chunk_index_(0),
+displayable_version_(uint64_t(-1)),
+instance_batches_dirty_(true),
+occlusion_culling_(true),
+occlusion_max_motion_(2.f),
+lod_selection_(true),
+terrain_lod_(true)
+{
+    CONFIG.get("root.render.occlusion.enabled"_h, occlusion_culling_);
+    CONFIG.get("root.render.occlusion.max_motion"_h, occlusion_max_motion_);
+    CONFIG.get("root.render.lod.enabled"_h, lod_selection_);
+    CONFIG.get("root.render.lod.base_size"_h, lod_selector_.base_size);
+    CONFIG.get("root.render.lod.ratio"_h, lod_selector_.ratio);
+    CONFIG.get("root.render.lod.hysteresis"_h, lod_selector_.hysteresis);
+    // Terrain chunks are large, finest level is kept for nearby chunks only
+    terrain_lod_selector_.base_size = 1.f;
+    CONFIG.get("root.render.terrain_lod.enabled"_h, terrain_lod_);
+    CONFIG.get("root.render.terrain_lod.base_size"_h, terrain_lod_selector_.base_size);
+    CONFIG.get("root.render.terrain_lod.ratio"_h, terrain_lod_selector_.ratio);
+    CONFIG.get("root.render.terrain_lod.hysteresis"_h, terrain_lod_selector_.hysteresis);
+
     // Disable light camera frustum update and make it a "look at" camera
     light_camera_->disable_frustum_update();
     light_camera_->set_view_policy(Camera::ViewPolicy::DIRECTIONAL);
@@ -49,13 +70,17 @@ current_chunk_index_(0)
     DINFO.register_text_slot("sdiPosition"_h, vec3(0.2,0.9,1.0));
     DINFO.register_text_slot("sdiAngles"_h, vec3(0.2,0.9,1.0));
     DINFO.register_text_slot("sdiChunk"_h, vec3(0.2,0.9,1.0));
+    DINFO.register_text_slot("sdiTransforms"_h, vec3(0.2,0.9,1.0));
 }
 
 Scene::~Scene()
 {
     // Delete chunks
     for(auto&& [key, chunk]: chunks_)
+    {
+        release_transforms(chunk);
         delete chunk;
+    }
 }
 
 void Scene::init_events(InputHandler& handler)
@@ -81,17 +106,14 @@ void Scene::load_instance_geometry()
 void Scene::add_chunk(const math::i32vec2& coords)
 {
     Chunk* chunk = new Chunk(coords);
-#ifdef __DEBUG__
-    auto it = chunks_.find(chunk->get_index());
-    if(it!=chunks_.end())
+    // Chunk indices are exact, a duplicate is a chunk loaded twice
+    if(!chunks_.insert(chunk->get_index(), chunk))
     {
         DLOGE("[Scene] Chunk <n>" + std::to_string(chunk->get_index()) + "</n> "
-            + "already loaded. Possible hash collision.", "scene");
+            + "already loaded.", "scene");
         delete chunk;
         return;
     }
-#endif
-    chunks_.insert(std::make_pair(chunk->get_index(), chunk));
 
     // Setup static octree if first chunk inserted
     if(!static_octree.is_initialized())
@@ -122,11 +144,11 @@ void Scene::populate_static_octree(uint32_t chunk_index)
 
 void Scene::sort_chunks()
 {
-    // Initialize order lists
-    chunks_order_.resize(chunks_.size());
-    uint32_t ii = 0;
+    // Initialize order lists, skip chunks that are still streaming in
+    chunks_order_.clear();
     for(auto&& [key, chunk]: chunks_)
-        chunks_order_[ii++] = key;
+        if(chunk->is_uploaded())
+            chunks_order_.push_back(key);
 
     // Get camera position
     const vec3& cam_pos = camera_->get_position();
@@ -144,18 +166,23 @@ void Scene::sort_chunks()
 // Sort models front to back with respect to camera position in all chunks
 void Scene::sort_models()
 {
-    // Gen entity system
-    auto* entity_system = locate<EntitySystem>("EntitySystem"_h);
+    gather_displayable_models();
 
-    // * Sort entities
+    // * Sort entities, distances are computed once per model and not in the comparator
     const vec3& cam_pos = camera_->get_position();
-    std::sort(displayable_entities_.begin(), displayable_entities_.end(),
-    [&](const uint64_t& a, const uint64_t& b)
+    std::vector<std::pair<float, Model*>> keyed;
+    keyed.reserve(displayable_models_.size());
+    for(Model* model: displayable_models_)
+        keyed.push_back({norm2(model->get_position()-cam_pos), model});
+    std::sort(keyed.begin(), keyed.end(),
+    [](const std::pair<float, Model*>& a, const std::pair<float, Model*>& b)
     {
-        float dist_a = norm2(entity_system->get_entity(a).get_component<component::WCModel>()->model->get_position()-cam_pos);
-        float dist_b = norm2(entity_system->get_entity(b).get_component<component::WCModel>()->model->get_position()-cam_pos);
-        return (dist_a < dist_b); // sort front to back
+        return (a.first < b.first); // sort front to back
     });
+    for(uint32_t ii=0; ii<keyed.size(); ++ii)
+        displayable_models_[ii] = keyed[ii].second;
+    // Entity visibility is indexed by position, consider all visible until next visibility pass
+    entity_visibility_.resize(displayable_models_.size(), true);
 
     // * Sort models in chunks
     for(auto&& [key, chunk]: chunks_)
@@ -172,7 +199,8 @@ void Scene::sort_models_light()
 void Scene::traverse_models(ModelVisitor func,
                             ModelEvaluator ifFunc,
                             wcore::ORDER order,
-                            wcore::MODEL_CATEGORY model_cat) const
+                            wcore::MODEL_CATEGORY model_cat,
+                            bool visible_only) const
 {
     //Traverse chunks front to back for opaque geometry
     if(model_cat==wcore::MODEL_CATEGORY::OPAQUE || model_cat==wcore::MODEL_CATEGORY::IRRELEVANT)
@@ -180,7 +208,7 @@ void Scene::traverse_models(ModelVisitor func,
         for(uint32_t ii=0; ii<chunks_order_.size(); ++ii)
         {
             Chunk* chunk = chunks_.at(chunks_order_[ii]);
-            chunk->traverse_models(func, ifFunc, order, model_cat);
+            chunk->traverse_models(func, ifFunc, order, model_cat, visible_only);
         }
     }
     //Traverse chunks back to front for transparent geometry
@@ -190,17 +218,17 @@ void Scene::traverse_models(ModelVisitor func,
         {
             uint32_t index = chunks_order_.size()-ii-1;
             Chunk* chunk = chunks_.at(chunks_order_[index]);
-            chunk->traverse_models(func, ifFunc, order, model_cat);
+            chunk->traverse_models(func, ifFunc, order, model_cat, visible_only);
         }
     }
 }
 
-void Scene::visit_model_first(ModelVisitor func, ModelEvaluator ifFunc) const
+void Scene::visit_model_first(ModelVisitor func, ModelEvaluator ifFunc, bool visible_only) const
 {
     for(uint32_t ii=0; ii<chunks_order_.size(); ++ii)
     {
         Chunk* chunk = chunks_.at(chunks_order_[ii]);
-        if(chunk->visit_model_first(func, ifFunc))
+        if(chunk->visit_model_first(func, ifFunc, visible_only))
             break;
     }
 }
@@ -223,10 +251,102 @@ void Scene::draw_line_models(std::function<void(pLineModel)> func)
     }
 }
 
+bool Scene::is_chunk_in_view(Chunk* chunk) const
+{
+    // Always traverse the chunk we're at, else, frustum cull
+    if(chunk->get_index()==current_chunk_index_)
+        return true;
+
+    // ----- /!\ (APPROX) /!\ -----
+    // Is chunk visible? ~= Is terrain visible? (when viewed from the top)
+
+    // Get terrain chunk OBB
+    if(chunk->has_terrain())
+    {
+        OBB& obb = chunk->get_terrain_nc().get_OBB();
+        // Frustum cull entire chunk
+        if(!camera_->frustum_collides(obb))
+            return false;
+    }
+    return true;
+}
+
+void Scene::submit_models(CommandBucket<DrawCommand>& bucket,
+                          std::function<uint64_t(const Model&, uint32_t)> make_key,
+                          ModelEvaluator evaluate,
+                          bool visible_only,
+                          wcore::MODEL_CATEGORY model_cat) const
+{
+    // STATIC MODELS
+    for(uint32_t ii=0; ii<chunks_order_.size(); ++ii)
+    {
+        Chunk* chunk = chunks_.at(chunks_order_[ii]);
+        // * Chunk frustum culling
+        if(!is_chunk_in_view(chunk))
+            continue;
+
+        chunk->traverse_models([&](const Model& model, uint32_t chunk_index)
+        {
+            bucket.submit(make_key(model, chunk_index), DrawCommand{&model, chunk});
+        }, evaluate, wcore::ORDER::IRRELEVANT, model_cat, visible_only);
+    }
+    if(model_cat != wcore::MODEL_CATEGORY::OPAQUE)
+        return;
+    // ENTITIES WITH MODEL INSTANCES
+    for(uint32_t ii=0; ii<displayable_models_.size(); ++ii)
+    {
+        if(visible_only && ii<entity_visibility_.size() && !entity_visibility_.test(ii))
+            continue;
+        const Model& e_model = *displayable_models_[ii];
+        if(e_model.get_mesh().get_buffer_token().batch_category != "instance"_h)
+            continue;
+        if(evaluate(const_cast<Model&>(e_model)))
+            bucket.submit(make_key(e_model, current_chunk_index_), DrawCommand{&e_model, nullptr});
+    }
+}
+
+void Scene::submit_shadow_casters(CommandBucket<DrawCommand>& bucket,
+                                  const FrustumBox& volume,
+                                  std::function<uint64_t(const Model&, uint32_t)> make_key)
+{
+    // STATIC MODELS
+    // Octree groups are chunk indices
+    static_octree.traverse_range(volume, [&](auto&& obj)
+    {
+        Chunk** chunk = chunks_.find(obj.group_id);
+        if(!chunk || !(*chunk)->is_uploaded())
+            return;
+        const Model& model = *obj.data.model;
+        bucket.submit(make_key(model, obj.group_id), DrawCommand{&model, *chunk});
+    });
+    // ENTITIES WITH MODEL INSTANCES
+    for(uint32_t ii=0; ii<displayable_models_.size(); ++ii)
+    {
+        Model& e_model = *displayable_models_[ii];
+        if(e_model.get_mesh().get_buffer_token().batch_category != "instance"_h)
+            continue;
+        if(!e_model.can_frustum_cull() || traits::collision<FrustumBox,OBB>::intersects(volume, e_model.get_OBB()))
+            bucket.submit(make_key(e_model, current_chunk_index_), DrawCommand{&e_model, nullptr});
+    }
+}
+
+void Scene::draw(const DrawCommand& command) const
+{
+    const BufferToken& token = command.model->get_buffer_token();
+    if(token.batch_category == "instance"_h)
+    {
+        // Instance buffers are owned by scene
+        instance_render_batch_.draw(token);
+    }
+    else if(command.chunk)
+        command.chunk->draw(token);
+}
+
 void Scene::draw_models(std::function<void(const Model&)> prepare,
                         ModelEvaluator evaluate,
                         wcore::ORDER order,
-                        wcore::MODEL_CATEGORY model_cat) const
+                        wcore::MODEL_CATEGORY model_cat,
+                        bool visible_only) const
 {
     //Traverse chunks front to back for opaque geometry
     if(model_cat==wcore::MODEL_CATEGORY::OPAQUE)
@@ -236,27 +356,14 @@ void Scene::draw_models(std::function<void(const Model&)> prepare,
         {
             Chunk* chunk = chunks_.at(chunks_order_[ii]);
             // * Chunk frustum culling
-            // Always traverse the chunk we're at, else, frustum cull
-            if(chunk->get_index()!=current_chunk_index_)
-            {
-                // ----- /!\ (APPROX) /!\ -----
-                // Is chunk visible? ~= Is terrain visible? (when viewed from the top)
-
-                // Get terrain chunk OBB
-                if(chunk->has_terrain())
-                {
-                    OBB& obb = chunk->get_terrain_nc().get_OBB();
-                    // Frustum cull entire chunk
-                    if(!camera_->frustum_collides(obb))
-                        continue;
-                }
-            }
+            if(!is_chunk_in_view(chunk))
+                continue;
 
             // Draw models
             chunk->traverse_models([&](const Model& model, uint32_t chunk_index)
             {
                 prepare(model);
-                const BufferToken& token = model.get_mesh().get_buffer_token();
+                const BufferToken& token = model.get_buffer_token();
                 if(token.batch_category == "instance"_h)
                 {
                     // Instance buffers are owned by scene
@@ -264,18 +371,18 @@ void Scene::draw_models(std::function<void(const Model&)> prepare,
                 }
                 else
                     chunk->draw(token);
-            }, evaluate, order, model_cat);
+            }, evaluate, order, model_cat, visible_only);
         }
         // ENTITIES WITH MODEL INSTANCES
-        auto* entity_system = locate<EntitySystem>("EntitySystem"_h);
-        for(uint64_t id: displayable_entities_)
+        for(uint32_t ii=0; ii<displayable_models_.size(); ++ii)
         {
-            const auto& entity = entity_system->get_entity(id);
-            Model& e_model = *entity.get_component<component::WCModel>()->model;
+            if(visible_only && ii<entity_visibility_.size() && !entity_visibility_.test(ii))
+                continue;
+            Model& e_model = *displayable_models_[ii];
             if(evaluate(e_model))
             {
                 prepare(e_model);
-                const BufferToken& token = e_model.get_mesh().get_buffer_token();
+                const BufferToken& token = e_model.get_buffer_token();
                 if(token.batch_category == "instance"_h)
                 {
                     // Instance buffers are owned by scene
@@ -305,12 +412,83 @@ void Scene::draw_models(std::function<void(const Model&)> prepare,
             chunk->traverse_models([&](const Model& model, uint32_t chunk_index)
             {
                 prepare(model);
-                chunk->draw(model.get_mesh().get_buffer_token());
-            }, evaluate, order, model_cat);
+                chunk->draw(model.get_buffer_token());
+            }, evaluate, order, model_cat, visible_only);
         }
     }
 }
 
+void Scene::draw_model_instances(std::function<void(const Model&)> prepare)
+{
+    if(instance_batches_dirty_)
+        build_instance_batches();
+
+    // * One draw call per group
+    for(auto&& group: instance_groups_)
+    {
+        const Model& model = *instance_refs_[group.first].model;
+        prepare(model);
+        instance_render_batch_.draw_instanced(model.get_buffer_token(), group.first, group.count);
+    }
+}
+
+void Scene::build_instance_batches()
+{
+    instance_batches_dirty_ = false;
+
+    // * Gather visible instances, front to back
+    instance_refs_.clear();
+    instance_groups_.clear();
+    auto gather = [&](const Model& model, uint32_t chunk_index)
+    {
+        const BufferToken& token = model.get_buffer_token();
+        if(token.batch_category != "instance"_h)
+            return;
+        instance_refs_.push_back({&model, token.buffer_offset, model.get_material().get_state_hash()});
+    };
+    for(uint32_t ii=0; ii<chunks_order_.size(); ++ii)
+        chunks_.at(chunks_order_[ii])->traverse_model_instances(gather, true);
+
+    for(uint32_t ii=0; ii<displayable_models_.size(); ++ii)
+    {
+        if(ii<entity_visibility_.size() && !entity_visibility_.test(ii))
+            continue;
+        gather(*displayable_models_[ii], 0);
+    }
+
+    if(instance_refs_.empty())
+        return;
+
+    // * Group by mesh and material, keep front to back order within groups
+    std::stable_sort(instance_refs_.begin(), instance_refs_.end(),
+    [](const InstanceRef& a, const InstanceRef& b)
+    {
+        if(a.buffer_offset != b.buffer_offset)
+            return a.buffer_offset < b.buffer_offset;
+        return a.material_hash < b.material_hash;
+    });
+
+    // * Stream model matrices of all groups at once
+    instance_data_.resize(instance_refs_.size());
+    for(uint32_t ii=0; ii<instance_refs_.size(); ++ii)
+        instance_data_[ii].model_matrix_ = const_cast<Model*>(instance_refs_[ii].model)->get_model_matrix();
+    instance_render_batch_.stream_instances(instance_data_);
+
+    // * Split into groups of same mesh and material
+    uint32_t first = 0;
+    while(first < instance_refs_.size())
+    {
+        uint32_t last = first+1;
+        while(last < instance_refs_.size()
+           && instance_refs_[last].buffer_offset == instance_refs_[first].buffer_offset
+           && instance_refs_[last].material_hash == instance_refs_[first].material_hash)
+            ++last;
+
+        instance_groups_.push_back({first, last-first});
+        first = last;
+    }
+}
+
 void Scene::draw_terrains(std::function<void(const TerrainChunk&)> prepare,
                           ModelEvaluator evaluate) const
 {
@@ -332,10 +510,25 @@ void Scene::draw_terrains(std::function<void(const TerrainChunk&)> prepare,
                 continue;
         }
 
-        // Draw terrains
+        // Draw terrains, body and border strips of the selected level
         TerrainChunk& terrain = chunk->get_terrain_nc();
         prepare(terrain);
-        chunk->draw(terrain.get_mesh().get_buffer_token());
+        if(terrain_lod_)
+            terrain.traverse_lod_tokens([&](const BufferToken& token) { chunk->draw(token); });
+        else
+            chunk->draw(terrain.get_mesh().get_buffer_token());
+    }
+}
+
+void Scene::traverse_occluders(std::function<void(Model&)> func)
+{
+    for(uint32_t ii=0; ii<chunks_order_.size(); ++ii)
+    {
+        Chunk* chunk = chunks_.at(chunks_order_[ii]);
+        if(!chunk->has_terrain()) continue;
+        if(chunk->get_index()!=current_chunk_index_ && !camera_->frustum_collides(chunk->get_terrain_nc().get_OBB()))
+            continue;
+        func(chunk->get_terrain_nc());
     }
 }
 
@@ -350,32 +543,20 @@ void Scene::traverse_lights(LightVisitor func,
 void Scene::traverse_loaded_neighbor_chunks(uint32_t chunk_index,
                                             std::function<void(Chunk*, wcore::NEIGHBOR)> visitor)
 {
-    // Get coordinates of chunk
-    const i32vec2& chunk_coords = get_chunk_coordinates(chunk_index);
-
-    if(chunk_coords.x()>0)
+    // Neighbor indices are computed from the exact coordinates held by the index
+    const i32vec2 coords = chunk_index_to_coords(chunk_index);
+    const std::pair<i32vec2, wcore::NEIGHBOR> neighbors[4] =
     {
-        uint32_t nei_index = std::hash<i32vec2>{}(i32vec2(chunk_coords.x()-1, chunk_coords.y()));
-        if(has_chunk(nei_index))
-            visitor(chunks_[nei_index], wcore::NEIGHBOR::WEST);
-    }
-    if(chunk_coords.x()<std::numeric_limits<uint32_t>::max())
-    {
-        uint32_t nei_index = std::hash<i32vec2>{}(i32vec2(chunk_coords.x()+1, chunk_coords.y()));
-        if(has_chunk(nei_index))
-            visitor(chunks_[nei_index], wcore::NEIGHBOR::EAST);
-    }
-    if(chunk_coords.y()>0)
-    {
-        uint32_t nei_index = std::hash<i32vec2>{}(i32vec2(chunk_coords.x(), chunk_coords.y()-1));
-        if(has_chunk(nei_index))
-            visitor(chunks_[nei_index], wcore::NEIGHBOR::SOUTH);
-    }
-    if(chunk_coords.y()<std::numeric_limits<uint32_t>::max())
+        {i32vec2(coords.x()-1, coords.y()), wcore::NEIGHBOR::WEST},
+        {i32vec2(coords.x()+1, coords.y()), wcore::NEIGHBOR::EAST},
+        {i32vec2(coords.x(), coords.y()-1), wcore::NEIGHBOR::SOUTH},
+        {i32vec2(coords.x(), coords.y()+1), wcore::NEIGHBOR::NORTH}
+    };
+    for(auto&& [nei_coords, location]: neighbors)
     {
-        uint32_t nei_index = std::hash<i32vec2>{}(i32vec2(chunk_coords.x(), chunk_coords.y()+1));
-        if(has_chunk(nei_index))
-            visitor(chunks_[nei_index], wcore::NEIGHBOR::NORTH);
+        Chunk** neighbor = chunks_.find(coords_to_chunk_index(nei_coords));
+        if(neighbor)
+            visitor(*neighbor, location);
     }
 }
 
@@ -383,43 +564,143 @@ void Scene::add_terrain(std::shared_ptr<TerrainChunk> terrain, uint32_t chunk_in
 {
     // * Add terrain to chunk
     chunks_.at(chunk_index)->terrain_ = terrain;
+    terrain->attach_transform(transforms_);
+}
+
+void Scene::release_transforms(Chunk* chunk)
+{
+    // Instance batches may reference models of this chunk
+    instance_batches_dirty_ = true;
+    // Models may outlive their chunk (references held elsewhere)
+    for(auto&& pmdl: chunk->models_)
+        pmdl->detach_transform();
+    for(auto&& pmdl: chunk->models_blend_)
+        pmdl->detach_transform();
+    for(auto&& pmdl: chunk->model_instances_)
+        pmdl->detach_transform();
+    if(chunk->terrain_)
+        chunk->terrain_->detach_transform();
+}
+
+void Scene::gather_displayable_models()
+{
+    EntityRegistry& registry = locate<EntitySystem>("EntitySystem"_h)->get_registry();
+    if(registry.get_structure_version() == displayable_version_)
+        return;
+
+    // Model instances are shared, pointers stay valid when components move in the registry
+    displayable_models_.clear();
+    registry.query<component::WCModel>([&](EntityHandle handle, component::WCModel& cmp)
+    {
+        displayable_models_.push_back(cmp.model.get());
+    });
+    displayable_version_ = registry.get_structure_version();
 }
 
 void Scene::visibility_pass()
 {
-    // Entities
-    auto* entity_system = locate<EntitySystem>("EntitySystem"_h);
-    for(uint64_t id: displayable_entities_)
+    FrustumPlanes planes;
+    planes.update(camera_->get_frustum_box());
+
+    // * Entities
+    gather_displayable_models();
+    uint32_t n_entities = displayable_models_.size();
+    if(entity_boxes_.size() != n_entities)
+        entity_boxes_.resize(n_entities);
+    if(entity_visibility_.size() != n_entities)
+        entity_visibility_.resize(n_entities);
+    for(uint32_t ii=0; ii<n_entities; ++ii)
     {
-        const auto& entity = entity_system->get_entity(id);
-        auto e_model = entity.get_component<component::WCModel>()->model;
+        Model* e_model = displayable_models_[ii];
 
         // Non cullable models are passed
         if(!e_model->can_frustum_cull())
+            entity_boxes_.set_no_cull(ii);
+        else
+            entity_boxes_.set(ii, e_model->get_OBB().get_vertices());
+    }
+    entity_boxes_.cull(planes, 0, n_entities, entity_visibility_);
+
+    // Occlusion buffer holds the depth of a previous frame, tested with the matching
+    // view-projection matrix
+    const HiZBuffer* hiz = (occlusion_culling_ && occlusion_buffer_.is_valid()) ? &occlusion_buffer_ : nullptr;
+    // Objects hidden from the eye the depth was produced from can be visible from the
+    // current one and would pop in late. Camera rotations are harmless (areas that were
+    // off screen are never occluded), so only a displacement of the eye is bounded:
+    // after a fast move or a teleport, the buffer is ignored until it catches up.
+    if(hiz && occlusion_max_motion_ >= 0.f
+    && hiz->get_eye_distance(camera_->get_position()) > occlusion_max_motion_)
+        hiz = nullptr;
+    // LODs are selected from current camera
+    lod_selector_.eye = camera_->get_position();
+    lod_selector_.projection_scale = camera_->get_projection_matrix()(1,1);
+    const lod::LodSelector* lods = lod_selection_ ? &lod_selector_ : nullptr;
+    for(uint32_t ii=0; ii<n_entities; ++ii)
+    {
+        if(!entity_visibility_.test(ii)) continue;
+        Model* e_model = displayable_models_[ii];
+        if(hiz && e_model->can_frustum_cull() && hiz->is_occluded(e_model->get_OBB().get_vertices()))
         {
-            e_model->set_visibility(true);
-            return;
+            entity_visibility_.reset(ii);
+            continue;
         }
-        // Get model OBB
-        OBB& obb = e_model->get_OBB();
-        // Frustum culling
-        e_model->set_visibility(camera_->frustum_collides(obb));
+        uint32_t n_lods = e_model->get_mesh().get_lod_count();
+        if(lods && n_lods > 1)
+            e_model->set_lod(lods->select(e_model->get_OBB().get_vertices(), e_model->get_lod(), n_lods));
     }
 
-    // Models in chunks
-    traverse_models([&](Model& model, uint32_t chunk_id)
+    // * Models in chunks
+    // Split visibility slots of each chunk in batches, so that
+    // a chunk with many models is culled by multiple workers
+    culling_tasks_.clear();
+    for(auto&& [key, chunk]: chunks_)
     {
-        // Non cullable models are passed
-        if(!model.can_frustum_cull())
+        // Chunk may still be submitted by a streaming worker
+        if(!chunk->is_uploaded()) continue;
+        uint32_t n_slots = chunk->prepare_culling();
+        for(uint32_t begin=0; begin<n_slots; begin+=CullingBoxes::BATCH_SIZE)
+            culling_tasks_.push_back({chunk, begin, std::min(begin+CullingBoxes::BATCH_SIZE, n_slots)});
+    }
+
+    JOBS.parallel_for(0, culling_tasks_.size(), [&](uint32_t ii)
+    {
+        const CullingTask& task = culling_tasks_[ii];
+        task.chunk->cull(planes, task.begin, task.end, hiz, lods);
+    }, 1);
+}
+
+void Scene::terrain_lod_pass()
+{
+    if(!terrain_lod_) return;
+
+    terrain_lod_selector_.eye = camera_->get_position();
+    terrain_lod_selector_.projection_scale = camera_->get_projection_matrix()(1,1);
+
+    // * Select a level per chunk
+    for(auto&& [key, chunk]: chunks_)
+    {
+        if(!chunk->is_uploaded() || !chunk->has_terrain()) continue;
+        TerrainChunk& terrain = chunk->get_terrain_nc();
+        terrain.set_lod_level(terrain_lod_selector_.select(terrain.get_OBB().get_vertices(),
+                                                           terrain.get_lod_level(),
+                                                           terrain.get_lod_level_count()));
+    }
+
+    // * Shared edges are sampled at the coarsest level of both chunks, so
+    // that both sides use the same vertices and no crack appears
+    for(auto&& [key, chunk]: chunks_)
+    {
+        if(!chunk->is_uploaded() || !chunk->has_terrain()) continue;
+        TerrainChunk& terrain = chunk->get_terrain_nc();
+        for(uint32_t ss=0; ss<4; ++ss)
+            terrain.set_edge_level(NEIGHBOR(ss), terrain.get_lod_level());
+
+        traverse_loaded_neighbor_chunks(chunk->get_index(), [&](Chunk* neighbor, NEIGHBOR location)
         {
-            model.set_visibility(true);
-            return;
-        }
-        // Get model OBB
-        OBB& obb = model.get_OBB();
-        // Frustum culling
-        model.set_visibility(camera_->frustum_collides(obb));
-    });
+            if(!neighbor->is_uploaded() || !neighbor->has_terrain()) return;
+            terrain.set_edge_level(location, neighbor->get_terrain().get_lod_level());
+        });
+    }
 }
 
 
@@ -431,17 +712,24 @@ void Scene::update(const GameClock& clock)
     const vec3& cam_pos = camera_->get_position();
     current_chunk_coords_ = i32vec2((uint32_t)floor(cam_pos.x()/chunk_size_m_),
                                     (uint32_t)floor(cam_pos.z()/chunk_size_m_));
-    current_chunk_index_ = std::hash<i32vec2>{}(current_chunk_coords_);
+    current_chunk_index_ = coords_to_chunk_index(current_chunk_coords_);
 
     // Basic chunk updaters
     for(auto&& [key, chunk]: chunks_)
     {
+        // Chunk may still be submitted by a streaming worker
+        if(!chunk->is_uploaded()) continue;
         chunk->update(scaled_dt);
         chunk->sort_models(camera_);
     }
 
+    // World matrices of moved models, before bounding boxes are used by the visibility pass
+    uint32_t n_transforms = transforms_.update();
+
     // Perform and cache OBB / frustum tests
     visibility_pass();
+    terrain_lod_pass();
+    instance_batches_dirty_ = true;
 
     // Display debug info
     if(DINFO.active())
@@ -459,6 +747,10 @@ void Scene::update(const GameClock& clock)
         ss.str("");
         ss << "Loaded chunks: " << get_num_loaded_chunks();
         DINFO.display("sdiChunk"_h, ss.str());
+
+        ss.str("");
+        ss << "Transforms updated: " << n_transforms << "/" << transforms_.size();
+        DINFO.display("sdiTransforms"_h, ss.str());
     }
 }
 
@@ -476,7 +768,7 @@ float Scene::get_height(math::vec3 position) const
 {
     i32vec2 chunk_coords((uint32_t)floor(position.x()/chunk_size_m_),
                          (uint32_t)floor(position.y()/chunk_size_m_));
-    uint32_t chunk_index = std::hash<i32vec2>{}(chunk_coords);
+    uint32_t chunk_index = coords_to_chunk_index(chunk_coords);
     if(has_chunk(chunk_index))
     {
         if(!has_terrain(chunk_index)) return 0.f;
@@ -511,6 +803,7 @@ void Scene::get_loaded_chunks_coords(std::vector<math::i32vec2>& coord_list) con
 void Scene::add_model_instance(std::shared_ptr<Model> model, uint32_t chunk_index)
 {
     chunks_.at(chunk_index)->add_model(model,true);
+    model->attach_transform(transforms_);
     if(model->has_reference())
         ref_models_.insert(std::pair(model->get_reference(), model));
 }
@@ -518,6 +811,7 @@ void Scene::add_model_instance(std::shared_ptr<Model> model, uint32_t chunk_inde
 void Scene::add_model(std::shared_ptr<Model> model, uint32_t chunk_index)
 {
     chunks_.at(chunk_index)->add_model(model);
+    model->attach_transform(transforms_);
     if(model->has_reference())
         ref_models_.insert(std::pair(model->get_reference(), model));
 }
@@ -538,6 +832,12 @@ void Scene::add_light(std::shared_ptr<Light> light, uint32_t chunk_index)
         ref_lights_.insert(std::pair(light->get_reference(), light));
 }
 
+void Scene::set_model_parent(Model& child, const Model& parent)
+{
+    assert(child.has_transform_node() && parent.has_transform_node() && "[Scene] Models must be added to the scene first.");
+    transforms_.set_parent(child.get_transform_node(), parent.get_transform_node());
+}
+
 std::weak_ptr<Light> Scene::get_light_by_ref(hash_t href)
 {
     auto it = ref_lights_.find(href);
@@ -27,6 +27,9 @@
 #include "file_system.h"
 #include "basic_components.h"
 #include "pipeline.h"
+#include "chunk_manager.h"
+#include "frame_profiler.h"
+#include "config.h"
 
 namespace wcore
 {
@@ -42,9 +45,19 @@ typedef std::shared_ptr<const Model>  pcModel;
 typedef std::shared_ptr<const Camera> pcCamera;
 typedef std::shared_ptr<const Light>  pcLight;
 
+// Transformation of a model as it was baked
+static Transformation make_transformation(const BakedTransform& baked)
+{
+    return Transformation(vec3(baked.position[0], baked.position[1], baked.position[2]),
+                          quat(vec4(baked.orientation[0], baked.orientation[1],
+                                    baked.orientation[2], baked.orientation[3])),
+                          baked.scale);
+}
+
 SceneLoader::SceneLoader():
 xml_parser_(),
 game_object_factory_(nullptr),
+baked_transform_cursor_(0),
 chunk_size_m_(32),
 lattice_scale_(1.0f),
 texture_scale_(1.0f),
@@ -55,7 +68,8 @@ pscene_(nullptr)
 
 SceneLoader::~SceneLoader()
 {
-
+    clear_prefetched_chunks();
+    JOBS.wait(bake_jobs_);
 }
 
 void SceneLoader::init_self()
@@ -116,9 +130,27 @@ void SceneLoader::load_level(const char* level_name)
         DLOGI("<p>" + levelfilename + "</p>", "scene");
         fatal();
     }
-    xml_parser_.load_file_xml(*pstream);
+    // Keep file content to identify this version of the level
+    std::string content((std::istreambuf_iterator<char>(*pstream)),
+                         std::istreambuf_iterator<char>());
+    std::istringstream iss(content);
+    xml_parser_.load_file_xml(iss);
 
     current_map_ = level_name;
+
+    // Baked chunks of a previous version of the level will be ignored
+    JOBS.wait(bake_jobs_);
+    bool bake_chunks = false;
+    CONFIG.get("root.render.chunk.bake"_h, bake_chunks);
+    if(bake_chunks)
+    {
+        fs::path cache_path;
+        if(!CONFIG.get("root.folders.cache"_h, cache_path))
+            cache_path = CONFIG.get_root_directory() / "cache";
+        chunk_cache_.init(cache_path, current_map_, ChunkCache::make_stamp(content));
+    }
+    else
+        chunk_cache_.disable();
     DLOGES("scene", Severity::LOW);
 }
 
@@ -181,7 +213,7 @@ void SceneLoader::load_global(DaylightSystem& daylight)
         if(xml::parse_attribute(ck_node, "coords", chunk_coords))
         {
             // Compute hash of chunk coordinates to generate unique chunk index
-            uint32_t chunk_index = std::hash<i32vec2>{}(chunk_coords);
+            uint32_t chunk_index = coords_to_chunk_index(chunk_coords);
             chunk_nodes_.insert(std::make_pair(chunk_index, ck_node));
         }
     }
@@ -371,6 +403,9 @@ void SceneLoader::parse_patches(rapidxml::xml_node<>* node)
     chunk_size_ = uint32_t(floor(chunk_size_m_/lattice_scale_));
     pscene_->set_chunk_size_meters(chunk_size_m_);
     TerrainChunk::set_chunk_size(chunk_size_);
+    uint32_t terrain_lod_levels = 4;
+    CONFIG.get("root.render.terrain_lod.levels"_h, terrain_lod_levels);
+    TerrainChunk::set_max_lod_levels(terrain_lod_levels);
 
     // For each terrain patch
     for(xml_node<>* patch=node->first_node("TerrainPatch");
@@ -405,7 +440,7 @@ void SceneLoader::parse_patches(rapidxml::xml_node<>* node)
             for(uint32_t yy=patchStart.y(); yy<patchStart.y()+patchSize.y(); ++yy)
             {
                 // Compute chunk index
-                uint32_t chunk_index = std::hash<i32vec2>{}(i32vec2(xx,yy));
+                uint32_t chunk_index = coords_to_chunk_index(i32vec2(xx,yy));
                 // Add/Override reference to patch node in table
 #ifdef __DEBUG__
                 auto it = chunk_patches_.find(chunk_index);
@@ -512,8 +547,9 @@ void SceneLoader::parse_skybox(rapidxml::xml_node<>* node)
 
 uint32_t SceneLoader::load_chunk(const i32vec2& chunk_coords, bool finalize)
 {
+    W_PROFILE_SCOPE("Load chunk");
     // Compute chunk index, find corresponding node and load content
-    uint32_t chunk_index = std::hash<i32vec2>{}(chunk_coords);
+    uint32_t chunk_index = coords_to_chunk_index(chunk_coords);
     auto it = chunk_nodes_.find(chunk_index);
     if(it == chunk_nodes_.end())
     {
@@ -600,6 +636,19 @@ uint32_t SceneLoader::load_chunk(const i32vec2& chunk_coords, bool finalize)
     dt_lights_us = 1e6*std::chrono::duration_cast<std::chrono::duration<float>>(period).count();
 #endif
 
+    // Placements are known now, a generated chunk can be baked.
+    // Only the copy is done here, writing the file is left to a worker.
+    if(pending_bake_)
+    {
+        const ChunkCache* cache = &chunk_cache_;
+        std::shared_ptr<ChunkBakeData> bake_data = std::move(pending_bake_);
+        JOBS.schedule([cache, bake_data]()
+        {
+            cache->store(*bake_data);
+        }, &bake_jobs_);
+    }
+    baked_chunk_.reset();
+
     // UPLOADING TO OPENGL
 #ifdef __PROFILING_CHUNKS__
     profile_clock_.restart();
@@ -611,7 +660,9 @@ uint32_t SceneLoader::load_chunk(const i32vec2& chunk_coords, bool finalize)
     dt_upload_us = 1e6*std::chrono::duration_cast<std::chrono::duration<float>>(period).count();
 #endif
 
-    pscene_->populate_static_octree(chunk_index);
+    // Unfinalized chunks are inserted in the octree when their geometry is sent
+    if(finalize)
+        pscene_->populate_static_octree(chunk_index);
 
 #ifdef __PROFILING_CHUNKS__
     float dt_total_us = dt_terrain_us + dt_models_us + dt_batches_us + dt_lights_us + dt_upload_us;
@@ -652,6 +703,9 @@ uint32_t SceneLoader::load_chunk(const i32vec2& chunk_coords, bool finalize)
 
 void SceneLoader::reload_chunks()
 {
+    // Chunks still streaming in are about to be destroyed
+    locate<ChunkManager>("ChunkManager"_h)->cancel_streaming();
+
     std::vector<i32vec2> coords;
     pscene_->get_loaded_chunks_coords(coords);
 
@@ -662,6 +716,8 @@ void SceneLoader::reload_chunks()
 
 void SceneLoader::reload_map()
 {
+    // Prefetch jobs read the XML tree we are about to free
+    clear_prefetched_chunks();
     xml_parser_.reset();
 
     load_level(current_map_.c_str());
@@ -670,9 +726,10 @@ void SceneLoader::reload_map()
 
 void SceneLoader::parse_terrain(const i32vec2& chunk_coords)
 {
+    W_PROFILE_SCOPE("Parse terrain");
     // Look for correct patch node in chunk/patch table
     // given chunk coordinates
-    uint32_t chunk_index = std::hash<i32vec2>{}(chunk_coords);
+    uint32_t chunk_index = coords_to_chunk_index(chunk_coords);
     auto it = chunk_patches_.find(chunk_index);
     if(it==chunk_patches_.end())
     {
@@ -684,6 +741,10 @@ void SceneLoader::parse_terrain(const i32vec2& chunk_coords)
     }
     xml_node<>* patch = it->second;
 
+    baked_chunk_.reset();
+    baked_transform_cursor_ = 0;
+    pending_bake_.reset();
+
     // If patch is null, we have a void patch and should not create a terrain
     if(patch == nullptr)
     {
@@ -692,10 +753,81 @@ void SceneLoader::parse_terrain(const i32vec2& chunk_coords)
     }
 
     // Get nodes
-    xml_node<>* splat_node = patch->first_node("Splat");
-    xml_node<>* mat_node = patch->first_node("Material");
     xml_node<>* trn_node = patch->first_node("Transform");
     xml_node<>* shadow_node = patch->first_node("Shadow");
+
+    TerrainPatchDescriptor desc;
+    if(!make_patch_descriptor(patch, chunk_coords, desc))
+    {
+        DLOGE("[SceneLoader] No Material node detected in TerrainPatch.", "parsing");
+        return;
+    }
+
+    // Use height map generated ahead of time if any (waits for the job to finish)
+    auto pit = prefetched_heightmaps_.find(chunk_index);
+    if(pit != prefetched_heightmaps_.end())
+    {
+        JOBS.wait(pit->second->job);
+        desc.heightmap = pit->second->heightmap;
+        prefetched_heightmaps_.erase(pit);
+    }
+    // Else, use baked height map and mesh if any
+    else if(auto baked = chunk_cache_.fetch(chunk_coords))
+    {
+        const WchkHeader& header = baked->get_header();
+        if(header.hm_width == chunk_size_ && header.hm_length == chunk_size_)
+        {
+            desc.heightmap = baked->make_heightmap();
+            desc.mesh = baked->make_terrain_mesh();
+            // Keep it mapped for models and lights
+            baked_chunk_ = std::move(baked);
+        }
+    }
+    bool generated = (desc.mesh == nullptr);
+
+    pTerrain terrain = game_object_factory_->make_terrain_patch(desc);
+    if(terrain == nullptr)
+    {
+        baked_chunk_.reset();
+        return;
+    }
+
+    // Copy terrain before its edges are modified by neighbor chunks,
+    // it is baked by load_chunk() once models and lights are placed.
+    if(generated && chunk_cache_.is_enabled())
+        pending_bake_ = std::make_shared<ChunkBakeData>(chunk_coords, terrain->get_heightmap(), terrain->get_mesh());
+
+    // Fix new terrain edge normals and tangents
+    terrain::stitch_terrain_edges(pscene_, *terrain, chunk_index, chunk_size_);
+
+    // Spacial transformation
+    Transformation trans;
+    parse_transformation(trn_node, trans);
+    // Translate according to chunk coordinates
+    trans.translate((chunk_size_m_-lattice_scale_)*chunk_coords.x(),
+                    0,
+                    (chunk_size_m_-lattice_scale_)*chunk_coords.y());
+    terrain->set_transformation(trans);
+
+    // Shadow options
+    if(shadow_node)
+    {
+        uint32_t cull_face=0;
+        if(xml::parse_node(shadow_node, "CullFace", cull_face))
+            terrain->set_shadow_cull_face(cull_face);
+    }
+
+    terrain->update_bounding_boxes();
+    pscene_->add_terrain(terrain, chunk_index);
+}
+
+bool SceneLoader::make_patch_descriptor(xml_node<>* patch,
+                                        const i32vec2& chunk_coords,
+                                        TerrainPatchDescriptor& desc)
+{
+    // Get nodes
+    xml_node<>* splat_node = patch->first_node("Splat");
+    xml_node<>* mat_node = patch->first_node("Material");
     xml_node<>* generator_node = patch->first_node("Generator");
     xml_node<>* height_modifier_node = patch->first_node("HeightModifier");
 
@@ -703,9 +835,8 @@ void SceneLoader::parse_terrain(const i32vec2& chunk_coords)
     float height = 0.0f;
     xml::parse_attribute(patch, "height", height);
 
-    TerrainPatchDescriptor desc;
     desc.chunk_size = chunk_size_;
-    desc.chunk_index = chunk_index;
+    desc.chunk_index = coords_to_chunk_index(chunk_coords);
     desc.chunk_x = chunk_coords.x();
     desc.chunk_z = chunk_coords.y();
     desc.lattice_scale = lattice_scale_;
@@ -732,40 +863,111 @@ void SceneLoader::parse_terrain(const i32vec2& chunk_coords)
         if(mat_node)
             desc.material_nodes.push_back(mat_node);
         else
-        {
-            DLOGE("[SceneLoader] No Material node detected in TerrainPatch.", "parsing");
-            return;
-        }
+            return false;
     }
+    return true;
+}
 
-    pTerrain terrain = game_object_factory_->make_terrain_patch(desc);
+bool SceneLoader::prefetch_chunk(const i32vec2& chunk_coords)
+{
+    W_PROFILE_SCOPE("Prefetch chunk");
+    uint32_t chunk_index = coords_to_chunk_index(chunk_coords);
+    if(is_prefetched(chunk_index) || chunk_nodes_.find(chunk_index) == chunk_nodes_.end())
+        return false;
 
-    // Fix new terrain edge normals and tangents
-    terrain::stitch_terrain_edges(pscene_, *terrain, chunk_index, chunk_size_);
+    // Baked chunks are mapped on demand, nothing to generate
+    if(chunk_cache_.is_baked(chunk_coords))
+        return false;
 
-    // Spacial transformation
-    Transformation trans;
-    parse_transformation(trn_node, trans);
-    // Translate according to chunk coordinates
-    trans.translate((chunk_size_m_-lattice_scale_)*chunk_coords.x(),
-                    0,
-                    (chunk_size_m_-lattice_scale_)*chunk_coords.y());
-    terrain->set_transformation(trans);
+    // Nothing to generate for void patches and orphan chunks
+    auto it = chunk_patches_.find(chunk_index);
+    if(it==chunk_patches_.end() || it->second==nullptr)
+        return false;
 
-    // Shadow options
-    if(shadow_node)
+    TerrainPatchDescriptor desc;
+    if(!make_patch_descriptor(it->second, chunk_coords, desc))
+        return false;
+
+    // Height map generation is the costliest part of chunk loading and
+    // does not involve any graphics resource, so it can run in a job.
+    // Materials, models and GPU uploads stay on the render thread.
+    auto prefetched = std::make_unique<PrefetchedHeightmap>();
+    prefetched->coords = chunk_coords;
+    PrefetchedHeightmap* target = prefetched.get();
+    GameObjectFactory* factory = game_object_factory_;
+    JOBS.schedule([factory, desc, target]()
     {
-        uint32_t cull_face=0;
-        if(xml::parse_node(shadow_node, "CullFace", cull_face))
-            terrain->set_shadow_cull_face(cull_face);
+        target->heightmap = factory->make_heightmap(desc);
+    }, &target->job);
+    prefetched_heightmaps_.emplace(chunk_index, std::move(prefetched));
+
+    return true;
+}
+
+bool SceneLoader::is_prefetch_pending(uint32_t chunk_index) const
+{
+    auto it = prefetched_heightmaps_.find(chunk_index);
+    return it != prefetched_heightmaps_.end() && !it->second->job.is_done();
+}
+
+uint32_t SceneLoader::get_prefetch_job_count() const
+{
+    uint32_t count = 0;
+    for(auto&& [key, prefetched]: prefetched_heightmaps_)
+        count += prefetched->job.is_done() ? 0 : 1;
+    for(auto&& prefetched: dropped_prefetches_)
+        count += prefetched->job.is_done() ? 0 : 1;
+    return count;
+}
+
+void SceneLoader::drop_prefetched_chunks(const i32vec2& center, uint32_t radius)
+{
+    for(auto it=prefetched_heightmaps_.begin(); it!=prefetched_heightmaps_.end();)
+    {
+        int dx = int(it->second->coords.x()) - int(center.x());
+        int dy = int(it->second->coords.y()) - int(center.y());
+        if(uint32_t(dx*dx+dy*dy) > radius*radius)
+        {
+            // Job may still be writing the height map
+            dropped_prefetches_.push_back(std::move(it->second));
+            it = prefetched_heightmaps_.erase(it);
+        }
+        else
+            ++it;
     }
+    release_dropped_prefetches();
+}
 
-    terrain->update_bounding_boxes();
-    pscene_->add_terrain(terrain, chunk_index);
+void SceneLoader::release_dropped_prefetches()
+{
+    for(auto it=dropped_prefetches_.begin(); it!=dropped_prefetches_.end();)
+    {
+        if((*it)->job.is_done())
+        {
+            delete (*it)->heightmap;
+            it = dropped_prefetches_.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+void SceneLoader::clear_prefetched_chunks()
+{
+    for(auto&& [key, prefetched]: prefetched_heightmaps_)
+        dropped_prefetches_.push_back(std::move(prefetched));
+    prefetched_heightmaps_.clear();
+    for(auto&& prefetched: dropped_prefetches_)
+    {
+        JOBS.wait(prefetched->job);
+        delete prefetched->heightmap;
+    }
+    dropped_prefetches_.clear();
 }
 
 void SceneLoader::parse_models(xml_node<>* chunk_node, uint32_t chunk_index)
 {
+    W_PROFILE_SCOPE("Parse models");
     xml_node<>* mdls_node = chunk_node->first_node("Models");
     if(!mdls_node) return;
 
@@ -806,22 +1008,28 @@ void SceneLoader::parse_models(xml_node<>* chunk_node, uint32_t chunk_index)
         // Spacial transformation
         if(trn_node)
         {
-            Transformation trans;
-            parse_transformation(trn_node, trans);
-
-            pmdl->set_transformation(trans);
-            // Is the y position specified relative to a height map?
-            if(relative_positioning)
+            if(const BakedTransform* baked = next_baked_transforms(1))
+                pmdl->set_transformation(make_transformation(*baked));
+            else
             {
-                // If so, translate model using chunk heightmap
-                ground_model(*pmdl, chunk_index);
-            }
+                Transformation trans;
+                parse_transformation(trn_node, trans);
 
-            // Translate according to chunk coordinates
-            auto chunk_coords = pscene_->get_chunk_coordinates(chunk_index);
-            pmdl->translate((chunk_size_m_-1)*chunk_coords.x(),
-                            0,
-                            (chunk_size_m_-1)*chunk_coords.y());
+                pmdl->set_transformation(trans);
+                // Is the y position specified relative to a height map?
+                if(relative_positioning)
+                {
+                    // If so, translate model using chunk heightmap
+                    ground_model(*pmdl, chunk_index);
+                }
+
+                // Translate according to chunk coordinates
+                auto chunk_coords = pscene_->get_chunk_coordinates(chunk_index);
+                pmdl->translate((chunk_size_m_-1)*chunk_coords.x(),
+                                0,
+                                (chunk_size_m_-1)*chunk_coords.y());
+                bake_transform(pmdl->get_transformation());
+            }
         }
 
         // Shadow options
@@ -924,9 +1132,11 @@ void SceneLoader::parse_line_models(xml_node<>* chunk_node, uint32_t chunk_index
 
 void SceneLoader::parse_model_batches(xml_node<>* chunk_node, uint32_t chunk_index)
 {
+    W_PROFILE_SCOPE("Parse model batches");
     xml_node<>* bat_node = chunk_node->first_node("ModelBatches");
     if(!bat_node) return;
 
+    uint32_t batch_index = 0;
     for (xml_node<>* batch=bat_node->first_node("ModelBatch"); batch; batch=batch->next_sibling())
     {
         // Get nodes
@@ -949,9 +1159,21 @@ void SceneLoader::parse_model_batches(xml_node<>* chunk_node, uint32_t chunk_ind
         std::uniform_int_distribution<uint32_t> mesh_seed(0,std::numeric_limits<uint32_t>::max());
         std::uniform_real_distribution<float> var_distrib(-1.0f,1.0f);
 
-        // Generate batch transformations
+        // Generate batch transformations. When they are baked, the random draws
+        // they consumed are skipped so that procedural meshes are the same.
         std::vector<Transformation> transforms;
-        parse_transformation(trn_node, instances, transforms, rng);
+        const BakedTransform* baked = nullptr;
+        if(baked_chunk_ && batch_index < baked_chunk_->get_header().n_batches)
+            baked = next_baked_transforms(instances);
+        if(baked)
+            rng.discard(baked_chunk_->get_batch_draws()[batch_index]);
+        else
+        {
+            uint32_t draws = parse_transformation(trn_node, instances, transforms, rng);
+            if(pending_bake_)
+                pending_bake_->batch_draws.push_back(draws);
+        }
+        ++batch_index;
 
         for(uint32_t ii=0; ii<instances; ++ii)
         {
@@ -959,19 +1181,25 @@ void SceneLoader::parse_model_batches(xml_node<>* chunk_node, uint32_t chunk_ind
             pModel pmdl = game_object_factory_->make_model(mesh_node, mat_node, mesh_is_instance, &rng);
 
             // Transform
-            pmdl->set_transformation(transforms[ii]);
-
-            // Is the y position specified relative to a height map?
-            if(relative_positioning)
+            if(baked)
+                pmdl->set_transformation(make_transformation(baked[ii]));
+            else
             {
-                // If so, translate model using chunk height map.
-                ground_model(*pmdl, chunk_index);
+                pmdl->set_transformation(transforms[ii]);
+
+                // Is the y position specified relative to a height map?
+                if(relative_positioning)
+                {
+                    // If so, translate model using chunk height map.
+                    ground_model(*pmdl, chunk_index);
+                }
+                // Translate according to chunk coordinates
+                auto chunk_coords = pscene_->get_chunk_coordinates(chunk_index);
+                pmdl->translate((chunk_size_m_-1)*chunk_coords.x(),
+                                0,
+                                (chunk_size_m_-1)*chunk_coords.y());
+                bake_transform(pmdl->get_transformation());
             }
-            // Translate according to chunk coordinates
-            auto chunk_coords = pscene_->get_chunk_coordinates(chunk_index);
-            pmdl->translate((chunk_size_m_-1)*chunk_coords.x(),
-                            0,
-                            (chunk_size_m_-1)*chunk_coords.y());
 
             if(shadow_node)
             {
@@ -992,6 +1220,7 @@ void SceneLoader::parse_model_batches(xml_node<>* chunk_node, uint32_t chunk_ind
 
 void SceneLoader::parse_entities(rapidxml::xml_node<>* chunk_node, uint32_t chunk_index)
 {
+    W_PROFILE_SCOPE("Parse entities");
     xml_node<>* ents_node = chunk_node->first_node("Entities");
     if(!ents_node) return;
 
@@ -1036,10 +1265,32 @@ void SceneLoader::parse_entities(rapidxml::xml_node<>* chunk_node, uint32_t chun
 
 void SceneLoader::parse_lights(xml_node<>* chunk_node, uint32_t chunk_index)
 {
+    W_PROFILE_SCOPE("Parse lights");
     xml_node<>* lit_nodes = chunk_node->first_node("Lights");
     if(!lit_nodes) return;
 
-    for (xml_node<>* light=lit_nodes->first_node("Light"); light; light=light->next_sibling())
+    // Baked lights only need their node when they are dynamic
+    if(baked_chunk_ && baked_chunk_->get_header().n_lights > 0)
+    {
+        const BakedLight* lights = baked_chunk_->get_lights();
+        xml_node<>* light = lit_nodes->first_node("Light");
+        uint32_t node_index = 0;
+        for(uint32_t ii=0; ii<baked_chunk_->get_header().n_lights; ++ii)
+        {
+            xml_node<>* light_node = nullptr;
+            if(lights[ii].flags & BAKED_LIGHT_DYNAMIC)
+            {
+                for(; light && node_index<lights[ii].node_index; light=light->next_sibling())
+                    ++node_index;
+                light_node = light;
+            }
+            make_light(lights[ii], light_node, chunk_index);
+        }
+        return;
+    }
+
+    uint32_t node_index = 0;
+    for (xml_node<>* light=lit_nodes->first_node("Light"); light; light=light->next_sibling(), ++node_index)
     {
         std::string light_type;
         vec3 position;
@@ -1062,54 +1313,92 @@ void SceneLoader::parse_lights(xml_node<>* chunk_node, uint32_t chunk_index)
             position[1] += height;
         }
 
+        float radius = 0.f;
+        uint32_t flags = 0;
         if(!light_type.compare("directional"))
         {
-            std::shared_ptr<Light> dirlight(new DirectionalLight(position.normalized(),
-                                                                 color,
-                                                                 brightness));
-            dirlight->set_ambient_strength(ambient_strength);
-            pscene_->add_directional_light(dirlight);
+            position = position.normalized();
         }
         else if(!light_type.compare("point"))
         {
-            float radius = 10.f;
+            radius = 10.f;
             xml::parse_node(light, "Radius", radius);
 
             // Translate according to chunk coordinates
             auto chunk_coords = pscene_->get_chunk_coordinates(chunk_index);
-            vec3 offset((chunk_size_m_-1)*chunk_coords.x(),
-                        0,
-                        (chunk_size_m_-1)*chunk_coords.y());
+            position += vec3((chunk_size_m_-1)*chunk_coords.x(),
+                             0,
+                             (chunk_size_m_-1)*chunk_coords.y());
+
+            flags |= BAKED_LIGHT_POINT;
+            if(light->first_node("Motion") || light->first_attribute("href"))
+                flags |= BAKED_LIGHT_DYNAMIC;
+        }
+        else continue;
+
+        BakedLight params;
+        params.flags = flags;
+        params.node_index = node_index;
+        for(int ii=0; ii<3; ++ii)
+        {
+            params.position[ii] = position[ii];
+            params.color[ii] = color[ii];
+        }
+        params.brightness = brightness;
+        params.ambient_strength = ambient_strength;
+        params.radius = radius;
+        if(pending_bake_)
+            pending_bake_->lights.push_back(params);
+
+        make_light(params, light, chunk_index);
+    }
+}
+
+void SceneLoader::make_light(const BakedLight& params, xml_node<>* light_node, uint32_t chunk_index)
+{
+    vec3 position(params.position[0], params.position[1], params.position[2]);
+    vec3 color(params.color[0], params.color[1], params.color[2]);
 
-            std::shared_ptr<Light> pointlight(new PointLight(position+offset,
+    if(!(params.flags & BAKED_LIGHT_POINT))
+    {
+        std::shared_ptr<Light> dirlight(new DirectionalLight(position,
                                                              color,
-                                                             radius,
-                                                             brightness));
-            pointlight->set_ambient_strength(ambient_strength);
+                                                             params.brightness));
+        dirlight->set_ambient_strength(params.ambient_strength);
+        pscene_->add_directional_light(dirlight);
+        return;
+    }
 
-            // Motion
-            xml_node<>* mot_node = light->first_node("Motion");
-            if(mot_node)
-            {
-                parse_motion(mot_node, pointlight, chunk_index);
-            }
+    std::shared_ptr<Light> pointlight(new PointLight(position,
+                                                     color,
+                                                     params.radius,
+                                                     params.brightness));
+    pointlight->set_ambient_strength(params.ambient_strength);
+
+    if(light_node)
+    {
+        // Motion
+        xml_node<>* mot_node = light_node->first_node("Motion");
+        if(mot_node)
+        {
+            parse_motion(mot_node, pointlight, chunk_index);
+        }
 
         // Should we save a reference so that the light can be accessed via a hash?
 #ifdef __DEBUG__
-            std::string ref;
-            if(xml::parse_attribute(light, "href", ref))
-            {
-                hash_t href = H_(ref.c_str());
-                pointlight->set_reference(href);
-                HRESOLVE.add_intern_string(ref);
-            }
+        std::string ref;
+        if(xml::parse_attribute(light_node, "href", ref))
+        {
+            hash_t href = H_(ref.c_str());
+            pointlight->set_reference(href);
+            HRESOLVE.add_intern_string(ref);
+        }
 #else
-            if(hash_t href = xml::parse_attribute_h(light, "href"))
-                pointlight->set_reference(href);
+        if(hash_t href = xml::parse_attribute_h(light_node, "href"))
+            pointlight->set_reference(href);
 #endif
-            pscene_->add_light(pointlight, chunk_index);
-        }
     }
+    pscene_->add_light(pointlight, chunk_index);
 }
 
 void SceneLoader::parse_camera(xml_node<>* node)
@@ -1155,10 +1444,10 @@ void SceneLoader::parse_transformation(xml_node<>* trn_node, Transformation& tra
     }
 }
 
-void SceneLoader::parse_transformation(rapidxml::xml_node<>* trn_node,
-                          uint32_t n_instances,
-                          std::vector<Transformation>& trans_vector,
-                          std::mt19937& rng)
+uint32_t SceneLoader::parse_transformation(rapidxml::xml_node<>* trn_node,
+                                           uint32_t n_instances,
+                                           std::vector<Transformation>& trans_vector,
+                                           std::mt19937& rng)
 {
     xml_node<>* pos_node = trn_node->first_node("Position");
     xml_node<>* ang_node = trn_node->first_node("Angle");
@@ -1220,6 +1509,12 @@ void SceneLoader::parse_transformation(rapidxml::xml_node<>* trn_node,
         }
         trans_vector.push_back(trans);
     }
+
+    // Each variance component is a single draw
+    uint32_t draws_per_instance = (pos_has_variance ? 3 : 0)
+                                + (ang_has_variance ? 3 : 0)
+                                + (scl_has_variance ? 1 : 0);
+    return n_instances*draws_per_instance;
 }
 
 /*
@@ -1276,6 +1571,40 @@ void SceneLoader::ground_model(LineModel& model, uint32_t chunk_index)
     }
 }
 
+const BakedTransform* SceneLoader::next_baked_transforms(uint32_t count)
+{
+    if(baked_chunk_ == nullptr)
+        return nullptr;
+
+    // Once a model falls back to parsing, all following models must too
+    uint32_t n_transforms = baked_chunk_->get_header().n_transforms;
+    if(baked_transform_cursor_ + count > n_transforms)
+    {
+        baked_transform_cursor_ = n_transforms + 1;
+        return nullptr;
+    }
+
+    const BakedTransform* transforms = baked_chunk_->get_transforms() + baked_transform_cursor_;
+    baked_transform_cursor_ += count;
+    return transforms;
+}
+
+void SceneLoader::bake_transform(const Transformation& trans)
+{
+    if(pending_bake_ == nullptr)
+        return;
+
+    BakedTransform baked;
+    const vec3& position = trans.get_position();
+    const vec4& orientation = trans.get_orientation().get_as_vec();
+    for(int ii=0; ii<3; ++ii)
+        baked.position[ii] = position[ii];
+    for(int ii=0; ii<4; ++ii)
+        baked.orientation[ii] = orientation[ii];
+    baked.scale = trans.get_scale();
+    pending_bake_->transforms.push_back(baked);
+}
+
 void SceneLoader::parse_bezier_interpolator(rapidxml::xml_node<>* bez_node,
                                             std::vector<math::vec3>& controls,
                                             uint32_t chunk_index)
@@ -6,6 +6,8 @@
 #include <GL/glew.h>
 
 #include "shader.h"
+#include "gfx_api.h"
+#include "platform/null/null_renderer_api.h"
 #include "lights.h"
 #include "material.h"
 #include "texture.h"
@@ -139,8 +141,9 @@ FragmentShaderID_(0)
     program_active_report();
 #endif
 
-    // Register uniform locations
+    // Register uniform locations and block bindings
     setup_uniform_map();
+    setup_uniform_blocks();
     DLOGES("shader", Severity::LOW);
 }
 
@@ -155,6 +158,9 @@ Shader::~Shader()
         if(it != hotswap_shaders_.end())
             hotswap_shaders_.erase(it);
     #endif
+    if(Gfx::get_api() == GfxAPI::Null)
+        return;
+
     glDetachShader(ProgramID_,VertexShaderID_);
     glDetachShader(ProgramID_,FragmentShaderID_);
     if(GeometryShaderID_)
@@ -184,16 +190,26 @@ void Shader::dbg_hotswap()
 
 void Shader::use() const
 {
-    glUseProgram(ProgramID_);
+    if(Gfx::get_api() == GfxAPI::Null)
+        null_device().set_state(NullState::Program, ProgramID_);
+    else
+        glUseProgram(ProgramID_);
 }
 
 void Shader::unuse() const
 {
-    glUseProgram(0);
+    if(Gfx::get_api() == GfxAPI::Null)
+        null_device().set_state(NullState::Program, 0);
+    else
+        glUseProgram(0);
 }
 
 bool Shader::reload()
 {
+    // Nothing to recompile
+    if(Gfx::get_api() == GfxAPI::Null)
+        return true;
+
     GLuint vs_id = 0;
     GLuint gs_id = 0;
     GLuint fs_id = 0;
@@ -262,12 +278,19 @@ bool Shader::reload()
     FragmentShaderID_ = fs_id;
     ProgramID_ = pr_id;
 
+    // Locations may have changed, and the new program holds default uniform values
+    setup_uniform_map();
+    setup_uniform_blocks();
+
     return true;
 }
 
 void Shader::program_active_report()
 {
     #ifdef __DEBUG__
+        if(Gfx::get_api() == GfxAPI::Null)
+            return;
+
         // Display active attributes
         GLint active_attribs;
         glGetProgramiv(ProgramID_, GL_ACTIVE_ATTRIBUTES, &active_attribs);
@@ -304,11 +327,15 @@ void Shader::program_active_report()
 
 void Shader::setup_uniform_map()
 {
+    uniforms_.clear();
+    if(Gfx::get_api() == GfxAPI::Null)
+        return;
+
     // Get number of active uniforms
     GLint num_active_uniforms;
     glGetProgramiv(ProgramID_, GL_ACTIVE_UNIFORMS, &num_active_uniforms);
 
-    // For each uniform register name in map
+    // For each uniform register name in table
     for(GLint ii=0; ii<num_active_uniforms; ++ii)
     {
         GLchar name[33];
@@ -316,8 +343,80 @@ void Shader::setup_uniform_map()
 
         glGetActiveUniformName(ProgramID_, ii, 32, &length, name);
         GLint location = glGetUniformLocation(ProgramID_, name);
+        // Members of uniform blocks have no location, they are sourced from buffers
+        if(location == -1)
+            continue;
+
+        UniformSlot slot;
+        slot.name = H_(name);
+        slot.location = location;
+        slot.cached_size = 0;
+        uniforms_.push_back(slot);
+    }
+
+    // Sort by hname for binary search
+    std::sort(uniforms_.begin(), uniforms_.end(),
+              [](const UniformSlot& a, const UniformSlot& b) { return a.name < b.name; });
+}
+
+const Shader::UniformSlot* Shader::find_uniform(hash_t name) const
+{
+    auto it = std::lower_bound(uniforms_.begin(), uniforms_.end(), name,
+                               [](const UniformSlot& slot, hash_t value) { return slot.name < value; });
+    if(it == uniforms_.end() || it->name != name)
+    {
+        if(Gfx::get_api() != GfxAPI::Null)
+            return nullptr;
+
+        UniformSlot slot;
+        slot.name = name;
+        slot.location = int32_t(uniforms_.size());
+        slot.cached_size = 0;
+        it = uniforms_.insert(it, slot);
+    }
+    return &*it;
+}
 
-        uniform_locations_.insert(std::make_pair(H_(name), location));
+bool Shader::upload_needed(const UniformSlot& slot, const void* value, uint32_t size) const
+{
+    if(!slot.update(value, size))
+        return false;
+    if(Gfx::get_api() == GfxAPI::Null)
+    {
+        null_device().upload(size);
+        return false;
+    }
+    return true;
+}
+
+// Engine-wide uniform blocks and their binding points
+static const std::map<hash_t, UniformBlock> UNIFORM_BLOCKS =
+{
+    {"frame_data"_h,  UniformBlock::FRAME},
+    {"object_data"_h, UniformBlock::OBJECT},
+};
+
+void Shader::setup_uniform_blocks()
+{
+    if(Gfx::get_api() == GfxAPI::Null)
+        return;
+
+    GLint num_active_blocks;
+    glGetProgramiv(ProgramID_, GL_ACTIVE_UNIFORM_BLOCKS, &num_active_blocks);
+
+    for(GLint ii=0; ii<num_active_blocks; ++ii)
+    {
+        GLchar name[33];
+        GLsizei length=0;
+
+        glGetActiveUniformBlockName(ProgramID_, ii, 32, &length, name);
+        auto it = UNIFORM_BLOCKS.find(H_(name));
+        if(it == UNIFORM_BLOCKS.end())
+        {
+            DLOGW("[Shader] Unknown uniform block: " + std::string(name), "shader");
+            continue;
+        }
+        glUniformBlockBinding(ProgramID_, ii, uint32_t(it->second));
     }
 }
 
@@ -419,6 +518,10 @@ GLuint Shader::compile_shader(const std::string& shader_file,
         }
     }
 
+    // Source is still parsed with the null graphics API, only compilation is skipped
+    if(Gfx::get_api() == GfxAPI::Null)
+        return null_device().create_handle();
+
     GLuint ShaderID = glCreateShader(ShaderType);
     if(ShaderID == 0)
     {
@@ -468,6 +571,12 @@ GLuint Shader::compile_shader(const std::string& shader_file,
 
 bool Shader::link()
 {
+    if(Gfx::get_api() == GfxAPI::Null)
+    {
+        ProgramID_ = null_device().create_handle();
+        return true;
+    }
+
     ProgramID_ = glCreateProgram();
     glAttachShader(ProgramID_, VertexShaderID_);
     if(GeometryShaderID_) glAttachShader(ProgramID_, GeometryShaderID_);
@@ -582,62 +691,70 @@ void Shader::warn_uniform_unknown_type() const
 template <>
 bool Shader::send_uniform<bool>(hash_t name, const bool& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniform1i(it->second, value);
+    glUniform1i(slot->location, value);
     return true;
 }
 
 template <>
 bool Shader::send_uniform<float>(hash_t name, const float& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniform1f(it->second, value);
+    glUniform1f(slot->location, value);
     return true;
 }
 
 template <>
 bool Shader::send_uniform<int>(hash_t name, const int& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniform1i(it->second, value);
+    glUniform1i(slot->location, value);
     return true;
 }
 /*
 template <>
 bool Shader::send_uniform<uint32_t>(hash_t name, const uint32_t& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
     glUniform1ui(location, value);
     return true;
@@ -646,96 +763,108 @@ bool Shader::send_uniform<uint32_t>(hash_t name, const uint32_t& value) const
 template <>
 bool Shader::send_uniform<math::vec2>(hash_t name, const math::vec2& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniform2fv(it->second, 1, (const GLfloat*)&value);
+    glUniform2fv(slot->location, 1, (const GLfloat*)&value);
     return true;
 }
 
 template <>
 bool Shader::send_uniform<math::vec3>(hash_t name, const math::vec3& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniform3fv(it->second, 1, (const GLfloat*)&value);
+    glUniform3fv(slot->location, 1, (const GLfloat*)&value);
     return true;
 }
 
 template <>
 bool Shader::send_uniform<math::vec4>(hash_t name, const math::vec4& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniform4fv(it->second, 1, (const GLfloat*)&value);
+    glUniform4fv(slot->location, 1, (const GLfloat*)&value);
     return true;
 }
 
 template <>
 bool Shader::send_uniform<math::mat2>(hash_t name, const math::mat2& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniformMatrix2fv(it->second, 1, GL_FALSE, value.get_pointer());
+    glUniformMatrix2fv(slot->location, 1, GL_FALSE, value.get_pointer());
     return true;
 }
 
 template <>
 bool Shader::send_uniform<math::mat3>(hash_t name, const math::mat3& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniformMatrix3fv(it->second, 1, GL_FALSE, value.get_pointer());
+    glUniformMatrix3fv(slot->location, 1, GL_FALSE, value.get_pointer());
     return true;
 }
 
 template <>
 bool Shader::send_uniform<math::mat4>(hash_t name, const math::mat4& value) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, &value, sizeof(value)))
+        return true; // Same value as last upload, or no device
 
-    glUniformMatrix4fv(it->second, 1, GL_FALSE, value.get_pointer());
+    glUniformMatrix4fv(slot->location, 1, GL_FALSE, value.get_pointer());
     return true;
 }
 
@@ -862,16 +991,36 @@ bool Shader::send_uniforms(const Light& light) const
 template<>
 bool Shader::send_uniform_array<float>(hash_t name, float* array, int size) const
 {
-    auto it = uniform_locations_.find(name);
-    if(it == uniform_locations_.end())
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
+    {
+#ifdef __DEBUG__
+        warn_unknown_uniform(name_, name);
+#endif
+        return false;
+    }
+    if(!upload_needed(*slot, array, size*sizeof(float)))
+        return true; // Same values as last upload, or no device
+
+    glUniform1fv(slot->location, size, array);
+    return true;
+}
+
+template<>
+bool Shader::send_uniform_array<math::mat4>(hash_t name, math::mat4* array, int size) const
+{
+    const UniformSlot* slot = find_uniform(name);
+    if(slot == nullptr)
     {
 #ifdef __DEBUG__
         warn_unknown_uniform(name_, name);
 #endif
         return false;
     }
+    if(!upload_needed(*slot, array, size*sizeof(math::mat4)))
+        return true; // Same values as last upload, or no device
 
-    glUniform1fv(it->second, size, array);
+    glUniformMatrix4fv(slot->location, size, GL_FALSE, array[0].get_pointer());
     return true;
 }
 
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+
 #include "gfx_api.h"
 #include "shadow_map_renderer.h"
 #include "config.h"
@@ -19,6 +22,10 @@ using namespace math;
 uint32_t ShadowMapRenderer::SHADOW_WIDTH  = 1024;
 uint32_t ShadowMapRenderer::SHADOW_HEIGHT = 1024;
 
+// Fixed light space depth range, because tight fit z-bounds would cause occluder clipping
+static constexpr float Z_NEAR = -10.0f;
+static constexpr float Z_FAR  = 200.0f;
+
 vec2 ShadowMapRenderer::SHADOW_TEXEL_SIZE(1.0f/ShadowMapRenderer::SHADOW_WIDTH, 1.0f/ShadowMapRenderer::SHADOW_HEIGHT);
 
 ShadowMapRenderer::ShadowMapRenderer():
@@ -32,15 +39,30 @@ ShadowMapRenderer::ShadowMapRenderer():
 #else
     sm_shader_(ShaderResource("shadowmap.vert;null.frag")),
 #endif
-normal_offset_(-0.013f)
+normal_offset_(-0.013f),
+split_lambda_(0.75f),
+n_cascades_(3),
+far_cascade_interval_(1),
+frame_index_(0)
 {
     CONFIG.get("root.render.shadowmap.width"_h, SHADOW_WIDTH);
     CONFIG.get("root.render.shadowmap.height"_h, SHADOW_HEIGHT);
+    CONFIG.get("root.render.shadowmap.cascades"_h, n_cascades_);
+    CONFIG.get("root.render.shadowmap.split_lambda"_h, split_lambda_);
+    CONFIG.get("root.render.shadowmap.far_cascade_interval"_h, far_cascade_interval_);
+    n_cascades_ = std::min(std::max(n_cascades_, 1u), MAX_CASCADES);
+    far_cascade_interval_ = std::max(far_cascade_interval_, 1u);
     SHADOW_TEXEL_SIZE = vec2(1.0f/SHADOW_WIDTH, 1.0f/SHADOW_HEIGHT);
 
+    for(auto&& cascade: cascades_)
+    {
+        cascade.light_matrix.init_identity();
+        cascade.far_depth = 0.f;
+    }
+
     //SHADOWBUFFER.Init(SHADOW_WIDTH, SHADOW_HEIGHT);
 
-    // Shadow map buffer
+    // Shadow map atlas, cascades are laid out horizontally
     GMODULES::REGISTER(std::make_unique<BufferModule>
     (
         "shadowmap",
@@ -54,7 +76,7 @@ normal_offset_(-0.013f)
                 TextureUnitInfo("shadowTex"_h, TextureFilter(TextureFilter::MAG_NEAREST | TextureFilter::MIN_NEAREST), TextureIF::DEPTH_COMPONENT24),
             #endif
             },
-            SHADOW_WIDTH,
+            SHADOW_WIDTH*n_cascades_,
             SHADOW_HEIGHT,
             TextureWrap::CLAMP_TO_EDGE
         )
@@ -66,6 +88,52 @@ ShadowMapRenderer::~ShadowMapRenderer()
 
 }
 
+void ShadowMapRenderer::fit_cascade(uint32_t index, const mat4& light_view, const mat4& light_view_inv)
+{
+    std::array<vec3, 8> corners;
+    view_box_.split_corners(index, corners);
+
+    // * Bounding sphere of frustum slice
+    // Its size does not depend on camera orientation, so the cascade does not shimmer when camera rotates
+    vec3 center(0.f);
+    for(auto&& corner: corners)
+        center += corner;
+    center /= 8.f;
+    float radius = 0.f;
+    for(auto&& corner: corners)
+        radius = std::max(radius, (corner-center).norm());
+    radius = std::ceil(radius*16.f)/16.f;
+
+    // * Round light space center to the nearest texel (limits shadow flickering when camera moves)
+    vec3 center_ls = light_view*center;
+    float texel_x = 2.f*radius/SHADOW_WIDTH;
+    float texel_y = 2.f*radius/SHADOW_HEIGHT;
+    float xmin = std::floor(center_ls.x()/texel_x)*texel_x - radius;
+    float ymin = std::floor(center_ls.y()/texel_y)*texel_y - radius;
+    float xmax = xmin + 2.f*radius;
+    float ymax = ymin + 2.f*radius;
+
+    mat4 P;
+    init_ortho(P, Frustum(xmin, xmax, ymin, ymax, Z_NEAR, Z_FAR));
+    cascades_[index].light_matrix = P*light_view;
+
+    // * World space culling volume, light view looks down -z
+    std::array<vec3, 8> box =
+    {
+        vec3(xmax, ymin, -Z_NEAR), // RBN
+        vec3(xmax, ymin, -Z_FAR),  // RBF
+        vec3(xmin, ymin, -Z_FAR),  // LBF
+        vec3(xmin, ymin, -Z_NEAR), // LBN
+        vec3(xmax, ymax, -Z_NEAR), // RTN
+        vec3(xmax, ymax, -Z_FAR),  // RTF
+        vec3(xmin, ymax, -Z_FAR),  // LTF
+        vec3(xmin, ymax, -Z_NEAR), // LTN
+    };
+    for(auto&& vertex: box)
+        vertex = light_view_inv*vertex;
+    cascade_box_.update(box);
+}
+
 void ShadowMapRenderer::render(Scene* pscene)
 {
     // TMP: For now, only render directional shadow
@@ -73,59 +141,95 @@ void ShadowMapRenderer::render(Scene* pscene)
     // * RENDER DIRECTIONAL LIGHT SHADOW
     if(auto dir_light = pscene->get_directional_light().lock())
     {
-/*#ifdef __EXPERIMENTAL_VARIANCE_SHADOW_MAPPING__
-        // TODO Find a way to cache scene sorting
-        pscene->sort_models_light();
-#endif*/
-
         auto& shadow_buffer = GMODULES::GET("shadowmap"_h);
+        Camera& camera = pscene->get_camera();
+
+        // * Slice view frustum
+        view_box_ = camera.get_frustum_box();
+        view_box_.set_splits(n_cascades_, split_lambda_, camera.get_near(), camera.get_far());
 
-        // Light matrix is light camera view-projection matrix
-        light_matrix_ = pscene->get_light_camera().get_view_projection_matrix();
+        // Light camera gives the light direction
+        const mat4& light_view = pscene->get_light_camera().get_view_matrix();
+        mat4 light_view_inv;
+        math::inverse_affine(light_view, light_view_inv);
 
         Gfx::device->disable_blending();
         sm_shader_.use();
         shadow_buffer.bind_as_target();
-#ifdef __EXPERIMENTAL_VARIANCE_SHADOW_MAPPING__
-        Gfx::device->clear(CLEAR_COLOR_FLAG);
-#else
+#ifndef __EXPERIMENTAL_VARIANCE_SHADOW_MAPPING__
         Gfx::device->set_depth_test_enabled(true);
         Gfx::device->set_depth_lock(false);
-        Gfx::device->clear(CLEAR_DEPTH_FLAG);
 #endif
+        // Clears are restricted to the current cascade tile
+        Gfx::device->set_scissor_test_enabled(true);
         //sm_shader_.send_uniform("lt.v3_lightPosition"_h, dir_light->get_position());
         sm_shader_.send_uniform("f_normalOffset"_h, normal_offset_);
-        pscene->draw_models([&](const Model& model)
+        uint32_t shader_id = sm_shader_.get_program_id();
+
+        for(uint32_t ii=0; ii<n_cascades_; ++ii)
         {
-            uint32_t cull_face = model.shadow_cull_face();
-            switch(cull_face)
+            cascades_[ii].far_depth = camera.get_near() + (camera.get_far()-camera.get_near())*view_box_.get_split(ii+1);
+
+            // * Far cascades keep their last shadow map and light matrix between refreshes
+            // All cascades are rendered on first frame
+            if(ii>0 && frame_index_>0 && (frame_index_+ii)%far_cascade_interval_ != 0)
+                continue;
+
+            fit_cascade(ii, light_view, light_view_inv);
+
+            // * Cull casters against cascade light frustum
+            // Casters have no material, the material field holds the cull face.
+            // Sort by cull face, then front to back along light direction
+            caster_bucket_.clear();
+            pscene->submit_shadow_casters(caster_bucket_, cascade_box_, [&](const Model& model, uint32_t chunk_index)
             {
-                case 1:
-                    Gfx::device->set_cull_mode(CullMode::Front);
-                    break;
-
-                case 2:
-                    Gfx::device->set_cull_mode(CullMode::Back);
-                    break;
-
-                default:
-                    Gfx::device->set_cull_mode(CullMode::None);
-            }
-            // Get model matrix and compute products
-            math::mat4 M = const_cast<Model&>(model).get_model_matrix();
-            //math::mat4 MV = Vl*M;
-            math::mat4 MVP = light_matrix_*M;
-            sm_shader_.send_uniform("m4_ModelViewProjection"_h, MVP);
-            //sm_shader_.send_uniform("m3_Normal"_h, MV.submatrix(3,3));
-        }/*,
-        wcore::DEFAULT_MODEL_EVALUATOR,
+                float depth = (-(light_view*model.get_position()).z() - Z_NEAR) / (Z_FAR - Z_NEAR);
+                return sort_key::make(sort_key::PASS_SHADOW, shader_id, uint32_t(model.shadow_cull_face()),
+                                      sort_key::quantize_depth(depth), chunk_index);
+            });
+            caster_bucket_.sort();
+
+            // * Render to cascade tile
+            int32_t x_offset = int32_t(ii*SHADOW_WIDTH);
+            Gfx::device->viewport(x_offset, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+            Gfx::device->set_scissor(x_offset, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
 #ifdef __EXPERIMENTAL_VARIANCE_SHADOW_MAPPING__
-        wcore::ORDER::BACK_TO_FRONT
+            Gfx::device->clear(CLEAR_COLOR_FLAG);
 #else
-        wcore::ORDER::FRONT_TO_BACK
-#endif*/
-        );
+            Gfx::device->clear(CLEAR_DEPTH_FLAG);
+#endif
+            const mat4& light_matrix = cascades_[ii].light_matrix;
+            uint32_t last_cull_face = ~0u;
+            caster_bucket_.execute([&](uint64_t, const DrawCommand& command)
+            {
+                const Model& model = *command.model;
+                uint32_t cull_face = model.shadow_cull_face();
+                if(cull_face != last_cull_face)
+                {
+                    switch(cull_face)
+                    {
+                        case 1:
+                            Gfx::device->set_cull_mode(CullMode::Front);
+                            break;
+
+                        case 2:
+                            Gfx::device->set_cull_mode(CullMode::Back);
+                            break;
+
+                        default:
+                            Gfx::device->set_cull_mode(CullMode::None);
+                    }
+                    last_cull_face = cull_face;
+                }
+                // Get model matrix and compute products
+                math::mat4 MVP = light_matrix*const_cast<Model&>(model).get_model_matrix();
+                sm_shader_.send_uniform("m4_ModelViewProjection"_h, MVP);
+                pscene->draw(command);
+            });
+        }
+        ++frame_index_;
 
+        Gfx::device->set_scissor_test_enabled(false);
         shadow_buffer.unbind_as_target();
         sm_shader_.unuse();
     /*
@@ -8,6 +8,7 @@
 #include "obj_loader.h"
 #include "wesh_loader.h"
 #include "cspline.h"
+#include "mesh_lod.h"
 #include "logger.h"
 #include "xml_utils.hpp"
 
@@ -18,10 +19,17 @@ using namespace math;
 
 SurfaceMeshFactory::SurfaceMeshFactory():
 obj_loader_(new ObjLoader()),
-wesh_loader_(new WeshLoader())
+wesh_loader_(new WeshLoader()),
+lod_levels_(3),
+lod_reduction_(0.5f),
+lod_max_error_(0.02f)
 {
     models_path_ = CONFIG.get_root_directory();
     models_path_ = models_path_ / "res/models";
+
+    CONFIG.get("root.render.lod.levels"_h, lod_levels_);
+    CONFIG.get("root.render.lod.reduction"_h, lod_reduction_);
+    CONFIG.get("root.render.lod.max_error"_h, lod_max_error_);
 }
 
 SurfaceMeshFactory::~SurfaceMeshFactory()
@@ -236,7 +244,9 @@ std::shared_ptr<SurfaceMesh> SurfaceMeshFactory::make_procedural(hash_t mesh_typ
         else
             props.density = 1;
 
-        return (std::shared_ptr<SurfaceMesh>)factory::make_ico_sphere(props.density);
+        auto pmesh = (std::shared_ptr<SurfaceMesh>)factory::make_ico_sphere(props.density);
+        make_lods(*pmesh);
+        return pmesh;
     }
     else if(mesh_type == "box"_h)
     {
@@ -267,7 +277,9 @@ std::shared_ptr<SurfaceMesh> SurfaceMeshFactory::make_procedural(hash_t mesh_typ
         TreeProps props;
         props.parse_xml(generator_node);
 
-        return TreeGenerator::generate_tree(props);
+        auto pmesh = TreeGenerator::generate_tree(props);
+        if(pmesh) make_lods(*pmesh);
+        return pmesh;
     }
     else if(mesh_type == "rock"_h && opt_rng)
     {
@@ -280,7 +292,9 @@ std::shared_ptr<SurfaceMesh> SurfaceMeshFactory::make_procedural(hash_t mesh_typ
         std::uniform_int_distribution<uint32_t> mesh_seed(0,std::numeric_limits<uint32_t>::max());
         props.seed = mesh_seed(*opt_rng);
 
-        return RockGenerator::generate_rock(props);
+        auto pmesh = RockGenerator::generate_rock(props);
+        if(pmesh) make_lods(*pmesh);
+        return pmesh;
     }
 
     // Hard-coded procedural meshes
@@ -305,6 +319,17 @@ std::shared_ptr<SurfaceMesh> SurfaceMeshFactory::make_procedural(hash_t mesh_typ
     return pmesh;
 }
 
+void SurfaceMeshFactory::make_lods(SurfaceMesh& mesh) const
+{
+    if(lod_levels_ == 0)
+        return;
+
+    uint32_t n_lods = lod::generate_lods(mesh, lod_levels_, lod_reduction_, lod_max_error_);
+    DLOGI("Generated <v>" + std::to_string(n_lods) + "</v> LODs, coarsest: <v>"
+        + std::to_string(mesh.get_buffer_token(n_lods).n_elements) + "</v>/"
+        + std::to_string(mesh.get_n_elements()) + " triangles.", "model");
+}
+
 std::shared_ptr<SurfaceMesh> SurfaceMeshFactory::make_obj(const char* filename,
                                                           bool process_uv,
                                                           bool process_normals,
@@ -324,8 +349,15 @@ std::shared_ptr<SurfaceMesh> SurfaceMeshFactory::make_obj(const char* filename,
 std::shared_ptr<SurfaceMesh> SurfaceMeshFactory::make_wesh(const char* filename,
                                                            bool centered)
 {
-    auto stream = FILESYSTEM.get_file_as_stream(filename, "root.folders.model"_h, "pack0"_h);
-    std::shared_ptr<SurfaceMesh> pmesh = wesh_loader_->read<Vertex3P3N3T2U>(*stream);
+    // Copy straight from the mapped file if possible, else (compressed archive entry) use a stream
+    std::shared_ptr<SurfaceMesh> pmesh = nullptr;
+    if(auto view = FILESYSTEM.map_file(filename, "root.folders.model"_h, "pack0"_h))
+        pmesh = wesh_loader_->read<Vertex3P3N3T2U>(view);
+    if(pmesh == nullptr)
+    {
+        auto stream = FILESYSTEM.get_file_as_stream(filename, "root.folders.model"_h, "pack0"_h);
+        pmesh = wesh_loader_->read<Vertex3P3N3T2U>(*stream);
+    }
     pmesh->set_centered(centered);
 
     return pmesh;
@@ -66,8 +66,11 @@ void TerrainFactory::generate_simplex(HeightMap& input, const TerrainPatchDescri
     props.startX = desc.chunk_x * (desc.chunk_size-1);
     props.startZ = desc.chunk_z * (desc.chunk_size-1);
 
-    HeightmapGenerator::init_simplex_generator(rng);
-    HeightmapGenerator::heightmap_from_simplex_noise(input, props);
+    // One generator per call, seeded from the descriptor: height maps
+    // are generated concurrently by the prefetch jobs
+    HeightmapGenerator::SimplexGenerator generator;
+    generator.init(rng);
+    HeightmapGenerator::heightmap_from_simplex_noise(input, props, generator);
 }
 
 void TerrainFactory::modify_randomize(HeightMap& input, rapidxml::xml_node<>* modifier_node)
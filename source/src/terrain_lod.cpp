@@ -0,0 +1,167 @@
+#include "terrain_lod.h"
+
+namespace wcore
+{
+namespace lod
+{
+
+TerrainLodLayout::TerrainLodLayout():
+width_(0),
+length_(0),
+n_levels_(0)
+{
+
+}
+
+TerrainLodLayout::TerrainLodLayout(uint32_t width, uint32_t length, uint32_t max_levels):
+width_(width),
+length_(length),
+n_levels_(0)
+{
+    // A level needs at least one inner row and column for the border strips to attach to
+    while(n_levels_<max_levels
+       && samples(width_, n_levels_).size()>=3
+       && samples(length_, n_levels_).size()>=3)
+        ++n_levels_;
+
+    // Body plus one strip per side and edge level
+    level_base_.resize(n_levels_+1);
+    level_base_[0] = 0;
+    for(uint32_t ll=0; ll<n_levels_; ++ll)
+        level_base_[ll+1] = level_base_[ll] + 1 + 4*(n_levels_-ll);
+}
+
+std::vector<uint32_t> TerrainLodLayout::samples(uint32_t count, uint32_t level)
+{
+    std::vector<uint32_t> ret;
+    if(count == 0)
+        return ret;
+    uint32_t step = 1u << level;
+    for(uint32_t ii=0; ii+1<count; ii+=step)
+        ret.push_back(ii);
+    ret.push_back(count-1);
+    return ret;
+}
+
+void TerrainLodLayout::push_triangle(std::vector<uint32_t>& indices,
+                                     uint32_t i0, uint32_t j0,
+                                     uint32_t i1, uint32_t j1,
+                                     uint32_t i2, uint32_t j2) const
+{
+    // y component of (p1-p0)x(p2-p0) with p=(ii,0,jj)
+    int64_t e1x = int64_t(i1)-i0, e1z = int64_t(j1)-j0;
+    int64_t e2x = int64_t(i2)-i0, e2z = int64_t(j2)-j0;
+    int64_t cross_y = e1z*e2x - e1x*e2z;
+    if(cross_y == 0)
+        return;
+
+    indices.push_back(vertex(i0, j0));
+    if(cross_y > 0)
+    {
+        indices.push_back(vertex(i1, j1));
+        indices.push_back(vertex(i2, j2));
+    }
+    else
+    {
+        indices.push_back(vertex(i2, j2));
+        indices.push_back(vertex(i1, j1));
+    }
+}
+
+std::vector<uint32_t> TerrainLodLayout::make_body(uint32_t level) const
+{
+    std::vector<uint32_t> xs = samples(width_, level);
+    std::vector<uint32_t> zs = samples(length_, level);
+
+    std::vector<uint32_t> indices;
+    for(uint32_t ci=1; ci+2<xs.size(); ++ci)
+    {
+        for(uint32_t cj=1; cj+2<zs.size(); ++cj)
+        {
+            uint32_t il = xs[ci], ir = xs[ci+1];
+            uint32_t jb = zs[cj], jt = zs[cj+1];
+            // Same diagonal pattern as the full resolution mesh
+            if(ci%2==0)
+            {
+                push_triangle(indices, il, jb, il, jt, ir, jt);
+                push_triangle(indices, il, jb, ir, jt, ir, jb);
+            }
+            else
+            {
+                push_triangle(indices, il, jb, il, jt, ir, jb);
+                push_triangle(indices, ir, jb, il, jt, ir, jt);
+            }
+        }
+    }
+    return indices;
+}
+
+std::vector<uint32_t> TerrainLodLayout::make_edge(uint32_t level, NEIGHBOR side, uint32_t edge_level) const
+{
+    std::vector<uint32_t> xs = samples(width_, level);
+    std::vector<uint32_t> zs = samples(length_, level);
+    std::vector<uint32_t> xe = samples(width_, edge_level);
+    std::vector<uint32_t> ze = samples(length_, edge_level);
+
+    // * Outer line on the grid edge, inner line on the first body row / column
+    // Points are (ii,jj) pairs, ordered along the edge
+    struct Point { uint32_t ii; uint32_t jj; };
+    std::vector<Point> outer, inner;
+    bool along_z = (side==NEIGHBOR::WEST || side==NEIGHBOR::EAST);
+    switch(side)
+    {
+        case NEIGHBOR::WEST:
+            for(uint32_t jj: ze) outer.push_back({0, jj});
+            for(uint32_t tt=1; tt+1<zs.size(); ++tt) inner.push_back({xs[1], zs[tt]});
+            break;
+        case NEIGHBOR::EAST:
+            for(uint32_t jj: ze) outer.push_back({xs.back(), jj});
+            for(uint32_t tt=1; tt+1<zs.size(); ++tt) inner.push_back({xs[xs.size()-2], zs[tt]});
+            break;
+        case NEIGHBOR::SOUTH:
+            for(uint32_t ii: xe) outer.push_back({ii, 0});
+            for(uint32_t tt=1; tt+1<xs.size(); ++tt) inner.push_back({xs[tt], zs[1]});
+            break;
+        case NEIGHBOR::NORTH:
+            for(uint32_t ii: xe) outer.push_back({ii, zs.back()});
+            for(uint32_t tt=1; tt+1<xs.size(); ++tt) inner.push_back({xs[tt], zs[zs.size()-2]});
+            break;
+    }
+    auto key = [along_z](const Point& p) { return along_z ? p.jj : p.ii; };
+
+    // * Zip both lines, advancing the line whose next point comes first
+    std::vector<uint32_t> indices;
+    uint32_t aa=0, bb=0;
+    while(aa+1<outer.size() || bb+1<inner.size())
+    {
+        bool advance_outer = (bb+1==inner.size())
+                          || (aa+1<outer.size() && key(outer[aa+1])<=key(inner[bb+1]));
+        if(advance_outer)
+        {
+            push_triangle(indices, outer[aa].ii, outer[aa].jj, outer[aa+1].ii, outer[aa+1].jj, inner[bb].ii, inner[bb].jj);
+            ++aa;
+        }
+        else
+        {
+            push_triangle(indices, outer[aa].ii, outer[aa].jj, inner[bb].ii, inner[bb].jj, inner[bb+1].ii, inner[bb+1].jj);
+            ++bb;
+        }
+    }
+    return indices;
+}
+
+std::vector<std::vector<uint32_t>> TerrainLodLayout::make_ranges() const
+{
+    std::vector<std::vector<uint32_t>> ranges(get_range_count());
+    for(uint32_t ll=0; ll<n_levels_; ++ll)
+    {
+        ranges[body_range(ll)] = make_body(ll);
+        for(uint32_t ss=0; ss<4; ++ss)
+            for(uint32_t ee=ll; ee<n_levels_; ++ee)
+                ranges[edge_range(ll, NEIGHBOR(ss), ee)] = make_edge(ll, NEIGHBOR(ss), ee);
+    }
+    return ranges;
+}
+
+} // namespace lod
+} // namespace wcore
@@ -12,6 +12,7 @@ namespace wcore
 using namespace math;
 
 uint32_t TerrainChunk::chunk_size_ = 0;
+uint32_t TerrainChunk::max_lod_levels_ = 4;
 
 TerrainChunk::TerrainChunk(HeightMap* phm,
                            Material* pmat,
@@ -24,9 +25,55 @@ Model(static_cast<std::shared_ptr<SurfaceMesh>>(factory::make_terrain_tri_mesh(*
 heightmap_(phm),
 alt_material_(nullptr),
 splatmap_(nullptr),
-use_splat_(false)
+use_splat_(false),
+lod_level_(0),
+edge_levels_{0,0,0,0}
 {
     is_terrain_ = true;
+    make_lod_ranges();
+}
+
+TerrainChunk::TerrainChunk(HeightMap* phm,
+                           std::shared_ptr<SurfaceMesh> pmesh,
+                           Material* pmat):
+Model(pmesh, pmat),
+heightmap_(phm),
+alt_material_(nullptr),
+splatmap_(nullptr),
+use_splat_(false),
+lod_level_(0),
+edge_levels_{0,0,0,0}
+{
+    is_terrain_ = true;
+    make_lod_ranges();
+}
+
+void TerrainChunk::make_lod_ranges()
+{
+    // Mesh grid is 1 vertex shorter than the height map, see factory::make_terrain_tri_mesh()
+    lod_layout_ = lod::TerrainLodLayout(heightmap_->get_width(),
+                                        heightmap_->get_length()-1,
+                                        max_lod_levels_);
+    // Mesh LOD ii+1 holds range ii
+    pmesh_->clear_lods();
+    for(auto&& indices: lod_layout_.make_ranges())
+        pmesh_->add_lod(std::move(indices));
+}
+
+void TerrainChunk::traverse_lod_tokens(std::function<void(const BufferToken&)> visitor) const
+{
+    if(lod_layout_.get_level_count()==0)
+    {
+        visitor(pmesh_->get_buffer_token());
+        return;
+    }
+
+    visitor(pmesh_->get_buffer_token(1 + lod_layout_.body_range(lod_level_)));
+    for(uint32_t ss=0; ss<4; ++ss)
+    {
+        NEIGHBOR side = NEIGHBOR(ss);
+        visitor(pmesh_->get_buffer_token(1 + lod_layout_.edge_range(lod_level_, side, get_edge_level(side))));
+    }
 }
 
 TerrainChunk::~TerrainChunk()
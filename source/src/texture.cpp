@@ -5,6 +5,8 @@
 
 
 #include "texture.h"
+#include "gfx_api.h"
+#include "platform/null/null_renderer_api.h"
 #include "material_common.h"
 #include "pixel_buffer.h"
 #include "shader.h"
@@ -46,6 +48,7 @@ struct FormatDescriptor
 static std::map<TextureIF, FormatDescriptor> FORMAT_DESCRIPTOR =
 {
     {TextureIF::R8,                              {GL_R8,                                  GL_RED,             GL_UNSIGNED_BYTE}},
+    {TextureIF::R32F,                            {GL_R32F,                                GL_RED,             GL_FLOAT}},
     {TextureIF::RGB8,                            {GL_RGB8,                                GL_RGB,             GL_UNSIGNED_BYTE}},
     {TextureIF::RGBA8,                           {GL_RGBA8,                               GL_RGBA,            GL_UNSIGNED_BYTE}},
     {TextureIF::RG16F,                           {GL_RG16F,                               GL_RG,              GL_HALF_FLOAT}},
@@ -72,8 +75,45 @@ static std::map<TextureIF, FormatDescriptor> FORMAT_DESCRIPTOR =
     {TextureIF::DEPTH32F_STENCIL8,               {GL_DEPTH32F_STENCIL8,                   GL_DEPTH_STENCIL,   GL_FLOAT_32_UNSIGNED_INT_24_8_REV}},
 };
 
+// Size in bytes of a pixel sent to the device in given format
+static uint32_t client_pixel_size(const FormatDescriptor& descriptor)
+{
+    uint32_t n_channels = 1;
+    switch(descriptor.format)
+    {
+        case GL_RG:   n_channels = 2; break;
+        case GL_RGB:  n_channels = 3; break;
+        case GL_RGBA: n_channels = 4; break;
+    }
+
+    switch(descriptor.data_type)
+    {
+        case GL_HALF_FLOAT:
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            return 2*n_channels;
+        case GL_FLOAT:
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_INT_24_8:
+            return 4*n_channels;
+        case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+            return 8;
+    }
+    return n_channels;
+}
+
 static PngLoader PNG_LOADER;
 
+// Check whether a unit in given format has depth / stencil information
+static UnitType get_unit_type(const FormatDescriptor& descriptor)
+{
+    if(descriptor.format == GL_DEPTH_COMPONENT)
+        return UnitType::DEPTH;
+    else if(descriptor.format == GL_DEPTH_STENCIL)
+        return UnitType((uint8_t)UnitType::DEPTH | (uint8_t)UnitType::STENCIL);
+    return UnitType::COLOR;
+}
+
 static bool handle_filter(TextureFilter filter, GLenum target)
 {
     bool has_mipmap = (filter & TextureFilter::MIN_NEAREST_MIPMAP_NEAREST)
@@ -326,7 +366,7 @@ sampler_group_(1)
 
 Texture::~Texture()
 {
-    if(texture_ids_.size())
+    if(texture_ids_.size() && Gfx::get_api() != GfxAPI::Null)
         glDeleteTextures(n_units_, &texture_ids_[0]);
 }
 
@@ -343,23 +383,22 @@ void Texture::bind_all() const
 
 void Texture::bind(uint32_t unit, uint32_t index) const
 {
-    glActiveTexture(GL_TEXTURE0 + unit + (sampler_group_-1)*SAMPLER_GROUP_SIZE);
-    glBindTexture(GL_TEXTURE_2D, texture_ids_[index]);
+    Gfx::device->bind_texture2D(unit + (sampler_group_-1)*SAMPLER_GROUP_SIZE, texture_ids_[index]);
 }
 
 void Texture::unbind() const
 {
     for(uint32_t ii=0; ii<n_units_; ++ii)
-    {
-        glActiveTexture(GL_TEXTURE0 + ii);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
+        Gfx::device->bind_texture2D(ii, 0);
 }
 
 void Texture::generate_mipmaps(uint32_t index,
                                uint32_t base_level,
                                uint32_t max_level) const
 {
+    if(Gfx::get_api() == GfxAPI::Null)
+        return;
+
     glBindTexture(GL_TEXTURE_2D, texture_ids_[index]);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base_level);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level);
@@ -375,7 +414,17 @@ void Texture::generate_texture_unit(const TextureUnitInfo& unit_info,
                                     TextureWrap wrap_param,
                                     bool lazy_mipmap)
 {
-    if(!unit_info.is_shared_)
+    if(!unit_info.is_shared_ && Gfx::get_api() == GfxAPI::Null)
+    {
+        // No device storage, only the pixel transfer is accounted for
+        const auto& format_descriptor = FORMAT_DESCRIPTOR[unit_info.internal_format_];
+        texture_ids_.push_back(null_device().create_handle());
+        uniform_sampler_names_.push_back(unit_info.sampler_name_);
+        unit_types_.push_back(get_unit_type(format_descriptor));
+        if(unit_info.data_)
+            null_device().upload(std::size_t(width_)*height_*client_pixel_size(format_descriptor));
+    }
+    else if(!unit_info.is_shared_)
     {
         size_t index = texture_ids_.size();
         // Generate one texture unit
@@ -395,13 +444,7 @@ void Texture::generate_texture_unit(const TextureUnitInfo& unit_info,
         const auto& format_descriptor = FORMAT_DESCRIPTOR[unit_info.internal_format_];
 
         // Check whether this unit has depth / stencil information
-        UnitType unit_type = UnitType::COLOR;
-        if(format_descriptor.format == GL_DEPTH_COMPONENT)
-            unit_type = UnitType::DEPTH;
-        else if(format_descriptor.format == GL_DEPTH_STENCIL)
-            unit_type = UnitType((uint8_t)UnitType::DEPTH | (uint8_t)UnitType::STENCIL);
-
-        unit_types_.push_back(unit_type);
+        unit_types_.push_back(get_unit_type(format_descriptor));
 
         // Specify OpenGL texture
         glTexImage2D(GL_TEXTURE_2D,
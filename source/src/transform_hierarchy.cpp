@@ -0,0 +1,196 @@
+#include <atomic>
+
+#include "transform_hierarchy.h"
+#include "transformation.h"
+#include "job_system.h"
+
+namespace wcore
+{
+
+using namespace math;
+
+TransformHierarchy::TransformHierarchy():
+order_dirty_(false)
+{
+
+}
+
+uint32_t TransformHierarchy::create(const Transformation& local, uint32_t parent)
+{
+    assert((parent == NONE || is_alive(parent)) && "[TransformHierarchy] Invalid parent.");
+
+    uint32_t node;
+    if(!free_.empty())
+    {
+        node = free_.back();
+        free_.pop_back();
+    }
+    else
+    {
+        node = uint32_t(alive_.size());
+        position_.emplace_back();
+        orientation_.emplace_back();
+        scale_.push_back(1.f);
+        parent_.push_back(NONE);
+        world_.emplace_back();
+        version_.push_back(0);
+        parent_version_.push_back(0);
+        dirty_.push_back(0);
+        alive_.push_back(0);
+    }
+
+    position_[node]    = local.get_position();
+    orientation_[node] = local.get_orientation();
+    scale_[node]       = local.get_scale();
+    parent_[node]      = parent;
+    dirty_[node]       = 1;
+    alive_[node]       = 1;
+    order_dirty_ = true;
+    return node;
+}
+
+void TransformHierarchy::destroy(uint32_t node)
+{
+    assert(is_alive(node) && "[TransformHierarchy] Invalid node.");
+
+    for(uint32_t ii=0; ii<parent_.size(); ++ii)
+    {
+        if(alive_[ii] && parent_[ii] == node)
+        {
+            parent_[ii] = NONE;
+            dirty_[ii] = 1;
+        }
+    }
+    alive_[node] = 0;
+    free_.push_back(node);
+    order_dirty_ = true;
+}
+
+void TransformHierarchy::clear()
+{
+    position_.clear();
+    orientation_.clear();
+    scale_.clear();
+    parent_.clear();
+    world_.clear();
+    version_.clear();
+    parent_version_.clear();
+    dirty_.clear();
+    alive_.clear();
+    free_.clear();
+    order_.clear();
+    level_offsets_.clear();
+    order_dirty_ = false;
+}
+
+void TransformHierarchy::set_local(uint32_t node, const Transformation& local)
+{
+    assert(is_alive(node) && "[TransformHierarchy] Invalid node.");
+
+    if(position_[node] == local.get_position()
+    && orientation_[node].get_as_vec() == local.get_orientation().get_as_vec()
+    && scale_[node] == local.get_scale())
+        return;
+
+    position_[node]    = local.get_position();
+    orientation_[node] = local.get_orientation();
+    scale_[node]       = local.get_scale();
+    dirty_[node]       = 1;
+}
+
+void TransformHierarchy::set_parent(uint32_t node, uint32_t parent)
+{
+    assert(is_alive(node) && "[TransformHierarchy] Invalid node.");
+    assert((parent == NONE || is_alive(parent)) && "[TransformHierarchy] Invalid parent.");
+#ifdef __DEBUG__
+    for(uint32_t ancestor=parent; ancestor!=NONE; ancestor=parent_[ancestor])
+        assert(ancestor != node && "[TransformHierarchy] Cycle in hierarchy.");
+#endif
+
+    if(parent_[node] == parent)
+        return;
+    parent_[node] = parent;
+    dirty_[node] = 1;
+    order_dirty_ = true;
+}
+
+void TransformHierarchy::compute_world(uint32_t node)
+{
+    // World = parent world * T*R*S
+    uint32_t parent = parent_[node];
+    if(parent == NONE)
+        world_[node] = compose_trs(position_[node], orientation_[node], scale_[node]);
+    else
+    {
+        world_[node] = world_[parent]*compose_trs(position_[node], orientation_[node], scale_[node]);
+        parent_version_[node] = version_[parent];
+    }
+    ++version_[node];
+    dirty_[node] = 0;
+}
+
+void TransformHierarchy::resolve(uint32_t node)
+{
+    uint32_t parent = parent_[node];
+    if(parent != NONE)
+        resolve(parent);
+    if(needs_update(node))
+        compute_world(node);
+}
+
+uint32_t TransformHierarchy::get_depth(uint32_t node) const
+{
+    uint32_t depth = 0;
+    for(uint32_t ancestor=parent_[node]; ancestor!=NONE; ancestor=parent_[ancestor])
+        ++depth;
+    return depth;
+}
+
+void TransformHierarchy::rebuild_order()
+{
+    // * Counting sort of live nodes by depth
+    std::vector<uint32_t> depths(alive_.size(), 0);
+    level_offsets_.assign(1, 0);
+    for(uint32_t ii=0; ii<alive_.size(); ++ii)
+    {
+        if(!alive_[ii]) continue;
+        depths[ii] = get_depth(ii);
+        if(depths[ii]+2 > level_offsets_.size())
+            level_offsets_.resize(depths[ii]+2, 0);
+        ++level_offsets_[depths[ii]+1];
+    }
+    for(uint32_t ll=1; ll<level_offsets_.size(); ++ll)
+        level_offsets_[ll] += level_offsets_[ll-1];
+
+    order_.resize(level_offsets_.back());
+    std::vector<uint32_t> cursor(level_offsets_.begin(), level_offsets_.end()-1);
+    for(uint32_t ii=0; ii<alive_.size(); ++ii)
+        if(alive_[ii])
+            order_[cursor[depths[ii]]++] = ii;
+
+    order_dirty_ = false;
+}
+
+uint32_t TransformHierarchy::update()
+{
+    if(order_dirty_)
+        rebuild_order();
+
+    // Parents are up to date when their children are processed, nodes of a level are independent
+    std::atomic<uint32_t> n_updated(0);
+    for(uint32_t ll=0; ll+1<level_offsets_.size(); ++ll)
+    {
+        JOBS.parallel_for(level_offsets_[ll], level_offsets_[ll+1], [&](uint32_t ii)
+        {
+            uint32_t node = order_[ii];
+            if(needs_update(node))
+            {
+                compute_world(node);
+                n_updated.fetch_add(1, std::memory_order_relaxed);
+            }
+        }, 256);
+    }
+    return n_updated.load();
+}
+
+} // namespace wcore
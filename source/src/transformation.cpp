@@ -34,17 +34,8 @@ scaled_((scale!=1.0f))
 
 math::mat4 Transformation::get_model_matrix()
 {
-    mat4 T, R;
-    T.init_translation(position_);
-    R = orientation_.get_rotation_matrix();
-    // If no scaling (scale_==1.0f) just return product of translation and rotation matrices.
-    if (!scaled_)
-        return T*R;
-
-    // Else, compute a uniform scale matrix and return total product of transformations.
-    mat4 S;
-    S.init_scale(scale_);
-    return T*R*S;
+    // T*R*S without the matrix products
+    return compose_trs(position_, orientation_, scaled_ ? scale_ : 1.0f);
 }
 
 math::mat4 Transformation::get_scale_rotation_matrix()
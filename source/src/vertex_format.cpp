@@ -94,6 +94,11 @@ BufferLayout Vertex3P3N3T2U::Layout =
     {"a_texCoord"_h, ShaderDataType::Vec2}
 };
 
+BufferLayout InstanceData::Layout =
+{
+    {"a_model"_h, ShaderDataType::Mat4}
+};
+
 BufferLayout VertexAnim::Layout =
 {
     {"a_position"_h, ShaderDataType::Vec3},
@@ -1,4 +1,5 @@
 #include <bitset>
+#include <cstring>
 
 #include "wat_loader.h"
 #include "pixel_buffer.h"
@@ -27,17 +28,7 @@ void WatLoader::read(std::istream& stream, MaterialDescriptor& descriptor, bool
     bool has_block0 = (bool)header.h.has_block0;
     bool has_block1 = (bool)header.h.has_block1;
     bool has_block2 = (bool)header.h.has_block2;
-    bool is_textured = has_block0 || has_block1 || has_block2;
-
-    descriptor.texture_descriptor.owns_data   = read_texture_data;
-    descriptor.texture_descriptor.is_wat      = true;
-    descriptor.texture_descriptor.unit_flags  = header.h.unit_flags;
-    descriptor.texture_descriptor.width       = header.h.width;
-    descriptor.texture_descriptor.height      = header.h.height;
-    descriptor.texture_descriptor.resource_id = header.h.unique_id;
-    descriptor.parallax_height_scale          = header.h.parallax_height_scale;
-    descriptor.has_transparency               = bool(header.h.has_transparency);
-    descriptor.is_textured                    = is_textured;
+    read_descriptor(header.h, descriptor, read_texture_data);
 
     // * Read uniform data
     stream.read(reinterpret_cast<char*>(&descriptor.albedo), 3*sizeof(float));
@@ -89,6 +80,73 @@ void WatLoader::read(std::istream& stream, MaterialDescriptor& descriptor, bool
     }
 }
 
+bool WatLoader::read(const io::FileView& view, MaterialDescriptor& descriptor)
+{
+    // * Read header, it may not be aligned inside an archive
+    static constexpr size_t UNIFORM_DATA_SIZE = 6*sizeof(float);
+    if(!view || view.size < WAT_HEADER_SIZE + UNIFORM_DATA_SIZE)
+    {
+        DLOGE("[Wat] File view too small to hold a header.", "parsing");
+        return false;
+    }
+
+    WatHeaderWrapper header;
+    memcpy(&header, view.data, sizeof(header));
+    if(!header_sanity_check(header.h))
+        return false;
+
+    read_descriptor(header.h, descriptor, false);
+
+    // * Read uniform data
+    const uint8_t* data = view.data + WAT_HEADER_SIZE;
+    memcpy(&descriptor.albedo, data, 3*sizeof(float));
+    memcpy(&descriptor.metallic, data+3*sizeof(float), sizeof(float));
+    memcpy(&descriptor.roughness, data+4*sizeof(float), sizeof(float));
+    memcpy(&descriptor.transparency, data+5*sizeof(float), sizeof(float));
+    data += UNIFORM_DATA_SIZE;
+
+    // * Reference texture data
+    size_t block_size = size_t(header.h.width) * size_t(header.h.height) * 4;
+    size_t n_blocks = size_t(header.h.has_block0) + size_t(header.h.has_block1) + size_t(header.h.has_block2);
+    if(view.size < WAT_HEADER_SIZE + UNIFORM_DATA_SIZE + n_blocks*block_size)
+    {
+        DLOGE("[Wat] Truncated file.", "parsing");
+        return false;
+    }
+
+    // Texture upload only reads pixel data
+    TextureDescriptor& tex_desc = descriptor.texture_descriptor;
+    if(header.h.has_block0)
+    {
+        tex_desc.block0_data = const_cast<unsigned char*>(data);
+        data += block_size;
+    }
+    if(header.h.has_block1)
+    {
+        tex_desc.block1_data = const_cast<unsigned char*>(data);
+        data += block_size;
+    }
+    if(header.h.has_block2)
+        tex_desc.block2_data = const_cast<unsigned char*>(data);
+
+    return true;
+}
+
+void WatLoader::read_descriptor(const WatHeader& header, MaterialDescriptor& descriptor, bool owns_data)
+{
+    bool is_textured = header.has_block0 || header.has_block1 || header.has_block2;
+
+    descriptor.texture_descriptor.owns_data   = owns_data;
+    descriptor.texture_descriptor.is_wat      = true;
+    descriptor.texture_descriptor.unit_flags  = header.unit_flags;
+    descriptor.texture_descriptor.width       = header.width;
+    descriptor.texture_descriptor.height      = header.height;
+    descriptor.texture_descriptor.resource_id = header.unique_id;
+    descriptor.parallax_height_scale          = header.parallax_height_scale;
+    descriptor.has_transparency               = bool(header.has_transparency);
+    descriptor.is_textured                    = is_textured;
+}
+
 void WatLoader::write(std::ostream& stream, const MaterialDescriptor& descriptor)
 {
     // * Write header
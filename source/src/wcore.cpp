@@ -5,7 +5,10 @@
 #include "wcore.h"
 
 #include "gfx_api.h" // Won't compile if removed: ensures GLFW header included before GL
+#include "platform/null/null_renderer_api.h"
+#include "headless_context.h"
 #include "thread_utils.h"
+#include "job_system.h"
 #include "error.h"
 #include "config.h"
 #include "intern_string.h"
@@ -119,6 +122,7 @@ struct Engine::EngineImpl
         delete engine_core;
 
         // Kill singletons
+        JobSystem::Kill();
         DebugInfo::Kill();
 #ifdef __DEBUG__
         InternStringLocator::Kill();
@@ -264,6 +268,12 @@ void Engine::SetWindowSize(uint32_t width, uint32_t height)
     GLB.WIN_H = height;
 }
 
+void Engine::SetHeadless(uint32_t n_frames)
+{
+    GLB.HEADLESS = true;
+    GLB.HEADLESS_FRAMES = n_frames;
+}
+
 bool Engine::UseResourceArchive(const char* filename, hash_t key)
 {
     fs::path filepath;
@@ -296,14 +306,35 @@ void Engine::Init(int argc, char const *argv[],
     CONFIG.get("root.display.width"_h,  GLB.SCR_W);
     CONFIG.get("root.display.height"_h, GLB.SCR_H);
     CONFIG.get("root.display.full"_h,   GLB.SCR_FULL);
+    // Headless mode can also be requested by the host with SetHeadless()
+    bool headless = false;
+    if(CONFIG.get("root.display.headless"_h, headless) && headless)
+    {
+        GLB.HEADLESS = true;
+        CONFIG.get("root.display.headless_frames"_h, GLB.HEADLESS_FRAMES);
+    }
 
     // Parse command line arguments
     if(parse_arguments)
         parse_arguments(argc, argv);
 
+    // Headless run: no GL context to create, graphics commands are only recorded
+    if(GLB.HEADLESS)
+    {
+        DLOG("<s>--- WCore: Headless run, using null graphics API ---</s>", "core", Severity::LOW);
+        Gfx::set_api(GfxAPI::Null);
+        if(context == nullptr)
+            context = new HeadlessContext(GLB.HEADLESS_FRAMES);
+    }
+
     DLOG("<s>--- WCore: Loading default resource archive ---</s>", "core", Severity::LOW);
     UseResourceArchive("pack0.zip", "pack0"_h);
 
+    DLOG("<s>--- WCore: Spawning worker threads ---</s>", "core", Severity::LOW);
+    uint32_t n_workers = 0;
+    CONFIG.get("root.core.worker_threads"_h, n_workers);
+    JOBS.init(n_workers);
+
     DLOG("<s>--- WCore: Creating game systems ---</s>", "core", Severity::LOW);
     // Create game systems
     eimpl_->init(context);
@@ -346,6 +377,24 @@ void Engine::Init(int argc, char const *argv[],
     eimpl_->engine_core->register_game_system("ChunkManager"_h,      static_cast<GameSystem*>(eimpl_->chunk_manager));
     eimpl_->engine_core->register_game_system("SoundSystem"_h,       static_cast<GameSystem*>(eimpl_->sound_system));
 
+    // * Declare update dependencies. Systems that do not touch the graphics context
+    // are updated on worker threads, others keep their registration order on this thread.
+    eimpl_->engine_core->set_system_worker_update("EntitySystem"_h);
+    eimpl_->engine_core->set_system_worker_update("SoundSystem"_h);
+    eimpl_->engine_core->set_system_worker_update("RayCaster"_h);
+    eimpl_->engine_core->set_system_worker_update("Daylight"_h);
+    // Entity components read model transforms written by the scene and by chunk loading
+    eimpl_->engine_core->add_system_dependency("EntitySystem"_h, "Scene"_h);
+    eimpl_->engine_core->add_system_dependency("EntitySystem"_h, "ChunkManager"_h);
+    // Entities start sounds
+    eimpl_->engine_core->add_system_dependency("SoundSystem"_h, "EntitySystem"_h);
+    // Listener and unprojection follow the camera
+    eimpl_->engine_core->add_system_dependency("SoundSystem"_h, "CameraController"_h);
+    eimpl_->engine_core->add_system_dependency("RayCaster"_h,   "CameraController"_h);
+    // Light camera follows the directional light, chunk loading may replace it
+    eimpl_->engine_core->add_system_dependency("Daylight"_h,    "Scene"_h);
+    eimpl_->engine_core->add_system_dependency("Daylight"_h,    "ChunkManager"_h);
+
     DLOG("<s>--- WCore: Initializing game systems ---</s>", "core", Severity::LOW);
     eimpl_->engine_core->init_game_systems();
 
@@ -366,6 +415,8 @@ int Engine::Run()
     DLOG("<s>--- WCore: Game loop stopped ---</s>", "core", Severity::LOW);
 #ifdef __DEBUG__
     eimpl_->pipeline->dbg_show_statistics();
+    if(Gfx::get_api() == GfxAPI::Null)
+        null_device().dbg_show_statistics();
 #endif
     DLOG("<s>--- WCore: Serializing ---</s>", "core", Severity::LOW);
     try
@@ -459,7 +510,7 @@ uint32_t Engine::SceneControl::LoadChunk(uint32_t xx, uint32_t zz, bool send_geo
 
 void Engine::SceneControl::SendChunk(uint32_t xx, uint32_t zz)
 {
-    uint32_t chunk_index = std::hash<math::i32vec2>{}(math::i32vec2(xx,zz));
+    uint32_t chunk_index = coords_to_chunk_index(math::i32vec2(xx,zz));
     eimpl_->scene->populate_static_octree(chunk_index);
     eimpl_->scene->load_geometry(chunk_index);
 }
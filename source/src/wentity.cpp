@@ -16,6 +16,17 @@ WEntity::~WEntity()
         delete it.second;
 }
 
+void WEntity::copy_components(EntityRegistry& registry, EntityHandle handle) const
+{
+    auto& copy_registry = component::detail::getComponentCopyRegistry();
+    for(auto&& [index, component]: components_)
+    {
+        auto it = copy_registry.find(index);
+        assert(it != copy_registry.end());
+        it->second(registry, handle, component);
+    }
+}
+
 #ifdef __DEBUG__
 void WEntity::warn_duplicate_component(const char* name)
 {
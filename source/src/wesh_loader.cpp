@@ -36,6 +36,37 @@ void WeshLoader::write_header(std::ostream& stream,
     stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
 }
 
+bool WeshLoader::read(const io::FileView& view, WeshView& mesh_view, size_t vertex_size)
+{
+    if(!view || view.size < WESH_HEADER_SIZE)
+    {
+        DLOGE("[Wesh] File view too small to hold a header.", "parsing");
+        return false;
+    }
+
+    // Header may not be aligned inside an archive
+    WeshHeaderWrapper header;
+    memcpy(&header, view.data, sizeof(header));
+    if(!header_sanity_check(header.h, vertex_size))
+        return false;
+
+    size_t vsize = size_t(header.h.n_vertices)*header.h.vertex_size;
+    size_t isize = size_t(header.h.n_indices)*sizeof(uint32_t);
+    if(view.size < WESH_HEADER_SIZE + vsize + isize)
+    {
+        DLOGE("[Wesh] Truncated file.", "parsing");
+        return false;
+    }
+
+    mesh_view.file        = view;
+    mesh_view.vertex_data = view.data + WESH_HEADER_SIZE;
+    mesh_view.index_data  = mesh_view.vertex_data + vsize;
+    mesh_view.vertex_size = header.h.vertex_size;
+    mesh_view.n_vertices  = header.h.n_vertices;
+    mesh_view.n_indices   = header.h.n_indices;
+    return true;
+}
+
 bool WeshLoader::header_sanity_check(const WeshHeader& header, size_t vertex_size)
 {
     // Check magic bytes
@@ -0,0 +1,99 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "buffer_allocator.h"
+
+using namespace wcore;
+
+TEST_CASE("Allocations are contiguous in an empty allocator.", "[balloc]")
+{
+    BufferAllocator alloc(100);
+    REQUIRE(alloc.allocate(10) == 0);
+    REQUIRE(alloc.allocate(20) == 10);
+    REQUIRE(alloc.allocate(70) == 30);
+    REQUIRE(alloc.get_used() == 100);
+    REQUIRE(alloc.allocate(1) == BufferAllocator::INVALID_OFFSET);
+    REQUIRE(alloc.allocate(0) == BufferAllocator::INVALID_OFFSET);
+}
+
+TEST_CASE("Released blocks are reused, first fit.", "[balloc]")
+{
+    BufferAllocator alloc(100);
+    std::size_t a = alloc.allocate(30);
+    std::size_t b = alloc.allocate(30);
+    alloc.allocate(30);
+    alloc.release(b);
+    // Too large for the hole
+    REQUIRE(alloc.allocate(40) == BufferAllocator::INVALID_OFFSET);
+    // Hole is used before the tail
+    REQUIRE(alloc.allocate(10) == b);
+    REQUIRE(alloc.allocate(20) == b+10);
+    REQUIRE(alloc.allocate(10) == 90);
+    alloc.release(a);
+    REQUIRE(alloc.allocate(30) == a);
+}
+
+TEST_CASE("Free neighbors are merged.", "[balloc]")
+{
+    BufferAllocator alloc(90);
+    std::size_t a = alloc.allocate(30);
+    std::size_t b = alloc.allocate(30);
+    std::size_t c = alloc.allocate(30);
+
+    alloc.release(a);
+    alloc.release(c);
+    AllocatorStats stats = alloc.get_stats();
+    REQUIRE(stats.n_free_blocks == 2);
+    REQUIRE(stats.largest_free == 30);
+    REQUIRE(stats.fragmentation() == Approx(0.5f));
+
+    // Middle block joins both neighbors
+    alloc.release(b);
+    stats = alloc.get_stats();
+    REQUIRE(stats.n_free_blocks == 1);
+    REQUIRE(stats.largest_free == 90);
+    REQUIRE(stats.fragmentation() == Approx(0.f));
+    REQUIRE(alloc.is_empty());
+    REQUIRE(alloc.allocate(90) == 0);
+}
+
+TEST_CASE("Random allocation churn keeps blocks disjoint and fully recovers.", "[balloc]")
+{
+    const std::size_t capacity = 1 << 16;
+    BufferAllocator alloc(capacity);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> size_dist(1, 2048);
+
+    std::vector<std::pair<std::size_t, std::size_t>> live;
+    bool disjoint = true;
+    for(int ii=0; ii<2000; ++ii)
+    {
+        if(!live.empty() && (rng()%3==0 || alloc.get_used()>capacity/2))
+        {
+            std::size_t idx = rng()%live.size();
+            alloc.release(live[idx].first);
+            live.erase(live.begin()+idx);
+            continue;
+        }
+        std::size_t size = size_dist(rng);
+        std::size_t offset = alloc.allocate(size);
+        if(offset == BufferAllocator::INVALID_OFFSET)
+            continue;
+        disjoint &= (offset+size <= capacity);
+        for(auto&& [o, s]: live)
+            disjoint &= (offset+size <= o || o+s <= offset);
+        live.push_back({offset, size});
+    }
+    REQUIRE(disjoint);
+    REQUIRE(alloc.get_stats().n_allocations == live.size());
+
+    for(auto&& [o, s]: live)
+        alloc.release(o);
+    AllocatorStats stats = alloc.get_stats();
+    REQUIRE(stats.used == 0);
+    REQUIRE(stats.n_free_blocks == 1);
+    REQUIRE(stats.largest_free == capacity);
+}
@@ -0,0 +1,163 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#include "chunk_cache.h"
+#include "height_map.h"
+#include "mesh_factory.h"
+#include "surface_mesh.h"
+#include "job_system.h"
+
+using namespace wcore;
+
+class ChunkCacheFixture
+{
+public:
+    ChunkCacheFixture():
+    folder_(fs::temp_directory_path() / "wcore_test_chunk_cache"),
+    heightmap_(32, 32)
+    {
+        // Some bumpy terrain
+        for(uint32_t ii=0; ii<32; ++ii)
+            for(uint32_t jj=0; jj<32; ++jj)
+                heightmap_.set_height(ii, jj, std::sin(0.3f*ii)*std::cos(0.2f*jj));
+        mesh_ = factory::make_terrain_tri_mesh(heightmap_, 1.f, 1.f);
+
+        cache_.init(folder_, "test", ChunkCache::make_stamp("<Level></Level>"));
+        cache_.clear();
+    }
+
+    ~ChunkCacheFixture()
+    {
+        cache_.clear();
+        fs::remove_all(folder_);
+    }
+
+protected:
+    fs::path folder_;
+    HeightMap heightmap_;
+    std::shared_ptr<TriangularMesh> mesh_;
+    ChunkCache cache_;
+};
+
+TEST_CASE_METHOD(ChunkCacheFixture, "Baked chunk round trip", "[chunk]")
+{
+    math::i32vec2 coords(1,-2);
+    REQUIRE(!cache_.is_baked(coords));
+    REQUIRE(cache_.fetch(coords) == nullptr);
+
+    REQUIRE(cache_.store(coords, heightmap_, *mesh_));
+    REQUIRE(cache_.is_baked(coords));
+
+    auto baked = cache_.fetch(coords);
+    REQUIRE(baked != nullptr);
+
+    std::unique_ptr<HeightMap> hm(baked->make_heightmap());
+    REQUIRE(hm->get_width() == 32);
+    REQUIRE(hm->get_length() == 32);
+    bool same_heights = true;
+    for(uint32_t ii=0; ii<32; ++ii)
+        for(uint32_t jj=0; jj<32; ++jj)
+            same_heights &= (hm->get_height(ii,jj) == heightmap_.get_height(ii,jj));
+    REQUIRE(same_heights);
+
+    auto mesh = baked->make_terrain_mesh();
+    REQUIRE(mesh->get_nv() == mesh_->get_nv());
+    REQUIRE(mesh->get_ni() == mesh_->get_ni());
+    REQUIRE(mesh->get_n_elements() == mesh_->get_n_elements());
+    REQUIRE(mesh->get_index_buffer() == mesh_->get_index_buffer());
+    REQUIRE(mesh->get_vertex_buffer() == mesh_->get_vertex_buffer());
+}
+
+TEST_CASE_METHOD(ChunkCacheFixture, "Baked chunks of another level version are stale", "[chunk]")
+{
+    math::i32vec2 coords(0,0);
+    REQUIRE(cache_.store(coords, heightmap_, *mesh_));
+
+    ChunkCache other_cache;
+    other_cache.init(folder_, "test", ChunkCache::make_stamp("<Level> </Level>"));
+    REQUIRE(!other_cache.is_baked(coords));
+    REQUIRE(other_cache.fetch(coords) == nullptr);
+
+    // Coordinates are checked too
+    REQUIRE(cache_.fetch(math::i32vec2(0,1)) == nullptr);
+}
+
+TEST_CASE_METHOD(ChunkCacheFixture, "Chunk baked from a copy by a job", "[chunk]")
+{
+    math::i32vec2 coords(3,4);
+    auto bake_data = std::make_shared<ChunkBakeData>(coords, heightmap_, *mesh_);
+
+    // Live data can be modified while the copy is baked
+    JobCounter counter;
+    JOBS.schedule([this, bake_data]()
+    {
+        cache_.store(*bake_data);
+    }, &counter);
+    heightmap_.set_height(0, 0, 100.f);
+    JOBS.wait(counter);
+
+    auto baked = cache_.fetch(coords);
+    REQUIRE(baked != nullptr);
+    std::unique_ptr<HeightMap> hm(baked->make_heightmap());
+    REQUIRE(hm->get_height(0,0) == bake_data->heights[0]);
+    REQUIRE(hm->get_height(0,0) != 100.f);
+
+    auto mesh = baked->make_terrain_mesh();
+    REQUIRE(mesh->get_index_buffer() == mesh_->get_index_buffer());
+    REQUIRE(mesh->get_vertex_buffer() == mesh_->get_vertex_buffer());
+
+    // No temporary file is left behind
+    bool tmp_left = false;
+    for(auto&& entry: fs::directory_iterator(folder_))
+        tmp_left |= (entry.path().extension() == ".tmp");
+    REQUIRE(!tmp_left);
+}
+
+TEST_CASE_METHOD(ChunkCacheFixture, "Baked chunk placements round trip", "[chunk]")
+{
+    math::i32vec2 coords(-1,2);
+    ChunkBakeData bake_data(coords, heightmap_, *mesh_);
+    for(uint32_t ii=0; ii<5; ++ii)
+        bake_data.transforms.push_back({{float(ii), 1.f, -2.f}, {0.f, 0.f, 0.f, 1.f}, 1.f+ii});
+    bake_data.batch_draws = {12, 0};
+    BakedLight light;
+    light.flags = BAKED_LIGHT_POINT|BAKED_LIGHT_DYNAMIC;
+    light.node_index = 3;
+    for(int ii=0; ii<3; ++ii)
+    {
+        light.position[ii] = 10.f*ii;
+        light.color[ii] = 0.5f;
+    }
+    light.brightness = 2.f;
+    light.ambient_strength = 0.03f;
+    light.radius = 7.f;
+    bake_data.lights.push_back(light);
+    REQUIRE(cache_.store(bake_data));
+
+    auto baked = cache_.fetch(coords);
+    REQUIRE(baked != nullptr);
+    const WchkHeader& header = baked->get_header();
+    REQUIRE(header.n_transforms == 5);
+    REQUIRE(header.n_batches == 2);
+    REQUIRE(header.n_lights == 1);
+
+    // Terrain sections are unaffected
+    auto mesh = baked->make_terrain_mesh();
+    REQUIRE(mesh->get_index_buffer() == mesh_->get_index_buffer());
+    REQUIRE(mesh->get_vertex_buffer() == mesh_->get_vertex_buffer());
+
+    REQUIRE(memcmp(baked->get_transforms(), bake_data.transforms.data(), 5*sizeof(BakedTransform)) == 0);
+    REQUIRE(baked->get_batch_draws()[0] == 12);
+    REQUIRE(baked->get_batch_draws()[1] == 0);
+    REQUIRE(memcmp(baked->get_lights(), &light, sizeof(BakedLight)) == 0);
+
+    // Terrain only bake has no placements
+    REQUIRE(cache_.store(coords, heightmap_, *mesh_));
+    baked = cache_.fetch(coords);
+    REQUIRE(baked != nullptr);
+    REQUIRE(baked->get_header().n_transforms == 0);
+    REQUIRE(baked->get_header().n_lights == 0);
+}
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <map>
+#include <random>
+
+#include "chunk_grid.hpp"
+
+using namespace wcore;
+using namespace math;
+
+TEST_CASE("Chunk indices are exact and never null.", "[cgrid]")
+{
+    std::map<uint32_t, i32vec2> seen;
+    bool exact = true;
+    for(int32_t xx=-64; xx<=64; ++xx)
+    {
+        for(int32_t zz=-64; zz<=64; ++zz)
+        {
+            i32vec2 coords(xx,zz);
+            uint32_t index = coords_to_chunk_index(coords);
+            exact &= (index != 0);
+            exact &= (chunk_index_to_coords(index) == coords);
+            exact &= seen.insert({index, coords}).second;
+        }
+    }
+    REQUIRE(exact);
+    REQUIRE(chunk_index_to_coords(coords_to_chunk_index(i32vec2(-32767, 32767))) == i32vec2(-32767, 32767));
+}
+
+TEST_CASE("Insert, find and erase.", "[cgrid]")
+{
+    ChunkGrid<int> grid;
+    REQUIRE(grid.empty());
+    REQUIRE(grid.insert(coords_to_chunk_index(i32vec2(0,0)), 1));
+    REQUIRE(grid.insert(coords_to_chunk_index(i32vec2(1,0)), 2));
+    REQUIRE(!grid.insert(coords_to_chunk_index(i32vec2(0,0)), 3));
+    REQUIRE(grid.size() == 2);
+
+    REQUIRE(grid.at(coords_to_chunk_index(i32vec2(1,0))) == 2);
+    REQUIRE(grid.find(coords_to_chunk_index(i32vec2(0,1))) == nullptr);
+
+    REQUIRE(grid.erase(coords_to_chunk_index(i32vec2(0,0))));
+    REQUIRE(!grid.erase(coords_to_chunk_index(i32vec2(0,0))));
+    REQUIRE(!grid.contains(coords_to_chunk_index(i32vec2(0,0))));
+    REQUIRE(grid.at(coords_to_chunk_index(i32vec2(1,0))) == 2);
+
+    grid.clear();
+    REQUIRE(grid.size() == 0);
+    REQUIRE(!grid.contains(coords_to_chunk_index(i32vec2(1,0))));
+}
+
+TEST_CASE("Grid matches a reference map under streaming churn.", "[cgrid]")
+{
+    // Moving view disk: chunks are loaded ahead and unloaded behind
+    ChunkGrid<uint32_t> grid;
+    std::map<uint32_t, uint32_t> reference;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int32_t> coord(-20, 20);
+
+    bool consistent = true;
+    for(int ii=0; ii<20000; ++ii)
+    {
+        uint32_t index = coords_to_chunk_index(i32vec2(coord(rng), coord(rng)));
+        if(rng()%2)
+        {
+            bool inserted = grid.insert(index, uint32_t(ii));
+            bool ref_inserted = reference.insert({index, uint32_t(ii)}).second;
+            consistent &= (inserted == ref_inserted);
+        }
+        else
+            consistent &= (grid.erase(index) == (reference.erase(index)==1));
+    }
+    REQUIRE(consistent);
+    REQUIRE(grid.size() == reference.size());
+
+    // Every value is found, and contiguous iteration visits each exactly once
+    for(auto&& [index, value]: reference)
+    {
+        const uint32_t* found = grid.find(index);
+        consistent &= (found && *found == value);
+    }
+    uint32_t n_visited = 0;
+    for(auto&& [index, value]: grid)
+    {
+        consistent &= (reference.at(index) == value);
+        ++n_visited;
+    }
+    REQUIRE(consistent);
+    REQUIRE(n_visited == reference.size());
+}
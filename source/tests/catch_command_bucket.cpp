@@ -0,0 +1,83 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "command_bucket.hpp"
+
+using namespace wcore;
+
+TEST_CASE("Radix sort matches stable sort", "[bucket]")
+{
+    std::mt19937_64 rng(42);
+    CommandBucket<uint32_t> bucket;
+    std::vector<std::pair<uint64_t, uint32_t>> expected;
+
+    for(uint32_t ii=0; ii<5000; ++ii)
+    {
+        // Few distinct values in high bytes, to exercise equal keys and skipped passes
+        uint64_t key = (rng() & 0x00ff00000000ffffULL) | (uint64_t(rng()%4) << 60);
+        bucket.submit(key, ii);
+        expected.push_back({key, ii});
+    }
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b)
+    {
+        return a.first < b.first;
+    });
+    bucket.sort();
+
+    std::vector<std::pair<uint64_t, uint32_t>> result;
+    bucket.execute([&](uint64_t key, uint32_t command)
+    {
+        result.push_back({key, command});
+    });
+    REQUIRE(result == expected);
+}
+
+TEST_CASE("Equal keys keep submission order", "[bucket]")
+{
+    CommandBucket<uint32_t> bucket;
+    for(uint32_t ii=0; ii<100; ++ii)
+        bucket.submit(sort_key::make(1, 2, ii%3, 0, 0), ii);
+    bucket.sort();
+
+    uint32_t last_material = 0;
+    uint32_t last_command = 0;
+    bool ordered = true;
+    bucket.execute([&](uint64_t key, uint32_t command)
+    {
+        uint32_t material = sort_key::get_material(key);
+        if(material == last_material)
+            ordered &= (command >= last_command);
+        last_material = material;
+        last_command = command;
+    });
+    REQUIRE(ordered);
+
+    bucket.clear();
+    REQUIRE(bucket.empty());
+}
+
+TEST_CASE("Sort key field ordering", "[bucket]")
+{
+    // Higher fields dominate lower ones
+    REQUIRE(sort_key::make(0, 1, 0, 0, 0) > sort_key::make(0, 0, 0xfffff, 0xffff, 0xffff));
+    REQUIRE(sort_key::make(0, 0, 1, 0, 0) > sort_key::make(0, 0, 0, 0xffff, 0xffff));
+    REQUIRE(sort_key::make(0, 0, 0, 1, 0) > sort_key::make(0, 0, 0, 0, 0xffff));
+    REQUIRE(sort_key::make(1, 0, 0, 0, 0) > sort_key::make(0, 0xff, 0xfffff, 0xffff, 0xffff));
+    // Out of range values do not leak into other fields
+    REQUIRE(sort_key::make(0, 0, 0, 0, 0x1ffff) == sort_key::make(0, 0, 0, 0, 0xffff));
+
+    REQUIRE(sort_key::quantize_depth(0.f) == 0);
+    REQUIRE(sort_key::quantize_depth(1.f) == 0xffff);
+    REQUIRE(sort_key::quantize_depth(2.f) == 0xffff);
+    REQUIRE(sort_key::quantize_depth(0.25f) < sort_key::quantize_depth(0.5f));
+    REQUIRE(sort_key::quantize_depth(0.25f, true) > sort_key::quantize_depth(0.5f, true));
+    REQUIRE(sort_key::fold_material(~std::size_t(0)) <= 0xfffff);
+
+    uint64_t key = sort_key::make(sort_key::PASS_FORWARD, 0x1a5, 7, 0, 0);
+    REQUIRE(sort_key::get_pass(key) == sort_key::PASS_FORWARD);
+    REQUIRE(sort_key::get_shader(key) == 0xa5);
+    REQUIRE(sort_key::get_material(key) == 7);
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "entity_registry.h"
+
+using namespace wcore;
+
+struct CPosition
+{
+    float x, y, z;
+};
+
+struct CVelocity
+{
+    float x, y, z;
+};
+
+struct CName
+{
+    std::string name;
+};
+
+TEST_CASE("Components are added, fetched and removed.", "[ecs]")
+{
+    EntityRegistry registry;
+    EntityHandle ent = registry.create();
+    REQUIRE(registry.is_alive(ent));
+    REQUIRE(registry.get<CPosition>(ent) == nullptr);
+
+    registry.add<CPosition>(ent, CPosition{1.f, 2.f, 3.f});
+    registry.add<CName>(ent, CName{"plop"});
+    REQUIRE(registry.has<CPosition>(ent));
+    REQUIRE(registry.has<CName>(ent));
+    REQUIRE(!registry.has<CVelocity>(ent));
+    REQUIRE(registry.get<CPosition>(ent)->y == 2.f);
+    REQUIRE(registry.get<CName>(ent)->name == "plop");
+
+    // Adding an existing component returns it untouched
+    REQUIRE(registry.add<CName>(ent, CName{"other"})->name == "plop");
+
+    REQUIRE(registry.remove<CPosition>(ent));
+    REQUIRE(!registry.remove<CPosition>(ent));
+    REQUIRE(registry.get<CPosition>(ent) == nullptr);
+    REQUIRE(registry.get<CName>(ent)->name == "plop");
+}
+
+TEST_CASE("Stale handles are detected after their slot is reused.", "[ecs]")
+{
+    EntityRegistry registry;
+    EntityHandle a = registry.create();
+    EntityHandle b = registry.create();
+    registry.add<CName>(b, CName{"b"});
+
+    REQUIRE(registry.destroy(a));
+    REQUIRE(!registry.is_alive(a));
+    REQUIRE(!registry.destroy(a));
+
+    // Dense ids: the slot is recycled with a new generation
+    EntityHandle c = registry.create();
+    REQUIRE(c.index == a.index);
+    REQUIRE(c != a);
+    REQUIRE(registry.is_alive(c));
+    REQUIRE(!registry.is_alive(a));
+    REQUIRE(registry.size() == 2);
+    REQUIRE(registry.get<CName>(b)->name == "b");
+
+    registry.clear();
+    REQUIRE(registry.size() == 0);
+    REQUIRE(!registry.is_alive(b));
+    REQUIRE(!registry.is_alive(c));
+}
+
+TEST_CASE("Queries visit every matching entity once, in all archetypes.", "[ecs]")
+{
+    EntityRegistry registry;
+    std::map<uint32_t, float> expected;
+    std::vector<EntityHandle> handles;
+    for(int ii=0; ii<300; ++ii)
+    {
+        EntityHandle ent = registry.create();
+        handles.push_back(ent);
+        registry.add<CPosition>(ent, CPosition{float(ii), 0.f, 0.f});
+        if(ii%2)
+        {
+            registry.add<CVelocity>(ent, CVelocity{1.f, 0.f, 0.f});
+            expected[ent.index] = float(ii)+1.f;
+        }
+        if(ii%3==0)
+            registry.add<CName>(ent, CName{std::to_string(ii)});
+    }
+    // Swap removal in the middle of archetypes
+    for(int ii=1; ii<300; ii+=10)
+    {
+        registry.destroy(handles[ii]);
+        expected.erase(handles[ii].index);
+    }
+    REQUIRE(registry.count<CPosition, CVelocity>() == expected.size());
+
+    uint32_t n_visited = 0;
+    registry.query<CPosition, CVelocity>([&](EntityHandle ent, CPosition& pos, CVelocity& vel)
+    {
+        pos.x += vel.x;
+        ++n_visited;
+    });
+    REQUIRE(n_visited == expected.size());
+
+    bool consistent = true;
+    for(auto&& [index, x]: expected)
+    {
+        EntityHandle ent = handles[index];
+        consistent &= registry.get<CPosition>(ent)->x == x;
+    }
+    // Components moved between archetypes keep their values
+    for(int ii=0; ii<300; ii+=3)
+        if(registry.is_alive(handles[ii]))
+            consistent &= registry.get<CName>(handles[ii])->name == std::to_string(ii);
+    REQUIRE(consistent);
+}
@@ -0,0 +1,161 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+
+#include "informer.h"
+#include "listener.h"
+
+using namespace wcore;
+
+struct CountData: public WData
+{
+    CountData(int producer, int value): producer(producer), value(value) {}
+    int producer;
+    int value;
+};
+
+struct NameData: public WData
+{
+    explicit NameData(const std::string& name): name(name) {}
+    std::string name;
+};
+
+class DeferredInformer: public Informer
+{
+public:
+    DeferredInformer() { enable_deferred(64); }
+
+    inline bool send(int producer, int value)     { return post_deferred("count"_h, CountData(producer, value)); }
+    inline bool send_name(const std::string& name) { return post_deferred("name"_h, NameData(name)); }
+    inline void send_now(int value)               { post("count"_h, CountData(0, value)); }
+};
+
+class CountListener: public Listener
+{
+public:
+    bool on_count(const WData& data)
+    {
+        const CountData& cd = static_cast<const CountData&>(data);
+        values.push_back(cd.value);
+        return true;
+    }
+    bool on_name(const WData& data)
+    {
+        names.push_back(static_cast<const NameData&>(data).name);
+        return true;
+    }
+    bool on_count_consume(const WData& data)
+    {
+        return false;
+    }
+
+    std::vector<int> values;
+    std::vector<std::string> names;
+};
+
+TEST_CASE("Deferred events are delivered at dispatch, in order.", "[evq]")
+{
+    DeferredInformer informer;
+    CountListener listener;
+    listener.subscribe("count"_h, informer, &CountListener::on_count);
+    listener.subscribe("name"_h, informer, &CountListener::on_name);
+
+    informer.send(0, 1);
+    informer.send_name("plop");
+    informer.send(0, 2);
+    REQUIRE(listener.values.empty());
+
+    // Immediate posting is still available
+    informer.send_now(42);
+    REQUIRE(listener.values == std::vector<int>({42}));
+
+    REQUIRE(informer.dispatch_deferred() == 3);
+    REQUIRE(listener.values == std::vector<int>({42, 1, 2}));
+    REQUIRE(listener.names == std::vector<std::string>({"plop"}));
+    REQUIRE(informer.dispatch_deferred() == 0);
+}
+
+TEST_CASE("Full queue drops events, consumption stops delivery.", "[evq]")
+{
+    DeferredInformer informer;
+    CountListener first, second;
+    first.subscribe("count"_h, informer, &CountListener::on_count_consume);
+    second.subscribe("count"_h, informer, &CountListener::on_count);
+
+    uint32_t n_accepted = 0;
+    for(int ii=0; ii<100; ++ii)
+        n_accepted += informer.send(0, ii);
+    REQUIRE(n_accepted == 64);
+    REQUIRE(informer.get_dropped_count() == 36);
+
+    REQUIRE(informer.dispatch_deferred() == 64);
+    REQUIRE(second.values.empty());
+
+    // Unsubscribed listener does not get events anymore
+    first.unsubscribe("count"_h, informer);
+    informer.send(0, 7);
+    informer.dispatch_deferred();
+    REQUIRE(second.values == std::vector<int>({7}));
+}
+
+TEST_CASE("Events posted from many threads are all delivered, in per-thread order.", "[evq]")
+{
+    DeferredInformer informer;
+    CountListener listener;
+    listener.subscribe("count"_h, informer, &CountListener::on_count);
+
+    const int n_producers = 4;
+    const int n_events = 2000;
+    std::vector<std::thread> producers;
+    for(int pp=0; pp<n_producers; ++pp)
+    {
+        producers.emplace_back([&informer, pp, n_events]()
+        {
+            for(int ii=0; ii<n_events; ++ii)
+                while(!informer.send(pp, pp*n_events+ii))
+                    std::this_thread::yield();
+        });
+    }
+    // Consumer dispatches while producers are running, like a frame loop
+    uint32_t n_delivered = 0;
+    while(n_delivered < n_producers*n_events)
+        n_delivered += informer.dispatch_deferred();
+    for(auto&& producer: producers)
+        producer.join();
+
+    REQUIRE(listener.values.size() == n_producers*n_events);
+    // Values of each producer are increasing
+    std::vector<int> last(n_producers, -1);
+    bool ordered = true;
+    for(int value: listener.values)
+    {
+        int producer = value/n_events;
+        ordered &= (value > last[producer]);
+        last[producer] = value;
+    }
+    REQUIRE(ordered);
+}
+
+TEST_CASE("Delegates subscribed during a dispatch get the next events.", "[evq]")
+{
+    DeferredInformer informer;
+    CountListener listener, late;
+    bool subscribed = false;
+    WpFunc subscriber = [&](const WData& data)
+    {
+        if(!subscribed)
+        {
+            late.subscribe("count"_h, informer, &CountListener::on_count);
+            subscribed = true;
+        }
+        return true;
+    };
+    listener.subscribe("count"_h, informer, subscriber);
+
+    informer.send(0, 1);
+    informer.send(0, 2);
+    informer.dispatch_deferred();
+    REQUIRE(late.values == std::vector<int>({2}));
+}
@@ -0,0 +1,252 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <vector>
+#include <cstring>
+#include <zlib.h>
+
+#include "file_system.h"
+#include "config.h"
+#include "wesh_loader.h"
+#include "wat_loader.h"
+#include "mesh.hpp"
+#include "vertex_format.h"
+#include "logger.h"
+
+using namespace wcore;
+
+// Minimal zip writer, so that tests do not depend on an external tool
+class ZipWriter
+{
+public:
+    // Stored entries get an extra field in their local header only, so that
+    // data offset must be computed from the local header, as map_file() does
+    void add(const std::string& name, const std::string& content, bool compress)
+    {
+        std::string data = compress ? deflate_raw(content) : content;
+        uint32_t crc = crc32(0L, reinterpret_cast<const Bytef*>(content.data()), content.size());
+        std::string extra = compress ? "" : std::string("\x35\xd9\x02\x00\x00\x00", 6);
+
+        Entry entry{name, uint16_t(compress ? 8 : 0), crc, uint32_t(data.size()),
+                    uint32_t(content.size()), uint32_t(buffer_.size())};
+        put32(0x04034b50);
+        put16(20); put16(0); put16(entry.method); put16(0); put16(0x21);
+        put32(crc); put32(entry.csize); put32(entry.usize);
+        put16(uint16_t(name.size())); put16(uint16_t(extra.size()));
+        buffer_ += name + extra + data;
+        entries_.push_back(entry);
+    }
+
+    void write(const fs::path& path)
+    {
+        uint32_t cd_offset = uint32_t(buffer_.size());
+        for(auto&& entry: entries_)
+        {
+            put32(0x02014b50);
+            put16(20); put16(20); put16(0); put16(entry.method); put16(0); put16(0x21);
+            put32(entry.crc); put32(entry.csize); put32(entry.usize);
+            put16(uint16_t(entry.name.size())); put16(0); put16(0); put16(0); put16(0);
+            put32(0); put32(entry.offset);
+            buffer_ += entry.name;
+        }
+        uint32_t cd_size = uint32_t(buffer_.size()) - cd_offset;
+        put32(0x06054b50);
+        put16(0); put16(0); put16(uint16_t(entries_.size())); put16(uint16_t(entries_.size()));
+        put32(cd_size); put32(cd_offset); put16(0);
+
+        std::ofstream ofs(path, std::ios::binary);
+        ofs.write(buffer_.data(), buffer_.size());
+    }
+
+private:
+    struct Entry
+    {
+        std::string name;
+        uint16_t method;
+        uint32_t crc;
+        uint32_t csize;
+        uint32_t usize;
+        uint32_t offset;
+    };
+
+    void put16(uint16_t value) { buffer_ += char(value&0xff); buffer_ += char(value>>8); }
+    void put32(uint32_t value) { put16(uint16_t(value&0xffff)); put16(uint16_t(value>>16)); }
+
+    static std::string deflate_raw(const std::string& content)
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        std::string out(deflateBound(&zs, content.size()), '\0');
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+        zs.avail_in = uInt(content.size());
+        zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        zs.avail_out = uInt(out.size());
+        deflate(&zs, Z_FINISH);
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        return out;
+    }
+
+    std::string buffer_;
+    std::vector<Entry> entries_;
+};
+
+static std::vector<uint8_t> stream_bytes(std::istream& stream)
+{
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+static std::vector<uint8_t> view_bytes(const io::FileView& view)
+{
+    return std::vector<uint8_t>(view.data, view.data + view.size);
+}
+
+class FileSystemFixture
+{
+public:
+    FileSystemFixture():
+    folder_(fs::temp_directory_path() / "wcore_test_file_system")
+    {
+        dbg::LOG.register_channel("ios", 0);
+        dbg::LOG.register_channel("parsing", 0);
+        fs::create_directories(folder_);
+
+        // Small mesh and textured material
+        std::vector<Vertex3P3N3T2U> vertices;
+        for(int ii=0; ii<4; ++ii)
+            vertices.push_back({math::vec3(ii&1, ii>>1, 0.f), math::vec3(0.f,0.f,1.f),
+                                math::vec3(1.f,0.f,0.f), math::vec2(ii&1, ii>>1)});
+        std::vector<uint32_t> indices = {0, 1, 2, 2, 1, 3};
+        std::stringstream wesh;
+        WeshLoader().write(wesh, vertices, indices);
+        wesh_ = wesh.str();
+
+        std::vector<unsigned char> pixels(4*4*4);
+        for(size_t ii=0; ii<pixels.size(); ++ii)
+            pixels[ii] = (unsigned char)(7*ii);
+        MaterialDescriptor descriptor;
+        descriptor.albedo = math::vec3(0.1f, 0.2f, 0.3f);
+        descriptor.metallic = 0.4f;
+        descriptor.roughness = 0.5f;
+        descriptor.transparency = 0.6f;
+        descriptor.texture_descriptor.width = 4;
+        descriptor.texture_descriptor.height = 4;
+        descriptor.texture_descriptor.add_unit(TextureUnit::ALBEDO);
+        descriptor.texture_descriptor.block0_data = pixels.data();
+        std::stringstream wat;
+        WatLoader().write(wat, descriptor);
+        wat_ = wat.str();
+
+        // Loose file
+        std::ofstream(folder_ / "loose.wesh", std::ios::binary) << wesh_;
+
+        // Archive
+        ZipWriter zip;
+        zip.add("MANIFEST.xml", "<Manifest><vpath name=\"test.folders.packed\" value=\"packed/\"/></Manifest>", false);
+        zip.add("packed/stored.wesh", wesh_, false);
+        zip.add("packed/stored.wat", wat_, false);
+        zip.add("packed/deflated.wesh", wesh_, true);
+        zip.write(folder_ / "test.zip");
+
+        CONFIG.set("test.folders.loose"_h, std::cref(folder_));
+        REQUIRE(FILESYSTEM.open_archive(folder_ / "test.zip", "test_archive"_h));
+    }
+
+    ~FileSystemFixture()
+    {
+        FILESYSTEM.close_archive("test_archive"_h);
+        fs::remove_all(folder_);
+    }
+
+protected:
+    fs::path folder_;
+    std::string wesh_;
+    std::string wat_;
+};
+
+TEST_CASE_METHOD(FileSystemFixture, "Mapped files hold the same bytes as streams", "[fs]")
+{
+    // Loose file
+    auto view = FILESYSTEM.map_file("loose.wesh", "test.folders.loose"_h, "test_archive"_h);
+    auto stream = FILESYSTEM.get_file_as_stream((folder_ / "loose.wesh"));
+    REQUIRE(view);
+    REQUIRE(stream != nullptr);
+    REQUIRE(view_bytes(view) == stream_bytes(*stream));
+
+    // Stored archive entry, through vpath
+    view = FILESYSTEM.map_file("stored.wesh", "test.folders.packed"_h, "test_archive"_h);
+    stream = FILESYSTEM.get_file_as_stream("packed/stored.wesh", "test_archive"_h);
+    REQUIRE(view);
+    REQUIRE(stream != nullptr);
+    auto bytes = stream_bytes(*stream);
+    REQUIRE(bytes.size() == wesh_.size());
+    REQUIRE(view_bytes(view) == bytes);
+
+    // Mapping outlives the archive
+    FILESYSTEM.close_archive("test_archive"_h);
+    REQUIRE(view_bytes(view) == bytes);
+    REQUIRE(FILESYSTEM.open_archive(folder_ / "test.zip", "test_archive"_h));
+}
+
+TEST_CASE_METHOD(FileSystemFixture, "Compressed archive entries cannot be mapped", "[fs]")
+{
+    REQUIRE(!FILESYSTEM.map_file("packed/deflated.wesh", "test_archive"_h));
+    auto stream = FILESYSTEM.get_file_as_stream("packed/deflated.wesh", "test_archive"_h);
+    REQUIRE(stream != nullptr);
+    auto bytes = stream_bytes(*stream);
+    REQUIRE(std::string(bytes.begin(), bytes.end()) == wesh_);
+}
+
+TEST_CASE_METHOD(FileSystemFixture, "Wesh read from a view matches stream read", "[fs]")
+{
+    auto view = FILESYSTEM.map_file("packed/stored.wesh", "test_archive"_h);
+    auto stream = FILESYSTEM.get_file_as_stream("packed/stored.wesh", "test_archive"_h);
+    REQUIRE(view);
+    REQUIRE(stream != nullptr);
+
+    WeshLoader loader;
+    auto mapped_mesh = loader.read<Vertex3P3N3T2U>(view);
+    auto streamed_mesh = loader.read<Vertex3P3N3T2U>(*stream);
+    REQUIRE(mapped_mesh != nullptr);
+    REQUIRE(mapped_mesh->get_index_buffer() == streamed_mesh->get_index_buffer());
+    const auto& mapped_vertices = mapped_mesh->get_vertex_buffer();
+    const auto& streamed_vertices = streamed_mesh->get_vertex_buffer();
+    REQUIRE(mapped_vertices.size() == streamed_vertices.size());
+    REQUIRE(memcmp(mapped_vertices.data(), streamed_vertices.data(),
+                   mapped_vertices.size()*sizeof(Vertex3P3N3T2U)) == 0);
+
+    // Wrong vertex size is rejected
+    WeshView mesh_view;
+    REQUIRE(!loader.read(view, mesh_view, sizeof(Vertex3P)));
+}
+
+TEST_CASE_METHOD(FileSystemFixture, "Wat read from a view matches stream read", "[fs]")
+{
+    auto view = FILESYSTEM.map_file("packed/stored.wat", "test_archive"_h);
+    auto stream = FILESYSTEM.get_file_as_stream("packed/stored.wat", "test_archive"_h);
+    REQUIRE(view);
+    REQUIRE(stream != nullptr);
+
+    WatLoader loader;
+    MaterialDescriptor mapped;
+    MaterialDescriptor streamed;
+    REQUIRE(loader.read(view, mapped));
+    loader.read(*stream, streamed, true);
+
+    REQUIRE(mapped.albedo == streamed.albedo);
+    REQUIRE(mapped.metallic == streamed.metallic);
+    REQUIRE(mapped.roughness == streamed.roughness);
+    REQUIRE(mapped.transparency == streamed.transparency);
+    REQUIRE(mapped.texture_descriptor.width == streamed.texture_descriptor.width);
+    REQUIRE(mapped.texture_descriptor.height == streamed.texture_descriptor.height);
+    REQUIRE(mapped.texture_descriptor.unit_flags == streamed.texture_descriptor.unit_flags);
+
+    // Texture data is referenced in place
+    REQUIRE(!mapped.texture_descriptor.owns_data);
+    REQUIRE(mapped.texture_descriptor.block0_data >= view.data);
+    REQUIRE(mapped.texture_descriptor.block0_data < view.data + view.size);
+    REQUIRE(memcmp(mapped.texture_descriptor.block0_data, streamed.texture_descriptor.block0_data, 4*4*4) == 0);
+}
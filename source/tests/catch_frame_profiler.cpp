@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+#include "frame_profiler.h"
+#include "logger.h"
+
+using namespace wcore;
+
+static const ProfileEvent* find_event(const FrameProfile& frame, const char* name)
+{
+    for(auto&& event: frame.events)
+        if(strcmp(event.name, name) == 0)
+            return &event;
+    return nullptr;
+}
+
+TEST_CASE("Nested markers are recorded in last frame", "[profile]")
+{
+    PROFILER.set_enabled(true);
+    PROFILER.begin_frame();
+    {
+        ProfileScope outer("outer");
+        {
+            ProfileScope inner("inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    PROFILER.end_frame();
+
+    const FrameProfile& frame = PROFILER.get_frame(0);
+    const ProfileEvent* outer = find_event(frame, "outer");
+    const ProfileEvent* inner = find_event(frame, "inner");
+    REQUIRE(outer != nullptr);
+    REQUIRE(inner != nullptr);
+    REQUIRE(outer->depth == 0);
+    REQUIRE(inner->depth == 1);
+    REQUIRE(inner->start >= outer->start);
+    REQUIRE(inner->start + inner->duration <= outer->start + outer->duration);
+    REQUIRE(inner->duration >= 1000000);
+    // Parents are sorted before their children
+    REQUIRE(outer < inner);
+    REQUIRE(PROFILER.get_last_duration("inner") >= 1e-3f);
+}
+
+TEST_CASE("Markers from other threads land in current frame", "[profile]")
+{
+    PROFILER.set_enabled(true);
+    PROFILER.begin_frame();
+    std::thread worker([]()
+    {
+        ProfileScope scope("worker");
+    });
+    worker.join();
+    {
+        ProfileScope scope("main");
+    }
+    PROFILER.end_frame();
+
+    const FrameProfile& frame = PROFILER.get_frame(0);
+    const ProfileEvent* worker_event = find_event(frame, "worker");
+    const ProfileEvent* main_event = find_event(frame, "main");
+    REQUIRE(worker_event != nullptr);
+    REQUIRE(main_event != nullptr);
+    REQUIRE(worker_event->thread != main_event->thread);
+}
+
+TEST_CASE("Markers of many concurrent threads are all merged", "[profile]")
+{
+    // More threads than per-thread buffers, last ones share a buffer
+    constexpr uint32_t n_threads = FrameProfiler::MAX_THREADS + 8;
+    constexpr uint32_t n_markers = 100;
+
+    PROFILER.set_enabled(true);
+    PROFILER.begin_frame();
+    std::vector<std::thread> workers;
+    for(uint32_t ii=0; ii<n_threads; ++ii)
+    {
+        workers.emplace_back([]()
+        {
+            for(uint32_t jj=0; jj<n_markers; ++jj)
+                ProfileScope scope("concurrent");
+        });
+    }
+    for(auto&& worker: workers)
+        worker.join();
+    PROFILER.end_frame();
+
+    const FrameProfile& frame = PROFILER.get_frame(0);
+    size_t count = 0;
+    for(auto&& event: frame.events)
+        count += (strcmp(event.name, "concurrent") == 0) ? 1 : 0;
+    REQUIRE(count == n_threads*n_markers);
+
+    bool sorted = true;
+    for(size_t ii=1; ii<frame.events.size(); ++ii)
+        sorted &= (frame.events[ii-1].start <= frame.events[ii].start);
+    REQUIRE(sorted);
+}
+
+TEST_CASE("Disabled profiler records nothing", "[profile]")
+{
+    PROFILER.set_enabled(true);
+    PROFILER.begin_frame();
+    PROFILER.end_frame();
+    size_t n_frames = PROFILER.get_frame_count();
+
+    PROFILER.set_enabled(false);
+    PROFILER.begin_frame();
+    {
+        ProfileScope scope("ignored");
+    }
+    PROFILER.end_frame();
+
+    REQUIRE(PROFILER.get_frame_count() == n_frames);
+    REQUIRE(find_event(PROFILER.get_frame(0), "ignored") == nullptr);
+}
+
+TEST_CASE("Chrome trace export", "[profile]")
+{
+    dbg::LOG.register_channel("profile", 0);
+    PROFILER.set_enabled(true);
+    PROFILER.begin_frame();
+    {
+        ProfileScope scope(PROFILER.intern_name("exported \"marker\""));
+    }
+    PROFILER.end_frame();
+
+    fs::path path = fs::temp_directory_path() / "wcore_test_trace.json";
+    REQUIRE(PROFILER.export_chrome_trace(path));
+
+    std::ifstream ifs(path);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    std::string json = ss.str();
+    fs::remove(path);
+
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(json.find("\"name\":\"exported \\\"marker\\\"\"") != std::string::npos);
+    REQUIRE(json.find("\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(json.find("]}") != std::string::npos);
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+
+#include "frustum_culling.h"
+#include "bounding_boxes.h"
+#include "camera.h"
+#include "math3d.h"
+
+using namespace wcore;
+
+TEST_CASE("Visibility bitset set / reset / count", "[cull]")
+{
+    VisibilityBitset bitset;
+    bitset.resize(130, false);
+    REQUIRE(bitset.n_words() == 3);
+    REQUIRE(bitset.count() == 0);
+
+    bitset.set(0);
+    bitset.set(64);
+    bitset.set(129);
+    REQUIRE(bitset.test(0));
+    REQUIRE(bitset.test(64));
+    REQUIRE(bitset.test(129));
+    REQUIRE(!bitset.test(1));
+    REQUIRE(bitset.count() == 3);
+
+    bitset.reset(64);
+    REQUIRE(!bitset.test(64));
+
+    // Bits past the end are not counted
+    bitset.resize(130, true);
+    REQUIRE(bitset.count() == 130);
+}
+
+class CullingFixture
+{
+public:
+    CullingFixture():
+    camera_(1024, 768)
+    {
+        camera_.set_perspective(1024, 768, 0.1f, 100.f);
+        camera_.set_position(math::vec3(0,10,0));
+        camera_.update(0.f);
+        planes_.update(camera_.get_frustum_box());
+
+        // Random oriented boxes around the camera
+        math::srand_vec3(42);
+        math::extent_t region({-120,120,-20,40,-120,120});
+        math::extent_t scales({0.1f,5.f,0.1f,5.f,0.1f,5.f});
+        math::extent_t angles({0.f,6.28f,0.f,6.28f,0.f,6.28f});
+        for(int ii=0; ii<1000; ++ii)
+        {
+            math::vec3 dims(math::random_vec3(scales));
+            OBB obb({-dims.x(),dims.x(),-dims.y(),dims.y(),-dims.z(),dims.z()}, true);
+
+            math::mat4 M;
+            math::init_rotation_tait_bryan(M, math::random_vec3(angles));
+            math::translate_matrix(M, math::random_vec3(region));
+            obb.update(M);
+            boxes_.push_back(obb);
+        }
+    }
+
+protected:
+    Camera camera_;
+    FrustumPlanes planes_;
+    std::vector<OBB> boxes_;
+};
+
+TEST_CASE_METHOD(CullingFixture, "Batched culling agrees with OBB / frustum collision test", "[cull]")
+{
+    CullingBoxes culling_boxes;
+    culling_boxes.resize(boxes_.size());
+    for(uint32_t ii=0; ii<boxes_.size(); ++ii)
+        culling_boxes.set(ii, boxes_[ii].get_vertices());
+
+    VisibilityBitset visibility;
+    visibility.resize(boxes_.size());
+    culling_boxes.cull(planes_, 0, boxes_.size(), visibility);
+
+    uint32_t n_mismatch = 0;
+    uint32_t n_visible = 0;
+    for(uint32_t ii=0; ii<boxes_.size(); ++ii)
+    {
+        bool expected = camera_.frustum_collides(boxes_[ii]);
+        n_visible += expected ? 1 : 0;
+        if(visibility.test(ii) != expected)
+            ++n_mismatch;
+    }
+
+    REQUIRE(n_visible > 0);
+    REQUIRE(n_visible < boxes_.size());
+    REQUIRE(n_mismatch == 0);
+    REQUIRE(visibility.count() == n_visible);
+}
+
+TEST_CASE_METHOD(CullingFixture, "SIMD and scalar culling paths agree", "[cull]")
+{
+    CullingBoxes culling_boxes;
+    culling_boxes.resize(boxes_.size());
+    for(uint32_t ii=0; ii<boxes_.size(); ++ii)
+        culling_boxes.set(ii, boxes_[ii].get_vertices());
+
+    VisibilityBitset vis_simd, vis_scalar;
+    vis_simd.resize(boxes_.size());
+    vis_scalar.resize(boxes_.size());
+    culling_boxes.cull(planes_, 0, boxes_.size(), vis_simd);
+    culling_boxes.cull(planes_, 0, boxes_.size(), vis_scalar, false);
+
+    bool same = true;
+    for(uint32_t ww=0; ww<vis_simd.n_words(); ++ww)
+        same &= (vis_simd.get_word(ww) == vis_scalar.get_word(ww));
+    REQUIRE(same);
+
+    uint32_t n_mismatch = 0;
+    for(uint32_t ii=0; ii<boxes_.size(); ++ii)
+        if(vis_scalar.test(ii) != camera_.frustum_collides(boxes_[ii]))
+            ++n_mismatch;
+    REQUIRE(n_mismatch == 0);
+}
+
+TEST_CASE_METHOD(CullingFixture, "Culling by ranges and non cullable boxes", "[cull]")
+{
+    CullingBoxes culling_boxes;
+    culling_boxes.resize(boxes_.size());
+    for(uint32_t ii=0; ii<boxes_.size(); ++ii)
+    {
+        if(ii%10 == 0)
+            culling_boxes.set_no_cull(ii);
+        else
+            culling_boxes.set(ii, boxes_[ii].get_vertices());
+    }
+
+    VisibilityBitset visibility;
+    visibility.resize(boxes_.size());
+    for(uint32_t begin=0; begin<boxes_.size(); begin+=128)
+        culling_boxes.cull(planes_, begin, begin+128, visibility);
+
+    bool success = true;
+    for(uint32_t ii=0; ii<boxes_.size(); ++ii)
+    {
+        bool expected = (ii%10 == 0) || camera_.frustum_collides(boxes_[ii]);
+        success &= (visibility.test(ii) == expected);
+    }
+
+    REQUIRE(success);
+}
+
+TEST_CASE("Frustum slices cover the view frustum", "[cull]")
+{
+    Camera camera(1024, 768);
+    camera.set_perspective(1024, 768, 0.1f, 100.f);
+    camera.set_position(math::vec3(0,10,0));
+    camera.update(0.f);
+
+    FrustumBox box = camera.get_frustum_box();
+    box.set_splits(4, 0.75f, 0.1f, 100.f);
+    REQUIRE(box.get_split_count() == 4);
+    REQUIRE(box.get_split(0) == 0.f);
+    REQUIRE(box.get_split(4) == 1.f);
+    for(uint32_t ii=0; ii<4; ++ii)
+        REQUIRE(box.get_split(ii) < box.get_split(ii+1));
+
+    // First slice starts at near plane, last slice ends at far plane, slices are contiguous
+    std::array<math::vec3, 8> first, last, current, next;
+    box.split_corners(0, first);
+    box.split_corners(3, last);
+    REQUIRE((first[0]-box.RBN()).norm() < 1e-4f);
+    REQUIRE((first[7]-box.LTN()).norm() < 1e-4f);
+    REQUIRE((last[1]-box.RBF()).norm() < 1e-4f);
+    REQUIRE((last[6]-box.LTF()).norm() < 1e-4f);
+    bool contiguous = true;
+    for(uint32_t ii=0; ii<3; ++ii)
+    {
+        box.split_corners(ii, current);
+        box.split_corners(ii+1, next);
+        contiguous &= (current[1]-next[0]).norm() < 1e-4f;
+        contiguous &= (current[5]-next[4]).norm() < 1e-4f;
+    }
+    REQUIRE(contiguous);
+
+    // A frustum built from slice corners contains the slice center, not the camera position
+    FrustumBox slice;
+    slice.update(last);
+    REQUIRE(traits::collision<FrustumBox,math::vec3>::intersects(slice, box.split_center(3)));
+    REQUIRE(!traits::collision<FrustumBox,math::vec3>::intersects(slice, camera.get_position()));
+}
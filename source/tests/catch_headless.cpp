@@ -0,0 +1,42 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+#include "wcore.h"
+#include "gfx_api.h"
+#include "platform/null/null_renderer_api.h"
+
+using namespace wcore;
+
+static constexpr uint32_t N_FRAMES = 8;
+
+// Runs the whole engine on the null graphics API: config, resource archive,
+// game systems, level loading and the game loop. The null device counters
+// are the ones dumped by Engine::Run() in debug builds.
+TEST_CASE("Headless engine runs a level for a fixed number of frames.", "[headless]")
+{
+    Engine engine;
+    engine.SetHeadless(N_FRAMES);
+    engine.Init(0, nullptr);
+    REQUIRE(Gfx::get_api() == GfxAPI::Null);
+
+    engine.scene->LoadStart();
+    // Only count commands issued by the game loop
+    null_device().reset_stats();
+
+    REQUIRE(engine.Run() == 0);
+
+    const GfxStats& total = null_device().get_total_stats();
+    REQUIRE(total.frames == N_FRAMES);
+    // Every frame clears and draws the G-Buffer at least
+    REQUIRE(total.draw_calls >= N_FRAMES);
+    REQUIRE(total.clears >= N_FRAMES);
+    REQUIRE(total.instances >= total.draw_calls);
+    REQUIRE(total.elements > 0);
+    REQUIRE(total.program_binds >= N_FRAMES);
+    REQUIRE(total.framebuffer_binds >= N_FRAMES);
+
+    // Last frame issued work too, the loop did not stall after the first frames
+    const GfxStats& last = null_device().get_last_frame_stats();
+    REQUIRE(last.frames == 1);
+    REQUIRE(last.draw_calls > 0);
+}
@@ -0,0 +1,132 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "heightmap_generator.h"
+#include "height_map.h"
+#include "noise_generator.hpp"
+#include "noise_policy.hpp"
+#include "job_system.h"
+
+using namespace wcore;
+
+static void make_bumpy(HeightMap& hm)
+{
+    for(uint32_t ii=0; ii<hm.get_width(); ++ii)
+        for(uint32_t jj=0; jj<hm.get_length(); ++jj)
+            hm.set_height(ii, jj, 5.f*std::sin(0.21f*ii)*std::cos(0.13f*jj) + 0.05f*ii);
+}
+
+static bool same_heights(const HeightMap& a, const HeightMap& b)
+{
+    for(uint32_t ii=0; ii<a.get_width()*a.get_length(); ++ii)
+        if(a.data()[ii] != b.data()[ii])
+            return false;
+    return true;
+}
+
+TEST_CASE("Batched simplex noise matches scalar noise", "[noise]")
+{
+    std::mt19937 rng(42);
+    NoiseGenerator2D<SimplexNoise<>> gen;
+    gen.init(rng);
+
+    // Odd count to exercise the scalar tail
+    const size_t count = 103;
+    std::vector<float> xs(count), ys(count), out(count);
+    for(size_t ii=0; ii<count; ++ii)
+    {
+        xs[ii] = -17.3f + 0.731f*ii;
+        ys[ii] =  4.1f  - 0.377f*ii;
+    }
+
+    gen.octave_noise(xs.data(), ys.data(), out.data(), count, 6, 0.05f, 0.5f);
+
+    bool success = true;
+    for(size_t ii=0; ii<count; ++ii)
+        success &= std::fabs(out[ii] - gen.octave_noise(xs[ii], ys[ii], 6, 0.05f, 0.5f)) < 1e-4f;
+
+    REQUIRE(success);
+}
+
+TEST_CASE("Tiled droplet erosion is deterministic", "[erosion]")
+{
+    DropletErosionProps props;
+    props.iterations = 2000;
+    props.tile_size = 16;
+
+    HeightMap reference(64, 64);
+    make_bumpy(reference);
+    HeightMap original(reference);
+
+    JOBS.init(3);
+    HeightmapGenerator::erode_droplets(reference, props);
+
+    SECTION("Erosion modifies the height map")
+    {
+        REQUIRE(!same_heights(reference, original));
+    }
+
+    SECTION("Same seed gives same result")
+    {
+        HeightMap hm(64, 64);
+        make_bumpy(hm);
+        HeightmapGenerator::erode_droplets(hm, props);
+        REQUIRE(same_heights(reference, hm));
+    }
+
+    SECTION("Result does not depend on worker count")
+    {
+        JOBS.shutdown();
+        HeightMap hm(64, 64);
+        make_bumpy(hm);
+        HeightmapGenerator::erode_droplets(hm, props);
+        REQUIRE(same_heights(reference, hm));
+    }
+
+    SECTION("Different seed gives different result")
+    {
+        props.seed = 43;
+        HeightMap hm(64, 64);
+        make_bumpy(hm);
+        HeightmapGenerator::erode_droplets(hm, props);
+        REQUIRE(!same_heights(reference, hm));
+    }
+
+    JOBS.shutdown();
+}
+
+TEST_CASE("Simplex height maps generated concurrently match sequential ones", "[noise]")
+{
+    static constexpr uint32_t N_MAPS = 4;
+    SimplexNoiseProps props;
+    props.octaves = 6;
+    props.frequency = 0.05f;
+
+    auto generate = [&](HeightMap& hm, uint32_t index)
+    {
+        std::mt19937 rng(index);
+        HeightmapGenerator::SimplexGenerator generator;
+        generator.init(rng);
+        HeightmapGenerator::heightmap_from_simplex_noise(hm, props, generator);
+    };
+
+    std::vector<HeightMap> reference(N_MAPS, HeightMap(32, 32));
+    for(uint32_t ii=0; ii<N_MAPS; ++ii)
+        generate(reference[ii], ii);
+
+    JOBS.init(3);
+    std::vector<HeightMap> concurrent(N_MAPS, HeightMap(32, 32));
+    JobCounter counter;
+    for(uint32_t ii=0; ii<N_MAPS; ++ii)
+        JOBS.schedule([&, ii]() { generate(concurrent[ii], ii); }, &counter);
+    JOBS.wait(counter);
+    JOBS.shutdown();
+
+    bool success = !same_heights(reference[0], reference[1]);
+    for(uint32_t ii=0; ii<N_MAPS; ++ii)
+        success &= same_heights(reference[ii], concurrent[ii]);
+    REQUIRE(success);
+}
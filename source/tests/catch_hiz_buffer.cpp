@@ -0,0 +1,175 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <array>
+#include <vector>
+
+#include "hiz_buffer.h"
+#include "math3d.h"
+
+using namespace wcore;
+using namespace math;
+
+static constexpr uint32_t BUF_W = 128;
+static constexpr uint32_t BUF_H = 64;
+static constexpr float NEAR = 0.1f;
+static constexpr float FAR = 100.f;
+
+// Camera at origin looking down -z
+static mat4 make_view_projection()
+{
+    mat4 P;
+    float aspect = float(BUF_W)/BUF_H;
+    init_frustum(P, Frustum(-aspect*NEAR, aspect*NEAR, -NEAR, NEAR, NEAR, FAR));
+    return P;
+}
+
+static std::array<vec3, 8> make_box(const vec3& center, float half_extent)
+{
+    std::array<vec3, 8> vertices;
+    for(int ii=0; ii<8; ++ii)
+        vertices[ii] = center + vec3((ii&1) ? half_extent : -half_extent,
+                                     (ii&2) ? half_extent : -half_extent,
+                                     (ii&4) ? half_extent : -half_extent);
+    return vertices;
+}
+
+// Large quad facing the camera at view depth -depth
+static void rasterize_wall(HiZBuffer& hiz, float depth, float half_size)
+{
+    vec3 p0(-half_size, -half_size, -depth);
+    vec3 p1( half_size, -half_size, -depth);
+    vec3 p2( half_size,  half_size, -depth);
+    vec3 p3(-half_size,  half_size, -depth);
+    hiz.rasterize_triangle(p0, p1, p2);
+    hiz.rasterize_triangle(p0, p2, p3);
+}
+
+class HiZFixture
+{
+public:
+    HiZFixture()
+    {
+        hiz.resize(BUF_W, BUF_H);
+        hiz.clear(make_view_projection());
+        rasterize_wall(hiz, 10.f, 5.f);
+        hiz.build();
+    }
+
+protected:
+    HiZBuffer hiz;
+};
+
+TEST_CASE("Invalid buffer never occludes.", "[hiz]")
+{
+    HiZBuffer hiz;
+    hiz.resize(BUF_W, BUF_H);
+    hiz.clear(make_view_projection());
+    rasterize_wall(hiz, 10.f, 5.f);
+
+    REQUIRE(!hiz.is_occluded(make_box(vec3(0.f,0.f,-50.f), 1.f)));
+}
+
+TEST_CASE_METHOD(HiZFixture, "Pyramid levels hold the maximum depth of their footprint.", "[hiz]")
+{
+    REQUIRE(hiz.get_level_width(hiz.get_level_count()-1) == 1);
+    REQUIRE(hiz.get_level_height(hiz.get_level_count()-1) == 1);
+
+    bool max_property = true;
+    for(uint32_t ll=1; ll<hiz.get_level_count(); ++ll)
+    {
+        uint32_t src_w = hiz.get_level_width(ll-1);
+        uint32_t src_h = hiz.get_level_height(ll-1);
+        for(uint32_t yy=0; yy<hiz.get_level_height(ll); ++yy)
+        {
+            for(uint32_t xx=0; xx<hiz.get_level_width(ll); ++xx)
+            {
+                float expected = 0.f;
+                for(uint32_t sy=2*yy; sy<std::min(2*yy+2, src_h); ++sy)
+                    for(uint32_t sx=2*xx; sx<std::min(2*xx+2, src_w); ++sx)
+                        expected = std::max(expected, hiz.get_depth(ll-1, sx, sy));
+                max_property &= (hiz.get_depth(ll, xx, yy) == expected);
+            }
+        }
+    }
+    REQUIRE(max_property);
+
+    // Wall does not cover the whole screen, so the root is the far plane
+    REQUIRE(hiz.get_depth(hiz.get_level_count()-1, 0, 0) == Approx(1.f));
+    // Screen center is covered by the wall
+    REQUIRE(hiz.get_depth(0, BUF_W/2, BUF_H/2) < 1.f);
+}
+
+TEST_CASE_METHOD(HiZFixture, "Box behind occluder is occluded.", "[hiz]")
+{
+    REQUIRE(hiz.is_occluded(make_box(vec3(0.f,0.f,-30.f), 1.f)));
+    REQUIRE(hiz.is_occluded(make_box(vec3(1.f,-1.f,-15.f), 0.5f)));
+}
+
+TEST_CASE_METHOD(HiZFixture, "Box in front of occluder is visible.", "[hiz]")
+{
+    REQUIRE(!hiz.is_occluded(make_box(vec3(0.f,0.f,-5.f), 1.f)));
+}
+
+TEST_CASE_METHOD(HiZFixture, "Box partially outside occluder is visible.", "[hiz]")
+{
+    // Box overlaps wall border in screen space
+    REQUIRE(!hiz.is_occluded(make_box(vec3(15.f,0.f,-30.f), 1.f)));
+    // Box straddling the occluder plane
+    REQUIRE(!hiz.is_occluded(make_box(vec3(0.f,0.f,-10.f), 1.f)));
+}
+
+TEST_CASE("Box partially off screen is visible.", "[hiz]")
+{
+    // Wall covers the whole screen
+    HiZBuffer hiz;
+    hiz.resize(BUF_W, BUF_H);
+    hiz.clear(make_view_projection());
+    rasterize_wall(hiz, 10.f, 100.f);
+    hiz.build();
+
+    REQUIRE(hiz.is_occluded(make_box(vec3(0.f,0.f,-30.f), 1.f)));
+    // Right and top screen edges are at x=2|z| and y=|z|, the hidden
+    // part of the box may not be behind the wall
+    REQUIRE(!hiz.is_occluded(make_box(vec3(60.f,0.f,-30.f), 1.f)));
+    REQUIRE(!hiz.is_occluded(make_box(vec3(0.f,-30.f,-30.f), 1.f)));
+}
+
+TEST_CASE_METHOD(HiZFixture, "Box crossing the near plane is visible.", "[hiz]")
+{
+    REQUIRE(!hiz.is_occluded(make_box(vec3(0.f,0.f,0.f), 1.f)));
+}
+
+TEST_CASE("Depth readback matches rasterized depth.", "[hiz]")
+{
+    HiZBuffer ref;
+    ref.resize(BUF_W, BUF_H);
+    ref.clear(make_view_projection());
+    rasterize_wall(ref, 10.f, 5.f);
+
+    std::vector<float> depth(BUF_W*BUF_H);
+    for(uint32_t yy=0; yy<BUF_H; ++yy)
+        for(uint32_t xx=0; xx<BUF_W; ++xx)
+            depth[yy*BUF_W+xx] = ref.get_depth(0, xx, yy);
+
+    HiZBuffer hiz;
+    hiz.resize(BUF_W, BUF_H);
+    hiz.set_depth(depth.data(), make_view_projection());
+    hiz.build();
+
+    REQUIRE(hiz.is_occluded(make_box(vec3(0.f,0.f,-30.f), 1.f)));
+    REQUIRE(!hiz.is_occluded(make_box(vec3(0.f,0.f,-5.f), 1.f)));
+}
+
+TEST_CASE_METHOD(HiZFixture, "Eye position is recovered from the view-projection matrix.", "[hiz]")
+{
+    REQUIRE(hiz.get_eye_distance(vec3(0.f,0.f,0.f)) == Approx(0.f).margin(1e-4f));
+    REQUIRE(hiz.get_eye_distance(vec3(3.f,0.f,-4.f)) == Approx(5.f));
+
+    // Translated camera
+    mat4 V;
+    init_translation(V, vec3(-2.f,-1.f,5.f));
+    HiZBuffer moved;
+    moved.resize(BUF_W, BUF_H);
+    moved.clear(make_view_projection()*V);
+    REQUIRE(moved.get_eye_distance(vec3(2.f,1.f,-5.f)) == Approx(0.f).margin(1e-3f));
+}
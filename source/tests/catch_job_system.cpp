@@ -0,0 +1,102 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+
+#include "job_system.h"
+
+using namespace wcore;
+
+static constexpr uint32_t N_WORKERS = 3;
+
+TEST_CASE("Jobs are all executed before counter is released", "[jobs]")
+{
+    JOBS.init(N_WORKERS);
+
+    std::atomic<uint32_t> count(0);
+    JobCounter counter;
+    for(int ii=0; ii<1000; ++ii)
+        JOBS.schedule([&count]() { ++count; }, &counter);
+    JOBS.wait(counter);
+
+    REQUIRE(counter.is_done());
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("Parallel for visits each index once", "[jobs]")
+{
+    JOBS.init(N_WORKERS);
+
+    std::vector<uint32_t> visits(10000, 0);
+    JOBS.parallel_for(0, visits.size(), [&visits](uint32_t ii)
+    {
+        ++visits[ii];
+    });
+    REQUIRE(std::all_of(visits.begin(), visits.end(), [](uint32_t v) { return v==1; }));
+
+    // Explicit grain, range not a multiple of grain
+    std::vector<uint32_t> squares(1001, 0);
+    JOBS.parallel_for(1, squares.size(), [&squares](uint32_t ii)
+    {
+        squares[ii] = ii*ii;
+    }, 7);
+    REQUIRE(squares[0] == 0);
+    REQUIRE(squares[1] == 1);
+    REQUIRE(squares[1000] == 1000000);
+}
+
+TEST_CASE("Dependent jobs start after their dependency", "[jobs]")
+{
+    JOBS.init(N_WORKERS);
+
+    std::vector<uint32_t> data(256, 0);
+    JobCounter fill_counter;
+    JobCounter sum_counter;
+    uint32_t sum = 0;
+
+    // Fill jobs are spawned by another job, they may still run when the
+    // dependent job is declared
+    JobCounter gate;
+    JOBS.schedule([&]()
+    {
+        for(uint32_t ii=0; ii<data.size(); ii+=32)
+            JOBS.schedule([&data, ii]()
+            {
+                for(uint32_t jj=ii; jj<ii+32; ++jj)
+                    data[jj] = jj;
+            }, &fill_counter);
+    }, &gate);
+    JOBS.wait(gate);
+
+    JOBS.schedule_after(fill_counter, [&]()
+    {
+        sum = std::accumulate(data.begin(), data.end(), 0u);
+    }, &sum_counter);
+    JOBS.wait(sum_counter);
+
+    REQUIRE(fill_counter.is_done());
+    REQUIRE(sum == 255*256/2);
+}
+
+TEST_CASE("Jobs can wait on nested jobs", "[jobs]")
+{
+    JOBS.init(N_WORKERS);
+
+    std::atomic<uint32_t> count(0);
+    JobCounter counter;
+    for(int ii=0; ii<16; ++ii)
+    {
+        JOBS.schedule([&count]()
+        {
+            JobCounter inner;
+            for(int jj=0; jj<16; ++jj)
+                JOBS.schedule([&count]() { ++count; }, &inner);
+            JOBS.wait(inner);
+        }, &counter);
+    }
+    JOBS.wait(counter);
+
+    REQUIRE(count == 256);
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "light_grid.h"
+#include "math3d.h"
+
+using namespace wcore;
+using namespace math;
+
+static constexpr uint32_t SCR_W = 1280;
+static constexpr uint32_t SCR_H = 720;
+static constexpr float NEAR = 0.1f;
+static constexpr float FAR = 100.f;
+
+static mat4 make_projection()
+{
+    mat4 P;
+    float aspect = float(SCR_W)/SCR_H;
+    init_frustum(P, Frustum(-aspect*NEAR, aspect*NEAR, -NEAR, NEAR, NEAR, FAR));
+    return P;
+}
+
+// Tile coordinates of a view-space point, false if point is clipped
+static bool point_tile(const vec3& point, const mat4& P, uint32_t tile_size, uint32_t& tx, uint32_t& ty)
+{
+    if(point.z() > -NEAR)
+        return false;
+    vec4 clip = P*vec4(point, 1.f);
+    float ndc_x = clip.x()/clip.w();
+    float ndc_y = clip.y()/clip.w();
+    if(std::fabs(ndc_x) >= 1.f || std::fabs(ndc_y) >= 1.f)
+        return false;
+    tx = uint32_t((0.5f*ndc_x+0.5f)*SCR_W) / tile_size;
+    ty = uint32_t((0.5f*ndc_y+0.5f)*SCR_H) / tile_size;
+    return true;
+}
+
+TEST_CASE("Sphere tile rectangle is conservative", "[lgrid]")
+{
+    mat4 P = make_projection();
+    LightGrid grid(32);
+    grid.resize(SCR_W, SCR_H);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos_x(-20.f, 20.f);
+    std::uniform_real_distribution<float> pos_z(-40.f, 5.f);
+    std::uniform_real_distribution<float> rad(0.5f, 8.f);
+    std::uniform_real_distribution<float> angle(0.f, 1.f);
+
+    bool all_inside = true;
+    uint32_t n_visible = 0;
+    for(int ll=0; ll<500; ++ll)
+    {
+        vec3 center(pos_x(rng), pos_x(rng)*0.5f, pos_z(rng));
+        float radius = rad(rng);
+        TileRect rect;
+        bool visible = grid.compute_tile_rect(center, radius, P, rect);
+        n_visible += visible;
+
+        // Every visible point of the sphere surface must land in the rectangle
+        for(int ss=0; ss<400; ++ss)
+        {
+            float theta = 2.f*float(M_PI)*angle(rng);
+            float phi = std::acos(2.f*angle(rng)-1.f);
+            vec3 point = center + radius*vec3(std::sin(phi)*std::cos(theta),
+                                              std::sin(phi)*std::sin(theta),
+                                              std::cos(phi));
+            uint32_t tx, ty;
+            if(!point_tile(point, P, 32, tx, ty))
+                continue;
+            all_inside &= visible && tx>=rect.x0 && tx<=rect.x1 && ty>=rect.y0 && ty<=rect.y1;
+        }
+    }
+    REQUIRE(n_visible > 0);
+    REQUIRE(all_inside);
+}
+
+TEST_CASE("Sphere behind near plane is rejected", "[lgrid]")
+{
+    mat4 P = make_projection();
+    LightGrid grid(32);
+    grid.resize(SCR_W, SCR_H);
+
+    TileRect rect;
+    REQUIRE(!grid.compute_tile_rect(vec3(0.f, 0.f, 5.f), 2.f, P, rect));
+    // Camera inside light volume: whole screen
+    REQUIRE(grid.compute_tile_rect(vec3(0.f, 0.f, -1.f), 3.f, P, rect));
+    REQUIRE(rect.x0 == 0);
+    REQUIRE(rect.y0 == 0);
+    REQUIRE(rect.x1 == grid.get_tiles_x()-1);
+    REQUIRE(rect.y1 == grid.get_tiles_y()-1);
+}
+
+TEST_CASE("Tile light lists match light rectangles", "[lgrid]")
+{
+    mat4 P = make_projection();
+    LightGrid grid(16);
+    grid.resize(SCR_W, SCR_H);
+    REQUIRE(grid.get_tiles_x() == 80);
+    REQUIRE(grid.get_tiles_y() == 45);
+
+    std::vector<vec3> centers =
+    {
+        vec3(0.f, 0.f, -10.f),
+        vec3(-5.f, 2.f, -15.f),
+        vec3(4.f, -1.f, -8.f),
+        vec3(0.f, 0.f, 10.f), // Behind camera
+    };
+    std::vector<TileRect> rects;
+    for(auto&& center: centers)
+    {
+        TileRect rect;
+        if(grid.compute_tile_rect(center, 2.f, P, rect))
+            rects.push_back(rect);
+        grid.push_light(center, 2.f, vec3(1.f), 0.1f, P);
+    }
+    grid.build();
+    REQUIRE(grid.get_light_count() == 3);
+    REQUIRE(grid.get_light_data().size() == 6);
+
+    bool match = true;
+    for(uint32_t ty=0; ty<grid.get_tiles_y(); ++ty)
+    {
+        for(uint32_t tx=0; tx<grid.get_tiles_x(); ++tx)
+        {
+            std::vector<uint32_t> expected;
+            for(uint32_t ii=0; ii<rects.size(); ++ii)
+                if(tx>=rects[ii].x0 && tx<=rects[ii].x1 && ty>=rects[ii].y0 && ty<=rects[ii].y1)
+                    expected.push_back(ii);
+
+            uint32_t count = grid.get_tile_light_count(tx, ty);
+            match &= (count == expected.size());
+            if(count == expected.size())
+                match &= std::equal(expected.begin(), expected.end(), grid.get_tile_lights(tx, ty));
+        }
+    }
+    REQUIRE(match);
+
+    // Rebuilding after clear gives empty lists
+    grid.clear();
+    grid.build();
+    REQUIRE(grid.get_light_indices().empty());
+    REQUIRE(grid.get_tile_light_count(40, 22) == 0);
+}
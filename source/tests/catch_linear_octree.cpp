@@ -0,0 +1,138 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <set>
+
+#include "octree.hpp"
+#include "linear_octree.hpp"
+#include "math3d.h"
+#include "catch_math_common.h"
+
+using namespace wcore;
+
+struct UData
+{
+    float value;
+    int key;
+
+    bool operator==(const UData& other) const
+    {
+        return key == other.key;
+    }
+};
+
+class LinearOctreeFixture
+{
+public:
+    typedef Octree<math::vec3,UData>       PointOctree;
+    typedef LinearOctree<math::vec3,UData> LinearPointOctree;
+
+    LinearOctreeFixture():
+    region_({-100,100,0,100,-100,100})
+    {
+        PointOctree::ContentT ref_points;
+        LinearPointOctree::ContentT lin_points;
+        math::srand_vec3(42);
+        for(int ii=0; ii<1000; ++ii)
+        {
+            math::vec3 point(math::random_vec3(region_.extent));
+            UData user_data({point.norm(), ii});
+            ref_points.push_back(PointOctree::DataT(point, user_data, ii/100));
+            lin_points.push_back(LinearPointOctree::DataT(point, user_data, ii/100));
+        }
+        ref_octree_ = new PointOctree(region_, ref_points);
+        lin_octree_ = new LinearPointOctree(region_, lin_points);
+        ref_octree_->propagate();
+        lin_octree_->propagate();
+    }
+
+    ~LinearOctreeFixture()
+    {
+        delete ref_octree_;
+        delete lin_octree_;
+    }
+
+    template <typename RangeT>
+    void compare_range(const RangeT& range)
+    {
+        std::set<int> ref_keys;
+        std::set<int> lin_keys;
+        ref_octree_->traverse_range(range, [&](auto&& obj) { ref_keys.insert(obj.data.key); });
+        lin_octree_->traverse_range(range, [&](auto&& obj) { lin_keys.insert(obj.data.key); });
+
+        REQUIRE(ref_keys.size() > 0);
+        REQUIRE(ref_keys == lin_keys);
+    }
+
+protected:
+    BoundingRegion region_;
+    PointOctree* ref_octree_;
+    LinearPointOctree* lin_octree_;
+};
+
+TEST_CASE_METHOD(LinearOctreeFixture, "Linear octree leaves traversal", "[loctree]")
+{
+    uint32_t npoints=0;
+    lin_octree_->traverse_leaves([&](auto&& data)
+    {
+        ++npoints;
+    });
+
+    REQUIRE(npoints == 1000);
+}
+
+TEST_CASE_METHOD(LinearOctreeFixture, "Linear octree range traversal matches Octree", "[loctree]")
+{
+    compare_range(BoundingRegion({-28,0,0,20,0,50}));
+    compare_range(Sphere(math::vec3(-20,10,50),30));
+}
+
+TEST_CASE_METHOD(LinearOctreeFixture, "Linear octree removal", "[loctree]")
+{
+    // Remove single objects
+    REQUIRE(lin_octree_->remove(UData({0.f, 0})));
+    REQUIRE(lin_octree_->remove(UData({0.f, 999})));
+    REQUIRE_FALSE(lin_octree_->remove(UData({0.f, 999})));
+    REQUIRE(lin_octree_->get_size() == 998);
+
+    // Remove objects from 100 to 199
+    lin_octree_->remove_group(1);
+    ref_octree_->remove(UData({0.f, 0}));
+    ref_octree_->remove(UData({0.f, 999}));
+    ref_octree_->remove_group(1);
+    REQUIRE(lin_octree_->get_size() == 898);
+
+    uint32_t npoints=0;
+    lin_octree_->traverse_range(region_, [&](auto&& obj)
+    {
+        REQUIRE(obj.group_id != 1);
+        ++npoints;
+    });
+    REQUIRE(npoints == 898);
+
+    compare_range(BoundingRegion({-28,0,0,20,0,50}));
+}
+
+TEST_CASE_METHOD(LinearOctreeFixture, "Linear octree lazy insertion and growth", "[loctree]")
+{
+    // Pending objects must be visible before propagation
+    lin_octree_->insert(LinearPointOctree::DataT(math::vec3(-10,10,10), UData({0.f, 5000})));
+    // Out of bounds object, root region grows
+    lin_octree_->insert(LinearPointOctree::DataT(math::vec3(-120,10,40), UData({0.f, 5001})));
+
+    auto count_key = [&](int key)
+    {
+        uint32_t count = 0;
+        lin_octree_->traverse_range(Sphere(math::vec3(-65,10,25),60), [&](auto&& obj)
+        {
+            if(obj.data.key == key) ++count;
+        });
+        return count;
+    };
+    REQUIRE(count_key(5000) == 1);
+    REQUIRE(count_key(5001) == 1);
+
+    lin_octree_->propagate();
+    REQUIRE(lin_octree_->get_size() == 1002);
+    REQUIRE(count_key(5000) == 1);
+    REQUIRE(count_key(5001) == 1);
+}
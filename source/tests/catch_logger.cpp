@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <sstream>
+
+#include "logger.h"
+#include "mpsc_ring_buffer.hpp"
+
+using namespace wcore;
+namespace fs = std::filesystem;
+
+TEST_CASE("Ring buffer preserves order and rejects push when full", "[log]")
+{
+    MPSCRingBuffer<int> queue(4);
+
+    for(int ii=0; ii<4; ++ii)
+        REQUIRE(queue.try_push(int(ii)));
+    REQUIRE(!queue.try_push(4));
+
+    int value = -1;
+    bool success = true;
+    for(int ii=0; ii<4; ++ii)
+        success &= (queue.try_pop(value) && value == ii);
+    REQUIRE(success);
+    REQUIRE(queue.empty());
+    REQUIRE(!queue.try_pop(value));
+}
+
+TEST_CASE("Ring buffer with concurrent producers", "[log]")
+{
+    static constexpr int N_PRODUCERS = 4;
+    static constexpr int N_ITEMS = 10000;
+
+    MPSCRingBuffer<int> queue(64);
+    std::vector<std::thread> producers;
+    for(int pp=0; pp<N_PRODUCERS; ++pp)
+    {
+        producers.emplace_back([&queue, pp]()
+        {
+            for(int ii=0; ii<N_ITEMS; ++ii)
+                while(!queue.try_push(pp*N_ITEMS + ii))
+                    std::this_thread::yield();
+        });
+    }
+
+    // Items of a given producer must be received in order
+    std::vector<int> last(N_PRODUCERS, -1);
+    bool in_order = true;
+    int received = 0;
+    while(received < N_PRODUCERS*N_ITEMS)
+    {
+        int value;
+        if(!queue.try_pop(value))
+            continue;
+        int producer = value / N_ITEMS;
+        int index = value % N_ITEMS;
+        in_order &= (index == last[producer]+1);
+        last[producer] = index;
+        ++received;
+    }
+
+    for(auto&& producer: producers)
+        producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Asynchronous logger outputs all messages from all threads", "[log]")
+{
+    static constexpr int N_PRODUCERS = 4;
+    static constexpr int N_MESSAGES = 500;
+
+    dbg::LOG.clear();
+    dbg::LOG.set_async(true, 256);
+    REQUIRE(dbg::LOG.is_async());
+
+    std::vector<std::thread> producers;
+    for(int pp=0; pp<N_PRODUCERS; ++pp)
+    {
+        producers.emplace_back([pp]()
+        {
+            for(int ii=0; ii<N_MESSAGES; ++ii)
+                dbg::LOG(std::to_string(pp) + " " + std::to_string(ii), MsgType::CANONICAL, LogMode::TEXTFILE);
+        });
+    }
+    for(auto&& producer: producers)
+        producer.join();
+
+    // write() flushes the queue beforehand
+    fs::path log_path = fs::temp_directory_path() / "wcore_test_async.log";
+    dbg::LOG.write(log_path);
+    dbg::LOG.set_async(false);
+    REQUIRE(!dbg::LOG.is_async());
+
+    std::ifstream ifs(log_path);
+    std::string line;
+    std::getline(ifs, line);
+    std::getline(ifs, line);
+
+    int count = 0;
+    bool in_order = true;
+    std::vector<int> last(N_PRODUCERS, -1);
+    while(std::getline(ifs, line))
+    {
+        // Message is at the end of the line: "<producer> <index>"
+        std::istringstream iss(line.substr(line.find_last_of(' ', line.size()-1) - 1));
+        int producer, index;
+        iss >> producer >> index;
+        in_order &= (index == last[producer]+1);
+        last[producer] = index;
+        ++count;
+    }
+    fs::remove(log_path);
+    dbg::LOG.clear();
+
+    REQUIRE(count == N_PRODUCERS*N_MESSAGES);
+    REQUIRE(in_order);
+}
+
+TEST_CASE("Asynchronous logger keeps the file of forwarded messages", "[log]")
+{
+    dbg::LOG.set_async(true, 256);
+
+    std::ostringstream captured;
+    std::streambuf* cout_buf = std::cout.rdbuf(captured.rdbuf());
+    {
+        // File name must be copied, message is destroyed before the log thread outputs it
+        std::string file("forwarded_file.cpp");
+        LogMessage message("forwarded", std::chrono::nanoseconds(0), MsgType::CANONICAL, LogMode::CONSOLE,
+                           Severity::CRIT, "core"_h, file.c_str(), 42);
+        dbg::LOG(message);
+    }
+    dbg::LOG.flush();
+    std::cout.rdbuf(cout_buf);
+    dbg::LOG.set_async(false);
+
+    REQUIRE(captured.str().find("@ forwarded_file.cpp: 42") != std::string::npos);
+}
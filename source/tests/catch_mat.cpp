@@ -1,5 +1,6 @@
 #include <catch2/catch.hpp>
 #include <iostream>
+#include <vector>
 #include "math3d.h"
 #include "catch_math_common.h"
 
@@ -322,6 +323,164 @@ TEST_CASE("Matrix inversion.", "[mat]")
     }
 }
 
+// Reference 4x4 product and matrix-vector product, plain loops on column major storage
+static mat4 reference_product(const mat4& lhs, const mat4& rhs)
+{
+    mat4 result;
+    for(unsigned col=0; col<4; ++col)
+        for(unsigned row=0; row<4; ++row)
+        {
+            float sum = 0.f;
+            for(unsigned kk=0; kk<4; ++kk)
+                sum += lhs[4*kk+row]*rhs[4*col+kk];
+            result[4*col+row] = sum;
+        }
+    return result;
+}
+
+static vec4 reference_product(const mat4& lhs, const vec4& rhs)
+{
+    vec4 result;
+    for(unsigned row=0; row<4; ++row)
+    {
+        float sum = 0.f;
+        for(unsigned kk=0; kk<4; ++kk)
+            sum += lhs[4*kk+row]*rhs[kk];
+        result[row] = sum;
+    }
+    return result;
+}
+
+static bool AllNear(const float* expected, const float* result, unsigned size, float delta)
+{
+    for(unsigned ii=0; ii<size; ++ii)
+        if(!FloatNear(expected[ii], result[ii], delta))
+            return false;
+    return true;
+}
+
+static const mat4 M_SIMD(0.9619, 0.8687, 0.8001, 0.2638,
+                         0.0046, 0.0844, 0.4314, 0.1455,
+                         0.7749, 0.3998, 0.9106, 0.1361,
+                         0.8173, 0.2599, 0.1818, 0.8693);
+static const mat4 N_SIMD(1.0, 2.0, 3.0, 2.0,
+                         3.0, 4.0, 5.0, 4.0,
+                         8.0, 9.0, 7.0, 5.0,
+                         1.0, 2.0, 1.0, 1.0);
+
+TEST_CASE("4x4 products match the scalar reference.", "[mat]")
+{
+    mat4 MN(M_SIMD*N_SIMD);
+    mat4 expect(reference_product(M_SIMD, N_SIMD));
+    REQUIRE(AllNear(expect.get_pointer(), MN.get_pointer(), 16, 1e-6));
+
+    vec4 v(1.5, -2.0, 0.25, 1.0);
+    vec4 Mv(M_SIMD*v);
+    vec4 expect_v(reference_product(M_SIMD, v));
+    REQUIRE(AllNear(expect_v.get_pointer(), Mv.get_pointer(), 4, 1e-6));
+}
+
+TEST_CASE("General 4x4 inverse of random matrices.", "[mat]")
+{
+    srand_vec3(42);
+    extent_t extent = {-10.f, 10.f, -10.f, 10.f, -10.f, 10.f};
+    for(unsigned ii=0; ii<20; ++ii)
+    {
+        // Non affine: last row is not (0,0,0,1)
+        mat4 M(vec4(random_vec3(extent), 1.f),
+               vec4(random_vec3(extent), 2.f),
+               vec4(random_vec3(extent), -3.f),
+               vec4(random_vec3(extent), 5.f));
+        mat4 Minv;
+        REQUIRE(inverse(M, Minv));
+        mat4 I(M*Minv);
+        mat4 Id; Id.init_identity();
+        REQUIRE(AllNear(Id.get_pointer(), I.get_pointer(), 16, 1e-3));
+    }
+
+    SECTION("Singular matrices are rejected.")
+    {
+        mat4 S(1.0, 2.0, 3.0, 4.0,
+               2.0, 4.0, 6.0, 8.0,
+               8.0, 9.0, 7.0, 5.0,
+               1.0, 2.0, 1.0, 1.0);
+        mat4 Sinv;
+        REQUIRE(!inverse(S, Sinv));
+    }
+}
+
+TEST_CASE("Batch transforms match single operations.", "[mat]")
+{
+    srand_vec3(0);
+    extent_t extent = {-100.f, 100.f, -100.f, 100.f, -100.f, 100.f};
+    std::vector<vec3> points(37);
+    std::vector<vec4> points4(37);
+    for(unsigned ii=0; ii<points.size(); ++ii)
+    {
+        points[ii] = random_vec3(extent);
+        points4[ii] = vec4(points[ii], float(ii%3));
+    }
+
+    SECTION("Points.")
+    {
+        std::vector<vec3> out(points.size());
+        transform_points(M_SIMD, points.data(), out.data(), points.size());
+        for(unsigned ii=0; ii<points.size(); ++ii)
+        {
+            vec3 expect(M_SIMD*points[ii]);
+            REQUIRE(AllNear(expect.get_pointer(), out[ii].get_pointer(), 3, 1e-4));
+        }
+        // In place
+        transform_points(M_SIMD, points.data(), points.data(), points.size());
+        for(unsigned ii=0; ii<points.size(); ++ii)
+            REQUIRE(out[ii] == points[ii]);
+    }
+
+    SECTION("Homogeneous vectors.")
+    {
+        std::vector<vec4> out(points4.size());
+        transform(M_SIMD, points4.data(), out.data(), points4.size());
+        for(unsigned ii=0; ii<points4.size(); ++ii)
+        {
+            vec4 expect(M_SIMD*points4[ii]);
+            REQUIRE(AllNear(expect.get_pointer(), out[ii].get_pointer(), 4, 1e-4));
+        }
+    }
+}
+
+TEST_CASE("Batch matrix products match single products.", "[mat]")
+{
+    std::vector<mat4> lhs(9), rhs(9), out(9);
+    for(unsigned ii=0; ii<lhs.size(); ++ii)
+    {
+        lhs[ii] = M_SIMD*float(ii+1);
+        rhs[ii] = N_SIMD - M_SIMD*float(ii);
+    }
+
+    multiply(M_SIMD, rhs.data(), out.data(), rhs.size());
+    for(unsigned ii=0; ii<rhs.size(); ++ii)
+    {
+        mat4 expect(reference_product(M_SIMD, rhs[ii]));
+        REQUIRE(AllNear(expect.get_pointer(), out[ii].get_pointer(), 16, 1e-4));
+    }
+
+    multiply(lhs.data(), rhs.data(), out.data(), rhs.size());
+    for(unsigned ii=0; ii<rhs.size(); ++ii)
+    {
+        mat4 expect(reference_product(lhs[ii], rhs[ii]));
+        REQUIRE(AllNear(expect.get_pointer(), out[ii].get_pointer(), 16, 1e-4));
+    }
+
+    // Output aliasing right operand
+    std::vector<mat4> copy(rhs);
+    multiply(M_SIMD, copy.data(), copy.data(), copy.size());
+    for(unsigned ii=0; ii<rhs.size(); ++ii)
+    {
+        mat4 expect(M_SIMD*rhs[ii]);
+        REQUIRE(AllNear(expect.get_pointer(), copy[ii].get_pointer(), 16, 1e-6));
+    }
+}
+
 TEST_CASE("Linear interpolation performed on matrices.", "[mat]")
 {
     mat4 M1(0.2769, 0.6948, 0.4387, 0.1869,
@@ -345,7 +504,7 @@ TEST_CASE("4x4 matrices are initialized as rotation mats.", "[mat]")
     SECTION("60° rotation around x axis.")
     {
         mat4 R;
-        init_rotation_euler(R, 0.0, 0.0, TORADIANS(60));
+        init_rotation_tait_bryan(R, 0.0, 0.0, TORADIANS(60));
         // MATLAB: eul2rotm([0 0 pi/3]) % ZYX notation
         mat4 expect(1.0, 0.0, 0.0, 0.0,
                     0.0, 0.5, -0.866, 0.0,
@@ -356,7 +515,7 @@ TEST_CASE("4x4 matrices are initialized as rotation mats.", "[mat]")
     SECTION("60° rotation around y axis.")
     {
         mat4 R;
-        init_rotation_euler(R, 0.0, TORADIANS(60), 0.0);
+        init_rotation_tait_bryan(R, 0.0, TORADIANS(60), 0.0);
         // MATLAB: eul2rotm([0 pi/3 0]) % ZYX notation
         mat4 expect(0.5, 0.0, 0.866, 0.0,
                     0.0, 1.0, 0.0, 0.0,
@@ -367,7 +526,7 @@ TEST_CASE("4x4 matrices are initialized as rotation mats.", "[mat]")
     SECTION("60° rotation around z axis.")
     {
         mat4 R;
-        init_rotation_euler(R, TORADIANS(60), 0.0, 0.0);
+        init_rotation_tait_bryan(R, TORADIANS(60), 0.0, 0.0);
         // MATLAB: eul2rotm([pi/3 0 0]) % ZYX notation
         mat4 expect(0.5, -0.866, 0.0, 0.0,
                     0.866, 0.5, 0.0, 0.0,
@@ -394,7 +553,7 @@ TEST_CASE("4x4 matrix initialized as lookAt matrix.", "[mat]")
         // so -14.14 along forward direction (from camera to origin).
         // Also there is a 45° rotation along y-axis.
         init_translation(T, -eye);
-        init_rotation_euler(R, 0.0, TORADIANS(-45), 0.0);
+        init_rotation_tait_bryan(R, 0.0, TORADIANS(-45), 0.0);
 
         REQUIRE(MatrixNear(R*T, V, precision));
     }
@@ -408,7 +567,7 @@ TEST_CASE("4x4 matrix initialized as lookAt matrix.", "[mat]")
         init_translation(T, -eye);
         // cam and target at opposite points of a rectangle in (XZ) plane
         // rotation angle is the angle btw diagonal and Z
-        init_rotation_euler(R, 0.0, -atan(0.5), 0.0);
+        init_rotation_tait_bryan(R, 0.0, -atan(0.5), 0.0);
 
         REQUIRE(MatrixNear(R*T, V, precision));
     }
@@ -420,7 +579,7 @@ TEST_CASE("4x4 matrix initialized as lookAt matrix.", "[mat]")
         init_look_at(V, eye, target, up);
 
         init_translation(T, -eye);
-        init_rotation_euler(R, 0.0, -atan(5.0/7.0), 0.0);
+        init_rotation_tait_bryan(R, 0.0, -atan(5.0/7.0), 0.0);
 
         REQUIRE(MatrixNear(R*T, V, precision));
     }
@@ -0,0 +1,188 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "mesh_lod.h"
+#include "vertex_format.h"
+#include "math3d.h"
+
+using namespace wcore;
+using namespace math;
+
+// Closed UV sphere with a duplicated seam column, like generated meshes with texture coordinates
+static void make_uv_sphere(uint32_t n_rings, uint32_t n_sectors,
+                           std::vector<Vertex3P>& vertices, std::vector<uint32_t>& indices)
+{
+    for(uint32_t rr=0; rr<=n_rings; ++rr)
+    {
+        float theta = float(M_PI)*rr/n_rings;
+        for(uint32_t ss=0; ss<=n_sectors; ++ss)
+        {
+            float phi = 2.f*float(M_PI)*(ss%n_sectors)/n_sectors;
+            Vertex3P vertex;
+            vertex.position_ = vec3(std::sin(theta)*std::cos(phi), std::cos(theta), std::sin(theta)*std::sin(phi));
+            vertices.push_back(vertex);
+        }
+    }
+    for(uint32_t rr=0; rr<n_rings; ++rr)
+    {
+        for(uint32_t ss=0; ss<n_sectors; ++ss)
+        {
+            uint32_t i0 = rr*(n_sectors+1)+ss;
+            uint32_t i1 = i0+n_sectors+1;
+            if(rr != 0)
+                indices.insert(indices.end(), {i0, i1, i0+1});
+            if(rr != n_rings-1)
+                indices.insert(indices.end(), {i0+1, i1, i1+1});
+        }
+    }
+}
+
+static std::vector<vec3> get_positions(const std::vector<Vertex3P>& vertices)
+{
+    std::vector<vec3> positions;
+    for(auto&& vertex: vertices)
+        positions.push_back(vertex.position_);
+    return positions;
+}
+
+TEST_CASE("Simplification reduces triangle count and keeps valid indices.", "[lod]")
+{
+    std::vector<Vertex3P> vertices;
+    std::vector<uint32_t> indices;
+    make_uv_sphere(24, 32, vertices, indices);
+    std::vector<vec3> positions = get_positions(vertices);
+
+    uint32_t n_tris = indices.size()/3;
+    std::vector<uint32_t> simplified = lod::simplify(positions, indices, n_tris/4, 1.f);
+
+    REQUIRE(simplified.size()%3 == 0);
+    REQUIRE(simplified.size()/3 <= n_tris/4 + 2);
+    REQUIRE(simplified.size()/3 > 0);
+
+    bool valid = true;
+    bool degenerate = false;
+    for(uint32_t ii=0; ii<simplified.size(); ii+=3)
+    {
+        for(int cc=0; cc<3; ++cc)
+            valid &= (simplified[ii+cc] < vertices.size());
+        degenerate |= (positions[simplified[ii]] == positions[simplified[ii+1]]
+                    || positions[simplified[ii+1]] == positions[simplified[ii+2]]
+                    || positions[simplified[ii+2]] == positions[simplified[ii]]);
+    }
+    REQUIRE(valid);
+    REQUIRE(!degenerate);
+}
+
+TEST_CASE("Seam vertices are kept.", "[lod]")
+{
+    std::vector<Vertex3P> vertices;
+    std::vector<uint32_t> indices;
+    const uint32_t n_sectors = 32;
+    make_uv_sphere(24, n_sectors, vertices, indices);
+    std::vector<vec3> positions = get_positions(vertices);
+
+    std::vector<uint32_t> simplified = lod::simplify(positions, indices, 0, 1.f);
+
+    // Every seam vertex (sector 0 and its duplicate) off the poles is still referenced
+    bool seam_kept = true;
+    for(uint32_t rr=1; rr<24; ++rr)
+    {
+        uint32_t first = rr*(n_sectors+1);
+        uint32_t last  = first+n_sectors;
+        seam_kept &= std::find(simplified.begin(), simplified.end(), first) != simplified.end();
+        seam_kept &= std::find(simplified.begin(), simplified.end(), last) != simplified.end();
+    }
+    REQUIRE(seam_kept);
+}
+
+TEST_CASE("Error bound stops simplification of a curved surface.", "[lod]")
+{
+    std::vector<Vertex3P> vertices;
+    std::vector<uint32_t> indices;
+    make_uv_sphere(24, 32, vertices, indices);
+    std::vector<vec3> positions = get_positions(vertices);
+
+    uint32_t n_tris = indices.size()/3;
+    std::vector<uint32_t> strict = lod::simplify(positions, indices, 0, 1e-8f);
+    std::vector<uint32_t> loose  = lod::simplify(positions, indices, 0, 1.f);
+
+    REQUIRE(strict.size()/3 > n_tris/2);
+    REQUIRE(loose.size() < strict.size());
+}
+
+TEST_CASE("LOD chain is generated on a mesh.", "[lod]")
+{
+    std::vector<Vertex3P> vertices;
+    std::vector<uint32_t> indices;
+    make_uv_sphere(24, 32, vertices, indices);
+    uint32_t n_tris = indices.size()/3;
+    Mesh<Vertex3P> mesh(std::move(vertices), std::move(indices));
+
+    uint32_t n_added = lod::generate_lods(mesh, 3, 0.5f, 0.1f);
+
+    REQUIRE(n_added > 0);
+    REQUIRE(mesh.get_lod_count() == n_added+1);
+    bool decreasing = true;
+    for(uint32_t ll=1; ll<mesh.get_lod_count(); ++ll)
+        decreasing &= (mesh.get_buffer_token(ll).n_elements < mesh.get_buffer_token(ll-1).n_elements);
+    REQUIRE(decreasing);
+    REQUIRE(mesh.get_buffer_token(0).n_elements == n_tris);
+}
+
+TEST_CASE("LOD chain does not depend on mesh scale.", "[lod]")
+{
+    std::vector<Vertex3P> vertices;
+    std::vector<uint32_t> indices;
+    make_uv_sphere(24, 32, vertices, indices);
+    std::vector<Vertex3P> scaled_vertices(vertices);
+    // Power of two scale, float rounding is the same for both meshes
+    for(auto&& vertex: scaled_vertices)
+        vertex.position_ *= 64.f;
+    std::vector<uint32_t> scaled_indices(indices);
+
+    Mesh<Vertex3P> mesh(std::move(vertices), std::move(indices));
+    Mesh<Vertex3P> scaled(std::move(scaled_vertices), std::move(scaled_indices));
+
+    // Aggressive reduction, so that levels are bounded by the error and not by the target
+    uint32_t n_added        = lod::generate_lods(mesh, 3, 0.05f, 0.02f);
+    uint32_t n_added_scaled = lod::generate_lods(scaled, 3, 0.05f, 0.02f);
+
+    REQUIRE(n_added > 0);
+    REQUIRE(n_added_scaled == n_added);
+    for(uint32_t ll=0; ll<mesh.get_lod_count(); ++ll)
+        REQUIRE(scaled.get_buffer_token(ll).n_elements == mesh.get_buffer_token(ll).n_elements);
+}
+
+TEST_CASE("LOD selection with hysteresis.", "[lod]")
+{
+    lod::LodSelector selector;
+    selector.base_size  = 0.4f;
+    selector.ratio      = 0.5f;
+    selector.hysteresis = 0.1f;
+
+    // Thresholds: LOD1 under 0.4, LOD2 under 0.2
+    REQUIRE(selector.level_for(1.0f, 3) == 0);
+    REQUIRE(selector.level_for(0.3f, 3) == 1);
+    REQUIRE(selector.level_for(0.1f, 3) == 2);
+    REQUIRE(selector.level_for(0.1f, 2) == 1);
+
+    // Far from thresholds
+    REQUIRE(selector.select(1.0f, 2, 3) == 0);
+    REQUIRE(selector.select(0.1f, 0, 3) == 2);
+
+    // Slightly under threshold of LOD1: stay at LOD0
+    REQUIRE(selector.select(0.39f, 0, 3) == 0);
+    // Slightly over threshold of LOD1: stay at LOD1
+    REQUIRE(selector.select(0.41f, 1, 3) == 1);
+    // Well past the threshold
+    REQUIRE(selector.select(0.34f, 0, 3) == 1);
+    REQUIRE(selector.select(0.46f, 1, 3) == 0);
+
+    // Projected size decreases with distance
+    selector.eye = vec3(0.f);
+    selector.projection_scale = 1.f;
+    REQUIRE(selector.screen_size(vec3(0.f,0.f,-10.f), 1.f) == Approx(0.1f));
+    REQUIRE(selector.screen_size(vec3(0.f,0.f,-0.5f), 1.f) > 1.f);
+}
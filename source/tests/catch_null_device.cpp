@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <memory>
+
+#include "gfx_api.h"
+#include "buffer.h"
+#include "platform/null/null_renderer_api.h"
+
+using namespace wcore;
+
+TEST_CASE("Null device counts draw calls and filters redundant states.", "[null]")
+{
+    Gfx::set_api(GfxAPI::Null);
+    NullRenderDevice& device = null_device();
+
+    device.set_depth_test_enabled(true);
+    device.set_depth_test_enabled(true);
+    device.set_cull_mode(CullMode::Back);
+    device.set_std_blending();
+    device.set_std_blending();
+    device.bind_texture2D(0, 7);
+    device.bind_texture2D(0, 7);
+    device.bind_texture2D(1, 7);
+    device.draw_indexed(DrawPrimitive::Triangles, 36, 0);
+    device.draw_indexed_instanced(DrawPrimitive::Triangles, 12, 0, 10);
+    device.clear(CLEAR_COLOR_FLAG | CLEAR_DEPTH_FLAG);
+
+    const GfxStats& stats = device.get_frame_stats();
+    REQUIRE(stats.draw_calls == 2);
+    REQUIRE(stats.instances == 11);
+    REQUIRE(stats.elements == 36+120);
+    REQUIRE(stats.clears == 1);
+    REQUIRE(stats.state_changes == 5);
+    REQUIRE(stats.redundant_states == 3);
+    REQUIRE(stats.texture_binds == 2);
+
+    // 3 states, 2 texture binds, 2 draws and a clear
+    REQUIRE(device.get_commands().size() == 8);
+    REQUIRE(device.get_commands()[5].type == GfxCommandType::Draw);
+    REQUIRE(device.get_commands()[6].arg2 == 10);
+
+    SECTION("Ending a frame moves statistics and commands to last frame.")
+    {
+        device.end_frame();
+        REQUIRE(device.get_frame_stats().draw_calls == 0);
+        REQUIRE(device.get_commands().empty());
+        REQUIRE(device.get_last_frame_stats().draw_calls == 2);
+        REQUIRE(device.get_last_commands().size() == 8);
+        REQUIRE(device.get_total_stats().frames == 1);
+
+        // Tracked states survive the frame boundary
+        device.set_depth_test_enabled(true);
+        device.end_frame();
+        REQUIRE(device.get_last_frame_stats().redundant_states == 1);
+        REQUIRE(device.get_total_stats().frames == 2);
+        REQUIRE(device.get_total_stats().draw_calls == 2);
+    }
+
+    SECTION("Statistics are updated when recording is disabled.")
+    {
+        device.set_recording_enabled(false);
+        device.draw_indexed(DrawPrimitive::Lines, 2, 0);
+        REQUIRE(device.get_frame_stats().draw_calls == 3);
+        REQUIRE(device.get_commands().size() == 8);
+    }
+
+    Gfx::set_api(GfxAPI::OpenGL);
+}
+
+TEST_CASE("Null buffers report binds and uploads.", "[null]")
+{
+    Gfx::set_api(GfxAPI::Null);
+    NullRenderDevice& device = null_device();
+
+    float vertices[12] = {0.f};
+    uint32_t indices[6] = {0, 1, 2, 2, 3, 0};
+    std::unique_ptr<VertexArray> vao(VertexArray::create());
+    std::unique_ptr<VertexBuffer> vbo(VertexBuffer::create(vertices, sizeof(vertices)));
+    std::unique_ptr<IndexBuffer> ibo(IndexBuffer::create(indices, sizeof(indices)));
+    std::unique_ptr<UniformBuffer> ubo(UniformBuffer::create(64));
+
+    REQUIRE(device.get_frame_stats().uploads == 2);
+    REQUIRE(device.get_frame_stats().bytes_uploaded == sizeof(vertices)+sizeof(indices));
+
+    vao->bind();
+    vao->bind();
+    ubo->bind(0);
+    ubo->stream(vertices, 32);
+    vao->unbind();
+
+    REQUIRE(device.get_frame_stats().state_changes == 3);
+    REQUIRE(device.get_frame_stats().redundant_states == 1);
+    REQUIRE(device.get_frame_stats().uploads == 3);
+    REQUIRE(device.get_frame_stats().bytes_uploaded == sizeof(vertices)+sizeof(indices)+32);
+
+    Gfx::set_api(GfxAPI::OpenGL);
+}
+
+TEST_CASE("Null stream buffer honors frame capacity and alignment.", "[null]")
+{
+    Gfx::set_api(GfxAPI::Null);
+    NullRenderDevice& device = null_device();
+
+    std::unique_ptr<StreamBuffer> stream(StreamBuffer::create(256, 3));
+    uint8_t data[100] = {0};
+
+    REQUIRE(stream->write(data, 10) == 0);
+    REQUIRE(stream->write(data, 10) == 16);
+    REQUIRE(stream->write(data, 100) == 32);
+    REQUIRE(stream->write(data, 100) == 144);
+    // Region is full
+    REQUIRE(stream->write(data, 100) == StreamBuffer::INVALID_OFFSET);
+    REQUIRE(device.get_frame_stats().bytes_uploaded == 220);
+
+    // Next frame writes to next region
+    stream->next_frame();
+    REQUIRE(stream->write(data, 10) == 256);
+    stream->next_frame();
+    stream->next_frame();
+    REQUIRE(stream->write(data, 10) == 0);
+
+    Gfx::set_api(GfxAPI::OpenGL);
+}
@@ -1,5 +1,6 @@
 #include <catch2/catch.hpp>
 #include <iostream>
+#include <vector>
 #include "math3d.h"
 #include "quaternion.h"
 #include "catch_math_common.h"
@@ -205,6 +206,49 @@ TEST_CASE("Two quats are multiplied.", "[quat]")
     REQUIRE(VectorNear(vec4(0.5000, 0.5000, -0.5000, 0.5000), q21.get_as_vec(), precision));
 }
 
+TEST_CASE("Quat product matches the Hamilton product.", "[quat]")
+{
+    quat q1(0.1, -0.7, 0.3, 0.6);
+    quat q2(-0.4, 0.2, 0.8, -0.35);
+    const vec4& l = q1.get_as_vec();
+    const vec4& r = q2.get_as_vec();
+    vec4 expect(l.w()*r.x() + l.x()*r.w() + l.y()*r.z() - l.z()*r.y(),
+                l.w()*r.y() - l.x()*r.z() + l.y()*r.w() + l.z()*r.x(),
+                l.w()*r.z() + l.x()*r.y() - l.y()*r.x() + l.z()*r.w(),
+                l.w()*r.w() - l.x()*r.x() - l.y()*r.y() - l.z()*r.z());
+    quat q12 = q1*q2;
+    for(unsigned ii=0; ii<4; ++ii)
+        REQUIRE(FloatNear(expect[ii], q12[ii], 1e-6));
+}
+
+TEST_CASE("TRS composition matches the product of transformation matrices.", "[quat]")
+{
+    std::vector<vec3> positions = {vec3(1.0, -2.0, 3.5), vec3(-10.0, 0.0, 42.0), vec3(0.0)};
+    std::vector<quat> orientations = {quat(30.0, 15.0, -60.0), quat(vec3(1.0, 1.0, 0.0), 45.0), quat()};
+    std::vector<float> scales = {1.0f, 2.5f, 0.1f};
+    std::vector<mat4> out(positions.size());
+
+    compose_trs(positions.data(), orientations.data(), scales.data(), out.data(), out.size());
+    for(unsigned ii=0; ii<out.size(); ++ii)
+    {
+        mat4 T, S;
+        T.init_translation(positions[ii]);
+        S.init_scale(scales[ii]);
+        mat4 expect(T*orientations[ii].get_rotation_matrix()*S);
+        for(unsigned jj=0; jj<16; ++jj)
+            REQUIRE(FloatNear(expect[jj], out[ii][jj], precision));
+    }
+
+    // No scale array
+    compose_trs(positions.data(), orientations.data(), nullptr, out.data(), out.size());
+    for(unsigned ii=0; ii<out.size(); ++ii)
+    {
+        mat4 expect(compose_trs(positions[ii], orientations[ii]));
+        for(unsigned jj=0; jj<16; ++jj)
+            REQUIRE(expect[jj] == out[ii][jj]);
+    }
+}
+
 TEST_CASE("Two quats are divided.", "[quat]")
 {
     quat q1(0.7071, 0.0, 0.0, 0.7071);
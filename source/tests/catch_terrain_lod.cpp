@@ -0,0 +1,129 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <vector>
+#include <set>
+#include <cstdlib>
+
+#include "terrain_lod.h"
+
+using namespace wcore;
+using namespace lod;
+
+static const uint32_t W = 33;
+static const uint32_t L = 33;
+
+// Twice the signed area of a triangle in grid coordinates, positive when facing +y
+static int64_t double_area(uint32_t v0, uint32_t v1, uint32_t v2)
+{
+    int64_t i0 = v0/L, j0 = v0%L;
+    int64_t i1 = v1/L, j1 = v1%L;
+    int64_t i2 = v2/L, j2 = v2%L;
+    return (j1-j0)*(i2-i0) - (i1-i0)*(j2-j0);
+}
+
+// Triangles drawn for a chunk at some level, with given edge levels
+static std::vector<uint32_t> gather(const TerrainLodLayout& layout, uint32_t level, const uint32_t edge_levels[4])
+{
+    std::vector<uint32_t> indices = layout.make_body(level);
+    for(uint32_t ss=0; ss<4; ++ss)
+    {
+        std::vector<uint32_t> edge = layout.make_edge(level, NEIGHBOR(ss), edge_levels[ss]);
+        indices.insert(indices.end(), edge.begin(), edge.end());
+    }
+    return indices;
+}
+
+// Grid vertices of a triangle list lying on a line ii==column
+static std::set<uint32_t> column_vertices(const std::vector<uint32_t>& indices, uint32_t column)
+{
+    std::set<uint32_t> ret;
+    for(uint32_t index: indices)
+        if(index/L == column)
+            ret.insert(index%L);
+    return ret;
+}
+
+TEST_CASE("Level count and range enumeration.", "[tlod]")
+{
+    // 33 samples per axis: 33, 17, 9, 5, 3 samples at levels 0 to 4
+    TerrainLodLayout layout(W, L, 8);
+    REQUIRE(layout.get_level_count() == 5);
+    REQUIRE(layout.get_range_count() == 5 + 4*(5+4+3+2+1));
+
+    TerrainLodLayout capped(W, L, 3);
+    REQUIRE(capped.get_level_count() == 3);
+
+    // All range indices are distinct
+    std::set<uint32_t> ranges;
+    for(uint32_t ll=0; ll<layout.get_level_count(); ++ll)
+    {
+        ranges.insert(layout.body_range(ll));
+        for(uint32_t ss=0; ss<4; ++ss)
+            for(uint32_t ee=ll; ee<layout.get_level_count(); ++ee)
+                ranges.insert(layout.edge_range(ll, NEIGHBOR(ss), ee));
+    }
+    REQUIRE(ranges.size() == layout.get_range_count());
+    REQUIRE(*ranges.rbegin() == layout.get_range_count()-1);
+}
+
+TEST_CASE("Each level tiles the whole chunk whatever the edge levels.", "[tlod]")
+{
+    TerrainLodLayout layout(W, L, 8);
+    const uint32_t n_levels = layout.get_level_count();
+    bool all_valid = true;
+    for(uint32_t ll=0; ll<n_levels; ++ll)
+    {
+        for(uint32_t ee=ll; ee<n_levels; ++ee)
+        {
+            uint32_t edge_levels[4] = {ll, ee, ll, ee};
+            std::vector<uint32_t> indices = gather(layout, ll, edge_levels);
+
+            int64_t total_area = 0;
+            std::set<std::pair<uint32_t, uint32_t>> directed_edges;
+            for(uint32_t ii=0; ii+2<indices.size(); ii+=3)
+            {
+                int64_t area = double_area(indices[ii], indices[ii+1], indices[ii+2]);
+                // Counter-clockwise when viewed from above, no degenerate triangle
+                all_valid &= (area > 0);
+                total_area += area;
+                // A directed edge used twice means overlapping triangles
+                for(uint32_t cc=0; cc<3; ++cc)
+                    all_valid &= directed_edges.insert({indices[ii+cc], indices[ii+(cc+1)%3]}).second;
+            }
+            for(uint32_t index: indices)
+                all_valid &= (index < W*L);
+            all_valid &= (total_area == int64_t(2*(W-1)*(L-1)));
+        }
+    }
+    REQUIRE(all_valid);
+}
+
+TEST_CASE("Coarser levels have fewer triangles.", "[tlod]")
+{
+    TerrainLodLayout layout(W, L, 8);
+    uint32_t last_count = 2*(W-1)*(L-1)+1;
+    for(uint32_t ll=0; ll<layout.get_level_count(); ++ll)
+    {
+        uint32_t edge_levels[4] = {ll, ll, ll, ll};
+        uint32_t count = gather(layout, ll, edge_levels).size()/3;
+        REQUIRE(count < last_count);
+        last_count = count;
+    }
+}
+
+TEST_CASE("Shared edges use the same vertices on both sides of a seam.", "[tlod]")
+{
+    TerrainLodLayout layout(W, L, 8);
+    const uint32_t n_levels = layout.get_level_count();
+    // Chunk A (west) at level la, chunk B (east) at level lb, seam sampled at max(la,lb)
+    for(uint32_t la=0; la<n_levels; ++la)
+    {
+        for(uint32_t lb=0; lb<n_levels; ++lb)
+        {
+            uint32_t seam = std::max(la, lb);
+            std::vector<uint32_t> east_strip = layout.make_edge(la, NEIGHBOR::EAST, seam);
+            std::vector<uint32_t> west_strip = layout.make_edge(lb, NEIGHBOR::WEST, seam);
+            REQUIRE(column_vertices(east_strip, W-1) == column_vertices(west_strip, 0));
+        }
+    }
+}
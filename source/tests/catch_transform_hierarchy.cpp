@@ -0,0 +1,108 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include "catch_math_common.h"
+
+#include "transformation.h"
+#include "transform_hierarchy.h"
+#include "job_system.h"
+
+using namespace wcore;
+using namespace math;
+
+static const float precision = 1e-4;
+
+static bool WorldNear(const mat4& expected, const mat4& result)
+{
+    for(unsigned ii=0; ii<16; ++ii)
+        if(!FloatNear(expected[ii], result[ii], precision))
+            return false;
+    return true;
+}
+
+TEST_CASE("World matrices are composed along parent links.", "[xfh]")
+{
+    TransformHierarchy hierarchy;
+    Transformation root_trf(vec3(1.0, 2.0, 3.0), quat(30.0, 0.0, 0.0), 2.0f);
+    Transformation child_trf(vec3(0.0, 1.0, 0.0), quat(0.0, 45.0, 0.0));
+    Transformation grandchild_trf(vec3(-1.0, 0.0, 5.0), quat(), 0.5f);
+
+    uint32_t root       = hierarchy.create(root_trf);
+    uint32_t child      = hierarchy.create(child_trf, root);
+    uint32_t grandchild = hierarchy.create(grandchild_trf, child);
+
+    REQUIRE(hierarchy.update() == 3);
+    mat4 expect_root(root_trf.get_model_matrix());
+    mat4 expect_child(expect_root*child_trf.get_model_matrix());
+    REQUIRE(WorldNear(expect_root, hierarchy.get_world(root)));
+    REQUIRE(WorldNear(expect_child, hierarchy.get_world(child)));
+    REQUIRE(WorldNear(expect_child*grandchild_trf.get_model_matrix(), hierarchy.get_world(grandchild)));
+
+    // Nothing changed
+    REQUIRE(hierarchy.update() == 0);
+}
+
+TEST_CASE("Only dirty nodes and their descendants are recomputed.", "[xfh]")
+{
+    JOBS.init(3);
+
+    TransformHierarchy hierarchy;
+    std::vector<uint32_t> roots, children;
+    for(int ii=0; ii<1000; ++ii)
+    {
+        roots.push_back(hierarchy.create(Transformation(vec3(float(ii), 0.0, 0.0), quat())));
+        children.push_back(hierarchy.create(Transformation(vec3(0.0, 1.0, 0.0), quat()), roots.back()));
+    }
+    REQUIRE(hierarchy.update() == 2000);
+
+    SECTION("Same local transform does not dirty a node.")
+    {
+        hierarchy.set_local(roots[10], Transformation(vec3(10.0, 0.0, 0.0), quat()));
+        REQUIRE(hierarchy.update() == 0);
+    }
+
+    SECTION("Moving a parent moves its child.")
+    {
+        uint32_t root_version  = hierarchy.get_version(roots[10]);
+        uint32_t child_version = hierarchy.get_version(children[10]);
+        uint32_t other_version = hierarchy.get_version(children[11]);
+
+        hierarchy.set_local(roots[10], Transformation(vec3(10.0, 5.0, 0.0), quat()));
+        REQUIRE(hierarchy.update() == 2);
+        REQUIRE(hierarchy.get_version(roots[10]) == root_version+1);
+        REQUIRE(hierarchy.get_version(children[10]) == child_version+1);
+        REQUIRE(hierarchy.get_version(children[11]) == other_version);
+        REQUIRE(VectorNear(vec3(10.0, 6.0, 0.0), vec3(hierarchy.get_world(children[10]).col(3)), precision));
+    }
+
+    SECTION("World matrix is resolved on access between updates.")
+    {
+        hierarchy.set_local(roots[3], Transformation(vec3(0.0, 0.0, 7.0), quat()));
+        REQUIRE(VectorNear(vec3(0.0, 1.0, 7.0), vec3(hierarchy.get_world(children[3]).col(3)), precision));
+        // Already up to date
+        REQUIRE(hierarchy.update() == 0);
+    }
+
+    JOBS.shutdown();
+}
+
+TEST_CASE("Destroyed nodes release their children.", "[xfh]")
+{
+    TransformHierarchy hierarchy;
+    uint32_t root  = hierarchy.create(Transformation(vec3(3.0, 0.0, 0.0), quat()));
+    uint32_t child = hierarchy.create(Transformation(vec3(0.0, 2.0, 0.0), quat()), root);
+    hierarchy.update();
+    REQUIRE(VectorNear(vec3(3.0, 2.0, 0.0), vec3(hierarchy.get_world(child).col(3)), precision));
+
+    hierarchy.destroy(root);
+    REQUIRE(!hierarchy.is_alive(root));
+    REQUIRE(hierarchy.size() == 1);
+    REQUIRE(hierarchy.get_parent(child) == TransformHierarchy::NONE);
+    REQUIRE(hierarchy.update() == 1);
+    REQUIRE(VectorNear(vec3(0.0, 2.0, 0.0), vec3(hierarchy.get_world(child).col(3)), precision));
+
+    // Released node is reused
+    uint32_t other = hierarchy.create(Transformation(), child);
+    REQUIRE(other == root);
+    hierarchy.update();
+    REQUIRE(VectorNear(vec3(0.0, 2.0, 0.0), vec3(hierarchy.get_world(other).col(3)), precision));
+}